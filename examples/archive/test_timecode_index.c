@@ -24,12 +24,18 @@
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <time.h>
 
 #include <timecode_index.h>
 
 
 #define MAX_TIMECODE_SHOW       40
 
+/* 3 hour tape transfer */
+#define NUM_RANDOM_TIMECODES    (3 * 60 * 60 * 25)
+#define NUM_RANDOM_SEARCHES     20000
+#define MAX_TIMECODE_POS        (24 * 60 * 60 * 25)
+
 #define CHECK(cmd) \
     if (!(cmd)) \
     { \
@@ -104,6 +110,168 @@ static void decrement_timecode(ArchiveTimecode* timecode)
     }
 }
 
+static void position_to_timecode(int64_t position, ArchiveTimecode* timecode)
+{
+    memset(timecode, 0, sizeof(ArchiveTimecode));
+    timecode->hour = (uint8_t)(position / (60 * 60 * 25));
+    timecode->min = (uint8_t)((position % (60 * 60 * 25)) / (60 * 25));
+    timecode->sec = (uint8_t)((position % (60 * 25)) / 25);
+    timecode->frame = (uint8_t)(position % 25);
+}
+
+static int64_t timecode_to_position(const ArchiveTimecode* timecode)
+{
+    return ((timecode->hour * 60 + timecode->min) * 60 + timecode->sec) * 25 + timecode->frame;
+}
+
+/* Compares searches in an index with discontinuities, repeated and frozen timecodes against a brute
+   force search of the timecode at each position */
+static void test_random_search()
+{
+    TimecodeIndex index;
+    TimecodeIndexSearcher searcher;
+    ArchiveTimecode timecode;
+    int64_t* timecodes;
+    int* firstPosition;
+    int* nextPosition;
+    int64_t timecodePos;
+    int64_t position;
+    int64_t expectedPosition;
+    int numFound;
+    clock_t startTime;
+    int count;
+    int i;
+    int j;
+
+    CHECK((timecodes = malloc(NUM_RANDOM_TIMECODES * sizeof(int64_t))) != NULL);
+    CHECK((firstPosition = malloc(MAX_TIMECODE_POS * sizeof(int))) != NULL);
+    CHECK((nextPosition = malloc(NUM_RANDOM_TIMECODES * sizeof(int))) != NULL);
+
+    srand(1);
+    initialise_timecode_index(&index, 512);
+    timecodePos = 10 * 60 * 60 * 25;
+    i = 0;
+    while (i < NUM_RANDOM_TIMECODES)
+    {
+        j = rand() % 1000;
+        if (j < 2)
+        {
+            /* jump back up to 2 minutes, repeating timecodes */
+            timecodePos -= rand() % (2 * 60 * 25);
+        }
+        else if (j < 4)
+        {
+            /* jump forward up to 2 minutes */
+            timecodePos += rand() % (2 * 60 * 25);
+        }
+        else if (j < 8)
+        {
+            /* frozen timecode */
+            count = 2 + rand() % 50;
+            while (count > 1 && i < NUM_RANDOM_TIMECODES)
+            {
+                timecodes[i++] = timecodePos;
+                count--;
+            }
+        }
+        if (i == NUM_RANDOM_TIMECODES)
+        {
+            break;
+        }
+        timecodes[i++] = timecodePos;
+        timecodePos++;
+    }
+
+    memset(firstPosition, 0xff, MAX_TIMECODE_POS * sizeof(int));
+    for (i = NUM_RANDOM_TIMECODES - 1; i >= 0; i--)
+    {
+        nextPosition[i] = firstPosition[timecodes[i]];
+        firstPosition[timecodes[i]] = i;
+    }
+    for (i = 0; i < NUM_RANDOM_TIMECODES; i++)
+    {
+        position_to_timecode(timecodes[i], &timecode);
+        CHECK(add_timecode(&index, &timecode));
+    }
+    
+    
+    /* timecode to position from the start */
+    startTime = clock();
+    numFound = 0;
+    for (i = 0; i < NUM_RANDOM_SEARCHES; i++)
+    {
+        if (i % 10 == 0)
+        {
+            /* probably not in the index */
+            timecodePos = rand() % MAX_TIMECODE_POS;
+        }
+        else
+        {
+            timecodePos = timecodes[rand() % NUM_RANDOM_TIMECODES];
+        }
+        position_to_timecode(timecodePos, &timecode);
+        
+        initialise_timecode_index_searcher(&index, &searcher);
+        if (find_position(&searcher, &timecode, &position))
+        {
+            CHECK(position == firstPosition[timecodePos]);
+            numFound++;
+        }
+        else
+        {
+            CHECK(firstPosition[timecodePos] < 0);
+        }
+    }
+    printf("%d random timecode searches (%d found) in %.3f seconds\n", NUM_RANDOM_SEARCHES, numFound,
+        (clock() - startTime) / (double)CLOCKS_PER_SEC);
+
+    /* timecode to position, moving forward from the previous position */
+    startTime = clock();
+    initialise_timecode_index_searcher(&index, &searcher);
+    position = 0;
+    count = 0;
+    for (i = 0; i < NUM_RANDOM_SEARCHES && position + 1 < NUM_RANDOM_TIMECODES; i++)
+    {
+        timecodePos = timecodes[position + 1 + rand() % (NUM_RANDOM_TIMECODES - position - 1 < 200 ?
+            NUM_RANDOM_TIMECODES - position - 1 : 200)];
+        if (timecodePos == timecodes[position])
+        {
+            continue;
+        }
+        
+        expectedPosition = firstPosition[timecodePos];
+        while (expectedPosition <= position)
+        {
+            expectedPosition = nextPosition[expectedPosition];
+        }
+        
+        position_to_timecode(timecodePos, &timecode);
+        CHECK(find_position(&searcher, &timecode, &position));
+        CHECK(position == expectedPosition);
+        count++;
+    }
+    printf("%d forward timecode searches in %.3f seconds\n", count,
+        (clock() - startTime) / (double)CLOCKS_PER_SEC);
+
+    /* position to timecode */
+    startTime = clock();
+    initialise_timecode_index_searcher(&index, &searcher);
+    position = 0;
+    for (i = 0; i < NUM_RANDOM_SEARCHES && position < NUM_RANDOM_TIMECODES; i++)
+    {
+        CHECK(find_timecode(&searcher, position, &timecode));
+        CHECK(timecode_to_position(&timecode) == timecodes[position]);
+        position += rand() % 30;
+    }
+    CHECK(!find_timecode(&searcher, NUM_RANDOM_TIMECODES, &timecode));
+    printf("%d position searches in %.3f seconds\n", i, (clock() - startTime) / (double)CLOCKS_PER_SEC);
+    
+    clear_timecode_index(&index);
+    free(timecodes);
+    free(firstPosition);
+    free(nextPosition);
+}
+
 
 int main()
 {
@@ -404,6 +572,12 @@ int main()
     printf("Done.\n");
 
     
+    printf("Check random search...\n");
+    fflush(stdout);
+    test_random_search();
+    printf("Done.\n");
+
+    
     clear_timecode_index(&vitcIndex);
     clear_timecode_index(&ltcIndex);
     return 0;
@@ -73,124 +73,313 @@ static void position_to_timecode(int64_t position, ArchiveTimecode* timecode)
     timecode->frame = (uint8_t)(((position % (60 * 60 * 25)) % (60 * 25)) % 25);
 }
 
-static int move_timecode_index_searcher_to_next_element(TimecodeIndexSearcher* searcher)
+static int64_t get_timecode_end(const TimecodeIndexElement* element)
 {
-    TimecodeIndexArray* indexArray;
-    TimecodeIndexElement* arrayElement;
-    TimecodeIndexSearcher searcherCopy = *searcher;
+    /* a frozen element only has the one timecode */
+    return element->timecodePos + (element->frozen ? 1 : element->duration);
+}
+
+static void clear_interval_index(TimecodeIntervalIndex* intervalIndex)
+{
+    SAFE_FREE(&intervalIndex->entries);
+    SAFE_FREE(&intervalIndex->timecodeOrder);
+    SAFE_FREE(&intervalIndex->maxTimecodeEnd);
+    intervalIndex->numEntries = 0;
+    intervalIndex->allocEntries = 0;
+    intervalIndex->isValid = 0;
+}
+
+typedef struct
+{
+    int64_t timecodePos;
+    int entryNum;
+} TimecodeSortElement;
+
+static int compare_timecode_sort_elements(const void* left, const void* right)
+{
+    const TimecodeSortElement* leftElement = (const TimecodeSortElement*)left;
+    const TimecodeSortElement* rightElement = (const TimecodeSortElement*)right;
     
-    if (searcher->atEnd)
+    if (leftElement->timecodePos != rightElement->timecodePos)
     {
-        return 0;
+        return leftElement->timecodePos < rightElement->timecodePos ? -1 : 1;
     }
+    return leftElement->entryNum - rightElement->entryNum;
+}
+
+static int64_t build_max_timecode_end(TimecodeIntervalIndex* intervalIndex, int lo, int hi)
+{
+    int64_t maxEnd;
+    int64_t subTreeMaxEnd;
+    int mid;
     
+    if (lo >= hi)
+    {
+        return -1;
+    }
     
-    indexArray = (TimecodeIndexArray*)mxf_get_iter_element(&searcher->indexArrayIter);
-    arrayElement = &indexArray->elements[searcher->elementNum];
+    mid = lo + (hi - lo) / 2;
+    maxEnd = get_timecode_end(intervalIndex->entries[intervalIndex->timecodeOrder[mid]].element);
+    subTreeMaxEnd = build_max_timecode_end(intervalIndex, lo, mid);
+    if (subTreeMaxEnd > maxEnd)
+    {
+        maxEnd = subTreeMaxEnd;
+    }
+    subTreeMaxEnd = build_max_timecode_end(intervalIndex, mid + 1, hi);
+    if (subTreeMaxEnd > maxEnd)
+    {
+        maxEnd = subTreeMaxEnd;
+    }
     
-    if (searcher->elementNum + 1 < indexArray->numElements)
+    intervalIndex->maxTimecodeEnd[mid] = maxEnd;
+    return maxEnd;
+}
+
+/* (re)builds the interval index if timecodes were added since it was last built */
+static int update_interval_index(TimecodeIndex* index)
+{
+    TimecodeIntervalIndex* intervalIndex = &index->intervalIndex;
+    TimecodeSortElement* sortElements = NULL;
+    TimecodeIndexArray* indexArray;
+    MXFListIterator iter;
+    int64_t position;
+    int numEntries;
+    int i;
+    
+    if (intervalIndex->isValid)
     {
-        /* move to next element in array */
-        searcher->position += arrayElement->duration - searcher->elementOffset;
-        searcher->elementOffset = 0;
-        searcher->elementNum++;
         return 1;
     }
-    else if (indexArray->numElements == searcher->index->arraySize)
+    
+    numEntries = 0;
+    mxf_initialise_list_iter(&iter, &index->indexArrays);
+    while (mxf_next_list_iter_element(&iter))
+    {
+        indexArray = (TimecodeIndexArray*)mxf_get_iter_element(&iter);
+        numEntries += indexArray->numElements;
+    }
+    
+    if (numEntries > intervalIndex->allocEntries)
     {
-        /* move to next array in list */
-        searcher->position += arrayElement->duration - searcher->elementOffset;
-        searcher->elementOffset = 0;
-        searcher->elementNum = 0;
-        searcher->atEnd = !mxf_next_list_iter_element(&searcher->indexArrayIter);
-        if (!searcher->atEnd)
+        clear_interval_index(intervalIndex);
+        CHK_MALLOC_ARRAY_OFAIL(intervalIndex->entries, TimecodeIndexEntry, numEntries);
+        CHK_MALLOC_ARRAY_OFAIL(intervalIndex->timecodeOrder, int, numEntries);
+        CHK_MALLOC_ARRAY_OFAIL(intervalIndex->maxTimecodeEnd, int64_t, numEntries);
+        intervalIndex->allocEntries = numEntries;
+    }
+    if (numEntries > 0)
+    {
+        CHK_MALLOC_ARRAY_OFAIL(sortElements, TimecodeSortElement, numEntries);
+    }
+    
+    /* list the elements in position order */
+    intervalIndex->numEntries = 0;
+    position = 0;
+    mxf_initialise_list_iter(&iter, &index->indexArrays);
+    while (mxf_next_list_iter_element(&iter))
+    {
+        indexArray = (TimecodeIndexArray*)mxf_get_iter_element(&iter);
+        for (i = 0; i < indexArray->numElements; i++)
         {
-            return 1;
+            intervalIndex->entries[intervalIndex->numEntries].element = &indexArray->elements[i];
+            intervalIndex->entries[intervalIndex->numEntries].position = position;
+            sortElements[intervalIndex->numEntries].timecodePos = indexArray->elements[i].timecodePos;
+            sortElements[intervalIndex->numEntries].entryNum = intervalIndex->numEntries;
+            
+            position += indexArray->elements[i].duration;
+            intervalIndex->numEntries++;
         }
-        /* else at end of index */
     }
-    /* else at end of index */
     
-    *searcher = searcherCopy;
+    /* sort by timecode and build the interval tree */
+    if (numEntries > 0)
+    {
+        qsort(sortElements, numEntries, sizeof(TimecodeSortElement), compare_timecode_sort_elements);
+        for (i = 0; i < numEntries; i++)
+        {
+            intervalIndex->timecodeOrder[i] = sortElements[i].entryNum;
+        }
+        build_max_timecode_end(intervalIndex, 0, numEntries);
+    }
+    
+    SAFE_FREE(&sortElements);
+    intervalIndex->isValid = 1;
+    return 1;
+    
+fail:
+    SAFE_FREE(&sortElements);
+    clear_interval_index(intervalIndex);
     return 0;
 }
 
-static int move_timecode_index_searcher(TimecodeIndexSearcher* searcher, int64_t position)
+/* returns the entry containing the position, or -1 if the position is beyond the end of the index */
+static int find_entry_at_position(const TimecodeIntervalIndex* intervalIndex, int64_t position)
 {
-    TimecodeIndexArray* indexArray;
-    TimecodeIndexElement* arrayElement;
-    TimecodeIndexSearcher searcherCopy = *searcher;
+    const TimecodeIndexEntry* lastEntry;
+    int lo = 0;
+    int hi = intervalIndex->numEntries;
+    int mid;
     
-    if (position == searcher->position)
+    if (hi == 0)
     {
-        return 1;
+        return -1;
     }
-    if (searcher->atEnd || position < searcher->position)
+    lastEntry = &intervalIndex->entries[hi - 1];
+    if (position >= lastEntry->position + lastEntry->element->duration)
     {
-        return 0;
+        return -1;
+    }
+    
+    /* find the last entry starting at or before the position */
+    while (hi - lo > 1)
+    {
+        mid = lo + (hi - lo) / 2;
+        if (intervalIndex->entries[mid].position <= position)
+        {
+            lo = mid;
+        }
+        else
+        {
+            hi = mid;
+        }
     }
     
+    return lo;
+}
+
+typedef struct
+{
+    const TimecodeIndexSearcher* searcher;
+    int64_t timecodePos;
+    int foundEntryNum;
+    int64_t foundPosition;
+} PositionQuery;
+
+static void check_position_candidate(PositionQuery* query, int entryNum)
+{
+    const TimecodeIndexSearcher* searcher = query->searcher;
+    const TimecodeIndexEntry* entry = &searcher->index->intervalIndex.entries[entryNum];
+    int64_t position;
     
-    indexArray = (TimecodeIndexArray*)mxf_get_iter_element(&searcher->indexArrayIter);
-    while (1)
+    if (entry->element->frozen)
     {
-        arrayElement = &indexArray->elements[searcher->elementNum];
-        
-        if (position < searcher->position + (arrayElement->duration - searcher->elementOffset))
+        /* a frozen element matches at the searcher position if the searcher is in the element */
+        position = (entryNum == searcher->entryNum) ? searcher->position : entry->position;
+        if (position < searcher->position)
         {
-            /* found it the right element */
-            searcher->elementOffset += position - searcher->position;
-            searcher->position = position;
-            searcher->beforeStart = 0;
-            return 1;
+            return;
         }
-        else if (searcher->elementNum + 1 < indexArray->numElements)
+    }
+    else
+    {
+        /* an incrementing element must match after the current position, unless the search has
+           not started yet */
+        position = entry->position + query->timecodePos - entry->element->timecodePos;
+        if (position < searcher->position || (position == searcher->position && !searcher->beforeStart))
         {
-            /* move to next element in array */
-            searcher->position += arrayElement->duration - searcher->elementOffset;
-            searcher->elementOffset = 0;
-            searcher->elementNum++;
+            return;
         }
-        else if (searcher->elementNum + 1 >= indexArray->numElements && 
-            indexArray->numElements == searcher->index->arraySize)
+    }
+    
+    if (query->foundEntryNum < 0 || position < query->foundPosition)
+    {
+        query->foundEntryNum = entryNum;
+        query->foundPosition = position;
+    }
+}
+
+/* reports all elements that contain the timecode in the sub-tree [lo, hi) */
+static void find_timecode_entries(PositionQuery* query, int lo, int hi)
+{
+    const TimecodeIntervalIndex* intervalIndex = &query->searcher->index->intervalIndex;
+    const TimecodeIndexElement* element;
+    int mid;
+    
+    while (lo < hi)
+    {
+        mid = lo + (hi - lo) / 2;
+        if (intervalIndex->maxTimecodeEnd[mid] <= query->timecodePos)
         {
-            /* move to next array in list */
-            searcher->position += arrayElement->duration - searcher->elementOffset;
-            searcher->elementOffset = 0;
-            searcher->elementNum = 0;
-            searcher->atEnd = !mxf_next_list_iter_element(&searcher->indexArrayIter);
-            if (searcher->atEnd)
-            {
-                /* end of index */
-                break;
-            }
-            indexArray = (TimecodeIndexArray*)mxf_get_iter_element(&searcher->indexArrayIter);
+            /* all elements in the sub-tree end before the timecode */
+            return;
         }
-        else
+        
+        find_timecode_entries(query, lo, mid);
+        
+        element = intervalIndex->entries[intervalIndex->timecodeOrder[mid]].element;
+        if (element->timecodePos > query->timecodePos)
+        {
+            /* this and the elements in the right sub-tree start after the timecode */
+            return;
+        }
+        if (get_timecode_end(element) > query->timecodePos)
         {
-            /* end of index */
-            break;
+            check_position_candidate(query, intervalIndex->timecodeOrder[mid]);
         }
+        
+        lo = mid + 1;
+    }
+}
+
+static int move_timecode_index_searcher_to_next_element(TimecodeIndexSearcher* searcher)
+{
+    TimecodeIntervalIndex* intervalIndex = &searcher->index->intervalIndex;
+    
+    if (searcher->atEnd || !update_interval_index(searcher->index))
+    {
+        return 0;
     }
     
+    if (searcher->entryNum + 1 >= intervalIndex->numEntries)
+    {
+        /* at end of index */
+        return 0;
+    }
     
-    *searcher = searcherCopy;
-    return 0;
+    searcher->position += intervalIndex->entries[searcher->entryNum].element->duration - searcher->elementOffset;
+    searcher->elementOffset = 0;
+    searcher->entryNum++;
+    return 1;
+}
+
+static int move_timecode_index_searcher(TimecodeIndexSearcher* searcher, int64_t position)
+{
+    TimecodeIntervalIndex* intervalIndex = &searcher->index->intervalIndex;
+    int entryNum;
+    
+    if (position == searcher->position)
+    {
+        return 1;
+    }
+    if (searcher->atEnd || position < searcher->position || !update_interval_index(searcher->index))
+    {
+        return 0;
+    }
+    
+    if ((entryNum = find_entry_at_position(intervalIndex, position)) < 0)
+    {
+        /* end of index */
+        return 0;
+    }
+    
+    searcher->entryNum = entryNum;
+    searcher->elementOffset = position - intervalIndex->entries[entryNum].position;
+    searcher->position = position;
+    searcher->beforeStart = 0;
+    return 1;
 }
 
 static int find_frozen_timecode_at_offset(TimecodeIndexSearcher* searcher, int64_t offset)
 {
-    TimecodeIndexArray* indexArray;
-    TimecodeIndexElement* arrayElement;
+    const TimecodeIndexElement* arrayElement;
     
-    if (searcher->atEnd)
+    if (searcher->atEnd || !update_interval_index(searcher->index))
     {
         return 0;
     }
     
     
-    indexArray = (TimecodeIndexArray*)mxf_get_iter_element(&searcher->indexArrayIter);
-    arrayElement = &indexArray->elements[searcher->elementNum];
+    arrayElement = searcher->index->intervalIndex.entries[searcher->entryNum].element;
     
     if (arrayElement->frozen && searcher->elementOffset + offset < arrayElement->duration)
     {
@@ -208,11 +397,13 @@ void initialise_timecode_index(TimecodeIndex* index, int arraySize)
 {
     mxf_initialise_list(&index->indexArrays, free_index_array_in_list);
     index->arraySize = arraySize;
+    memset(&index->intervalIndex, 0, sizeof(index->intervalIndex));
 }
 
 void clear_timecode_index(TimecodeIndex* index)
 {
     mxf_clear_list(&index->indexArrays);
+    clear_interval_index(&index->intervalIndex);
 }
 
 int add_timecode(TimecodeIndex* index, ArchiveTimecode* timecode)
@@ -221,6 +412,7 @@ int add_timecode(TimecodeIndex* index, ArchiveTimecode* timecode)
     TimecodeIndexArray* lastArray;
     int64_t timecodePos = timecode_to_position(timecode);
     
+    index->intervalIndex.isValid = 0;
     
     if (mxf_get_list_length(&index->indexArrays) == 0)
     {
@@ -235,7 +427,8 @@ int add_timecode(TimecodeIndex* index, ArchiveTimecode* timecode)
     
     if (lastArray->numElements != 0)
     {
-        if (lastArray->elements[lastArray->numElements - 1].timecodePos + 
+        if (!lastArray->elements[lastArray->numElements - 1].frozen &&
+            lastArray->elements[lastArray->numElements - 1].timecodePos + 
                 lastArray->elements[lastArray->numElements - 1].duration == timecodePos)
         {
             /* timecode is previous + 1 */
@@ -314,28 +507,26 @@ int is_null_timecode_index(TimecodeIndex* index)
 
 void initialise_timecode_index_searcher(TimecodeIndex* index, TimecodeIndexSearcher* searcher)
 {
-    mxf_initialise_list_iter(&searcher->indexArrayIter, &index->indexArrays);
-    searcher->elementNum = 0;
+    searcher->index = index;
+    searcher->entryNum = 0;
     searcher->elementOffset = 0;
     searcher->position = 0;
-    searcher->index = index;
-    searcher->atEnd = !mxf_next_list_iter_element(&searcher->indexArrayIter);
+    searcher->atEnd = (mxf_get_list_length(&index->indexArrays) == 0);
     searcher->beforeStart = 1;
 }
 
 int find_timecode(TimecodeIndexSearcher* searcher, int64_t position, ArchiveTimecode* timecode)
 {
-    TimecodeIndexArray* indexArray;
-    TimecodeIndexElement* arrayElement;
+    const TimecodeIndexElement* arrayElement;
     int64_t timecodePos;
     
-    if (!move_timecode_index_searcher(searcher, position))
+    if (!move_timecode_index_searcher(searcher, position) ||
+        !update_interval_index(searcher->index))
     {
         return 0;
     }
     
-    indexArray = (TimecodeIndexArray*)mxf_get_iter_element(&searcher->indexArrayIter);
-    arrayElement = &indexArray->elements[searcher->elementNum];
+    arrayElement = searcher->index->intervalIndex.entries[searcher->entryNum].element;
     if (arrayElement->frozen)
     {
         timecodePos = arrayElement->timecodePos;
@@ -351,78 +542,35 @@ int find_timecode(TimecodeIndexSearcher* searcher, int64_t position, ArchiveTime
 
 int find_position(TimecodeIndexSearcher* searcher, const ArchiveTimecode* timecode, int64_t* position)
 {
-    TimecodeIndexArray* indexArray;
-    TimecodeIndexElement* arrayElement;
-    int64_t timecodePos = timecode_to_position(timecode);
-    int doneFirst = 0;
-    TimecodeIndexSearcher searcherCopy = *searcher;
+    TimecodeIntervalIndex* intervalIndex = &searcher->index->intervalIndex;
+    PositionQuery query;
 
     if (timecode->hour == INVALID_TIMECODE_HOUR)
     {
         return 0;
     }
-    if (searcher->atEnd)
+    if (searcher->atEnd || !update_interval_index(searcher->index))
     {
         return 0;
     }
     
-    indexArray = (TimecodeIndexArray*)mxf_get_iter_element(&searcher->indexArrayIter);
-    while (1)
+    /* find the first element at or after the searcher position that contains the timecode */
+    query.searcher = searcher;
+    query.timecodePos = timecode_to_position(timecode);
+    query.foundEntryNum = -1;
+    query.foundPosition = 0;
+    find_timecode_entries(&query, 0, intervalIndex->numEntries);
+    if (query.foundEntryNum < 0)
     {
-        arrayElement = &indexArray->elements[searcher->elementNum];
-        
-        if ((doneFirst || searcher->beforeStart || timecodePos > arrayElement->timecodePos + searcher->elementOffset) &&
-            timecodePos >= arrayElement->timecodePos + searcher->elementOffset &&
-            timecodePos < arrayElement->timecodePos + arrayElement->duration)
-        {
-            /* found it in incrementing timecode element */
-            searcher->position += timecodePos - (arrayElement->timecodePos + searcher->elementOffset);
-            searcher->elementOffset = timecodePos - arrayElement->timecodePos;
-            *position = searcher->position;
-            searcher->beforeStart = 0;
-            return 1;
-        }
-        else if (arrayElement->frozen && timecodePos == arrayElement->timecodePos)
-        {
-            /* found it in frozen timecode element - position is the searcher position */
-            *position = searcher->position;
-            searcher->beforeStart = 0;
-            return 1;
-        }
-        else if (searcher->elementNum + 1 < indexArray->numElements)
-        {
-            /* move to next element in array */
-            searcher->position += arrayElement->duration - searcher->elementOffset;
-            searcher->elementOffset = 0;
-            searcher->elementNum++;
-        }
-        else if (searcher->elementNum + 1 >= indexArray->numElements && 
-            indexArray->numElements == searcher->index->arraySize)
-        {
-            /* move to next array in list */
-            searcher->position += arrayElement->duration - searcher->elementOffset;
-            searcher->elementOffset = 0;
-            searcher->elementNum = 0;
-            searcher->atEnd = !mxf_next_list_iter_element(&searcher->indexArrayIter);
-            if (searcher->atEnd)
-            {
-                /* end of index */
-                break;
-            }
-            indexArray = (TimecodeIndexArray*)mxf_get_iter_element(&searcher->indexArrayIter);
-        }
-        else
-        {
-            /* end of index */
-            break;
-        }
-        
-        doneFirst = 1;
+        return 0;
     }
     
-    
-    *searcher = searcherCopy;
-    return 0;
+    searcher->entryNum = query.foundEntryNum;
+    searcher->elementOffset = query.foundPosition - intervalIndex->entries[query.foundEntryNum].position;
+    searcher->position = query.foundPosition;
+    searcher->beforeStart = 0;
+    *position = query.foundPosition;
+    return 1;
 }
 
 
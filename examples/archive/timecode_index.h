@@ -47,18 +47,38 @@ typedef struct
     int numElements;
 } TimecodeIndexArray;
 
+/* Secondary index built from the arrays when searching. The elements are listed in position order
+   for position to timecode lookups and are sorted by timecodePos for timecode to position lookups. The
+   sorted elements form an implicit balanced interval tree (the root of the sub-tree [lo, hi) is at
+   (lo + hi) / 2) with the maximum timecode end of each sub-tree in maxTimecodeEnd */
+typedef struct
+{
+    const TimecodeIndexElement* element;
+    int64_t position;
+} TimecodeIndexEntry;
+
+typedef struct
+{
+    TimecodeIndexEntry* entries;
+    int* timecodeOrder;
+    int64_t* maxTimecodeEnd;
+    int numEntries;
+    int allocEntries;
+    int isValid;
+} TimecodeIntervalIndex;
+
 typedef struct
 {
     int arraySize;
     MXFList indexArrays;
+    TimecodeIntervalIndex intervalIndex;
 } TimecodeIndex;
 
 
 typedef struct
 {
-    MXFListIterator indexArrayIter;
     TimecodeIndex* index;
-    int elementNum;
+    int entryNum;
     int64_t elementOffset;
     int64_t position;
     int atEnd;
@@ -183,7 +183,7 @@ static void increment_timecode(ArchiveTimecode* timecode)
 
 static void usage(const char* cmd)
 {
-    fprintf(stderr, "Usage: %s [--num-audio <val> --10bit --16by9 --no-lto-update --crc32] <num frames> <filename> \n", cmd);
+    fprintf(stderr, "Usage: %s [--num-audio <val> --10bit --16by9 --no-lto-update --crc32 --async-write] <num frames> <filename> \n", cmd);
 }
 
 int main(int argc, const char* argv[])
@@ -212,6 +212,7 @@ int main(int argc, const char* argv[])
     uint32_t crc32[17];
     int numCRC32 = 0;
     int includeCRC32 = 0;
+    int asyncWrite = 0;
     int cmdlnIndex = 1;
     
 
@@ -256,6 +257,11 @@ int main(int argc, const char* argv[])
             includeCRC32 = 1;
             cmdlnIndex++;
         }
+        else if (strcmp(argv[cmdlnIndex], "--async-write") == 0)
+        {
+            asyncWrite = 1;
+            cmdlnIndex++;
+        }
         else
         {
             usage(argv[0]);
@@ -298,6 +304,15 @@ int main(int argc, const char* argv[])
             return 1;
         }
     }
+    else if (asyncWrite)
+    {
+        if (!prepare_archive_mxf_file_async(mxfFilename, depth8Bit, &aspectRatio, numAudioTracks,
+            includeCRC32, 0, 1, &output))
+        {
+            fprintf(stderr, "Failed to prepare file\n");
+            return 1;
+        }
+    }
     else
     {
         if (!prepare_archive_mxf_file(mxfFilename, depth8Bit, &aspectRatio, numAudioTracks,
@@ -44,6 +44,11 @@ typedef struct _ArchiveMXFWriter ArchiveMXFWriter;
 int prepare_archive_mxf_file(const char* filename, int componentDepth8Bit, const mxfRational* aspectRatio,
     int numAudioTracks, int includeCRC32, int64_t startPosition, int beStrict, ArchiveMXFWriter** output);
 
+/* same as prepare_archive_mxf_file, but the file is written through an MXFAsyncFile, which hands
+   the writes to a background thread (see mxf_async_file.h) */
+int prepare_archive_mxf_file_async(const char* filename, int componentDepth8Bit, const mxfRational* aspectRatio,
+    int numAudioTracks, int includeCRC32, int64_t startPosition, int beStrict, ArchiveMXFWriter** output);
+
 /* use the Archive MXF file (the filename is only used as metadata) and prepare for writing the essence */
 /* note: if this function returns 0 then check whether *mxfFile is not NULL and needs to be closed */
 int prepare_archive_mxf_file_2(MXFFile** mxfFile, const char* filename, int componentDepth8Bit,
@@ -356,7 +356,17 @@ static size_t get_range_string(char* buffer, size_t maxSize, int isFirst, int is
 
 
 
+int ami_load_data_model(MXFDataModel** dataModel)
+{
+    return mxf_avid_get_default_data_model(dataModel);
+}
+
 int ami_read_info(const char* filename, AvidMXFInfo* info, int printDebugError)
+{
+    return ami_read_info_2(filename, NULL, info, printDebugError);
+}
+
+int ami_read_info_2(const char* filename, MXFDataModel* sharedDataModel, AvidMXFInfo* info, int printDebugError)
 {
     int errorCode = -1;
     mxfKey key;
@@ -372,7 +382,8 @@ int ami_read_info(const char* filename, AvidMXFInfo* info, int printDebugError)
     MXFArrayItemIterator arrayIter;
     MXFFile* mxfFile = NULL;
     MXFPartition* headerPartition = NULL;
-    MXFDataModel* dataModel = NULL;
+    MXFDataModel* dataModel = sharedDataModel;
+    MXFDataModel* ownedDataModel = NULL;
     MXFHeaderMetadata* headerMetadata = NULL;
     MXFMetadataSet* set = NULL;
     MXFMetadataSet* prefaceSet = NULL;
@@ -442,11 +453,11 @@ int ami_read_info(const char* filename, AvidMXFInfo* info, int printDebugError)
     
     /* read the header metadata (filter out meta-dictionary and dictionary except data defs) */
     
-    DCHECK(mxf_load_data_model(&dataModel));
-    DCHECK(mxf_load_extensions_data_model(dataModel));
-    DCHECK(mxf_avid_load_extensions(dataModel));
-    
-    DCHECK(mxf_finalise_data_model(dataModel));
+    if (dataModel == NULL)
+    {
+        DCHECK(ami_load_data_model(&ownedDataModel));
+        dataModel = ownedDataModel;
+    }
     
     DCHECK(mxf_read_next_nonfiller_kl(mxfFile, &key, &llen, &len));
     DCHECK(mxf_is_header_metadata(&key));
@@ -1225,7 +1236,7 @@ int ami_read_info(const char* filename, AvidMXFInfo* info, int printDebugError)
     
     mxf_file_close(&mxfFile);
     mxf_free_header_metadata(&headerMetadata);
-    mxf_free_data_model(&dataModel);
+    mxf_free_data_model(&ownedDataModel);
     mxf_free_partition(&headerPartition);
     mxf_free_list(&list);
     mxf_free_list(&taggedValueNames);
@@ -1238,7 +1249,7 @@ fail:
     
     mxf_file_close(&mxfFile);
     mxf_free_header_metadata(&headerMetadata);
-    mxf_free_data_model(&dataModel);
+    mxf_free_data_model(&ownedDataModel);
     mxf_free_partition(&headerPartition);
     mxf_free_list(&list);
     mxf_free_list(&taggedValueNames);
@@ -1374,3 +1385,244 @@ void ami_print_info(AvidMXFInfo* info)
 
 
 
+
+const char* ami_get_error_string(int errorCode)
+{
+    switch (errorCode)
+    {
+        case 0:
+            return "";
+        case -2:
+            return "Failed to open file";
+        case -3:
+            return "Failed to read header partition";
+        case -4:
+            return "File is not OP-Atom";
+        case -1:
+        default:
+            return "Failed to read info";
+    }
+}
+
+static const char* phys_type_string(AvidPhysicalPackageType physicalPackageType)
+{
+    switch (physicalPackageType)
+    {
+        case TAPE_PHYS_TYPE:
+            return "Tape";
+        case IMPORT_PHYS_TYPE:
+            return "Import";
+        case RECORDING_PHYS_TYPE:
+            return "Recording";
+        case UNKNOWN_PHYS_TYPE:
+        default:
+            return "";
+    }
+}
+
+static void print_json_string(const char* str)
+{
+    const unsigned char* strPtr = (const unsigned char*)str;
+
+    printf("\"");
+    while (strPtr != NULL && *strPtr != '\0')
+    {
+        switch (*strPtr)
+        {
+            case '"':
+                printf("\\\"");
+                break;
+            case '\\':
+                printf("\\\\");
+                break;
+            case '\n':
+                printf("\\n");
+                break;
+            case '\r':
+                printf("\\r");
+                break;
+            case '\t':
+                printf("\\t");
+                break;
+            default:
+                if (*strPtr < 0x20)
+                {
+                    printf("\\u%04x", *strPtr);
+                }
+                else
+                {
+                    putchar(*strPtr);
+                }
+                break;
+        }
+        strPtr++;
+    }
+    printf("\"");
+}
+
+static void print_csv_string(const char* str)
+{
+    const char* strPtr = str;
+
+    printf("\"");
+    while (strPtr != NULL && *strPtr != '\0')
+    {
+        if (*strPtr == '"')
+        {
+            printf("\"\"");
+        }
+        else
+        {
+            putchar(*strPtr);
+        }
+        strPtr++;
+    }
+    printf("\"");
+}
+
+void ami_print_info_json(const char* filename, int errorCode, AvidMXFInfo* info)
+{
+    int i;
+
+    printf("{\"filename\":");
+    print_json_string(filename);
+    if (errorCode != 0)
+    {
+        printf(",\"error\":");
+        print_json_string(ami_get_error_string(errorCode));
+        printf("}\n");
+        return;
+    }
+
+    printf(",\"projectName\":");
+    print_json_string(info->projectName);
+    printf(",\"projectEditRate\":\"%d/%d\"", info->projectEditRate.numerator, info->projectEditRate.denominator);
+    printf(",\"clipName\":");
+    print_json_string(info->clipName);
+    printf(",\"clipCreated\":\"");
+    print_timestamp(&info->clipCreated);
+    printf("\",\"clipDuration\":%"PFi64, info->clipDuration);
+    printf(",\"numVideoTracks\":%d,\"numAudioTracks\":%d", info->numVideoTracks, info->numAudioTracks);
+    printf(",\"tracks\":");
+    print_json_string(info->tracksString);
+    printf(",\"isVideo\":%s", info->isVideo ? "true" : "false");
+    printf(",\"essenceType\":");
+    print_json_string(essence_type_string(info->essenceType));
+    printf(",\"essenceLabel\":\"");
+    print_label(&info->essenceContainerLabel);
+    printf("\",\"trackNumber\":%u", info->trackNumber);
+    printf(",\"editRate\":\"%d/%d\"", info->editRate.numerator, info->editRate.denominator);
+    printf(",\"trackDuration\":%"PFi64, info->trackDuration);
+    printf(",\"segmentDuration\":%"PFi64, info->segmentDuration);
+    printf(",\"segmentOffset\":%"PFi64, info->segmentOffset);
+    printf(",\"startTimecode\":%"PFi64, info->startTimecode);
+    if (info->isVideo)
+    {
+        printf(",\"aspectRatio\":\"%d/%d\"", info->aspectRatio.numerator, info->aspectRatio.denominator);
+        printf(",\"storedWidth\":%u,\"storedHeight\":%u", info->storedWidth, info->storedHeight);
+        printf(",\"frameLayout\":");
+        print_json_string(frame_layout_string(info->frameLayout));
+    }
+    else
+    {
+        printf(",\"audioSamplingRate\":\"%d/%d\"", info->audioSamplingRate.numerator,
+            info->audioSamplingRate.denominator);
+        printf(",\"channelCount\":%u,\"quantizationBits\":%u", info->channelCount, info->quantizationBits);
+    }
+    if (info->userComments != NULL)
+    {
+        printf(",\"userComments\":{");
+        for (i = 0; i < info->numUserComments; i++)
+        {
+            if (i > 0)
+            {
+                printf(",");
+            }
+            print_json_string(info->userComments[i].name);
+            printf(":");
+            print_json_string(info->userComments[i].value);
+        }
+        printf("}");
+    }
+    if (info->materialPackageAttributes != NULL)
+    {
+        printf(",\"materialPackageAttributes\":{");
+        for (i = 0; i < info->numMaterialPackageAttributes; i++)
+        {
+            if (i > 0)
+            {
+                printf(",");
+            }
+            print_json_string(info->materialPackageAttributes[i].name);
+            printf(":");
+            print_json_string(info->materialPackageAttributes[i].value);
+        }
+        printf("}");
+    }
+    printf(",\"materialPackageUID\":\"");
+    print_umid(&info->materialPackageUID);
+    printf("\",\"filePackageUID\":\"");
+    print_umid(&info->fileSourcePackageUID);
+    printf("\",\"physicalPackageUID\":\"");
+    print_umid(&info->physicalSourcePackageUID);
+    printf("\",\"physicalPackageType\":");
+    print_json_string(phys_type_string(info->physicalPackageType));
+    printf(",\"physicalPackageName\":");
+    print_json_string(info->physicalPackageName);
+    printf("}\n");
+}
+
+void ami_print_info_csv_header(void)
+{
+    printf("filename,error,projectName,projectEditRate,clipName,clipCreated,clipDuration,"
+        "numVideoTracks,numAudioTracks,tracks,isVideo,essenceType,essenceLabel,trackNumber,editRate,"
+        "trackDuration,segmentDuration,segmentOffset,startTimecode,aspectRatio,storedWidth,storedHeight,"
+        "frameLayout,audioSamplingRate,channelCount,quantizationBits,materialPackageUID,filePackageUID,"
+        "physicalPackageUID,physicalPackageType,physicalPackageName\n");
+}
+
+void ami_print_info_csv(const char* filename, int errorCode, AvidMXFInfo* info)
+{
+    print_csv_string(filename);
+    printf(",");
+    print_csv_string(ami_get_error_string(errorCode));
+    if (errorCode != 0)
+    {
+        printf(",,,,,,,,,,,,,,,,,,,,,,,,,,,,,\n");
+        return;
+    }
+
+    printf(",");
+    print_csv_string(info->projectName);
+    printf(",%d/%d,", info->projectEditRate.numerator, info->projectEditRate.denominator);
+    print_csv_string(info->clipName);
+    printf(",");
+    print_timestamp(&info->clipCreated);
+    printf(",%"PFi64",%d,%d,", info->clipDuration, info->numVideoTracks, info->numAudioTracks);
+    print_csv_string(info->tracksString);
+    printf(",%d,%s,", info->isVideo, essence_type_string(info->essenceType));
+    print_label(&info->essenceContainerLabel);
+    printf(",%u,%d/%d", info->trackNumber, info->editRate.numerator, info->editRate.denominator);
+    printf(",%"PFi64",%"PFi64",%"PFi64",%"PFi64, info->trackDuration, info->segmentDuration,
+        info->segmentOffset, info->startTimecode);
+    if (info->isVideo)
+    {
+        printf(",%d/%d,%u,%u,%s,,,", info->aspectRatio.numerator, info->aspectRatio.denominator,
+            info->storedWidth, info->storedHeight, frame_layout_string(info->frameLayout));
+    }
+    else
+    {
+        printf(",,,,,%d/%d,%u,%u", info->audioSamplingRate.numerator, info->audioSamplingRate.denominator,
+            info->channelCount, info->quantizationBits);
+    }
+    printf(",");
+    print_umid(&info->materialPackageUID);
+    printf(",");
+    print_umid(&info->fileSourcePackageUID);
+    printf(",");
+    print_umid(&info->physicalSourcePackageUID);
+    printf(",%s,", phys_type_string(info->physicalPackageType));
+    print_csv_string(info->physicalPackageName);
+    printf("\n");
+}
+
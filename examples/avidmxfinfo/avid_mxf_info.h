@@ -30,7 +30,7 @@ extern "C"
 #endif
 
 
-#include <mxf/mxf_types.h>
+#include <mxf/mxf.h>
 
 
 /* Note: keep essence_type_string() in sync when changes are made here */
@@ -146,12 +146,30 @@ typedef struct
 
 
 
+/* returns a reference to the (shared) data model used for reading Avid OP-Atom files.
+   Release it using mxf_free_data_model */
+int ami_load_data_model(MXFDataModel** dataModel);
+
+/* returns 0 on success, -2 if the file could not be opened, -3 if the header partition
+   could not be read, -4 if the file is not OP-Atom and -1 for other errors */
 int ami_read_info(const char* filename, AvidMXFInfo* info, int printDebugError);
 
+/* same as ami_read_info, but uses dataModel from ami_load_data_model if not NULL. The data model
+   is only read and can be shared by threads calling this function concurrently */
+int ami_read_info_2(const char* filename, MXFDataModel* dataModel, AvidMXFInfo* info, int printDebugError);
+
+const char* ami_get_error_string(int errorCode);
+
 void ami_free_info(AvidMXFInfo* info);
 
 void ami_print_info(AvidMXFInfo* info);
-/* TODO: add function to print machine readable info e.g. newline delimited fields */
+
+/* print a single line JSON object (NDJSON). info is not used if errorCode is not 0 */
+void ami_print_info_json(const char* filename, int errorCode, AvidMXFInfo* info);
+
+/* print a CSV line, with the column names printed by ami_print_info_csv_header */
+void ami_print_info_csv_header(void);
+void ami_print_info_csv(const char* filename, int errorCode, AvidMXFInfo* info);
 
 
 
@@ -19,15 +19,432 @@
  * License along with this library; if not, write to the Free Software
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
  */
- 
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+#include <mxf/mxf_thread.h>
 
 #include "avid_mxf_info.h"
 
 
+/* number of results each probe thread can be ahead of the output */
+#define RESULTS_PER_THREAD      64
+
+#define MAX_THREADS             64
+
+
+typedef enum
+{
+    TEXT_OUTPUT,
+    JSON_OUTPUT,
+    CSV_OUTPUT
+} OutputFormat;
+
+typedef struct
+{
+    char** filenames;
+    size_t numFilenames;
+    size_t allocFilenames;
+} FileList;
+
+typedef struct
+{
+    int done;
+    int result;
+    AvidMXFInfo info;
+} ProbeResult;
+
+typedef struct
+{
+    const FileList* files;
+    MXFDataModel* dataModel;
+    int printDebugError;
+
+    /* results for files [numOutput, numOutput + numResults) are held in results[index % numResults] */
+    ProbeResult* results;
+    size_t numResults;
+
+    /* protected by the mutex */
+    MXFMutex mutex;
+    MXFCondition doneCondition;
+    MXFCondition spaceCondition;
+    size_t nextFile;
+    size_t numOutput;
+} ProbePool;
+
+
+
+static int add_filename(FileList* files, const char* dirname, const char* name)
+{
+    char** newFilenames;
+    char* filename;
+    size_t dirnameLen = (dirname != NULL ? strlen(dirname) : 0);
+
+    if (files->numFilenames == files->allocFilenames)
+    {
+        newFilenames = (char**)realloc(files->filenames,
+            sizeof(char*) * (files->allocFilenames == 0 ? 256 : files->allocFilenames * 2));
+        if (newFilenames == NULL)
+        {
+            fprintf(stderr, "Failed to allocate memory\n");
+            return 0;
+        }
+        files->filenames = newFilenames;
+        files->allocFilenames = (files->allocFilenames == 0 ? 256 : files->allocFilenames * 2);
+    }
+
+    if ((filename = (char*)malloc(dirnameLen + 1 + strlen(name) + 1)) == NULL)
+    {
+        fprintf(stderr, "Failed to allocate memory\n");
+        return 0;
+    }
+    if (dirname != NULL)
+    {
+        strcpy(filename, dirname);
+        strcat(filename, "/");
+        strcat(filename, name);
+    }
+    else
+    {
+        strcpy(filename, name);
+    }
+
+    files->filenames[files->numFilenames] = filename;
+    files->numFilenames++;
+    return 1;
+}
+
+static void clear_file_list(FileList* files)
+{
+    size_t i;
+
+    for (i = 0; i < files->numFilenames; i++)
+    {
+        free(files->filenames[i]);
+    }
+    free(files->filenames);
+    memset(files, 0, sizeof(*files));
+}
+
+static int compare_filenames(const void* left, const void* right)
+{
+    return strcmp(*(char* const*)left, *(char* const*)right);
+}
+
+static int is_directory(const char* path)
+{
+    struct stat statBuf;
+
+    if (stat(path, &statBuf) != 0)
+    {
+        return 0;
+    }
+    return (statBuf.st_mode & S_IFMT) == S_IFDIR;
+}
+
+/* returns true if the path is a symbolic link, or a junction or other reparse point on Windows */
+static int is_link(const char* path)
+{
+#if defined(_WIN32)
+    DWORD attributes = GetFileAttributesA(path);
+
+    return attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_REPARSE_POINT);
+#else
+    struct stat statBuf;
+
+    if (lstat(path, &statBuf) != 0)
+    {
+        return 0;
+    }
+    return S_ISLNK(statBuf.st_mode);
+#endif
+}
+
+static int has_mxf_suffix(const char* name)
+{
+    size_t len = strlen(name);
+
+    return len > 4 &&
+        name[len - 4] == '.' &&
+        (name[len - 3] == 'm' || name[len - 3] == 'M') &&
+        (name[len - 2] == 'x' || name[len - 2] == 'X') &&
+        (name[len - 1] == 'f' || name[len - 1] == 'F');
+}
+
+/* add the .mxf files in the directory tree to the list, in sorted order within each directory.
+   Links to directories are not followed because they can form a loop */
+static int walk_directory(FileList* files, const char* dirname)
+{
+    FileList entries;
+    size_t i;
+    const char* name;
+    int addFailed = 0;
+#if defined(_WIN32)
+    WIN32_FIND_DATAA findData;
+    HANDLE findHandle;
+    char* pattern;
+#else
+    DIR* dir;
+    struct dirent* entry;
+#endif
+
+    memset(&entries, 0, sizeof(entries));
+
+#if defined(_WIN32)
+    if ((pattern = (char*)malloc(strlen(dirname) + 3)) == NULL)
+    {
+        fprintf(stderr, "Failed to allocate memory\n");
+        return 0;
+    }
+    strcpy(pattern, dirname);
+    strcat(pattern, "/*");
+    findHandle = FindFirstFileA(pattern, &findData);
+    free(pattern);
+    if (findHandle == INVALID_HANDLE_VALUE)
+    {
+        fprintf(stderr, "Failed to open directory '%s'\n", dirname);
+        return 0;
+    }
+    do
+    {
+        name = findData.cFileName;
+#else
+    if ((dir = opendir(dirname)) == NULL)
+    {
+        fprintf(stderr, "Failed to open directory '%s'\n", dirname);
+        return 0;
+    }
+    while ((entry = readdir(dir)) != NULL)
+    {
+        name = entry->d_name;
+#endif
+        if (strcmp(name, ".") != 0 && strcmp(name, "..") != 0 && !add_filename(&entries, dirname, name))
+        {
+            addFailed = 1;
+            break;
+        }
+#if defined(_WIN32)
+    }
+    while (FindNextFileA(findHandle, &findData));
+    FindClose(findHandle);
+#else
+    }
+    closedir(dir);
+#endif
+    if (addFailed)
+    {
+        goto fail;
+    }
+
+    if (entries.numFilenames > 1)
+    {
+        qsort(entries.filenames, entries.numFilenames, sizeof(char*), compare_filenames);
+    }
+
+    for (i = 0; i < entries.numFilenames; i++)
+    {
+        if (is_directory(entries.filenames[i]))
+        {
+            if (is_link(entries.filenames[i]))
+            {
+                fprintf(stderr, "Skipping link to directory '%s'\n", entries.filenames[i]);
+            }
+            else if (!walk_directory(files, entries.filenames[i]))
+            {
+                goto fail;
+            }
+        }
+        else if (has_mxf_suffix(entries.filenames[i]))
+        {
+            if (!add_filename(files, NULL, entries.filenames[i]))
+            {
+                goto fail;
+            }
+        }
+    }
+
+    clear_file_list(&entries);
+    return 1;
+
+fail:
+    clear_file_list(&entries);
+    return 0;
+}
+
+static void print_result(OutputFormat format, const char* filename, int result, AvidMXFInfo* info)
+{
+    switch (format)
+    {
+        case JSON_OUTPUT:
+            ami_print_info_json(filename, result, info);
+            break;
+        case CSV_OUTPUT:
+            ami_print_info_csv(filename, result, info);
+            break;
+        case TEXT_OUTPUT:
+        default:
+            printf("\nFilename = %s\n", filename);
+            if (result != 0)
+            {
+                fprintf(stderr, "%s (%s)\n", ami_get_error_string(result), filename);
+            }
+            else
+            {
+                ami_print_info(info);
+            }
+            break;
+    }
+}
+
+static void probe_thread(void* arg)
+{
+    ProbePool* pool = (ProbePool*)arg;
+    ProbeResult* result;
+    size_t fileIndex;
+
+    for (;;)
+    {
+        mxf_lock_mutex(&pool->mutex);
+        while (pool->nextFile < pool->files->numFilenames &&
+            pool->nextFile >= pool->numOutput + pool->numResults)
+        {
+            mxf_wait_condition(&pool->spaceCondition, &pool->mutex);
+        }
+        if (pool->nextFile >= pool->files->numFilenames)
+        {
+            mxf_unlock_mutex(&pool->mutex);
+            break;
+        }
+        fileIndex = pool->nextFile;
+        pool->nextFile++;
+        mxf_unlock_mutex(&pool->mutex);
+
+        /* the result slot is not accessed by other threads until it is marked done */
+        result = &pool->results[fileIndex % pool->numResults];
+        result->result = ami_read_info_2(pool->files->filenames[fileIndex], pool->dataModel, &result->info,
+            pool->printDebugError);
+
+        mxf_lock_mutex(&pool->mutex);
+        result->done = 1;
+        mxf_broadcast_condition(&pool->doneCondition);
+        mxf_unlock_mutex(&pool->mutex);
+    }
+}
+
+/* probe the files using numThreads threads and output the results in file list order */
+static int probe_files(const FileList* files, MXFDataModel* dataModel, int numThreads, OutputFormat format,
+    size_t* numFailed)
+{
+    ProbePool pool;
+    MXFThread threads[MAX_THREADS];
+    int numStarted = 0;
+    ProbeResult* result;
+    size_t i;
+    int j;
+
+    memset(&pool, 0, sizeof(pool));
+    pool.files = files;
+    pool.dataModel = dataModel;
+    pool.printDebugError = 1;
+    pool.numResults = (size_t)numThreads * RESULTS_PER_THREAD;
+    if ((pool.results = (ProbeResult*)calloc(pool.numResults, sizeof(ProbeResult))) == NULL)
+    {
+        fprintf(stderr, "Failed to allocate memory\n");
+        return 0;
+    }
+    if (!mxf_init_mutex(&pool.mutex))
+    {
+        free(pool.results);
+        return 0;
+    }
+    if (!mxf_init_condition(&pool.doneCondition))
+    {
+        mxf_destroy_mutex(&pool.mutex);
+        free(pool.results);
+        return 0;
+    }
+    if (!mxf_init_condition(&pool.spaceCondition))
+    {
+        mxf_destroy_condition(&pool.doneCondition);
+        mxf_destroy_mutex(&pool.mutex);
+        free(pool.results);
+        return 0;
+    }
+
+    for (j = 0; j < numThreads; j++)
+    {
+        if (!mxf_create_thread(&threads[j], probe_thread, &pool))
+        {
+            break;
+        }
+        numStarted++;
+    }
+    if (numStarted == 0)
+    {
+        fprintf(stderr, "Failed to start probe threads\n");
+        goto fail;
+    }
+
+    for (i = 0; i < files->numFilenames; i++)
+    {
+        result = &pool.results[i % pool.numResults];
+
+        mxf_lock_mutex(&pool.mutex);
+        while (!result->done)
+        {
+            mxf_wait_condition(&pool.doneCondition, &pool.mutex);
+        }
+        mxf_unlock_mutex(&pool.mutex);
+
+        print_result(format, files->filenames[i], result->result, &result->info);
+        if (result->result == 0)
+        {
+            ami_free_info(&result->info);
+        }
+        else
+        {
+            (*numFailed)++;
+        }
+
+        mxf_lock_mutex(&pool.mutex);
+        result->done = 0;
+        pool.numOutput++;
+        mxf_broadcast_condition(&pool.spaceCondition);
+        mxf_unlock_mutex(&pool.mutex);
+    }
+
+    for (j = 0; j < numStarted; j++)
+    {
+        mxf_join_thread(&threads[j]);
+    }
+
+    mxf_destroy_condition(&pool.spaceCondition);
+    mxf_destroy_condition(&pool.doneCondition);
+    mxf_destroy_mutex(&pool.mutex);
+    free(pool.results);
+
+    return 1;
+
+fail:
+    mxf_destroy_condition(&pool.spaceCondition);
+    mxf_destroy_condition(&pool.doneCondition);
+    mxf_destroy_mutex(&pool.mutex);
+    free(pool.results);
+
+    return 0;
+}
+
 
 static void usage(const char* cmd)
 {
@@ -35,6 +452,12 @@ static void usage(const char* cmd)
     fprintf(stderr, "\n");
     fprintf(stderr, "Options: (options marked with * are required)\n");
     fprintf(stderr, "  -h, --help                 display this usage message\n");
+    fprintf(stderr, "  --threads <num>            probe the files using <num> threads. Default is 1\n");
+    fprintf(stderr, "  --json                     print a JSON object for each file (NDJSON)\n");
+    fprintf(stderr, "  --csv                      print a CSV line for each file, preceded by a header line\n");
+    fprintf(stderr, "  --stats                    print the number of files probed and files/sec to stderr\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "An <input> directory is searched recursively for files with a .mxf suffix\n");
 }
 
 
@@ -45,8 +468,18 @@ int main(int argc, const char* argv[])
     AvidMXFInfo info;
     int result;
     int i;
-    const char* inputFilename;
+    size_t j;
+    int numThreads = 1;
+    OutputFormat format = TEXT_OUTPUT;
+    int printStats = 0;
+    FileList files;
+    MXFDataModel* dataModel = NULL;
+    size_t numFailed = 0;
+    int64_t startTime;
+    int64_t duration;
     
+    memset(&files, 0, sizeof(files));
+
     while (cmdlnIndex < argc)
     {
         if (strcmp(argv[cmdlnIndex], "-h") == 0 ||
@@ -55,6 +488,38 @@ int main(int argc, const char* argv[])
             usage(argv[0]);
             return 0;
         }
+        else if (strcmp(argv[cmdlnIndex], "--threads") == 0)
+        {
+            if (cmdlnIndex + 1 >= argc)
+            {
+                usage(argv[0]);
+                fprintf(stderr, "Missing argument for %s\n", argv[cmdlnIndex]);
+                return 1;
+            }
+            if (sscanf(argv[cmdlnIndex + 1], "%d", &numThreads) != 1 ||
+                numThreads < 1 || numThreads > MAX_THREADS)
+            {
+                usage(argv[0]);
+                fprintf(stderr, "Invalid argument for %s\n", argv[cmdlnIndex]);
+                return 1;
+            }
+            cmdlnIndex += 2;
+        }
+        else if (strcmp(argv[cmdlnIndex], "--json") == 0)
+        {
+            format = JSON_OUTPUT;
+            cmdlnIndex++;
+        }
+        else if (strcmp(argv[cmdlnIndex], "--csv") == 0)
+        {
+            format = CSV_OUTPUT;
+            cmdlnIndex++;
+        }
+        else if (strcmp(argv[cmdlnIndex], "--stats") == 0)
+        {
+            printStats = 1;
+            cmdlnIndex++;
+        }
         else
         {
             break;
@@ -71,42 +536,77 @@ int main(int argc, const char* argv[])
     inputFilenamesIndex = cmdlnIndex;
 
 
+    startTime = mxf_get_monotonic_time_usec();
 
     for (i = inputFilenamesIndex; i < argc; i++)
     {
-        inputFilename = argv[i];
-        
-        printf("\nFilename = %s\n", inputFilename);
-        
-        result = ami_read_info(inputFilename, &info, 1);
-        if (result != 0)
+        if (is_directory(argv[i]))
+        {
+            if (!walk_directory(&files, argv[i]))
+            {
+                goto fail;
+            }
+        }
+        else if (!add_filename(&files, NULL, argv[i]))
+        {
+            goto fail;
+        }
+    }
+
+    if (format == CSV_OUTPUT)
+    {
+        ami_print_info_csv_header();
+    }
+
+    /* the data model is only read when reading the files and is shared by the probe threads */
+    if (!ami_load_data_model(&dataModel))
+    {
+        fprintf(stderr, "Failed to load the data model\n");
+        goto fail;
+    }
+
+    if (numThreads > 1)
+    {
+        if (!probe_files(&files, dataModel, numThreads, format, &numFailed))
         {
-            switch (result)
+            goto fail;
+        }
+    }
+    else
+    {
+        for (j = 0; j < files.numFilenames; j++)
+        {
+            result = ami_read_info_2(files.filenames[j], dataModel, &info, 1);
+            print_result(format, files.filenames[j], result, &info);
+            if (result == 0)
             {
-                case -2:
-                    fprintf(stderr, "Failed to open file (%s)\n", inputFilename);
-                    break;
-                case -3:
-                    fprintf(stderr, "Failed to read header partition (%s)\n", inputFilename);
-                    break;
-                case -4:
-                    fprintf(stderr, "File is not OP-Atom (%s)\n", inputFilename);
-                    break;
-                case -1:
-                default:
-                    fprintf(stderr, "Failed to read info (%s)\n", inputFilename);
-                    break;
+                ami_free_info(&info);
+            }
+            else
+            {
+                numFailed++;
             }
-            
-            continue;
         }
-        
-        ami_print_info(&info);
-        
-        ami_free_info(&info);
     }
-    
+
+    if (printStats)
+    {
+        fflush(stdout);
+        duration = mxf_get_monotonic_time_usec() - startTime;
+        fprintf(stderr, "Probed %lu files (%lu failed) in %.3f sec: %.1f files/sec\n",
+            (unsigned long)files.numFilenames, (unsigned long)numFailed, duration / 1000000.0,
+            duration > 0 ? files.numFilenames * 1000000.0 / duration : 0.0);
+    }
+
+    mxf_free_data_model(&dataModel);
+    clear_file_list(&files);
     
     return 0;
+
+
+fail:
+    mxf_free_data_model(&dataModel);
+    clear_file_list(&files);
+    return 1;
 }
 
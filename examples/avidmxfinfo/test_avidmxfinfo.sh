@@ -33,3 +33,27 @@ do
 	echo $command
 	$command > /dev/null || exit 1
 done
+
+# batch probe the directory and check that multi-threaded output matches single-threaded output
+for format in --json --csv
+do
+	command="$VALGRIND_CMD ./avidmxfinfo $format --stats ../writeavidmxf"
+	echo $command
+	$command > avidmxfinfo_batch1.txt || exit 1
+	command="$VALGRIND_CMD ./avidmxfinfo $format --stats --threads 4 ../writeavidmxf"
+	echo $command
+	$command > avidmxfinfo_batch4.txt || exit 1
+	cmp avidmxfinfo_batch1.txt avidmxfinfo_batch4.txt || exit 1
+done
+rm -f avidmxfinfo_batch1.txt avidmxfinfo_batch4.txt
+
+# a link back to the parent directory is skipped rather than followed forever
+rm -rf avidmxfinfo_loop
+mkdir avidmxfinfo_loop || exit 1
+ln -s ../../writeavidmxf/test_unc_v1.mxf avidmxfinfo_loop/test.mxf || exit 1
+ln -s .. avidmxfinfo_loop/loop || exit 1
+command="$VALGRIND_CMD ./avidmxfinfo --csv avidmxfinfo_loop"
+echo $command
+$command > avidmxfinfo_loop.txt || exit 1
+test `wc -l < avidmxfinfo_loop.txt` -eq 2 || exit 1
+rm -rf avidmxfinfo_loop avidmxfinfo_loop.txt
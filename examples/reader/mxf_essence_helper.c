@@ -29,6 +29,7 @@
 #include <mxf_reader_int.h>
 #include <mxf_essence_helper.h>
 #include <mxf/mxf_avid.h>
+#include <mxf/mxf_aes3.h>
 
 
 /* TODO: check for best effort distinguished values in incomplete header metadata */
@@ -624,67 +625,12 @@ int process_wav_descriptor(MXFMetadataSet* descriptorSet, MXFTrack* track, Essen
 int convert_aes_to_pcm(uint32_t channelCount, uint32_t bitsPerSample, 
     uint8_t* buffer, uint64_t aesDataLen, uint64_t* pcmDataLen)
 {
-    uint16_t audioSampleCount = (buffer[2] << 8) | buffer[1];
-    uint8_t channelValidFlags = buffer[3];
-    uint32_t blockAlign = (bitsPerSample + 7) / 8;
-    uint8_t aes3ChannelCount = (channelValidFlags & 0x01) +
-        ((channelValidFlags >> 1) & 0x01) +
-        ((channelValidFlags >> 2) & 0x01) +
-        ((channelValidFlags >> 3) & 0x01) +
-        ((channelValidFlags >> 4) & 0x01) +
-        ((channelValidFlags >> 5) & 0x01) +
-        ((channelValidFlags >> 6) & 0x01) +
-        ((channelValidFlags >> 7) & 0x01);
-    uint8_t* aesDataPtr;
-    uint8_t* pcmDataPtr;
-    uint16_t sampleNum;
-    uint8_t channel;
-
-    CHK_ORET(channelCount <= aes3ChannelCount);
-    CHK_ORET(blockAlign >= 1 && blockAlign <= 3); /* only 8-bit to 24-bit sample size possible */
-    CHK_ORET(audioSampleCount == (aesDataLen - 4) / (8 * 4)); /* 4 bytes per sample, 8 channels */
+    uint32_t aes3ChannelCount;
     
-    aesDataPtr = &buffer[4];
-    pcmDataPtr = &buffer[0];
-    for (sampleNum = 0; sampleNum < audioSampleCount; sampleNum++)
-    {
-        for (channel = 0; channel < 8; channel++)
-        {
-            /* write audio channel if contains valid audio data */
-            if (channelValidFlags & (0x01 << channel))
-            {
-                /* write PCM word */
-                switch (blockAlign)
-                {
-                    case 1:
-                        pcmDataPtr[0] = ((aesDataPtr[2] & 0xf0 ) >> 4) |
-                            ((aesDataPtr[3] << 4) & 0xff);
-                        break;
-                    case 2:
-                        pcmDataPtr[0] = ((aesDataPtr[1] & 0xf0 ) >> 4) |
-                            ((aesDataPtr[2] << 4) & 0xff);
-                        pcmDataPtr[1] = ((aesDataPtr[2] & 0xf0 ) >> 4) |
-                            ((aesDataPtr[3] << 4) & 0xff);
-                        break;
-                    case 3:
-                        pcmDataPtr[0] = ((aesDataPtr[0] & 0xf0) >> 4) |
-                            ((aesDataPtr[1] << 4) & 0xff);
-                        pcmDataPtr[1] = ((aesDataPtr[1] & 0xf0 ) >> 4) |
-                            ((aesDataPtr[2] << 4) & 0xff);
-                        pcmDataPtr[2] = ((aesDataPtr[2] & 0xf0 ) >> 4) |
-                            ((aesDataPtr[3] << 4) & 0xff);
-                        break;
-                    default:
-                        assert(0);
-                        return 0;
-                }
-                pcmDataPtr += blockAlign;
-            }
-            aesDataPtr += 4 ; /* 4 bytes per sample */
-        }
-    }
-    
-    *pcmDataLen = pcmDataPtr - buffer;
+    /* the conversion is done in-place */
+    CHK_ORET(mxf_convert_aes3_to_pcm(buffer, aesDataLen, (bitsPerSample + 7) / 8, buffer, pcmDataLen,
+        &aes3ChannelCount));
+    CHK_ORET(channelCount <= aes3ChannelCount);
     
     return 1;
 }
@@ -752,6 +698,26 @@ fail:
     return 0;
 }
 
+int copy_frame(MXFReader* reader, MXFReaderListener* listener, int trackIndex, 
+    const uint8_t* data, uint64_t frameSize, uint8_t** buffer, uint64_t* bufferSize)
+{
+    EssenceTrack* essenceTrack;
+    uint8_t* newBuffer = NULL;
+    uint64_t newBufferSize;
+
+    CHK_ORET((essenceTrack = get_essence_track(reader->essenceReader, trackIndex)) != NULL);
+    CHK_ORET(essenceTrack->imageStartOffset == 0 || frameSize > essenceTrack->imageStartOffset);
+    
+    /* get client to allocate a buffer to contain just the image data and copy it across */
+    newBufferSize = frameSize - essenceTrack->imageStartOffset;
+    CHK_ORET(listener->allocate_buffer(listener, trackIndex, &newBuffer, newBufferSize));
+    memcpy(newBuffer, &data[essenceTrack->imageStartOffset], newBufferSize);
+
+    *bufferSize = newBufferSize;
+    *buffer = newBuffer;
+    return 1;
+}
+
 int send_frame(MXFReader* reader, MXFReaderListener* listener, int trackIndex, 
     uint8_t* buffer, uint64_t dataLen)
 {
@@ -785,9 +751,9 @@ int element_is_known_system_item(const mxfKey* key)
         mxf_equals_key(key, &MXF_EE_K(SDTI_CP_System_Pack));
 }
 
-int extract_system_item_info(MXFReader* reader, const mxfKey* key, uint64_t len, mxfPosition position)
+int extract_system_item_info(MXFReader* reader, MXFFile* mxfFile, const mxfKey* key, uint64_t len, 
+    mxfPosition position)
 {
-    MXFFile* mxfFile = reader->mxfFile;
     uint16_t localTag;
     uint16_t localItemLen;
     uint8_t arrayHeader[8];
@@ -36,11 +36,15 @@ int convert_aes_to_pcm(uint32_t channelCount, uint32_t bitsPerSample,
 int accept_frame(MXFReaderListener* listener, int trackIndex);
 int read_frame(MXFReader* reader, MXFReaderListener* listener, int trackIndex, 
     uint64_t frameSize, uint8_t** buffer, uint64_t* bufferSize);
+/* copies the frame from data, which could be part of a content package read in one go */
+int copy_frame(MXFReader* reader, MXFReaderListener* listener, int trackIndex, 
+    const uint8_t* data, uint64_t frameSize, uint8_t** buffer, uint64_t* bufferSize);
 int send_frame(MXFReader* reader, MXFReaderListener* listener, int trackIndex, 
     uint8_t* buffer, uint64_t dataLen);
     
 int element_is_known_system_item(const mxfKey* key);
-int extract_system_item_info(MXFReader* reader, const mxfKey* key, uint64_t len, mxfPosition position);
+int extract_system_item_info(MXFReader* reader, MXFFile* mxfFile, const mxfKey* key, uint64_t len, 
+    mxfPosition position);
 
 
 #endif
@@ -60,8 +60,32 @@ struct _FileIndex
     mxfKey nextKey;
     uint8_t nextLLen;
     uint64_t nextLen;
+    
+    /* content package file position and length for each edit unit, read from a VBE index table.
+       NULL if the file has no (complete) VBE index table */
+    int64_t* cpFilePositions;
+    uint32_t* cpLengths;
+    int64_t numIndexedCPs;
 };
 
+/* index entry stream offsets of a single index table segment */
+typedef struct
+{
+    uint64_t* streamOffsets;
+    uint32_t numStreamOffsets;
+    uint32_t allocStreamOffsets;
+} SegmentEntries;
+
+/* edit unit byte count or stream offset per edit unit for all segments with the index SID */
+typedef struct
+{
+    uint32_t editUnitByteCount;
+    int64_t* streamOffsets; /* -1 if not present in any segment */
+    int64_t numStreamOffsets;
+    int64_t allocStreamOffsets;
+    SegmentEntries segmentEntries;
+} IndexTableData;
+
 
 
 
@@ -356,6 +380,241 @@ static int move_to_next_partition_with_essence(MXFFile* mxfFile, FileIndex* inde
     return 1;    
 }
 
+static void clear_index_table_data(IndexTableData* ixData)
+{
+    SAFE_FREE(&ixData->segmentEntries.streamOffsets);
+    SAFE_FREE(&ixData->streamOffsets);
+    memset(ixData, 0, sizeof(IndexTableData));
+}
+
+static int add_segment_index_entry(void* data, uint32_t numEntries, MXFIndexTableSegment* segment, 
+    int8_t temporalOffset, int8_t keyFrameOffset, uint8_t flags, uint64_t streamOffset, 
+    uint32_t* sliceOffset, mxfRational* posTable)
+{
+    SegmentEntries* entries = (SegmentEntries*)data;
+    
+    /* avoid compiler warnings */
+    (void) segment;
+    (void) temporalOffset;
+    (void) keyFrameOffset;
+    (void) flags;
+    (void) sliceOffset;
+    (void) posTable;
+
+    /* numEntries is the array length, so allocate once for the whole segment */
+    if (entries->allocStreamOffsets < numEntries)
+    {
+        SAFE_FREE(&entries->streamOffsets);
+        entries->allocStreamOffsets = 0;
+        CHK_MALLOC_ARRAY_ORET(entries->streamOffsets, uint64_t, numEntries);
+        entries->allocStreamOffsets = numEntries;
+    }
+    CHK_ORET(entries->numStreamOffsets < numEntries);
+    
+    entries->streamOffsets[entries->numStreamOffsets] = streamOffset;
+    entries->numStreamOffsets++;
+    
+    return 1;
+}
+
+static int add_index_table_segment(IndexTableData* ixData, MXFIndexTableSegment* segment)
+{
+    SegmentEntries* entries = &ixData->segmentEntries;
+    int64_t* newStreamOffsets;
+    int64_t newAlloc;
+    int64_t endPosition;
+    int64_t i;
+    
+    if (segment->editUnitByteCount > 0)
+    {
+        CHK_ORET(ixData->editUnitByteCount == 0 || ixData->editUnitByteCount == segment->editUnitByteCount);
+        ixData->editUnitByteCount = segment->editUnitByteCount;
+        return 1;
+    }
+    
+    CHK_ORET(segment->indexStartPosition >= 0);
+    endPosition = segment->indexStartPosition + entries->numStreamOffsets;
+    
+    if (endPosition > ixData->allocStreamOffsets)
+    {
+        newAlloc = ixData->allocStreamOffsets * 2;
+        if (newAlloc < endPosition)
+        {
+            newAlloc = endPosition;
+        }
+        CHK_MALLOC_ARRAY_ORET(newStreamOffsets, int64_t, newAlloc);
+        if (ixData->numStreamOffsets > 0)
+        {
+            memcpy(newStreamOffsets, ixData->streamOffsets, sizeof(int64_t) * ixData->numStreamOffsets);
+        }
+        SAFE_FREE(&ixData->streamOffsets);
+        ixData->streamOffsets = newStreamOffsets;
+        ixData->allocStreamOffsets = newAlloc;
+    }
+    for (i = ixData->numStreamOffsets; i < segment->indexStartPosition; i++)
+    {
+        ixData->streamOffsets[i] = -1;
+    }
+    
+    /* a segment repeated in a later partition overwrites the same edit units */
+    for (i = 0; i < entries->numStreamOffsets; i++)
+    {
+        ixData->streamOffsets[segment->indexStartPosition + i] = (int64_t)entries->streamOffsets[i];
+    }
+    if (endPosition > ixData->numStreamOffsets)
+    {
+        ixData->numStreamOffsets = endPosition;
+    }
+    
+    return 1;
+}
+
+static int read_index_tables(MXFFile* mxfFile, FileIndex* index, IndexTableData* ixData)
+{
+    PartitionIndexEntry* entry;
+    MXFIndexTableSegment* segment = NULL;
+    MXFListIterator iter;
+    mxfKey key;
+    uint8_t llen;
+    uint64_t len;
+    uint64_t count;
+
+    mxf_initialise_list_iter(&iter, &index->partitionIndex);
+    while (mxf_next_list_iter_element(&iter))
+    {
+        entry = (PartitionIndexEntry*)mxf_get_iter_element(&iter);
+        if (entry->partition->indexSID != index->indexSID || entry->partition->indexByteCount == 0)
+        {
+            continue;
+        }
+        
+        /* seek to just after the partition pack and skip filler and header metadata */
+        CHK_ORET(mxf_file_seek(mxfFile, entry->partitionDataStartPos, SEEK_SET));
+        CHK_ORET(mxf_read_next_nonfiller_kl(mxfFile, &key, &llen, &len));
+        if (entry->partition->headerByteCount > 0)
+        {
+            CHK_ORET(mxf_skip(mxfFile, entry->partition->headerByteCount - mxfKey_extlen - llen));
+            CHK_ORET(mxf_read_kl(mxfFile, &key, &llen, &len));
+        }
+        
+        /* read the index table segments, skipping filler */
+        count = 0;
+        for (;;)
+        {
+            if (mxf_is_index_table_segment(&key))
+            {
+                ixData->segmentEntries.numStreamOffsets = 0;
+                CHK_ORET(mxf_read_index_table_segment_2(mxfFile, len, NULL, NULL,
+                    add_segment_index_entry, &ixData->segmentEntries, &segment));
+                if (segment->indexSID == index->indexSID)
+                {
+                    CHK_OFAIL(add_index_table_segment(ixData, segment));
+                }
+                mxf_free_index_table_segment(&segment);
+            }
+            else
+            {
+                CHK_ORET(mxf_skip(mxfFile, len));
+            }
+            
+            count += mxfKey_extlen + llen + len;
+            if (count >= entry->partition->indexByteCount)
+            {
+                break;
+            }
+            CHK_ORET(mxf_read_kl(mxfFile, &key, &llen, &len));
+        }
+    }
+    
+    return 1;
+    
+fail:
+    mxf_free_index_table_segment(&segment);
+    return 0;
+}
+
+/* convert the VBE essence stream offsets to content package file positions and lengths */
+static int create_cp_table(MXFFile* mxfFile, FileIndex* index, IndexTableData* ixData)
+{
+    PartitionIndexEntry* entry = NULL;
+    PartitionIndexEntry* nextEntry;
+    long numPartitions;
+    long partitionIndex;
+    long i;
+    int64_t streamEnd;
+    int64_t endPos;
+    int64_t cpLen;
+    int64_t pos;
+    
+    CHK_ORET(ixData->numStreamOffsets > 0);
+    
+    CHK_MALLOC_ARRAY_ORET(index->cpFilePositions, int64_t, ixData->numStreamOffsets);
+    CHK_MALLOC_ARRAY_OFAIL(index->cpLengths, uint32_t, ixData->numStreamOffsets);
+    index->numIndexedCPs = ixData->numStreamOffsets;
+    
+    numPartitions = mxf_get_list_length(&index->partitionIndex);
+    partitionIndex = -1;
+    streamEnd = -1;
+    for (pos = 0; pos < ixData->numStreamOffsets; pos++)
+    {
+        CHK_OFAIL(ixData->streamOffsets[pos] >= 0);
+        
+        /* move to the partition containing the content package. 
+           Essence partitions and stream offsets are both in increasing order */
+        while (entry == NULL || ixData->streamOffsets[pos] >= streamEnd)
+        {
+            for (i = partitionIndex + 1; i < numPartitions; i++)
+            {
+                entry = (PartitionIndexEntry*)mxf_get_list_element(&index->partitionIndex, i);
+                if (partition_has_essence(index, entry))
+                {
+                    break;
+                }
+            }
+            CHK_OFAIL(i < numPartitions);
+            partitionIndex = i;
+            
+            /* the essence in the partition ends at the next partition or the end of the file */
+            if (partitionIndex + 1 < numPartitions)
+            {
+                nextEntry = (PartitionIndexEntry*)mxf_get_list_element(&index->partitionIndex, partitionIndex + 1);
+                endPos = nextEntry->partitionStartPos;
+            }
+            else
+            {
+                CHK_OFAIL((endPos = mxf_file_size(mxfFile)) >= 0);
+            }
+            CHK_OFAIL(entry->essenceStartPos >= 0 && endPos >= entry->essenceStartPos);
+            streamEnd = (int64_t)entry->partition->bodyOffset + (endPos - entry->essenceStartPos);
+        }
+        CHK_OFAIL(ixData->streamOffsets[pos] >= (int64_t)entry->partition->bodyOffset);
+        
+        index->cpFilePositions[pos] = entry->essenceStartPos + 
+            (ixData->streamOffsets[pos] - (int64_t)entry->partition->bodyOffset);
+        
+        if (pos + 1 < ixData->numStreamOffsets)
+        {
+            cpLen = ixData->streamOffsets[pos + 1] - ixData->streamOffsets[pos];
+        }
+        else
+        {
+            cpLen = streamEnd - ixData->streamOffsets[pos];
+        }
+        CHK_OFAIL(cpLen > 0 && cpLen <= 0xffffffffLL);
+        index->cpLengths[pos] = (uint32_t)cpLen;
+    }
+    
+    index->indexedDuration = index->numIndexedCPs;
+    
+    return 1;
+    
+fail:
+    SAFE_FREE(&index->cpFilePositions);
+    SAFE_FREE(&index->cpLengths);
+    index->numIndexedCPs = 0;
+    return 0;
+}
+
 static int complete_partition_index(MXFFile* mxfFile, FileIndex* index)
 {
     PartitionIndexEntry* prevEntry = NULL;
@@ -366,6 +625,8 @@ static int complete_partition_index(MXFFile* mxfFile, FileIndex* index)
     uint64_t len;
     long i;
     long numPartitions;
+    IndexTableData ixData;
+    int haveIndexTable = 0;
 
     
     /* get the content package length and first element key */    
@@ -393,6 +654,34 @@ static int complete_partition_index(MXFFile* mxfFile, FileIndex* index)
     }
     while (!mxf_equals_key(&key, &index->startContentPackageKey) && !mxf_is_partition_pack(&key));
 
+    
+    /* read the index table segments if the file is complete. 
+       The content package length is the edit unit byte count for CBE index tables */
+    
+    memset(&ixData, 0, sizeof(IndexTableData));
+    if (index->indexSID != 0 && index->isComplete)
+    {
+        if (!read_index_tables(mxfFile, index, &ixData))
+        {
+            mxf_log_warn("Failed to read index table segments; using the first content package length" 
+                LOG_LOC_FORMAT, LOG_LOC_PARAMS);
+            clear_index_table_data(&ixData);
+        }
+        else if (ixData.editUnitByteCount > 0 && ixData.numStreamOffsets > 0)
+        {
+            mxf_log_warn("Ignoring index table with both CBE and VBE segments" LOG_LOC_FORMAT, LOG_LOC_PARAMS);
+            clear_index_table_data(&ixData);
+        }
+        else if (ixData.editUnitByteCount > 0)
+        {
+            index->contentPackageLen = ixData.editUnitByteCount;
+        }
+        else
+        {
+            haveIndexTable = (ixData.numStreamOffsets > 0);
+        }
+    }
+
         
     /* get the start of essence position, number of content packages and start position for each partition */
     
@@ -404,7 +693,7 @@ static int complete_partition_index(MXFFile* mxfFile, FileIndex* index)
         if (partition_has_essence(index, entry))
         {
             /* position at start of essence, and this fills in the essenceStartPos */
-            CHK_ORET(position_at_start_essence(mxfFile, index, entry));
+            CHK_OFAIL(position_at_start_essence(mxfFile, index, entry));
             
             /* calculate the number of content packages */
             if (i + 1 < numPartitions)
@@ -438,8 +727,25 @@ static int complete_partition_index(MXFFile* mxfFile, FileIndex* index)
         }
         
     }
+
+    
+    /* create the content package table from the VBE index table */
+    
+    if (haveIndexTable)
+    {
+        if (!create_cp_table(mxfFile, index, &ixData))
+        {
+            mxf_log_warn("Failed to map VBE index table to essence partitions; using the first content "
+                "package length" LOG_LOC_FORMAT, LOG_LOC_PARAMS);
+        }
+    }
+    clear_index_table_data(&ixData);
     
     return 1;
+    
+fail:
+    clear_index_table_data(&ixData);
+    return 0;
 }    
 
 
@@ -508,6 +814,8 @@ void free_index(FileIndex** index)
     }
     
     mxf_clear_list(&(*index)->partitionIndex);
+    SAFE_FREE(&(*index)->cpFilePositions);
+    SAFE_FREE(&(*index)->cpLengths);
     
     SAFE_FREE(index);
 }
@@ -527,7 +835,33 @@ int set_position(MXFFile* mxfFile, FileIndex* index, mxfPosition position)
     backup_index(index, &backup);
     CHK_ORET((filePos = mxf_file_tell(mxfFile)) >= 0);
     
-    if (index->currentPosition < 0)
+    if (index->cpFilePositions != NULL)
+    {
+        /* direct lookup in the content package table; position numIndexedCPs is the end of the essence */
+        CHK_OFAIL(position >= 0 && position <= index->numIndexedCPs);
+        
+        if (position == index->currentPosition && position < index->numIndexedCPs &&
+            filePos == index->cpFilePositions[position] + mxfKey_extlen + index->nextLLen)
+        {
+            /* already positioned after the first KL of the content package */
+            return 1;
+        }
+        
+        if (position < index->numIndexedCPs)
+        {
+            CHK_OFAIL(mxf_file_seek(mxfFile, index->cpFilePositions[position], SEEK_SET));
+        }
+        else
+        {
+            CHK_OFAIL(mxf_file_seek(mxfFile, index->cpFilePositions[position - 1] + index->cpLengths[position - 1], 
+                SEEK_SET));
+        }
+        CHK_OFAIL(mxf_read_kl(mxfFile, &key, &llen, &len));
+        set_next_kl(index, &key, llen, len);
+        index->currentPosition = position;
+    }
+    
+    else if (index->currentPosition < 0)
     {
         /* Note: index->currentPartition is assumed to be -1 */
         CHK_OFAIL(move_to_next_partition_with_essence(mxfFile, index));
@@ -691,6 +1025,97 @@ fail:
     return 0;
 }
 
+static PartitionIndexEntry* get_cp_partition(FileIndex* index, mxfPosition position, int includeEnd, long* partitionIndex)
+{
+    PartitionIndexEntry* entry;
+    long numPartitions;
+    long i;
+    
+    numPartitions = mxf_get_list_length(&index->partitionIndex);
+    for (i = 0; i < numPartitions; i++)
+    {
+        entry = (PartitionIndexEntry*)mxf_get_list_element(&index->partitionIndex, i);
+        if (partition_has_essence(index, entry) && entry->essenceStartPos >= 0 &&
+            position >= entry->startPosition &&
+            (entry->numContentPackages < 0 || 
+                position < entry->startPosition + entry->numContentPackages + (includeEnd ? 1 : 0)))
+        {
+            *partitionIndex = i;
+            return entry;
+        }
+    }
+    
+    return NULL;
+}
+
+int get_cp_file_range(FileIndex* index, mxfPosition position, int64_t* filePos, uint64_t* len)
+{
+    PartitionIndexEntry* entry;
+    long partitionIndex;
+    
+    if (position < 0)
+    {
+        return 0;
+    }
+    
+    if (index->cpFilePositions != NULL)
+    {
+        if (position >= index->numIndexedCPs)
+        {
+            return 0;
+        }
+        *filePos = index->cpFilePositions[position];
+        *len = index->cpLengths[position];
+        return 1;
+    }
+    
+    /* the partition layout is only fixed once the complete file has been indexed */
+    if (!index->isComplete || index->contentPackageLen == 0 ||
+        (entry = get_cp_partition(index, position, 0, &partitionIndex)) == NULL)
+    {
+        return 0;
+    }
+    *filePos = entry->essenceStartPos + (position - entry->startPosition) * index->contentPackageLen;
+    *len = index->contentPackageLen;
+    return 1;
+}
+
+int seek_to_cp(MXFFile* mxfFile, FileIndex* index, mxfPosition position)
+{
+    PartitionIndexEntry* entry;
+    long partitionIndex;
+    mxfKey key;
+    uint8_t llen;
+    uint64_t len;
+    
+    if (index->cpFilePositions != NULL)
+    {
+        /* set_position always seeks using the content package table */
+        return set_position(mxfFile, index, position);
+    }
+    
+    /* a position just after the last content package in a partition results in the same state as reading 
+       up to the end of that partition, ie. the next key is a partition pack key */
+    CHK_ORET(index->isComplete && index->contentPackageLen > 0);
+    CHK_ORET((entry = get_cp_partition(index, position, 1, &partitionIndex)) != NULL);
+    CHK_ORET(mxf_file_seek(mxfFile, 
+        entry->essenceStartPos + (position - entry->startPosition) * index->contentPackageLen, SEEK_SET));
+    index->currentPartition = partitionIndex;
+    index->currentPosition = position;
+    
+    if (!mxf_read_kl(mxfFile, &key, &llen, &len))
+    {
+        CHK_ORET(mxf_file_eof(mxfFile));
+        set_next_kl(index, &g_Null_Key, 0, 0);
+    }
+    else
+    {
+        set_next_kl(index, &key, llen, len);
+    }
+    
+    return 1;
+}
+
 /* TODO/NOTE: this only works for a single partition !! */
 int64_t ix_get_last_written_frame_number(MXFFile* mxfFile, FileIndex* index, int64_t duration)
 {
@@ -764,6 +1189,10 @@ void get_start_cp_key(FileIndex* index, mxfKey* key)
 
 uint64_t get_cp_len(FileIndex* index)
 {
+    if (index->cpLengths != NULL && index->currentPosition >= 0 && index->currentPosition < index->numIndexedCPs)
+    {
+        return index->cpLengths[index->currentPosition];
+    }
     return index->contentPackageLen;
 }
 
@@ -31,6 +31,11 @@ int create_index(MXFFile* mxfFile, MXFList* partitions, uint32_t indexSID, uint3
 void free_index(FileIndex** index);
 
 int set_position(MXFFile* mxfFile, FileIndex* index, mxfPosition frameNumber);
+/* returns the file position and length of the content package if the index is complete */
+int get_cp_file_range(FileIndex* index, mxfPosition position, int64_t* filePos, uint64_t* len);
+/* positions the file after the first KL of the content package without relying on the current index state,
+   eg. after content packages were read from a prefetch buffer */
+int seek_to_cp(MXFFile* mxfFile, FileIndex* index, mxfPosition position);
 int64_t ix_get_last_written_frame_number(MXFFile* mxfFile, FileIndex* index, int64_t duration);
 int end_of_essence(FileIndex* index);
 
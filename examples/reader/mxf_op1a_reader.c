@@ -30,6 +30,7 @@
 #include <mxf_op1a_reader.h>
 #include <mxf_essence_helper.h>
 #include <mxf_index_helper.h>
+#include <mxf_prefetch_helper.h>
 #include <mxf/mxf_uu_metadata.h>
 
 
@@ -37,10 +38,14 @@
 /* TODO: check for best effort distinguished values in incomplete header metadata; also, these items could be missing */
 /* TODO: combine multiple audio tracks into 1 multi-channel track (check tracknumber->channel assignments) */
 /* TODO: disable audio in DV essence if audio tracks are present (eg. add option to VLC rawdv demux to disable audio) */
-/* TODO: read index tables; get content package size from index table */
 /* TODO: use body offset to calculate first frame number ? */
 /* TODO: handle default 0 values for partition->previousPartition or partition->footerPartion */ 
 
+
+/* content packages up to this size are read into memory in one go */
+#define MAX_CP_BUFFER_SIZE      (256 * 1024 * 1024)
+
+
 typedef struct
 {
     MXFTrack* track;
@@ -68,6 +73,19 @@ typedef struct
     uint64_t nextLen;
 } NSFileIndex;
 
+typedef struct
+{
+    mxfKey key;
+    uint8_t llen;
+    uint64_t len;
+    uint32_t offset; /* offset of the value in the content package data following the first KL */
+    
+    /* set when the element is read directly into a listener buffer */
+    int trackIndex;
+    uint8_t* frameBuffer;
+    uint32_t frameSize;
+} CPElement;
+
 
 struct _EssenceReaderData
 {
@@ -82,6 +100,19 @@ struct _EssenceReaderData
     
     FileIndex* index;
     NSFileIndex nsIndex; /* file index for non-seekable file */
+    
+    /* content package data following the first KL and the layout of the last content package read */
+    uint8_t* cpBuffer;
+    uint32_t cpBufferSize;
+    CPElement* cpElements;
+    int numCPElements;
+    int cpElementsAllocSize;
+    uint64_t cpElementsLen;
+    MXFIOVector* cpVectors;
+    int cpVectorsAllocSize;
+    
+    /* the file position and next KL in the index are out of date after reading from the prefetcher */
+    int indexNeedsSync;
 };
 
 
@@ -333,7 +364,7 @@ static int process_metadata(MXFReader* reader, MXFPartition* partition)
     CHK_OFAIL(mxf_read_next_nonfiller_kl(mxfFile, &key, &llen, &len));
     CHK_OFAIL(mxf_is_header_metadata(&key));
     CHK_OFAIL(mxf_create_header_metadata(&data->headerMetadata, reader->dataModel));
-    CHK_OFAIL(mxf_read_header_metadata(mxfFile, data->headerMetadata, 
+    CHK_OFAIL(mxf_read_buffered_header_metadata(mxfFile, NULL, data->headerMetadata, 
         partition->headerByteCount, &key, llen, len));
 
     
@@ -650,9 +681,357 @@ static void op1a_close(MXFReader* reader)
     
     mxf_clear_list(&reader->essenceReader->data->partitions);
     
+    SAFE_FREE(&reader->essenceReader->data->cpBuffer);
+    SAFE_FREE(&reader->essenceReader->data->cpElements);
+    SAFE_FREE(&reader->essenceReader->data->cpVectors);
+    
     SAFE_FREE(&reader->essenceReader->data);
 }
 
+static int get_buffer_kl(const uint8_t* buffer, uint32_t size, mxfKey* key, uint8_t* llen, uint64_t* len)
+{
+    uint8_t i;
+    
+    CHK_ORET(size > mxfKey_extlen);
+    memcpy(key, buffer, mxfKey_extlen);
+    
+    *llen = 1;
+    *len = 0;
+    if (buffer[mxfKey_extlen] < 0x80)
+    {
+        *len = buffer[mxfKey_extlen];
+    }
+    else
+    {
+        *llen += buffer[mxfKey_extlen] & 0x7f;
+        CHK_ORET(*llen <= 9 && size >= mxfKey_extlen + (uint32_t)(*llen));
+        for (i = 1; i < *llen; i++)
+        {
+            *len = ((*len) << 8) | buffer[mxfKey_extlen + i];
+        }
+    }
+    
+    return 1;
+}
+
+static int add_cp_element(EssenceReaderData* data, const mxfKey* key, uint8_t llen, uint64_t len, uint32_t offset)
+{
+    CPElement* newElements;
+    CPElement* element;
+    
+    if (data->numCPElements == data->cpElementsAllocSize)
+    {
+        CHK_MALLOC_ARRAY_ORET(newElements, CPElement, data->cpElementsAllocSize + 16);
+        if (data->cpElements != NULL)
+        {
+            memcpy(newElements, data->cpElements, data->numCPElements * sizeof(CPElement));
+            free(data->cpElements);
+        }
+        data->cpElements = newElements;
+        data->cpElementsAllocSize += 16;
+    }
+    
+    element = &data->cpElements[data->numCPElements];
+    memset(element, 0, sizeof(*element));
+    element->key = *key;
+    element->llen = llen;
+    element->len = len;
+    element->offset = offset;
+    element->trackIndex = -1;
+    data->numCPElements++;
+    
+    return 1;
+}
+
+/* parse the element layout from the content package data following the first KL */
+static int parse_cp_elements(EssenceReaderData* data, const uint8_t* cpData, const mxfKey* firstKey, uint8_t firstLLen,
+    uint64_t firstLen, uint64_t cpLen, uint32_t dataLen)
+{
+    mxfKey key;
+    uint8_t llen;
+    uint64_t len;
+    uint32_t offset;
+    
+    data->numCPElements = 0;
+    data->cpElementsLen = 0;
+    
+    CHK_ORET(firstLen <= dataLen);
+    CHK_ORET(add_cp_element(data, firstKey, firstLLen, firstLen, 0));
+    offset = (uint32_t)firstLen;
+    
+    while (offset < dataLen)
+    {
+        CHK_ORET(get_buffer_kl(&cpData[offset], dataLen - offset, &key, &llen, &len));
+        offset += mxfKey_extlen + llen;
+        CHK_ORET(len <= dataLen - offset);
+        CHK_ORET(add_cp_element(data, &key, llen, len, offset));
+        offset += (uint32_t)len;
+    }
+    
+    data->cpElementsLen = cpLen;
+    return 1;
+}
+
+static int cp_layout_is_known(EssenceReaderData* data, const mxfKey* firstKey, uint8_t firstLLen, uint64_t firstLen,
+    uint64_t cpLen)
+{
+    return data->numCPElements > 0 && data->cpElementsLen == cpLen &&
+        mxf_equals_key(&data->cpElements[0].key, firstKey) &&
+        data->cpElements[0].llen == firstLLen && data->cpElements[0].len == firstLen;
+}
+
+static void deallocate_frame_buffers(EssenceReaderData* data, MXFReaderListener* listener, int startIndex)
+{
+    int i;
+    
+    for (i = startIndex; i < data->numCPElements; i++)
+    {
+        if (data->cpElements[i].frameBuffer != NULL)
+        {
+            listener->deallocate_buffer(listener, data->cpElements[i].trackIndex, &data->cpElements[i].frameBuffer);
+            data->cpElements[i].frameBuffer = NULL;
+        }
+    }
+}
+
+static void add_cp_vector(EssenceReaderData* data, int* numVectors, uint8_t* buffer, uint32_t size)
+{
+    if (size > 0)
+    {
+        data->cpVectors[*numVectors].data = buffer;
+        data->cpVectors[*numVectors].size = size;
+        (*numVectors)++;
+    }
+}
+
+/* reads the content package data following the first KL, assuming it has the same layout as the last 
+   content package. Accepted frames are read straight into the listener buffers and the remainder into the 
+   content package buffer. Returns -1 and re-positions the file if the layout is different */
+static int read_cp_vectors(MXFReader* reader, MXFReaderListener* listener, uint32_t dataLen)
+{
+    EssenceReader* essenceReader = reader->essenceReader;
+    EssenceReaderData* data = essenceReader->data;
+    EssenceTrack* essenceTrack;
+    CPElement* element;
+    mxfKey key;
+    uint8_t llen;
+    uint64_t len;
+    uint32_t offset;
+    uint32_t klOffset;
+    int numVectors;
+    int i;
+    
+    if (data->cpVectorsAllocSize < 2 * data->numCPElements + 1)
+    {
+        SAFE_FREE(&data->cpVectors);
+        data->cpVectorsAllocSize = 0;
+        CHK_MALLOC_ARRAY_ORET(data->cpVectors, MXFIOVector, 2 * data->numCPElements + 1);
+        data->cpVectorsAllocSize = 2 * data->numCPElements + 1;
+    }
+    
+    numVectors = 0;
+    offset = 0;
+    for (i = 0; i < data->numCPElements; i++)
+    {
+        element = &data->cpElements[i];
+        element->trackIndex = -1;
+        element->frameBuffer = NULL;
+        
+        if (!mxf_is_gc_essence_element(&element->key) ||
+            !get_essence_track_with_tracknumber(essenceReader, mxf_get_track_number(&element->key), &essenceTrack,
+                &element->trackIndex) ||
+            !accept_frame(listener, element->trackIndex))
+        {
+            continue;
+        }
+        CHK_OFAIL(essenceTrack->imageStartOffset == 0 || element->len > essenceTrack->imageStartOffset);
+        
+        element->frameSize = (uint32_t)(element->len - essenceTrack->imageStartOffset);
+        CHK_OFAIL(listener->allocate_buffer(listener, element->trackIndex, &element->frameBuffer, element->frameSize));
+        
+        add_cp_vector(data, &numVectors, &data->cpBuffer[offset], 
+            element->offset + essenceTrack->imageStartOffset - offset);
+        add_cp_vector(data, &numVectors, element->frameBuffer, element->frameSize);
+        offset = element->offset + (uint32_t)element->len;
+    }
+    add_cp_vector(data, &numVectors, &data->cpBuffer[offset], dataLen - offset);
+    
+    CHK_OFAIL(mxf_file_read_vector(reader->mxfFile, data->cpVectors, numVectors) == dataLen);
+    
+    /* check the element keys and lengths, which were all read into the content package buffer */
+    for (i = 1; i < data->numCPElements; i++)
+    {
+        element = &data->cpElements[i];
+        klOffset = element->offset - mxfKey_extlen - element->llen;
+        if (!get_buffer_kl(&data->cpBuffer[klOffset], dataLen - klOffset, &key, &llen, &len) ||
+            !mxf_equals_key(&key, &element->key) || llen != element->llen || len != element->len)
+        {
+            deallocate_frame_buffers(data, listener, 0);
+            CHK_ORET(mxf_file_seek(reader->mxfFile, -(int64_t)dataLen, SEEK_CUR));
+            return -1;
+        }
+    }
+    
+    return 1;
+    
+fail:
+    deallocate_frame_buffers(data, listener, 0);
+    return 0;
+}
+
+/* passes on the essence elements and extracts the system item info from the content package data following 
+   the first KL. Elements with a frame buffer were read directly into the listener buffer */
+static int process_cp_elements(MXFReader* reader, MXFReaderListener* listener, uint8_t* cpData, uint32_t dataLen,
+    int haveFrameBuffers)
+{
+    EssenceReader* essenceReader = reader->essenceReader;
+    EssenceReaderData* data = essenceReader->data;
+    MXFFile* cpFile = NULL;
+    EssenceTrack* essenceTrack;
+    CPElement* element;
+    uint8_t* buffer;
+    uint64_t bufferSize;
+    int trackIndex;
+    int i = 0;
+    
+    for (i = 0; i < data->numCPElements; i++)
+    {
+        element = &data->cpElements[i];
+        
+        if (element->frameBuffer != NULL)
+        {
+            buffer = element->frameBuffer;
+            element->frameBuffer = NULL;
+            CHK_OFAIL(send_frame(reader, listener, element->trackIndex, buffer, element->frameSize));
+        }
+        else if (!mxf_is_gc_essence_element(&element->key))
+        {
+            continue;
+        }
+        else if (get_essence_track_with_tracknumber(essenceReader, mxf_get_track_number(&element->key), 
+                    &essenceTrack, &trackIndex))
+        {
+            if (!haveFrameBuffers && accept_frame(listener, trackIndex))
+            {
+                CHK_OFAIL(copy_frame(reader, listener, trackIndex, &cpData[element->offset], element->len,
+                    &buffer, &bufferSize));
+                CHK_OFAIL(send_frame(reader, listener, trackIndex, buffer, bufferSize));
+            }
+        }
+        else if (element_is_known_system_item(&element->key))
+        {
+            if (cpFile == NULL)
+            {
+                CHK_OFAIL(mxf_byte_array_wrap_read(cpData, dataLen, &cpFile));
+            }
+            CHK_OFAIL(mxf_file_seek(cpFile, element->offset, SEEK_SET));
+            CHK_OFAIL(extract_system_item_info(reader, cpFile, &element->key, element->len,
+                get_current_position(data->index)));
+        }
+    }
+    
+    mxf_file_close(&cpFile);
+    return 1;
+    
+fail:
+    deallocate_frame_buffers(data, listener, i + 1);
+    mxf_file_close(&cpFile);
+    return 0;
+}
+
+/* reads the content package data following the first KL with a single read and passes each element on 
+   from memory. The file is positioned at the end of the content package */
+static int read_buffered_content_package(MXFReader* reader, MXFReaderListener* listener, const mxfKey* firstKey,
+    uint8_t firstLLen, uint64_t firstLen, uint64_t cpLen)
+{
+    EssenceReaderData* data = reader->essenceReader->data;
+    uint32_t dataLen;
+    int haveFrameBuffers = 0;
+    int result;
+    
+    dataLen = (uint32_t)(cpLen - mxfKey_extlen - firstLLen);
+    
+    if (data->cpBuffer == NULL || data->cpBufferSize < dataLen)
+    {
+        SAFE_FREE(&data->cpBuffer);
+        data->cpBufferSize = 0;
+        CHK_MALLOC_ARRAY_ORET(data->cpBuffer, uint8_t, dataLen);
+        data->cpBufferSize = dataLen;
+    }
+    
+    if (reader->separateTrackBuffers && cp_layout_is_known(data, firstKey, firstLLen, firstLen, cpLen))
+    {
+        CHK_ORET((result = read_cp_vectors(reader, listener, dataLen)) != 0);
+        haveFrameBuffers = (result == 1);
+    }
+    if (!haveFrameBuffers)
+    {
+        CHK_ORET(mxf_file_read(reader->mxfFile, data->cpBuffer, dataLen) == dataLen);
+        CHK_ORET(parse_cp_elements(data, data->cpBuffer, firstKey, firstLLen, firstLen, cpLen, dataLen));
+    }
+    
+    return process_cp_elements(reader, listener, data->cpBuffer, dataLen, haveFrameBuffers);
+}
+
+/* passes on the elements of a content package read by the prefetcher. Returns -1 if the data is not a valid 
+   content package, in which case nothing was passed on */
+static int read_prefetched_content_package(MXFReader* reader, MXFReaderListener* listener, uint8_t* cpData,
+    uint32_t cpLen)
+{
+    EssenceReaderData* data = reader->essenceReader->data;
+    mxfKey key;
+    uint8_t llen;
+    uint64_t len;
+    uint32_t klLen;
+    
+    if (!get_buffer_kl(cpData, cpLen, &key, &llen, &len))
+    {
+        return -1;
+    }
+    klLen = mxfKey_extlen + llen;
+    if (!parse_cp_elements(data, &cpData[klLen], &key, llen, len, cpLen, cpLen - klLen))
+    {
+        return -1;
+    }
+    
+    return process_cp_elements(reader, listener, &cpData[klLen], cpLen - klLen, 0);
+}
+
+/* queues reads for the content packages following the current position */
+static void prefetch_content_packages(MXFReader* reader)
+{
+    FileIndex* index = reader->essenceReader->data->index;
+    mxfPosition position = get_current_position(index);
+    int64_t filePos;
+    uint64_t cpLen;
+    int numSlots;
+    int i;
+    
+    numSlots = get_num_prefetch_slots(reader->prefetcher);
+    for (i = 0; i < numSlots; i++)
+    {
+        if (!get_cp_file_range(index, position + i, &filePos, &cpLen) ||
+            cpLen > MAX_CP_BUFFER_SIZE)
+        {
+            break;
+        }
+        prefetch_cp(reader->prefetcher, position + i, filePos, (uint32_t)cpLen);
+    }
+}
+
+static int sync_index(MXFReader* reader)
+{
+    EssenceReaderData* data = reader->essenceReader->data;
+    
+    if (data->indexNeedsSync)
+    {
+        CHK_ORET(seek_to_cp(reader->mxfFile, data->index, get_current_position(data->index)));
+        data->indexNeedsSync = 0;
+    }
+    
+    return 1;
+}
+
 static int read_content_package(MXFReader* reader, int skip, MXFReaderListener* listener)
 {
     MXFFile* mxfFile = reader->mxfFile;
@@ -674,6 +1053,23 @@ static int read_content_package(MXFReader* reader, int skip, MXFReaderListener*
     
     cpCount = mxfKey_extlen + llen;
     
+    if (!skip && cpLen > cpCount && cpLen - cpCount <= MAX_CP_BUFFER_SIZE)
+    {
+        /* read the rest of the content package in one go */
+        CHK_ORET(read_buffered_content_package(reader, listener, &key, llen, len, cpLen));
+        
+        if (!mxf_read_kl(mxfFile, &key, &llen, &len))
+        {
+            CHK_ORET(mxf_file_eof(mxfFile));
+            set_next_kl(index, &g_Null_Key, 0, 0);
+        }
+        else
+        {
+            set_next_kl(index, &key, llen, len);
+        }
+        return 1;
+    }
+    
     /* process essence elements in content package */
     while (cpCount < cpLen)
     {
@@ -696,7 +1092,7 @@ static int read_content_package(MXFReader* reader, int skip, MXFReaderListener*
             }
             else if (element_is_known_system_item(&key))
             {
-                CHK_ORET(extract_system_item_info(reader, &key, len,
+                CHK_ORET(extract_system_item_info(reader, mxfFile, &key, len,
                     get_current_position(reader->essenceReader->data->index)));
                 cpCount += len;
             }
@@ -780,7 +1176,7 @@ static int ns_read_content_package(MXFReader* reader, int skip, MXFReaderListene
             }
             else if (element_is_known_system_item(&key))
             {
-                CHK_ORET(extract_system_item_info(reader, &key, len, 
+                CHK_ORET(extract_system_item_info(reader, mxfFile, &key, len, 
                     reader->essenceReader->data->nsIndex.currentPosition));
                 cpCount += len;
             }
@@ -832,8 +1228,15 @@ static int op1a_position_at_frame(MXFReader* reader, int64_t frameNumber)
     EssenceReaderData* data = essenceReader->data;
     
     CHK_ORET(mxf_file_is_seekable(mxfFile));
+    CHK_ORET(sync_index(reader));
     CHK_ORET(set_position(mxfFile, data->index, frameNumber));
     
+    if (reader->prefetcher != NULL)
+    {
+        /* prefetching restarts from the new position when the next frame is read */
+        cancel_prefetch(reader->prefetcher);
+    }
+    
     return 1;
 }
 
@@ -857,6 +1260,7 @@ static int op1a_skip_next_frame(MXFReader* reader)
     
     if (mxf_file_is_seekable(mxfFile))
     {
+        CHK_ORET(sync_index(reader));
         if (end_of_essence(data->index))
         {
             return -1;
@@ -893,24 +1297,46 @@ static int op1a_read_next_frame(MXFReader* reader, MXFReaderListener* listener)
     MXFFile* mxfFile = reader->mxfFile;
     EssenceReader* essenceReader = reader->essenceReader;
     EssenceReaderData* data = essenceReader->data;
+    uint8_t* cpData;
+    uint32_t cpLen;
+    int result = -1;
     
     /* set position at start of the current content package */
     
     if (mxf_file_is_seekable(mxfFile))
     {
-        if (end_of_essence(data->index))
+        if (reader->prefetcher != NULL &&
+            get_prefetched_cp(reader->prefetcher, get_current_position(data->index), &cpData, &cpLen))
         {
-            return -1;
+            CHK_ORET((result = read_prefetched_content_package(reader, listener, cpData, cpLen)) != 0);
+            if (result == 1)
+            {
+                data->indexNeedsSync = 1;
+            }
         }
-        CHK_ORET(set_position(mxfFile, data->index, get_current_position(data->index)));
-        if (end_of_essence(data->index))
+        
+        if (result != 1)
         {
-            return -1;
-        }
+            CHK_ORET(sync_index(reader));
+            if (end_of_essence(data->index))
+            {
+                return -1;
+            }
+            CHK_ORET(set_position(mxfFile, data->index, get_current_position(data->index)));
+            if (end_of_essence(data->index))
+            {
+                return -1;
+            }
 
-        CHK_ORET(read_content_package(reader, 0, listener));
+            CHK_ORET(read_content_package(reader, 0, listener));
+        }
 
         increment_current_position(data->index);
+        
+        if (reader->prefetcher != NULL)
+        {
+            prefetch_content_packages(reader);
+        }
     }
     else
     {
@@ -944,6 +1370,30 @@ static int64_t op1a_get_next_frame_number(MXFReader* reader)
     }
 }
 
+static int op1a_enable_prefetch(MXFReader* reader, int numFrames)
+{
+    EssenceReaderData* data = reader->essenceReader->data;
+    mxfKey cpKey;
+    
+    CHK_ORET(sync_index(reader));
+    free_prefetcher(&reader->prefetcher);
+    if (numFrames <= 0)
+    {
+        return 1;
+    }
+    
+    if (reader->filename == NULL || !mxf_file_is_seekable(reader->mxfFile))
+    {
+        mxf_log_warn("Prefetching requires a seekable file opened by name" LOG_LOC_FORMAT, LOG_LOC_PARAMS);
+        return 0;
+    }
+    
+    get_start_cp_key(data->index, &cpKey);
+    CHK_ORET(create_prefetcher(reader->filename, &cpKey, numFrames, &reader->prefetcher));
+    
+    return 1;
+}
+
 static MXFHeaderMetadata* op1a_get_header_metadata(MXFReader* reader)
 {
     return reader->essenceReader->data->headerMetadata;
@@ -1049,6 +1499,7 @@ int op1a_initialise_reader(MXFReader* reader, MXFPartition** headerPartition)
     essenceReader->get_header_metadata = op1a_get_header_metadata;
     essenceReader->have_footer_metadata = op1a_have_footer_metadata;
     essenceReader->set_frame_rate = op1a_set_frame_rate;
+    essenceReader->enable_prefetch = op1a_enable_prefetch;
     
     data = essenceReader->data;
 
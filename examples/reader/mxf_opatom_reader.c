@@ -129,6 +129,36 @@ static uint32_t get_audio_frame_size(EssenceTrack* essenceTrack, int64_t frameNu
     }
 }
 
+/* a non-seekable file is read in a single pass and the bytes following the essence element can't be 
+   skipped back over, so the read stops at the end of the essence element */
+static int ns_end_of_essence(MXFReader* reader, EssenceTrack* essenceTrack)
+{
+    EssenceReaderData* data = reader->essenceReader->data;
+    int64_t filePos;
+    int64_t frameSize;
+    
+    if (mxf_file_is_seekable(reader->mxfFile) || data->essenceDataSize == 0)
+    {
+        return 0;
+    }
+    
+    if (essenceTrack->frameSize < 0)
+    {
+        /* audio frame sequence; Avid MJPEG is not supported for non-seekable files */
+        frameSize = get_audio_frame_size(essenceTrack, data->currentPosition);
+    }
+    else
+    {
+        frameSize = essenceTrack->frameSize;
+    }
+    
+    if ((filePos = mxf_file_tell(reader->mxfFile)) < 0)
+    {
+        return 1;
+    }
+    return (uint64_t)(filePos + frameSize) > data->essenceStartPos + data->essenceDataSize;
+}
+
 static int get_data_def_ul(MXFHeaderMetadata* headerMetadata, MXFMetadataSet* trackSet, mxfUL* dataDefUL)
 {
     CHK_ORET(mxf_uu_get_track_datadef(trackSet, dataDefUL));
@@ -328,6 +358,7 @@ static int process_metadata(MXFReader* reader, MXFPartition* partition)
     mxfUMID sourcePackageUID;
     mxfUMID packageUID;
     uint32_t trackID;
+    MXFSetDef* metaDictSetDef;
 
     
     CHK_ORET(add_track(reader, &track));
@@ -340,10 +371,14 @@ static int process_metadata(MXFReader* reader, MXFPartition* partition)
     track->essenceContainerLabel = *(mxfUL*)mxf_get_list_element(&partition->essenceContainers, 0);
     
     
-    /* load Avid extensions to the data model */
+    /* load Avid extensions to the data model if not already present. The shared Avid data model
+       includes the extensions and is not changed, which allows it to be shared between readers */
     
-    CHK_ORET(mxf_avid_load_extensions(reader->dataModel));
-    CHK_ORET(mxf_finalise_data_model(reader->dataModel));
+    if (!mxf_find_set_def(reader->dataModel, &MXF_SET_K(MetaDictionary), &metaDictSetDef))
+    {
+        CHK_ORET(mxf_avid_load_extensions(reader->dataModel));
+        CHK_ORET(mxf_finalise_data_model(reader->dataModel));
+    }
     
     
     /* create and read the header metadata (filter out meta-dictionary and dictionary except data defs) */
@@ -637,6 +672,11 @@ static int opatom_skip_next_frame(MXFReader* reader)
     
     essenceTrack = get_essence_track(reader->essenceReader, 0);
     
+    if (ns_end_of_essence(reader, essenceTrack))
+    {
+        return -1;
+    }
+    
     /* get file position so we can reset when something fails */
     CHK_ORET((filePos = mxf_file_tell(mxfFile)) >= 0);
     
@@ -685,6 +725,11 @@ static int opatom_read_next_frame(MXFReader* reader, MXFReaderListener* listener
     
     essenceTrack = get_essence_track(reader->essenceReader, 0);
     
+    if (ns_end_of_essence(reader, essenceTrack))
+    {
+        return -1;
+    }
+    
     /* get file position so we can reset when something fails */
     CHK_ORET((filePos = mxf_file_tell(mxfFile)) >= 0);
     
@@ -837,6 +882,7 @@ int opa_initialise_reader(MXFReader* reader, MXFPartition** headerPartition)
     uint8_t llen;
     uint64_t len;
     int64_t filePos;
+    int isAvidIMX;
 
     essenceReader->data = NULL;
     
@@ -870,6 +916,13 @@ int opa_initialise_reader(MXFReader* reader, MXFPartition** headerPartition)
     
     if (mxf_equals_ul(&MXF_EC_L(AvidMJPEGClipWrapped), &get_mxf_track(reader, 0)->essenceContainerLabel))
     {
+        if (!mxf_file_is_seekable(mxfFile))
+        {
+            mxf_log_error("Avid MJPEG files must be seekable because the frame offsets are in the index table "
+                "following the essence" LOG_LOC_FORMAT, LOG_LOC_PARAMS);
+            goto fail;
+        }
+        
         CHK_OFAIL((filePos = mxf_file_tell(mxfFile)) >= 0);
         CHK_OFAIL(read_avid_mjpeg_index_segment(reader));
         CHK_OFAIL(mxf_file_seek(mxfFile, filePos, SEEK_SET));    
@@ -877,12 +930,13 @@ int opa_initialise_reader(MXFReader* reader, MXFPartition** headerPartition)
     
     /* read the Avid IMX's index table edit unit byte count to set the frame size */
     
-    if (mxf_equals_ul(&MXF_EC_L(AvidIMX30_625_50), &get_mxf_track(reader, 0)->essenceContainerLabel) ||
+    isAvidIMX = mxf_equals_ul(&MXF_EC_L(AvidIMX30_625_50), &get_mxf_track(reader, 0)->essenceContainerLabel) ||
         mxf_equals_ul(&MXF_EC_L(AvidIMX40_625_50), &get_mxf_track(reader, 0)->essenceContainerLabel) ||
         mxf_equals_ul(&MXF_EC_L(AvidIMX50_625_50), &get_mxf_track(reader, 0)->essenceContainerLabel) ||
         mxf_equals_ul(&MXF_EC_L(AvidIMX30_525_60), &get_mxf_track(reader, 0)->essenceContainerLabel) ||
         mxf_equals_ul(&MXF_EC_L(AvidIMX40_525_60), &get_mxf_track(reader, 0)->essenceContainerLabel) ||
-        mxf_equals_ul(&MXF_EC_L(AvidIMX50_525_60), &get_mxf_track(reader, 0)->essenceContainerLabel))
+        mxf_equals_ul(&MXF_EC_L(AvidIMX50_525_60), &get_mxf_track(reader, 0)->essenceContainerLabel);
+    if (isAvidIMX && mxf_file_is_seekable(mxfFile))
     {
         CHK_OFAIL((filePos = mxf_file_tell(mxfFile)) >= 0);
         CHK_OFAIL(read_avid_imx_frame_size(reader, &essenceTrack->frameSize));
@@ -904,6 +958,19 @@ int opa_initialise_reader(MXFReader* reader, MXFPartition** headerPartition)
     CHK_OFAIL(mxf_is_gc_essence_element(&key) || mxf_avid_is_essence_element(&key));
 
     data->essenceDataSize = len;
+    
+    /* the index table follows the essence and can't be read from a non-seekable file. The Avid IMX frame 
+       size is instead derived from the essence element size and the track duration */
+    if (isAvidIMX && !mxf_file_is_seekable(mxfFile))
+    {
+        if (essenceTrack->playoutDuration <= 0 || len % (uint64_t)essenceTrack->playoutDuration != 0)
+        {
+            mxf_log_error("Failed to derive the Avid IMX frame size from the essence size and track duration "
+                "in non-seekable file" LOG_LOC_FORMAT, LOG_LOC_PARAMS);
+            goto fail;
+        }
+        essenceTrack->frameSize = (int64_t)(len / (uint64_t)essenceTrack->playoutDuration);
+    }
         
     CHK_OFAIL((filePos = mxf_file_tell(mxfFile)) >= 0);
     data->essenceStartPos = filePos;
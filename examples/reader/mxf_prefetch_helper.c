@@ -0,0 +1,310 @@
+/*
+ * $Id$
+ *
+ * Background read-ahead of content packages
+ *
+ * Copyright (C) 2010  British Broadcasting Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mxf/mxf.h>
+#include <mxf/mxf_thread.h>
+#include <mxf_prefetch_helper.h>
+
+
+typedef enum
+{
+    SLOT_EMPTY = 0,
+    SLOT_QUEUED,
+    SLOT_READING,
+    SLOT_READY
+} SlotState;
+
+typedef struct
+{
+    /* state, position, filePos and size are protected by the mutex. The data is only accessed by the
+       prefetch thread whilst the slot is queued or being read and by the reader once it is ready */
+    SlotState state;
+    mxfPosition position;
+    int64_t filePos;
+    uint32_t size;
+
+    uint8_t* data;
+    uint32_t allocSize;
+} PrefetchSlot;
+
+struct _Prefetcher
+{
+    MXFFile* mxfFile;
+    mxfKey cpKey;
+
+    PrefetchSlot* slots;
+    int numSlots;
+
+    MXFMutex mutex;
+    MXFCondition queueCondition;
+    MXFCondition readCondition;
+    int stopThread;
+
+    MXFThread thread;
+    int haveThread;
+    int haveSync;
+
+    /* only accessed by the reader */
+    int64_t numHits;
+    int64_t numMisses;
+};
+
+
+/* returns the queued slot with the lowest position, ie. the one the reader will need first */
+static PrefetchSlot* get_next_queued_slot(Prefetcher* prefetcher)
+{
+    PrefetchSlot* nextSlot = NULL;
+    int i;
+
+    for (i = 0; i < prefetcher->numSlots; i++)
+    {
+        if (prefetcher->slots[i].state == SLOT_QUEUED &&
+            (nextSlot == NULL || prefetcher->slots[i].position < nextSlot->position))
+        {
+            nextSlot = &prefetcher->slots[i];
+        }
+    }
+
+    return nextSlot;
+}
+
+static int read_slot(Prefetcher* prefetcher, PrefetchSlot* slot)
+{
+    if (slot->data == NULL || slot->allocSize < slot->size)
+    {
+        SAFE_FREE(&slot->data);
+        slot->allocSize = 0;
+        CHK_MALLOC_ARRAY_ORET(slot->data, uint8_t, slot->size);
+        slot->allocSize = slot->size;
+    }
+
+    CHK_ORET(mxf_file_seek(prefetcher->mxfFile, slot->filePos, SEEK_SET));
+    if (mxf_file_read(prefetcher->mxfFile, slot->data, slot->size) != slot->size)
+    {
+        /* the file could be shorter than the index indicated */
+        return 0;
+    }
+
+    return slot->size > mxfKey_extlen && memcmp(slot->data, &prefetcher->cpKey, mxfKey_extlen) == 0;
+}
+
+static void prefetch_thread(void* arg)
+{
+    Prefetcher* prefetcher = (Prefetcher*)arg;
+    PrefetchSlot* slot;
+    int haveData;
+
+    mxf_lock_mutex(&prefetcher->mutex);
+    for (;;)
+    {
+        slot = NULL;
+        while (!prefetcher->stopThread && (slot = get_next_queued_slot(prefetcher)) == NULL)
+        {
+            mxf_wait_condition(&prefetcher->queueCondition, &prefetcher->mutex);
+        }
+        if (prefetcher->stopThread)
+        {
+            break;
+        }
+
+        slot->state = SLOT_READING;
+        mxf_unlock_mutex(&prefetcher->mutex);
+
+        haveData = read_slot(prefetcher, slot);
+
+        mxf_lock_mutex(&prefetcher->mutex);
+        slot->state = (haveData ? SLOT_READY : SLOT_EMPTY);
+        mxf_broadcast_condition(&prefetcher->readCondition);
+    }
+    mxf_unlock_mutex(&prefetcher->mutex);
+}
+
+
+
+int create_prefetcher(const char* filename, const mxfKey* cpKey, int numSlots, Prefetcher** prefetcher)
+{
+    Prefetcher* newPrefetcher = NULL;
+
+    CHK_ORET(numSlots > 0);
+
+    CHK_MALLOC_ORET(newPrefetcher, Prefetcher);
+    memset(newPrefetcher, 0, sizeof(Prefetcher));
+    newPrefetcher->cpKey = *cpKey;
+
+    if (!mxf_disk_file_open_read(filename, &newPrefetcher->mxfFile))
+    {
+        mxf_log_error("Failed to open '%s' for prefetching" LOG_LOC_FORMAT, filename, LOG_LOC_PARAMS);
+        goto fail;
+    }
+
+    CHK_MALLOC_ARRAY_OFAIL(newPrefetcher->slots, PrefetchSlot, numSlots);
+    memset(newPrefetcher->slots, 0, numSlots * sizeof(PrefetchSlot));
+    newPrefetcher->numSlots = numSlots;
+
+    CHK_OFAIL(mxf_init_mutex(&newPrefetcher->mutex));
+    if (!mxf_init_condition(&newPrefetcher->queueCondition))
+    {
+        mxf_destroy_mutex(&newPrefetcher->mutex);
+        goto fail;
+    }
+    if (!mxf_init_condition(&newPrefetcher->readCondition))
+    {
+        mxf_destroy_condition(&newPrefetcher->queueCondition);
+        mxf_destroy_mutex(&newPrefetcher->mutex);
+        goto fail;
+    }
+    newPrefetcher->haveSync = 1;
+
+    CHK_OFAIL(mxf_create_thread(&newPrefetcher->thread, prefetch_thread, newPrefetcher));
+    newPrefetcher->haveThread = 1;
+
+
+    *prefetcher = newPrefetcher;
+    return 1;
+
+fail:
+    free_prefetcher(&newPrefetcher);
+    return 0;
+}
+
+void free_prefetcher(Prefetcher** prefetcher)
+{
+    int i;
+
+    if (*prefetcher == NULL)
+    {
+        return;
+    }
+
+    if ((*prefetcher)->haveThread)
+    {
+        mxf_lock_mutex(&(*prefetcher)->mutex);
+        (*prefetcher)->stopThread = 1;
+        mxf_signal_condition(&(*prefetcher)->queueCondition);
+        mxf_unlock_mutex(&(*prefetcher)->mutex);
+
+        mxf_join_thread(&(*prefetcher)->thread);
+    }
+    if ((*prefetcher)->haveSync)
+    {
+        mxf_destroy_condition(&(*prefetcher)->readCondition);
+        mxf_destroy_condition(&(*prefetcher)->queueCondition);
+        mxf_destroy_mutex(&(*prefetcher)->mutex);
+    }
+
+    mxf_file_close(&(*prefetcher)->mxfFile);
+
+    if ((*prefetcher)->slots != NULL)
+    {
+        for (i = 0; i < (*prefetcher)->numSlots; i++)
+        {
+            SAFE_FREE(&(*prefetcher)->slots[i].data);
+        }
+        SAFE_FREE(&(*prefetcher)->slots);
+    }
+
+    SAFE_FREE(prefetcher);
+}
+
+int get_num_prefetch_slots(Prefetcher* prefetcher)
+{
+    return prefetcher->numSlots;
+}
+
+void prefetch_cp(Prefetcher* prefetcher, mxfPosition position, int64_t filePos, uint32_t size)
+{
+    PrefetchSlot* slot = &prefetcher->slots[position % prefetcher->numSlots];
+
+    mxf_lock_mutex(&prefetcher->mutex);
+    if (slot->state != SLOT_READING && (slot->state == SLOT_EMPTY || slot->position != position))
+    {
+        slot->position = position;
+        slot->filePos = filePos;
+        slot->size = size;
+        slot->state = SLOT_QUEUED;
+        mxf_signal_condition(&prefetcher->queueCondition);
+    }
+    mxf_unlock_mutex(&prefetcher->mutex);
+}
+
+int get_prefetched_cp(Prefetcher* prefetcher, mxfPosition position, uint8_t** data, uint32_t* size)
+{
+    PrefetchSlot* slot = &prefetcher->slots[position % prefetcher->numSlots];
+    int haveData = 0;
+    int isHit = 0;
+
+    mxf_lock_mutex(&prefetcher->mutex);
+    if (slot->position == position)
+    {
+        /* a queued read is next in line because the thread reads the lowest position first */
+        isHit = (slot->state == SLOT_READY);
+        while (slot->position == position && (slot->state == SLOT_QUEUED || slot->state == SLOT_READING))
+        {
+            mxf_wait_condition(&prefetcher->readCondition, &prefetcher->mutex);
+        }
+        if (slot->position == position && slot->state == SLOT_READY)
+        {
+            *data = slot->data;
+            *size = slot->size;
+            haveData = 1;
+        }
+    }
+    mxf_unlock_mutex(&prefetcher->mutex);
+
+    /* a miss is counted if the reader had to wait for the data or read it itself */
+    if (isHit)
+    {
+        prefetcher->numHits++;
+    }
+    else
+    {
+        prefetcher->numMisses++;
+    }
+    return haveData;
+}
+
+void cancel_prefetch(Prefetcher* prefetcher)
+{
+    int i;
+
+    mxf_lock_mutex(&prefetcher->mutex);
+    for (i = 0; i < prefetcher->numSlots; i++)
+    {
+        if (prefetcher->slots[i].state == SLOT_QUEUED)
+        {
+            prefetcher->slots[i].state = SLOT_EMPTY;
+        }
+    }
+    mxf_unlock_mutex(&prefetcher->mutex);
+}
+
+void get_prefetcher_stats(Prefetcher* prefetcher, int64_t* numHits, int64_t* numMisses)
+{
+    *numHits = prefetcher->numHits;
+    *numMisses = prefetcher->numMisses;
+}
+
@@ -0,0 +1,57 @@
+/*
+ * $Id$
+ *
+ * Background read-ahead of content packages
+ *
+ * Copyright (C) 2010  British Broadcasting Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+ 
+#ifndef __MXF_PREFETCH_HELPER_H__
+#define __MXF_PREFETCH_HELPER_H__
+
+
+#include <mxf/mxf.h>
+
+
+typedef struct _Prefetcher Prefetcher;
+
+
+/* the prefetcher reads content packages on a background thread using a separate file handle. A content package 
+   at position is read into slot (position % numSlots) and the read is dropped if it fails or the data does not
+   start with cpKey */
+int create_prefetcher(const char* filename, const mxfKey* cpKey, int numSlots, Prefetcher** prefetcher);
+void free_prefetcher(Prefetcher** prefetcher);
+
+int get_num_prefetch_slots(Prefetcher* prefetcher);
+
+/* queues a read of the content package if its slot is not in use */
+void prefetch_cp(Prefetcher* prefetcher, mxfPosition position, int64_t filePos, uint32_t size);
+
+/* returns 1 if the content package was read, waiting for the read to complete if it is queued or in progress, 
+   and 0 if it was not prefetched. The data remains valid until the next call to prefetch_cp.
+   The request is counted as a hit if the data was available without waiting */
+int get_prefetched_cp(Prefetcher* prefetcher, mxfPosition position, uint8_t** data, uint32_t* size);
+
+/* drops the queued reads that have not been started */
+void cancel_prefetch(Prefetcher* prefetcher);
+
+void get_prefetcher_stats(Prefetcher* prefetcher, int64_t* numHits, int64_t* numMisses);
+
+
+#endif
+
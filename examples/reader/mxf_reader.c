@@ -233,49 +233,18 @@ int format_is_supported(MXFFile* mxfFile)
 
 int open_mxf_reader(const char* filename, MXFReader** reader)
 {
-    MXFDataModel* dataModel = NULL;
-    
-    CHK_OFAIL(mxf_load_data_model(&dataModel));
-    CHK_OFAIL(mxf_finalise_data_model(dataModel));
-    
-    CHK_OFAIL(open_mxf_reader_2(filename, dataModel, reader));
-    (*reader)->ownDataModel = 1; /* the reader will free it when closed */
-    dataModel = NULL;
-    
-    return 1;
-    
-fail:
-    if (dataModel != NULL)
-    {
-        mxf_free_data_model(&dataModel);
-    }
-    return 0;
+    return open_mxf_reader_2(filename, NULL, reader);
 }
 
 int init_mxf_reader(MXFFile** mxfFile, MXFReader** reader)
 {
-    MXFDataModel* dataModel = NULL;
-    
-    CHK_OFAIL(mxf_load_data_model(&dataModel));
-    CHK_OFAIL(mxf_finalise_data_model(dataModel));
-    
-    CHK_OFAIL(init_mxf_reader_2(mxfFile, dataModel, reader));
-    (*reader)->ownDataModel = 1; /* the reader will free it when closed */
-    dataModel = NULL;
-    
-    return 1;
-    
-fail:
-    if (dataModel != NULL)
-    {
-        mxf_free_data_model(&dataModel);
-    }
-    return 0;
+    return init_mxf_reader_2(mxfFile, NULL, reader);
 }
 
 int open_mxf_reader_2(const char* filename, MXFDataModel* dataModel, MXFReader** reader)
 {
     MXFFile* newMXFFile = NULL;
+    MXFReader* newReader = NULL;
 
     if (!mxf_disk_file_open_read(filename, &newMXFFile))
     {
@@ -283,12 +252,18 @@ int open_mxf_reader_2(const char* filename, MXFDataModel* dataModel, MXFReader**
         goto fail;
     }
     
-    CHK_OFAIL(init_mxf_reader_2(&newMXFFile, dataModel, reader));
+    CHK_OFAIL(init_mxf_reader_2(&newMXFFile, dataModel, &newReader));
+    
+    /* the file name allows other file handles to be opened, eg. for prefetching */
+    CHK_MALLOC_ARRAY_OFAIL(newReader->filename, char, strlen(filename) + 1);
+    strcpy(newReader->filename, filename);
     
+    *reader = newReader;
     return 1;
     
 fail:
     mxf_file_close(&newMXFFile);
+    close_mxf_reader(&newReader);
     return 0;
 }
 
@@ -326,6 +301,12 @@ int init_mxf_reader_2(MXFFile** mxfFile, MXFDataModel* dataModel, MXFReader** re
     
     if (opa_is_supported(headerPartition))
     {
+        if (newReader->dataModel == NULL)
+        {
+            CHK_OFAIL(mxf_avid_get_default_data_model(&newReader->dataModel));
+            newReader->ownDataModel = 1;
+        }
+        
         CHK_MALLOC_OFAIL(newReader->essenceReader, EssenceReader);
         memset(newReader->essenceReader, 0, sizeof(EssenceReader));
 
@@ -333,6 +314,12 @@ int init_mxf_reader_2(MXFFile** mxfFile, MXFDataModel* dataModel, MXFReader** re
     }
     else if (op1a_is_supported(headerPartition))
     {
+        if (newReader->dataModel == NULL)
+        {
+            CHK_OFAIL(mxf_get_default_data_model(&newReader->dataModel));
+            newReader->ownDataModel = 1;
+        }
+        
         CHK_MALLOC_OFAIL(newReader->essenceReader, EssenceReader);
         memset(newReader->essenceReader, 0, sizeof(EssenceReader));
 
@@ -371,7 +358,8 @@ void close_mxf_reader(MXFReader** reader)
         return;
     }
     
-    /* close the MXF file */
+    /* stop prefetching and close the MXF file */
+    free_prefetcher(&(*reader)->prefetcher);
     mxf_file_close(&(*reader)->mxfFile);
     
     /* free the essence reader */
@@ -406,6 +394,7 @@ void close_mxf_reader(MXFReader** reader)
     }
     SAFE_FREE(&(*reader)->buffer);
     SAFE_FREE(&(*reader)->archiveCRC32);
+    SAFE_FREE(&(*reader)->filename);
     
     SAFE_FREE(reader);
 }
@@ -480,6 +469,33 @@ int set_frame_rate(MXFReader* reader, const mxfRational* frameRate)
     return reader->essenceReader->set_frame_rate(reader, frameRate);
 }
 
+void set_separate_track_buffers(MXFReader* reader, int enable)
+{
+    reader->separateTrackBuffers = enable;
+}
+
+int enable_prefetch(MXFReader* reader, int numFrames)
+{
+    if (reader->essenceReader->enable_prefetch == NULL)
+    {
+        mxf_log_warn("Prefetching is not supported for this file" LOG_LOC_FORMAT, LOG_LOC_PARAMS);
+        return 0;
+    }
+    
+    return reader->essenceReader->enable_prefetch(reader, numFrames);
+}
+
+int get_prefetch_stats(MXFReader* reader, int64_t* numHits, int64_t* numMisses)
+{
+    if (reader->prefetcher == NULL)
+    {
+        return 0;
+    }
+    
+    get_prefetcher_stats(reader->prefetcher, numHits, numMisses);
+    return 1;
+}
+
 MXFHeaderMetadata* get_header_metadata(MXFReader* reader)
 {
     return reader->essenceReader->get_header_metadata(reader);
@@ -124,8 +124,14 @@ typedef struct
 
 int format_is_supported(MXFFile* mxfFile);
 
+/* the shared default data models are used if dataModel is NULL or not given: the one including the Avid 
+   extensions (mxf_avid_get_default_data_model) for OP-Atom files and the baseline one 
+   (mxf_get_default_data_model) for OP-1A files */
 int open_mxf_reader(const char* filename, MXFReader** reader);
 int open_mxf_reader_2(const char* filename, MXFDataModel* dataModel, MXFReader** reader);
+/* a non-seekable file, eg. standard input wrapped with mxf_stdin_wrap_read, is read in a single forward 
+   pass and frames are returned as they are received. Frames can only be skipped forward and
+   OP-Atom Avid MJPEG files are not supported because their frame offsets follow the essence */
 int init_mxf_reader(MXFFile** mxfFile, MXFReader** reader);
 int init_mxf_reader_2(MXFFile** mxfFile, MXFDataModel* dataModel, MXFReader** reader);
 void close_mxf_reader(MXFReader** reader);
@@ -139,6 +145,20 @@ int get_num_tracks(MXFReader* reader);
 int clip_has_video(MXFReader* reader);
 int set_frame_rate(MXFReader* reader, const mxfRational* frameRate);
 
+/* set to true if the listener's allocate_buffer returns a separate buffer for each track that remains valid 
+   until receive_frame is called for that track. The OP-1A reader can then read a content package into the 
+   listener buffers with a single vectored read (preadv) instead of reading it into an internal buffer and 
+   copying. The default is false */
+void set_separate_track_buffers(MXFReader* reader, int enable);
+
+/* reads the next numFrames content packages on a background thread whilst frames are read sequentially. 
+   Prefetching restarts from the new position after a seek and is disabled if numFrames is 0. It is supported 
+   for complete, seekable OP-1A files opened with open_mxf_reader */
+int enable_prefetch(MXFReader* reader, int numFrames);
+/* the number of frames that were or were not available in the prefetch buffers when read. A miss includes 
+   waiting for a prefetch read to complete. Returns 0 if prefetching is not enabled */
+int get_prefetch_stats(MXFReader* reader, int64_t* numHits, int64_t* numMisses);
+
 MXFHeaderMetadata* get_header_metadata(MXFReader* reader);
 int have_footer_metadata(MXFReader* reader);
 
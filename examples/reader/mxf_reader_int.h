@@ -25,6 +25,7 @@
 
 
 #include <mxf_reader.h>
+#include <mxf_prefetch_helper.h>
 
 
 typedef struct _EssenceReaderData EssenceReaderData;
@@ -66,6 +67,7 @@ typedef struct
     MXFHeaderMetadata* (*get_header_metadata) (MXFReader* reader);
     int (*have_footer_metadata)(MXFReader* reader);
     int (*set_frame_rate)(MXFReader* reader, const mxfRational* frameRate);
+    int (*enable_prefetch)(MXFReader* reader, int numFrames); /* NULL if not supported */
 
     EssenceReaderData* data;
 } EssenceReader;
@@ -98,6 +100,7 @@ typedef struct
 struct _MXFReader
 {
     MXFFile* mxfFile;
+    char* filename; /* NULL if the reader was initialised with a MXFFile */
     MXFClip clip;
     
     int haveReadAFrame; /* is true if a frame has been read and therefore the number of source timecodes is up to date */
@@ -116,6 +119,12 @@ struct _MXFReader
     /* buffer for internal use */
     uint8_t* buffer;
     uint32_t bufferSize;
+    
+    /* the listener allocates a separate buffer for each track */
+    int separateTrackBuffers;
+    
+    /* reads ahead on a background thread; NULL if not enabled */
+    Prefetcher* prefetcher;
 };
 
 
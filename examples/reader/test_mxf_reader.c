@@ -34,6 +34,8 @@
 
 #define INVALID_TIMECODE_HOUR       99
 
+#define MAX_CRC32_TRACKS            17
+
 
 struct _MXFReaderListenerData
 {
@@ -43,6 +45,15 @@ struct _MXFReaderListenerData
     
     uint8_t* buffer;
     uint32_t bufferSize;
+    
+    /* a buffer for each track, see set_separate_track_buffers() */
+    int separateTrackBuffers;
+    uint8_t* trackBuffer[MAX_CRC32_TRACKS];
+    uint32_t trackBufferSize[MAX_CRC32_TRACKS];
+
+    /* CRC-32 of the frames received for the current position, compared with the archive MXF CRC-32s */
+    uint32_t frameCRC32[MAX_CRC32_TRACKS];
+    int haveFrameCRC32[MAX_CRC32_TRACKS];
 };
 
 static void print_timecode(MXFTimecode* timecode)
@@ -70,6 +81,28 @@ static int allocate_buffer(MXFReaderListener* listener, int trackIndex, uint8_t*
 {
     MXFTrack* track;
     
+    if (listener->data->separateTrackBuffers)
+    {
+        if (trackIndex < 0 || trackIndex >= MAX_CRC32_TRACKS)
+        {
+            fprintf(stderr, "Track index %d exceeds maximum for separate track buffers\n", trackIndex);
+            return 0;
+        }
+        if (listener->data->trackBufferSize[trackIndex] < bufferSize)
+        {
+            free(listener->data->trackBuffer[trackIndex]);
+            listener->data->trackBufferSize[trackIndex] = 0;
+            if ((listener->data->trackBuffer[trackIndex] = (uint8_t*)malloc(bufferSize)) == NULL)
+            {
+                fprintf(stderr, "Failed to allocate buffer\n");
+                return 0;
+            }
+            listener->data->trackBufferSize[trackIndex] = bufferSize;
+        }
+        *buffer = listener->data->trackBuffer[trackIndex];
+        return 1;
+    }
+    
     if (listener->data->bufferSize >= bufferSize)
     {
         *buffer = listener->data->buffer;
@@ -103,6 +136,13 @@ static void deallocate_buffer(MXFReaderListener* listener, int trackIndex, uint8
 {
     MXFTrack* track;
     
+    if (listener->data->separateTrackBuffers)
+    {
+        /* the track buffers are re-used and freed at the end */
+        *buffer = NULL;
+        return;
+    }
+    
     assert(*buffer == listener->data->buffer);
 
     track = get_mxf_track(listener->data->input, trackIndex);
@@ -132,6 +172,12 @@ static int receive_frame(MXFReaderListener* listener, int trackIndex, uint8_t* b
         return 0;
     }
     printf("received frame from track index %d with size %d\n", trackIndex, bufferSize);
+
+    if (trackIndex >= 0 && trackIndex < MAX_CRC32_TRACKS)
+    {
+        listener->data->frameCRC32[trackIndex] = mxf_calc_crc32(buffer, bufferSize);
+        listener->data->haveFrameCRC32[trackIndex] = 1;
+    }
         
     if (track->isVideo)
     {
@@ -148,7 +194,8 @@ static int receive_frame(MXFReaderListener* listener, int trackIndex, uint8_t* b
 
 #if defined(DO_TEST1)
 
-static int test1(const char* mxfFilename, MXFTimecode* startTimecode, int sourceTimecodeCount, const char* outFilename)
+static int test1(const char* mxfFilename, MXFTimecode* startTimecode, int sourceTimecodeCount, 
+    int separateTrackBuffers, int numPrefetchFrames, const char* outFilename)
 {
     MXFReader* input;
     MXFClip* clip;
@@ -164,6 +211,9 @@ static int test1(const char* mxfFilename, MXFTimecode* startTimecode, int source
     int count;
     int result;
     uint32_t archiveCRC32;
+    int crc32Mismatch = 0;
+    int64_t numPrefetchHits;
+    int64_t numPrefetchMisses;
     
     memset(&data, 0, sizeof(MXFReaderListenerData));
     listener.data = &data;
@@ -195,6 +245,13 @@ static int test1(const char* mxfFilename, MXFTimecode* startTimecode, int source
         }
     }
     listener.data->input = input;
+    data.separateTrackBuffers = separateTrackBuffers;
+    set_separate_track_buffers(input, separateTrackBuffers);
+    if (numPrefetchFrames > 0 && !enable_prefetch(input, numPrefetchFrames))
+    {
+        fprintf(stderr, "Failed to enable prefetching\n");
+        return 0;
+    }
     
     if ((data.outFile = fopen(outFilename, "wb")) == NULL)
     {
@@ -255,12 +312,21 @@ static int test1(const char* mxfFilename, MXFTimecode* startTimecode, int source
             if (get_archive_crc32(input, i, &archiveCRC32))
             {
                 printf("crc32 %d = 0x%08x\n", i, archiveCRC32);
+                
+                /* the archive CRC-32s are in track order: video followed by the audio tracks */
+                if (i < MAX_CRC32_TRACKS && data.haveFrameCRC32[i] && data.frameCRC32[i] != archiveCRC32)
+                {
+                    fprintf(stderr, "Frame %"PFi64" track %d CRC-32 0x%08x does not match archive CRC-32 0x%08x\n",
+                            frameNumber, i, data.frameCRC32[i], archiveCRC32);
+                    crc32Mismatch = 1;
+                }
             }
             else
             {
                 printf("Failed to get archive crc-32\n");
             }
         }
+        memset(data.haveFrameCRC32, 0, sizeof(data.haveFrameCRC32));
         frameCount++;
     }
     if (clip->duration != -1 && frameCount != clip->duration)
@@ -269,12 +335,27 @@ static int test1(const char* mxfFilename, MXFTimecode* startTimecode, int source
         return 0;
     }
     
+    if (get_prefetch_stats(input, &numPrefetchHits, &numPrefetchMisses))
+    {
+        printf("Prefetch hits = %"PFi64", misses = %"PFi64"\n", numPrefetchHits, numPrefetchMisses);
+    }
+    
     close_mxf_reader(&input);
     fclose(data.outFile);
     if (data.buffer != NULL)
     {
         free(data.buffer);
     }
+    for (i = 0; i < MAX_CRC32_TRACKS; i++)
+    {
+        free(data.trackBuffer[i]);
+    }
+    
+    if (crc32Mismatch)
+    {
+        fprintf(stderr, "1) Frame CRC-32 check failed\n");
+        return 0;
+    }
     
     return 1;
 }
@@ -576,7 +657,9 @@ static int test3(const char* mxfFilename, const char* outFilename)
 
 static void usage(const char* cmd)
 {
-    fprintf(stderr, "Usage: %s [-sp startTimecode (-sc sourceTimecodeCount)] (<mxf filename> | -) <output filename>\n", cmd);
+    fprintf(stderr, "Usage: %s [-sp startTimecode (-sc sourceTimecodeCount)] [-t] [-p frames] (<mxf filename> | -) <output filename>\n", cmd);
+    fprintf(stderr, "  -t: use a separate buffer for each track\n");
+    fprintf(stderr, "  -p: read ahead the given number of frames on a background thread\n");
 }
 
 
@@ -587,6 +670,8 @@ int main(int argc, const char* argv[])
     int cmdlIndex;
     MXFTimecode startTimecode;
     int sourceTimecodeCount = -1;
+    int separateTrackBuffers = 0;
+    int numPrefetchFrames = 0;
     
     startTimecode.hour = INVALID_TIMECODE_HOUR;
 
@@ -631,6 +716,33 @@ int main(int argc, const char* argv[])
             }
             cmdlIndex += 2;
         }
+        else if (!strcmp(argv[cmdlIndex], "-t"))
+        {
+            separateTrackBuffers = 1;
+            cmdlIndex++;
+        }
+        else if (!strcmp(argv[cmdlIndex], "-p"))
+        {
+            if (cmdlIndex >= argc-1)
+            {
+                usage(argv[0]);
+                fprintf(stderr, "Missing -p argument\n");
+                return 1;
+            }
+            if (sscanf(argv[cmdlIndex + 1], "%d", &numPrefetchFrames) < 1 || numPrefetchFrames <= 0)
+            {
+                usage(argv[0]);
+                fprintf(stderr, "Invalid prefetch frame count\n");
+                return 1;
+            }
+            cmdlIndex += 2;
+        }
+        else
+        {
+            usage(argv[0]);
+            fprintf(stderr, "Unknown argument '%s'\n", argv[cmdlIndex]);
+            return 1;
+        }
     }
     
     if (argc - cmdlIndex != 2)
@@ -644,7 +756,8 @@ int main(int argc, const char* argv[])
 
 #if defined(DO_TEST1)
     printf("TEST 1\n");    
-    if (!test1(mxfFilename, &startTimecode, sourceTimecodeCount, outFilename))
+    if (!test1(mxfFilename, &startTimecode, sourceTimecodeCount, separateTrackBuffers, numPrefetchFrames,
+        outFilename))
     {
         return 1;
     }
@@ -0,0 +1,464 @@
+/*
+ * $Id$
+ *
+ * Test seeking in an OP-1A file with a VBE index table
+ *
+ * Copyright (C) 2010  British Broadcasting Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+/*
+ * The test creates a copy of an archive OP-1A file (see ../archive/write) in which every content package is
+ * followed by a KLV fill of a different size and the CBE index table is replaced by a VBE index table in
+ * the footer partition. The video frames are stamped with the frame number. The frames read after seeking
+ * must match the frames read sequentially, which is only possible if the reader uses the content package
+ * positions and lengths from the VBE index table.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mxf_reader.h>
+#include <mxf/mxf_crc32.h>
+
+
+#define MAX_TRACKS          17
+#define MAX_FRAMES          1000
+#define COPY_BUFFER_SIZE    65536
+
+
+struct _MXFReaderListenerData
+{
+    MXFReader* input;
+
+    uint8_t* buffer;
+    uint32_t bufferSize;
+
+    int64_t frameNumber;
+    int stampMismatch;
+
+    uint32_t frameCRC32[MAX_TRACKS];
+    int haveFrameCRC32[MAX_TRACKS];
+};
+
+
+static int copy_bytes(MXFFile* inFile, MXFFile* outFile, uint64_t count)
+{
+    uint8_t buffer[COPY_BUFFER_SIZE];
+    uint32_t numRead;
+
+    while (count > 0)
+    {
+        numRead = (count > COPY_BUFFER_SIZE ? COPY_BUFFER_SIZE : (uint32_t)count);
+        CHK_ORET(mxf_file_read(inFile, buffer, numRead) == numRead);
+        CHK_ORET(mxf_file_write(outFile, buffer, numRead) == numRead);
+        count -= numRead;
+    }
+
+    return 1;
+}
+
+static int is_picture_element(const mxfKey* key)
+{
+    return mxf_is_gc_essence_element(key) && (key->octet12 == 0x05 || key->octet12 == 0x15);
+}
+
+static int create_vbe_file(const char* inFilename, const char* outFilename, int64_t* numFrames)
+{
+    MXFFile* inFile = NULL;
+    MXFFile* outFile = NULL;
+    MXFPartition* inHeaderPartition = NULL;
+    MXFFilePartitions partitions;
+    MXFPartition* headerPartition;
+    MXFPartition* footerPartition;
+    MXFIndexTableSegment* segment = NULL;
+    mxfKey key;
+    mxfKey startKey;
+    uint8_t llen;
+    uint64_t len;
+    int64_t headerStartPos;
+    int64_t essenceStartPos;
+    int64_t filePos;
+    int64_t frameCount;
+
+    mxf_initialise_file_partitions(&partitions);
+
+    CHK_OFAIL(mxf_disk_file_open_read(inFilename, &inFile));
+    CHK_OFAIL(mxf_disk_file_open_new(outFilename, &outFile));
+
+
+    /* read the header partition pack and find the start of the header metadata */
+
+    CHK_OFAIL(mxf_read_header_pp_kl(inFile, &key, &llen, &len));
+    CHK_OFAIL(mxf_read_partition(inFile, &key, &inHeaderPartition));
+    CHK_OFAIL(inHeaderPartition->headerByteCount > 0 && inHeaderPartition->indexByteCount > 0);
+
+    CHK_OFAIL(mxf_read_next_nonfiller_kl(inFile, &key, &llen, &len));
+    CHK_OFAIL((headerStartPos = mxf_file_tell(inFile)) >= 0);
+    headerStartPos -= mxfKey_extlen + llen;
+    CHK_OFAIL(mxf_file_seek(inFile, headerStartPos, SEEK_SET));
+
+
+    /* write the header partition with the header metadata and without the CBE index table segment */
+
+    CHK_OFAIL(mxf_append_new_from_partition(&partitions, inHeaderPartition, &headerPartition));
+    headerPartition->key = inHeaderPartition->key;
+    headerPartition->bodySID = inHeaderPartition->bodySID;
+    headerPartition->headerByteCount = inHeaderPartition->headerByteCount;
+
+    CHK_OFAIL(mxf_write_partition(outFile, headerPartition));
+    CHK_OFAIL(copy_bytes(inFile, outFile, inHeaderPartition->headerByteCount));
+
+
+    /* read the CBE index table segment, which provides the properties for the VBE segment */
+
+    CHK_OFAIL(mxf_read_next_nonfiller_kl(inFile, &key, &llen, &len));
+    CHK_OFAIL(mxf_is_index_table_segment(&key));
+    CHK_OFAIL(mxf_read_index_table_segment(inFile, len, &segment));
+    CHK_OFAIL(segment->editUnitByteCount > 0 && segment->indexEntryArray == NULL);
+
+
+    /* copy the content packages, each followed by a KLV fill of a different size */
+
+    CHK_OFAIL(mxf_file_seek(inFile, headerStartPos + inHeaderPartition->headerByteCount +
+        inHeaderPartition->indexByteCount, SEEK_SET));
+    CHK_OFAIL(mxf_read_next_nonfiller_kl(inFile, &key, &llen, &len));
+    CHK_OFAIL(mxf_is_gc_essence_element(&key));
+    startKey = key;
+
+    CHK_OFAIL((essenceStartPos = mxf_file_tell(outFile)) >= 0);
+
+    segment->editUnitByteCount = 0;
+    frameCount = 0;
+    while (!mxf_is_partition_pack(&key))
+    {
+        CHK_OFAIL(frameCount < MAX_FRAMES);
+
+        CHK_OFAIL((filePos = mxf_file_tell(outFile)) >= 0);
+        CHK_OFAIL(mxf_default_add_index_entry(NULL, 0, segment, 0, 0, 0x80, filePos - essenceStartPos,
+            NULL, NULL));
+
+        do
+        {
+            if (mxf_is_filler(&key))
+            {
+                CHK_OFAIL(mxf_skip(inFile, len));
+            }
+            else if (is_picture_element(&key) && len >= 4)
+            {
+                CHK_OFAIL(mxf_write_kl(outFile, &key, len));
+                CHK_OFAIL(mxf_write_uint32(outFile, (uint32_t)frameCount));
+                CHK_OFAIL(mxf_skip(inFile, 4));
+                CHK_OFAIL(copy_bytes(inFile, outFile, len - 4));
+            }
+            else
+            {
+                CHK_OFAIL(mxf_write_kl(outFile, &key, len));
+                CHK_OFAIL(copy_bytes(inFile, outFile, len));
+            }
+
+            CHK_OFAIL(mxf_read_kl(inFile, &key, &llen, &len));
+        }
+        while (!mxf_equals_key(&key, &startKey) && !mxf_is_partition_pack(&key));
+
+        CHK_OFAIL(mxf_write_fill(outFile, 20 + (uint32_t)(frameCount % 5) * 13));
+
+        frameCount++;
+    }
+    CHK_OFAIL(frameCount > 1);
+
+
+    /* write the footer partition with the VBE index table segment */
+
+    CHK_OFAIL(mxf_append_new_from_partition(&partitions, inHeaderPartition, &footerPartition));
+    footerPartition->key = MXF_PP_K(ClosedComplete, Footer);
+    footerPartition->indexSID = segment->indexSID;
+
+    mxf_generate_uuid(&segment->instanceUID);
+    segment->indexStartPosition = 0;
+    segment->indexDuration = frameCount;
+
+    CHK_OFAIL(mxf_write_partition(outFile, footerPartition));
+    CHK_OFAIL(mxf_mark_index_start(outFile, footerPartition));
+    CHK_OFAIL(mxf_write_index_table_segment(outFile, segment));
+    CHK_OFAIL(mxf_mark_index_end(outFile, footerPartition));
+
+    CHK_OFAIL(mxf_write_rip(outFile, &partitions));
+    CHK_OFAIL(mxf_update_partitions(outFile, &partitions));
+
+
+    mxf_free_index_table_segment(&segment);
+    mxf_free_partition(&inHeaderPartition);
+    mxf_clear_file_partitions(&partitions);
+    mxf_file_close(&inFile);
+    mxf_file_close(&outFile);
+
+    *numFrames = frameCount;
+    return 1;
+
+fail:
+    mxf_free_index_table_segment(&segment);
+    mxf_free_partition(&inHeaderPartition);
+    mxf_clear_file_partitions(&partitions);
+    mxf_file_close(&inFile);
+    mxf_file_close(&outFile);
+    return 0;
+}
+
+
+static int accept_frame(MXFReaderListener* listener, int trackIndex)
+{
+    (void)listener;
+
+    return trackIndex >= 0 && trackIndex < MAX_TRACKS;
+}
+
+static int allocate_buffer(MXFReaderListener* listener, int trackIndex, uint8_t** buffer, uint32_t bufferSize)
+{
+    (void)trackIndex;
+
+    if (listener->data->bufferSize < bufferSize)
+    {
+        free(listener->data->buffer);
+        listener->data->bufferSize = 0;
+        if ((listener->data->buffer = (uint8_t*)malloc(bufferSize)) == NULL)
+        {
+            fprintf(stderr, "Failed to allocate buffer\n");
+            return 0;
+        }
+        listener->data->bufferSize = bufferSize;
+    }
+
+    *buffer = listener->data->buffer;
+    return 1;
+}
+
+static void deallocate_buffer(MXFReaderListener* listener, int trackIndex, uint8_t** buffer)
+{
+    (void)listener;
+    (void)trackIndex;
+
+    /* the buffer is re-used and freed at the end */
+    *buffer = NULL;
+}
+
+static int receive_frame(MXFReaderListener* listener, int trackIndex, uint8_t* buffer, uint32_t bufferSize)
+{
+    MXFTrack* track;
+    uint32_t stamp;
+
+    track = get_mxf_track(listener->data->input, trackIndex);
+    if (track == NULL)
+    {
+        fprintf(stderr, "Received frame from unknown track %d\n", trackIndex);
+        return 0;
+    }
+
+    listener->data->frameCRC32[trackIndex] = mxf_calc_crc32(buffer, bufferSize);
+    listener->data->haveFrameCRC32[trackIndex] = 1;
+
+    /* the video frame starts with the frame number written by create_vbe_file() */
+    if (track->isVideo)
+    {
+        stamp = 0;
+        if (bufferSize >= 4)
+        {
+            stamp = ((uint32_t)buffer[0] << 24) | ((uint32_t)buffer[1] << 16) |
+                ((uint32_t)buffer[2] << 8) | (uint32_t)buffer[3];
+        }
+        if (bufferSize < 4 || stamp != (uint32_t)listener->data->frameNumber)
+        {
+            fprintf(stderr, "Video frame %"PFi64" has frame number stamp %u\n",
+                listener->data->frameNumber, stamp);
+            listener->data->stampMismatch = 1;
+        }
+    }
+
+    return 1;
+}
+
+static int read_frame(MXFReader* input, MXFReaderListener* listener, int64_t frameNumber, int numTracks)
+{
+    int i;
+
+    memset(listener->data->haveFrameCRC32, 0, sizeof(listener->data->haveFrameCRC32));
+    listener->data->frameNumber = frameNumber;
+    listener->data->stampMismatch = 0;
+
+    if (read_next_frame(input, listener) != 1)
+    {
+        fprintf(stderr, "Failed to read frame %"PFi64"\n", frameNumber);
+        return 0;
+    }
+    if (listener->data->stampMismatch)
+    {
+        return 0;
+    }
+    for (i = 0; i < numTracks && i < MAX_TRACKS; i++)
+    {
+        if (!listener->data->haveFrameCRC32[i])
+        {
+            fprintf(stderr, "No data received for track %d in frame %"PFi64"\n", i, frameNumber);
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static int test_seek(const char* filename, int64_t numFrames)
+{
+    MXFReader* input = NULL;
+    MXFReaderListenerData data;
+    MXFReaderListener listener;
+    uint32_t* frameCRC32 = NULL;
+    int64_t* seekOrder = NULL;
+    int64_t frameNumber;
+    int64_t i;
+    int numTracks;
+    int j;
+
+    memset(&data, 0, sizeof(data));
+    memset(&listener, 0, sizeof(listener));
+    listener.data = &data;
+    listener.accept_frame = accept_frame;
+    listener.allocate_buffer = allocate_buffer;
+    listener.deallocate_buffer = deallocate_buffer;
+    listener.receive_frame = receive_frame;
+
+    if (!open_mxf_reader(filename, &input))
+    {
+        fprintf(stderr, "Failed to open MXF reader for '%s'\n", filename);
+        goto fail;
+    }
+    data.input = input;
+
+    if (get_duration(input) != numFrames)
+    {
+        fprintf(stderr, "Duration %"PFi64" does not equal the number of frames written %"PFi64"\n",
+            get_duration(input), numFrames);
+        goto fail;
+    }
+    numTracks = get_num_tracks(input);
+    if (numTracks <= 0 || numTracks > MAX_TRACKS)
+    {
+        fprintf(stderr, "Unexpected number of tracks %d\n", numTracks);
+        goto fail;
+    }
+
+    CHK_MALLOC_ARRAY_OFAIL(frameCRC32, uint32_t, numFrames * numTracks);
+    CHK_MALLOC_ARRAY_OFAIL(seekOrder, int64_t, numFrames * 2);
+
+
+    /* read all frames sequentially */
+
+    for (i = 0; i < numFrames; i++)
+    {
+        if (!read_frame(input, &listener, i, numTracks))
+        {
+            goto fail;
+        }
+        memcpy(&frameCRC32[i * numTracks], data.frameCRC32, sizeof(uint32_t) * numTracks);
+    }
+    if (read_next_frame(input, &listener) != -1)
+    {
+        fprintf(stderr, "Expected end of essence after the last frame\n");
+        goto fail;
+    }
+
+
+    /* seek to each frame in reverse order, then with a stride, and compare with the sequential read */
+
+    for (i = 0; i < numFrames; i++)
+    {
+        seekOrder[i] = numFrames - 1 - i;
+        seekOrder[numFrames + i] = (i * 3) % numFrames;
+    }
+
+    for (i = 0; i < numFrames * 2; i++)
+    {
+        frameNumber = seekOrder[i];
+        if (!position_at_frame(input, frameNumber))
+        {
+            fprintf(stderr, "Failed to position at frame %"PFi64"\n", frameNumber);
+            goto fail;
+        }
+        if (!read_frame(input, &listener, frameNumber, numTracks))
+        {
+            goto fail;
+        }
+        for (j = 0; j < numTracks; j++)
+        {
+            if (data.frameCRC32[j] != frameCRC32[frameNumber * numTracks + j])
+            {
+                fprintf(stderr, "Track %d frame %"PFi64" read after seeking differs from sequential read\n",
+                    j, frameNumber);
+                goto fail;
+            }
+        }
+    }
+
+
+    SAFE_FREE(&frameCRC32);
+    SAFE_FREE(&seekOrder);
+    SAFE_FREE(&data.buffer);
+    close_mxf_reader(&input);
+    return 1;
+
+fail:
+    SAFE_FREE(&frameCRC32);
+    SAFE_FREE(&seekOrder);
+    SAFE_FREE(&data.buffer);
+    if (input != NULL)
+    {
+        close_mxf_reader(&input);
+    }
+    return 0;
+}
+
+
+static void usage(const char* cmd)
+{
+    fprintf(stderr, "Usage: %s <archive mxf input> <vbe mxf output>\n", cmd);
+}
+
+int main(int argc, const char* argv[])
+{
+    int64_t numFrames;
+
+    if (argc != 3)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (!create_vbe_file(argv[1], argv[2], &numFrames))
+    {
+        fprintf(stderr, "Failed to create VBE indexed file '%s' from '%s'\n", argv[2], argv[1]);
+        return 1;
+    }
+
+    if (!test_seek(argv[2], numFrames))
+    {
+        fprintf(stderr, "VBE index seek test failed\n");
+        return 1;
+    }
+
+    printf("Seek and sequential reads matched for %"PFi64" frames\n", numFrames);
+    return 0;
+}
+
@@ -51,6 +51,18 @@ typedef struct
     int frame;
 } Timecode;
 
+typedef int (*input_job_func)(AvidMXFToP2Transfer* transfer, int inputIndex);
+
+typedef struct
+{
+    AvidMXFToP2Transfer* transfer;
+    input_job_func func;
+    const int* inputIndexes;
+    uint32_t numJobs;
+    volatile uint32_t nextJob;
+    volatile uint32_t failed;
+} InputJobs;
+
 
 static const mxfUUID g_mxfIdentProductUID = 
     {0xae, 0x36, 0x89, 0x2c, 0x8e, 0xaf, 0x4c, 0xe4, 0x92, 0x04, 0x0a, 0xf6, 0x7f, 0xa4, 0xfa, 0xd0};    
@@ -74,6 +86,9 @@ static const uint64_t g_p2_fixedBodyPPOffset = 32620;
 /* buffer size must be >= max frame size */
 #define ESSENCE_BUFFER_SIZE     288000
 
+/* essence that is not modified is copied in chunks of this size between progress reports */
+#define ESSENCE_COPY_SIZE       (16 * 1024 * 1024)
+
 
 /* invalid because the registry version, byte8, is 0x01 rather than 0x02, and
    byte14 should be 0x02 when multiple material package tracks are present */
@@ -259,6 +274,75 @@ static void convert_frames_to_timecode(int64_t frameCount, int fps, int dropFram
 }
 
 
+/* sets the output's progress and adds the change to the total progress */
+static void report_progress(AvidMXFToP2Transfer* transfer, P2MXFFile* output, float percentCompleted)
+{
+    mxf_lock_mutex(&transfer->progressMutex);
+    
+    transfer->percentCompleted += percentCompleted - output->percentCompleted;
+    output->percentCompleted = percentCompleted;
+    CALL_PROGRESS();
+    
+    mxf_unlock_mutex(&transfer->progressMutex);
+}
+
+/* runs the job for each input, in the order given, on up to transfer->numThreads threads */
+static void input_jobs_worker(void* arg)
+{
+    InputJobs* jobs = (InputJobs*)arg;
+    uint32_t job;
+    
+    while (!mxf_atomic_load_u32(&jobs->failed))
+    {
+        job = mxf_atomic_add_u32(&jobs->nextJob, 1) - 1;
+        if (job >= jobs->numJobs)
+        {
+            break;
+        }
+        
+        if (!jobs->func(jobs->transfer, jobs->inputIndexes[job]))
+        {
+            mxf_atomic_store_u32(&jobs->failed, 1);
+        }
+    }
+}
+
+static int run_input_jobs(AvidMXFToP2Transfer* transfer, input_job_func func, const int* inputIndexes)
+{
+    InputJobs jobs;
+    MXFThread threads[17];
+    int numThreads = 0;
+    int i;
+    
+    jobs.transfer = transfer;
+    jobs.func = func;
+    jobs.inputIndexes = inputIndexes;
+    jobs.numJobs = transfer->numInputs;
+    jobs.nextJob = 0;
+    jobs.failed = 0;
+    
+    /* the calling thread is also a worker */
+    for (i = 1; i < transfer->numThreads && i < transfer->numInputs; i++)
+    {
+        if (!mxf_create_thread(&threads[numThreads], input_jobs_worker, &jobs))
+        {
+            mxf_log_warn("Failed to create worker thread; continuing with %d threads\n", numThreads + 1);
+            break;
+        }
+        numThreads++;
+    }
+    
+    input_jobs_worker(&jobs);
+    
+    for (i = 0; i < numThreads; i++)
+    {
+        mxf_join_thread(&threads[i]);
+    }
+    
+    return !jobs.failed;
+}
+
+
 static int preprocess_avid_input(AvidMXFToP2Transfer* transfer, int inputFileIndex, int outputFileIndex)
 {
     mxfKey key;
@@ -338,7 +422,6 @@ static int preprocess_avid_input(AvidMXFToP2Transfer* transfer, int inputFileInd
         output->videoLineMap[0] = 23;
         output->videoLineMap[1] = 335;
         mxf_generate_umid(&output->sourcePackageUID);
-        transfer->pictureOutputIndex = outputFileIndex;
     }
     else if (mxf_equals_ul(essenceContainerLabel, &MXF_EC_L(IECDV_25_525_60_ClipWrapped)))
     {
@@ -363,7 +446,6 @@ static int preprocess_avid_input(AvidMXFToP2Transfer* transfer, int inputFileInd
         output->videoLineMap[0] = 23;
         output->videoLineMap[1] = 285;
         mxf_generate_umid(&output->sourcePackageUID);
-        transfer->pictureOutputIndex = outputFileIndex;
     }
     else if (mxf_equals_ul(essenceContainerLabel, &MXF_EC_L(DVBased_25_625_50_ClipWrapped)))
     {
@@ -388,7 +470,6 @@ static int preprocess_avid_input(AvidMXFToP2Transfer* transfer, int inputFileInd
         output->videoLineMap[0] = 23;
         output->videoLineMap[1] = 335;
         mxf_generate_umid(&output->sourcePackageUID);
-        transfer->pictureOutputIndex = outputFileIndex;
     }
     else if (mxf_equals_ul(essenceContainerLabel, &MXF_EC_L(DVBased_25_525_60_ClipWrapped)))
     {
@@ -413,7 +494,6 @@ static int preprocess_avid_input(AvidMXFToP2Transfer* transfer, int inputFileInd
         output->videoLineMap[0] = 23;
         output->videoLineMap[1] = 285;
         mxf_generate_umid(&output->sourcePackageUID);
-        transfer->pictureOutputIndex = outputFileIndex;
     }
     else if (mxf_equals_ul(essenceContainerLabel, &MXF_EC_L(DVBased_50_625_50_ClipWrapped)))
     {
@@ -438,7 +518,6 @@ static int preprocess_avid_input(AvidMXFToP2Transfer* transfer, int inputFileInd
         output->videoLineMap[0] = 23;
         output->videoLineMap[1] = 335;
         mxf_generate_umid(&output->sourcePackageUID);
-        transfer->pictureOutputIndex = outputFileIndex;
     }
     else if (mxf_equals_ul(essenceContainerLabel, &MXF_EC_L(DVBased_50_525_60_ClipWrapped)))
     {
@@ -463,7 +542,6 @@ static int preprocess_avid_input(AvidMXFToP2Transfer* transfer, int inputFileInd
         output->videoLineMap[0] = 23;
         output->videoLineMap[1] = 285;
         mxf_generate_umid(&output->sourcePackageUID);
-        transfer->pictureOutputIndex = outputFileIndex;
     }
     else if (mxf_equals_ul(essenceContainerLabel, &MXF_EC_L(BWFClipWrapped)) ||
         mxf_equals_ul(essenceContainerLabel, &MXF_EC_L(AES3ClipWrapped)))
@@ -676,8 +754,8 @@ static int transfer_to_p2(AvidMXFToP2Transfer* transfer, int inputFileIndex, int
     uint32_t essenceReadSize;
     mxfLength frameCount;
     int i;
-    float percentCompletedStart = transfer->percentCompleted;
     uint64_t totalBytesRead;
+    uint64_t numCopied;
     uint8_t* arrayElement;
 
     AvidMXFFile* input = &transfer->inputs[inputFileIndex];
@@ -981,39 +1059,66 @@ static int transfer_to_p2(AvidMXFToP2Transfer* transfer, int inputFileIndex, int
         &output->essenceElement));
     frameCount = 0;
     totalBytesRead = 0;
-    while (1)
+    
+    if (!output->isPicture || transfer->insertTimecode == NULL)
     {
-        CHK_ORET(mxf_read_essence_element_data(input->mxfFile, input->essenceElement, essenceReadSize,
-            buffer, &numRead));
-            
-        /* insert timecode into DV essence */
-        if (output->isPicture && transfer->insertTimecode != NULL &&
-            numRead == essenceReadSize)
-        {
-            transfer->insertTimecode(buffer, essenceReadSize, 
-                frameCount + transfer->timecodeStart, transfer->dropFrameFlag);
-            frameCount++;
-        }
-
-        if (output->isPicture && numRead > 0 && numRead != essenceReadSize)
+        /* copy the essence unmodified, allowing the system to copy it without passing it through a buffer */
+        if (output->isPicture && mxf_get_essence_element_size(input->essenceElement) % essenceReadSize != 0)
         {
-            mxf_log_warn("Last essence data frame is wrong size %u\n", numRead); 
+            mxf_log_warn("Last essence data frame is wrong size %u\n", 
+                (uint32_t)(mxf_get_essence_element_size(input->essenceElement) % essenceReadSize)); 
         }
         
-        if (numRead > 0)
+        while (1)
         {
-            CHK_ORET(mxf_write_essence_element_data(output->mxfFile, output->essenceElement, buffer, numRead));
+            CHK_ORET(mxf_copy_essence_element_data(input->mxfFile, input->essenceElement, output->mxfFile, 
+                output->essenceElement, ESSENCE_COPY_SIZE, &numCopied));
+            
+            /* report progress */
+            totalBytesRead += numCopied;
+            report_progress(transfer, output, 
+                output->percentCompletedContribution * (float)((double)totalBytesRead / output->essenceBytesLength)); 
+            
+            if (numCopied < ESSENCE_COPY_SIZE)
+            {
+                break;
+            }
         }
-        
-        /* report progress */
-        totalBytesRead += numRead;
-        transfer->percentCompleted = percentCompletedStart + 
-            output->percentCompletedContribution * (float)((double)totalBytesRead / output->essenceBytesLength); 
-        CALL_PROGRESS();
-        
-        if (numRead < essenceReadSize)
+    }
+    else
+    {
+        while (1)
         {
-            break;
+            CHK_ORET(mxf_read_essence_element_data(input->mxfFile, input->essenceElement, essenceReadSize,
+                buffer, &numRead));
+                
+            /* insert timecode into DV essence */
+            if (numRead == essenceReadSize)
+            {
+                transfer->insertTimecode(buffer, essenceReadSize, 
+                    frameCount + transfer->timecodeStart, transfer->dropFrameFlag);
+                frameCount++;
+            }
+    
+            if (numRead > 0 && numRead != essenceReadSize)
+            {
+                mxf_log_warn("Last essence data frame is wrong size %u\n", numRead); 
+            }
+            
+            if (numRead > 0)
+            {
+                CHK_ORET(mxf_write_essence_element_data(output->mxfFile, output->essenceElement, buffer, numRead));
+            }
+            
+            /* report progress */
+            totalBytesRead += numRead;
+            report_progress(transfer, output, 
+                output->percentCompletedContribution * (float)((double)totalBytesRead / output->essenceBytesLength)); 
+            
+            if (numRead < essenceReadSize)
+            {
+                break;
+            }
         }
     }
     CHK_ORET(mxf_finalize_essence_element_write(output->mxfFile, output->essenceElement));
@@ -1062,6 +1167,21 @@ static int transfer_to_p2(AvidMXFToP2Transfer* transfer, int inputFileIndex, int
     return 1;    
 }
 
+static int preprocess_input_job(AvidMXFToP2Transfer* transfer, int inputIndex)
+{
+    int result;
+    
+    result = preprocess_avid_input(transfer, inputIndex, inputIndex);
+    close_input_file(&transfer->inputs[inputIndex]);
+    
+    return result;
+}
+
+static int transfer_input_job(AvidMXFToP2Transfer* transfer, int inputIndex)
+{
+    return transfer_to_p2(transfer, inputIndex, inputIndex);
+}
+
 
 static int write_icon_bmp(AvidMXFToP2Transfer* transfer)
 {
@@ -1495,24 +1615,37 @@ int prepare_transfer(char* inputFilenames[17], int numInputs,
     int64_t timecodeStart, int dropFrameFlag,
     progress_callback progress, insert_timecode_callback insertTimecode, 
     AvidMXFToP2Transfer** transfer)
+{
+    return prepare_threaded_transfer(inputFilenames, numInputs, 1, timecodeStart, dropFrameFlag, 
+        progress, insertTimecode, transfer);
+}
+
+int prepare_threaded_transfer(char* inputFilenames[17], int numInputs, int numThreads,
+    int64_t timecodeStart, int dropFrameFlag,
+    progress_callback progress, insert_timecode_callback insertTimecode, 
+    AvidMXFToP2Transfer** transfer)
 {
     AvidMXFToP2Transfer* newTransfer;
+    int inputIndexes[17];
     uint32_t audioTrackNumber;
     int i;
     
     CHK_MALLOC_ORET(newTransfer, AvidMXFToP2Transfer);
     memset(newTransfer, 0, sizeof(AvidMXFToP2Transfer));
     
+    newTransfer->numThreads = numThreads;
     newTransfer->insertTimecode = insertTimecode;
     newTransfer->progress = progress;
     newTransfer->timecodeStart = timecodeStart;
     newTransfer->dropFrameFlag = dropFrameFlag;
     newTransfer->pictureOutputIndex = -1;
+    
+    CHK_OFAIL(mxf_init_mutex(&newTransfer->progressMutex));
+    newTransfer->haveProgressMutex = 1;
 
     mxf_generate_umid(&newTransfer->globalClipID);
     
     /* process the input files extracting information */
-    audioTrackNumber = 1;
     for (i = 0; i < numInputs; i++)
     {
         CHK_OFAIL(initialise_input_file(&newTransfer->inputs[i]));
@@ -1520,10 +1653,16 @@ int prepare_transfer(char* inputFilenames[17], int numInputs,
         newTransfer->numInputs++;
         
         CHK_OFAIL(open_input_file(inputFilenames[i], &newTransfer->inputs[i]));
-        
-        CHK_OFAIL(preprocess_avid_input(newTransfer, i, i));
+        inputIndexes[i] = i;
+    }
+    CHK_OFAIL(run_input_jobs(newTransfer, preprocess_input_job, inputIndexes));
+    
+    audioTrackNumber = 1;
+    for (i = 0; i < numInputs; i++)
+    {
         if (newTransfer->outputs[i].isPicture)
         {
+            newTransfer->pictureOutputIndex = i;
             newTransfer->outputs[i].materialTrackNumber = 1;
             newTransfer->outputs[i].materialTrackID = g_p2_timecodeTrackID + 1;
         }
@@ -1533,8 +1672,6 @@ int prepare_transfer(char* inputFilenames[17], int numInputs,
             newTransfer->outputs[i].materialTrackID = g_p2_timecodeTrackID + 2 + audioTrackNumber - 1;
             audioTrackNumber++;
         }
-        
-        close_input_file(&newTransfer->inputs[i]);
     }
     
     /* set clip parameters */    
@@ -1565,9 +1702,10 @@ fail:
 
 int transfer_avid_mxf_to_p2(const char* p2path, AvidMXFToP2Transfer* transfer, int* isComplete)
 {
-    int i;
+    int i, j;
     char outputFilename[FILENAME_MAX];
     uint64_t totalBytes; 
+    int inputIndexes[17];
     
     transfer->percentCompleted = 0.0f;
     transfer->lastCallPercentCompleted = -6.0f;
@@ -1583,6 +1721,7 @@ int transfer_avid_mxf_to_p2(const char* p2path, AvidMXFToP2Transfer* transfer, i
         /* 95% is essence data, 5% is other stuff */
         transfer->outputs[i].percentCompletedContribution = (float)
             (95 * (double)transfer->outputs[i].essenceBytesLength / totalBytes);
+        transfer->outputs[i].percentCompleted = 0.0f;
     }
     
     
@@ -1597,7 +1736,7 @@ int transfer_avid_mxf_to_p2(const char* p2path, AvidMXFToP2Transfer* transfer, i
     mxf_get_timestamp_now(&transfer->now);
     
     
-    /* create the output file and transfer the essence */    
+    /* create the output files */    
     for (i = 0; i < transfer->numInputs; i++)
     {
         if (transfer->outputs[i].isPicture)
@@ -1619,10 +1758,21 @@ int transfer_avid_mxf_to_p2(const char* p2path, AvidMXFToP2Transfer* transfer, i
 
         CHK_OFAIL(open_input_file(NULL, &transfer->inputs[i]));
         CHK_OFAIL(open_output_file(outputFilename, &transfer->outputs[i]));
-
-        CHK_OFAIL(transfer_to_p2(transfer, i, i));
-        CALL_PROGRESS();
+        
+        /* the inputs with the most essence data are transferred first so that the workers 
+           transfer the smaller inputs alongside them rather than after */
+        j = i;
+        while (j > 0 && transfer->outputs[inputIndexes[j - 1]].essenceBytesLength < 
+            transfer->outputs[i].essenceBytesLength)
+        {
+            inputIndexes[j] = inputIndexes[j - 1];
+            j--;
+        }
+        inputIndexes[j] = i;
     }
+    
+    /* transfer the essence */
+    CHK_OFAIL(run_input_jobs(transfer, transfer_input_job, inputIndexes));
 
     /* write the BMP icon */
     CHK_OFAIL(write_icon_bmp(transfer));
@@ -1666,6 +1816,11 @@ void free_transfer(AvidMXFToP2Transfer** transfer)
         clear_output_file(&(*transfer)->outputs[i]);
     }
     
+    if ((*transfer)->haveProgressMutex)
+    {
+        mxf_destroy_mutex(&(*transfer)->progressMutex);
+    }
+    
     SAFE_FREE(transfer);
 }
 
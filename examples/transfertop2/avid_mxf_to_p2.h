@@ -33,8 +33,10 @@ extern "C"
 #include <mxf/mxf.h>
 #include <mxf/mxf_avid.h>
 #include <mxf/mxf_p2.h>
+#include <mxf/mxf_thread.h>
 
 
+/* called from the worker threads when the transfer uses more than 1 thread; calls are not concurrent */
 typedef void (*progress_callback) (float percentCompleted);
     
 typedef int (*insert_timecode_callback) (uint8_t* frame, uint32_t frameSize, 
@@ -137,6 +139,7 @@ typedef struct
     
     uint64_t essenceBytesLength;
     float percentCompletedContribution;
+    float percentCompleted;
 } P2MXFFile;
 
 
@@ -147,6 +150,7 @@ typedef struct
     AvidMXFFile inputs[17];
     P2MXFFile outputs[17];
     int numInputs;
+    int numThreads;
     
     insert_timecode_callback insertTimecode;
     progress_callback progress;
@@ -171,6 +175,8 @@ typedef struct
     /* progress % */
     float percentCompleted;
     float lastCallPercentCompleted;
+    MXFMutex progressMutex;
+    int haveProgressMutex;
     
 } AvidMXFToP2Transfer;
 
@@ -181,6 +187,13 @@ int prepare_transfer(char* inputFilenames[17], int numInputs,
     progress_callback progress, insert_timecode_callback insertTimecode, 
     AvidMXFToP2Transfer** transfer);
 
+/* as prepare_transfer(), but the inputs are processed by up to numThreads threads (including the 
+   calling thread) in prepare_threaded_transfer() and transfer_avid_mxf_to_p2() */
+int prepare_threaded_transfer(char* inputFilenames[17], int numInputs, int numThreads,
+    int64_t timecodeStart, int dropFrameFlag,
+    progress_callback progress, insert_timecode_callback insertTimecode, 
+    AvidMXFToP2Transfer** transfer);
+
 int transfer_avid_mxf_to_p2(const char* p2path, AvidMXFToP2Transfer* transfer, int* isComplete);
 
 void free_transfer(AvidMXFToP2Transfer** transfer);
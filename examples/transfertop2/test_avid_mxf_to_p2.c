@@ -30,8 +30,9 @@
 
 void usage(const char* cmd)
 {
-    fprintf(stderr, "%s -r p2path (-i filename)+\n", cmd);
+    fprintf(stderr, "%s [-t num] -r p2path (-i filename)+\n", cmd);
     fprintf(stderr, "\n");
+    fprintf(stderr, "    -t num           number of threads used to process the inputs (default 1)\n");
     fprintf(stderr, "    -r p2path        directory path to the P2 card root directory\n");
     fprintf(stderr, "    -i filename      input MXF filename\n");
     fprintf(stderr, "\n");
@@ -45,13 +46,30 @@ int main(int argc, const char* argv[])
     int cmdlIndex;
     AvidMXFToP2Transfer* transfer = NULL;
     int isComplete;
+    int numThreads = 1;
     int i;
 
     inputIndex = 0;
     cmdlIndex = 1;
     while (cmdlIndex < argc)
     {
-        if (!strcmp(argv[cmdlIndex], "-r"))
+        if (!strcmp(argv[cmdlIndex], "-t"))
+        {
+            if (cmdlIndex >= argc-1)
+            {
+                usage(argv[0]);
+                fprintf(stderr, "Missing -t argument\n");
+                return 1;
+            }
+            if (sscanf(argv[cmdlIndex + 1], "%d", &numThreads) != 1 || numThreads < 1)
+            {
+                usage(argv[0]);
+                fprintf(stderr, "Invalid -t argument '%s'\n", argv[cmdlIndex + 1]);
+                return 1;
+            }
+            cmdlIndex += 2;
+        }
+        else if (!strcmp(argv[cmdlIndex], "-r"))
         {
             if (cmdlIndex >= argc-1)
             {
@@ -105,10 +123,10 @@ int main(int argc, const char* argv[])
         goto fail;
     }
 
-    if (!prepare_transfer(inputFilenames, inputIndex, 900000, 0, 
+    if (!prepare_threaded_transfer(inputFilenames, inputIndex, numThreads, 900000, 0, 
         NULL, NULL, &transfer))
     {
-        fprintf(stderr, "prepare_transfer failed\n");
+        fprintf(stderr, "prepare_threaded_transfer failed\n");
         goto fail;
     }
     
@@ -37,6 +37,9 @@
 
 #define MAX_USER_COMMENT_TAGS   64
 
+/* number of write requests queued for each track when using --threads */
+#define DEFAULT_THREAD_QUEUE_SIZE   8
+
 
 #define DV_DIF_BLOCK_SIZE           80
 #define DV_DIF_SEQUENCE_SIZE        (150 * DV_DIF_BLOCK_SIZE)
@@ -882,6 +885,8 @@ static void usage(const char* cmd)
     fprintf(stderr, "  --film23.976               use framerate of 23.976 (24000/1001) instead of default 25fps\n");
     fprintf(stderr, "  --legacy                   use legacy DataDefs, for DV essence use legacy descriptor properties\n");
     fprintf(stderr, "  --legacy-umid              use the legacy UMID generation method (e.g. for Pro Tools v5.3.1)\n");
+    fprintf(stderr, "  --threads                  write each track using a separate thread\n");
+    fprintf(stderr, "  --async-write              write the files using background write-behind threads\n");
     fprintf(stderr, "  --aspect <ratio>           video aspect ratio x:y. Default is DV file aspect ratio or 4:3\n");
     fprintf(stderr, "  --comment <string>         add 'Comments' user comment to the MaterialPackage\n");
     fprintf(stderr, "  --desc <string>            add 'Descript' user comment to the MaterialPackage\n");
@@ -966,6 +971,8 @@ int main(int argc, const char* argv[])
     int done = 0;
     int useLegacy = 0;
     int useLegacyUMID = 0;
+    uint32_t threadQueueSize = 0;
+    int asyncWrite = 0;
     size_t numRead;
     uint16_t numAudioChannels;
     int haveImage;
@@ -1076,6 +1083,16 @@ int main(int argc, const char* argv[])
             useLegacyUMID = 1;
             cmdlnIndex++;
         }
+        else if (strcmp(argv[cmdlnIndex], "--threads") == 0)
+        {
+            threadQueueSize = DEFAULT_THREAD_QUEUE_SIZE;
+            cmdlnIndex++;
+        }
+        else if (strcmp(argv[cmdlnIndex], "--async-write") == 0)
+        {
+            asyncWrite = 1;
+            cmdlnIndex++;
+        }
         else if (strcmp(argv[cmdlnIndex], "--aspect") == 0)
         {
             int result;
@@ -2290,8 +2307,8 @@ int main(int argc, const char* argv[])
     
     /* create the clip writer */
     
-    if (!create_clip_writer(projectName, isPAL ? PAL_25i : NTSC_30i, videoSampleRate, 0, useLegacy, packageDefinitions,
-        &clipWriter))
+    if (!create_clip_writer(projectName, isPAL ? PAL_25i : NTSC_30i, videoSampleRate, 0, useLegacy, threadQueueSize,
+        asyncWrite, packageDefinitions, &clipWriter))
     {
         fprintf(stderr, "Failed to create Avid MXF clip writer\n");
         goto fail;
@@ -50,4 +50,40 @@ do
 	$command || exit 1
 done
 
+# write the tracks using worker threads
+for format in IMX50 unc
+do
+	command="$VALGRIND_CMD ./writeavidmxf --threads --prefix test_${format}_threads --$format essence.dat --pcm essence.dat --pcm essence.dat"
+	echo $command
+	$command || exit 1
+done
+
+# write the files through the async write-behind file and check that the result equals the
+# synchronous output. The header metadata and the footer contain generated identifiers and
+# so only the sizes and the body partition with the essence (offset 0x40020) up to the
+# footer are compared
+for format in IMX50 unc
+do
+	command="$VALGRIND_CMD ./writeavidmxf --async-write --prefix test_${format}_async --$format essence.dat --pcm essence.dat"
+	echo $command
+	$command || exit 1
+
+	for track in v1 a1
+	do
+		size=`wc -c < test_${format}_${track}.mxf`
+		asyncSize=`wc -c < test_${format}_async_${track}.mxf`
+		if [ $size -ne $asyncSize ] ; then
+			echo "test_${format}_async_${track}.mxf size $asyncSize differs from $size"
+			exit 1
+		fi
+		bodySize=`expr $size - 262176 - 1024`
+		sum=`tail -c +262177 test_${format}_${track}.mxf | head -c $bodySize | cksum`
+		asyncSum=`tail -c +262177 test_${format}_async_${track}.mxf | head -c $bodySize | cksum`
+		if [ "$sum" != "$asyncSum" ] ; then
+			echo "test_${format}_async_${track}.mxf body differs from test_${format}_${track}.mxf"
+			exit 1
+		fi
+	done
+done
+
 rm -f essence.dat
@@ -27,6 +27,8 @@
 
 #include <mxf/mxf.h>
 #include <mxf/mxf_avid.h>
+#include <mxf/mxf_thread.h>
+#include <mxf/mxf_async_file.h>
 #include <write_avid_mxf.h>
 
 
@@ -55,10 +57,31 @@ typedef struct
     uint32_t materialTrackID;
 } TrackDurationItem;
 
+typedef enum
+{
+    WRITE_SAMPLES_REQUEST,
+    START_WRITE_SAMPLES_REQUEST,
+    WRITE_SAMPLE_DATA_REQUEST,
+    END_WRITE_SAMPLES_REQUEST
+} WriteRequestType;
+
+typedef struct
+{
+    WriteRequestType type;
+    uint32_t numSamples;
+    uint8_t* data;
+    uint32_t size;
+    uint32_t allocSize;
+} WriteRequest;
+
+typedef struct TrackWorker TrackWorker;
+
 typedef struct  
 {
     char* filename;
     MXFFile* mxfFile;
+    /* set if mxfFile is the async write-behind wrapper of the disk file */
+    MXFAsyncFile* asyncFile;
     
     EssenceType essenceType;
     
@@ -172,6 +195,9 @@ typedef struct
     
     /* container duration item that are created when writing is completed */
     MXFMetadataSet* descriptorSet;
+    
+    /* writes the samples on a separate thread if not NULL */
+    TrackWorker* worker;
 } TrackWriter;
 
 struct _AvidClipWriter
@@ -183,6 +209,7 @@ struct _AvidClipWriter
     ProjectFormat projectFormat;
     int dropFrameFlag;
     int useLegacy;
+    int asyncWrite;
     mxfRational projectEditRate;
     
     uint8_t dropFrameTimecode;
@@ -194,6 +221,29 @@ struct _AvidClipWriter
     mxfUTF16Char* wTmpString2;
 };
 
+struct TrackWorker
+{
+    AvidClipWriter* clipWriter;
+    TrackWriter* writer;
+
+    WriteRequest* requests;
+    uint32_t numRequests;
+
+    /* protected by the mutex: the queue starts at writeIndex and the request at writeIndex
+       stays queued until the worker thread has processed it */
+    MXFMutex mutex;
+    MXFCondition dataCondition;
+    MXFCondition spaceCondition;
+    uint32_t writeIndex;
+    uint32_t numQueued;
+    int stopThread;
+    int writeFailed;
+
+    MXFThread thread;
+    int haveThread;
+    int haveSync;
+};
+
 
 /* AVID RGB values matching color names defined in enum AvidRGBColor */
 static const RGBColor g_rgbColors[] =
@@ -1152,6 +1202,13 @@ static int complete_track(AvidClipWriter* clipWriter, TrackWriter* writer, Packa
     CHK_ORET(mxf_update_partitions(writer->mxfFile, writer->partitions));
 
     
+    /* check that the queued data has been written */
+    if (writer->asyncFile != NULL)
+    {
+        CHK_ORET(mxf_async_file_flush(writer->asyncFile));
+    }
+
+    
     return 1;
 }
 
@@ -2105,6 +2162,11 @@ static int create_track_writer(AvidClipWriter* clipWriter, PackageDefinitions* p
     
     CHK_OFAIL(mxf_create_file_partitions(&newTrackWriter->partitions));
     CHK_OFAIL(mxf_disk_file_open_new(newTrackWriter->filename, &newTrackWriter->mxfFile));
+    if (clipWriter->asyncWrite)
+    {
+        CHK_OFAIL(mxf_async_file_wrap(newTrackWriter->mxfFile, 0, 0, &newTrackWriter->asyncFile));
+        newTrackWriter->mxfFile = mxf_async_file_get_file(newTrackWriter->asyncFile);
+    }
     
     
     /* set the minimum llen - Avid uses llen=9 everywhere */
@@ -2186,53 +2248,9 @@ fail:
 
 
 
-int create_clip_writer(const char* projectName, ProjectFormat projectFormat,
-    mxfRational projectEditRate, int dropFrameFlag, int useLegacy, 
-    PackageDefinitions* packageDefinitions, AvidClipWriter** clipWriter)
-{
-    AvidClipWriter* newClipWriter = NULL;
-    MXFListIterator iter;
-
-    CHK_ORET(mxf_get_list_length(&packageDefinitions->materialPackage->tracks) <= MAX_TRACKS);
-    
-    
-    CHK_MALLOC_ORET(newClipWriter, AvidClipWriter);
-    memset(newClipWriter, 0, sizeof(AvidClipWriter));
-
-    if (projectName != NULL)
-    {
-        CHK_OFAIL(convert_string(newClipWriter, projectName));
-        newClipWriter->wProjectName = newClipWriter->wTmpString;
-        newClipWriter->wTmpString = NULL;
-    }
-    newClipWriter->projectFormat = projectFormat;
-    newClipWriter->dropFrameFlag = dropFrameFlag;
-    newClipWriter->useLegacy = useLegacy;
-
-    newClipWriter->projectEditRate.numerator = projectEditRate.numerator;
-    newClipWriter->projectEditRate.denominator = projectEditRate.denominator;
-
-    /* create track writer for each file package */
-    mxf_initialise_list_iter(&iter, &packageDefinitions->fileSourcePackages);
-    while (mxf_next_list_iter_element(&iter))
-    {
-        CHK_OFAIL(create_track_writer(newClipWriter, packageDefinitions, (Package*)mxf_get_iter_element(&iter)));
-    }
-
-    *clipWriter = newClipWriter;
-    return 1;
-    
-fail:
-    free_avid_clip_writer(&newClipWriter);
-    return 0;
-}
-    
-int write_samples(AvidClipWriter* clipWriter, uint32_t materialTrackID, uint32_t numSamples,
+static int write_track_samples(AvidClipWriter* clipWriter, TrackWriter* writer, uint32_t numSamples,
     const uint8_t* data, uint32_t size)
 {
-    TrackWriter* writer;
-    CHK_ORET(get_track_writer(clipWriter, materialTrackID, &writer));
-    
     switch (writer->essenceType)
     {
         case AvidMJPEG:
@@ -2329,21 +2347,15 @@ int write_samples(AvidClipWriter* clipWriter, uint32_t materialTrackID, uint32_t
 }
 
 
-int start_write_samples(AvidClipWriter* clipWriter, uint32_t materialTrackID)
+static int start_track_samples(TrackWriter* writer)
 {
-    TrackWriter* writer;
-    CHK_ORET(get_track_writer(clipWriter, materialTrackID, &writer));
-    
     writer->sampleDataSize = 0;    
 
     return 1;
 }
 
-int write_sample_data(AvidClipWriter* clipWriter, uint32_t materialTrackID, const uint8_t* data, uint32_t size)
+static int write_track_sample_data(TrackWriter* writer, const uint8_t* data, uint32_t size)
 {
-    TrackWriter* writer;
-    CHK_ORET(get_track_writer(clipWriter, materialTrackID, &writer));
-
     if (writer->essenceType == UncUYVY && writer->sampleDataSize == 0)
     {
         /* write start offset for alignment */
@@ -2368,11 +2380,8 @@ int write_sample_data(AvidClipWriter* clipWriter, uint32_t materialTrackID, cons
     return 1;
 }
 
-int end_write_samples(AvidClipWriter* clipWriter, uint32_t materialTrackID, uint32_t numSamples)
+static int end_track_samples(TrackWriter* writer, uint32_t numSamples)
 {
-    TrackWriter* writer;
-    CHK_ORET(get_track_writer(clipWriter, materialTrackID, &writer));
-    
     switch (writer->essenceType)
     {
         case AvidMJPEG:
@@ -2425,11 +2434,366 @@ int end_write_samples(AvidClipWriter* clipWriter, uint32_t materialTrackID, uint
 }
 
 
+static int process_write_request(TrackWorker* worker, const WriteRequest* request)
+{
+    switch (request->type)
+    {
+        case WRITE_SAMPLES_REQUEST:
+            return write_track_samples(worker->clipWriter, worker->writer, request->numSamples,
+                request->data, request->size);
+        case START_WRITE_SAMPLES_REQUEST:
+            return start_track_samples(worker->writer);
+        case WRITE_SAMPLE_DATA_REQUEST:
+            return write_track_sample_data(worker->writer, request->data, request->size);
+        case END_WRITE_SAMPLES_REQUEST:
+            return end_track_samples(worker->writer, request->numSamples);
+    }
+
+    assert(0);
+    return 0;
+}
+
+static void track_worker_thread(void* arg)
+{
+    TrackWorker* worker = (TrackWorker*)arg;
+    WriteRequest* request;
+    int writeFailed;
+
+    mxf_lock_mutex(&worker->mutex);
+    for (;;)
+    {
+        while (worker->numQueued == 0 && !worker->stopThread)
+        {
+            mxf_wait_condition(&worker->dataCondition, &worker->mutex);
+        }
+        if (worker->numQueued == 0)
+        {
+            break;
+        }
+
+        request = &worker->requests[worker->writeIndex];
+        writeFailed = worker->writeFailed;
+        mxf_unlock_mutex(&worker->mutex);
+
+        /* requests are discarded once a write has failed */
+        if (!writeFailed && !process_write_request(worker, request))
+        {
+            mxf_log_error("Failed to write samples for track %u" LOG_LOC_FORMAT,
+                worker->writer->materialTrackID, LOG_LOC_PARAMS);
+            writeFailed = 1;
+        }
+
+        mxf_lock_mutex(&worker->mutex);
+        if (writeFailed)
+        {
+            worker->writeFailed = 1;
+        }
+        worker->writeIndex = (worker->writeIndex + 1) % worker->numRequests;
+        worker->numQueued--;
+        mxf_broadcast_condition(&worker->spaceCondition);
+    }
+    mxf_unlock_mutex(&worker->mutex);
+}
+
+/* the caller's data is copied so that it can be reused as soon as the request has been queued */
+static int queue_write_request(TrackWorker* worker, WriteRequestType type, uint32_t numSamples,
+    const uint8_t* data, uint32_t size)
+{
+    WriteRequest* request;
+    int writeFailed;
+
+    mxf_lock_mutex(&worker->mutex);
+    while (worker->numQueued == worker->numRequests && !worker->writeFailed)
+    {
+        mxf_wait_condition(&worker->spaceCondition, &worker->mutex);
+    }
+    writeFailed = worker->writeFailed;
+    request = &worker->requests[(worker->writeIndex + worker->numQueued) % worker->numRequests];
+    mxf_unlock_mutex(&worker->mutex);
+
+    if (writeFailed)
+    {
+        mxf_log_error("Writer thread for track %u has failed" LOG_LOC_FORMAT,
+            worker->writer->materialTrackID, LOG_LOC_PARAMS);
+        return 0;
+    }
+
+    /* the request slot is not accessed by the worker thread until it has been queued */
+    if (size > request->allocSize)
+    {
+        SAFE_FREE(&request->data);
+        request->allocSize = 0;
+        CHK_MALLOC_ARRAY_ORET(request->data, uint8_t, size);
+        request->allocSize = size;
+    }
+    if (size > 0)
+    {
+        memcpy(request->data, data, size);
+    }
+    request->type = type;
+    request->numSamples = numSamples;
+    request->size = size;
+
+    mxf_lock_mutex(&worker->mutex);
+    worker->numQueued++;
+    mxf_signal_condition(&worker->dataCondition);
+    mxf_unlock_mutex(&worker->mutex);
+
+    return 1;
+}
+
+static int wait_for_track_worker(TrackWorker* worker)
+{
+    int writeFailed;
+
+    mxf_lock_mutex(&worker->mutex);
+    while (worker->numQueued > 0)
+    {
+        mxf_wait_condition(&worker->spaceCondition, &worker->mutex);
+    }
+    writeFailed = worker->writeFailed;
+    mxf_unlock_mutex(&worker->mutex);
+
+    return !writeFailed;
+}
+
+static void free_track_worker(TrackWorker** worker)
+{
+    uint32_t i;
+
+    if (*worker == NULL)
+    {
+        return;
+    }
+
+    if ((*worker)->haveSync)
+    {
+        mxf_destroy_condition(&(*worker)->spaceCondition);
+        mxf_destroy_condition(&(*worker)->dataCondition);
+        mxf_destroy_mutex(&(*worker)->mutex);
+    }
+
+    if ((*worker)->requests != NULL)
+    {
+        for (i = 0; i < (*worker)->numRequests; i++)
+        {
+            SAFE_FREE(&(*worker)->requests[i].data);
+        }
+        SAFE_FREE(&(*worker)->requests);
+    }
+
+    SAFE_FREE(worker);
+}
+
+/* waits for the queued requests to be written, joins the thread and frees the worker.
+   Returns 0 if a request failed */
+static int stop_track_worker(TrackWriter* writer)
+{
+    TrackWorker* worker = writer->worker;
+    int result = 1;
+
+    if (worker == NULL)
+    {
+        return 1;
+    }
+
+    if (worker->haveThread)
+    {
+        mxf_lock_mutex(&worker->mutex);
+        worker->stopThread = 1;
+        mxf_signal_condition(&worker->dataCondition);
+        mxf_unlock_mutex(&worker->mutex);
+
+        if (!mxf_join_thread(&worker->thread))
+        {
+            result = 0;
+        }
+        worker->haveThread = 0;
+
+        if (worker->writeFailed)
+        {
+            result = 0;
+        }
+    }
+
+    free_track_worker(&writer->worker);
+
+    return result;
+}
+
+static int stop_track_workers(AvidClipWriter* clipWriter)
+{
+    int result = 1;
+    int i;
+
+    for (i = 0; i < clipWriter->numTracks; i++)
+    {
+        if (!stop_track_worker(clipWriter->tracks[i]))
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static int start_track_worker(AvidClipWriter* clipWriter, TrackWriter* writer, uint32_t numRequests)
+{
+    TrackWorker* newWorker;
+
+    CHK_MALLOC_ORET(newWorker, TrackWorker);
+    memset(newWorker, 0, sizeof(TrackWorker));
+    writer->worker = newWorker;
+
+    newWorker->clipWriter = clipWriter;
+    newWorker->writer = writer;
+    newWorker->numRequests = numRequests;
+    CHK_MALLOC_ARRAY_ORET(newWorker->requests, WriteRequest, numRequests);
+    memset(newWorker->requests, 0, sizeof(WriteRequest) * numRequests);
+
+    CHK_ORET(mxf_init_mutex(&newWorker->mutex));
+    if (!mxf_init_condition(&newWorker->dataCondition))
+    {
+        mxf_destroy_mutex(&newWorker->mutex);
+        return 0;
+    }
+    if (!mxf_init_condition(&newWorker->spaceCondition))
+    {
+        mxf_destroy_condition(&newWorker->dataCondition);
+        mxf_destroy_mutex(&newWorker->mutex);
+        return 0;
+    }
+    newWorker->haveSync = 1;
+
+    CHK_ORET(mxf_create_thread(&newWorker->thread, track_worker_thread, newWorker));
+    newWorker->haveThread = 1;
+
+    return 1;
+}
+
+
+
+
+int create_clip_writer(const char* projectName, ProjectFormat projectFormat,
+    mxfRational projectEditRate, int dropFrameFlag, int useLegacy, uint32_t threadQueueSize,
+    int asyncWrite, PackageDefinitions* packageDefinitions, AvidClipWriter** clipWriter)
+{
+    AvidClipWriter* newClipWriter = NULL;
+    MXFListIterator iter;
+    int i;
+
+    CHK_ORET(mxf_get_list_length(&packageDefinitions->materialPackage->tracks) <= MAX_TRACKS);
+    
+    
+    CHK_MALLOC_ORET(newClipWriter, AvidClipWriter);
+    memset(newClipWriter, 0, sizeof(AvidClipWriter));
+
+    if (projectName != NULL)
+    {
+        CHK_OFAIL(convert_string(newClipWriter, projectName));
+        newClipWriter->wProjectName = newClipWriter->wTmpString;
+        newClipWriter->wTmpString = NULL;
+    }
+    newClipWriter->projectFormat = projectFormat;
+    newClipWriter->dropFrameFlag = dropFrameFlag;
+    newClipWriter->useLegacy = useLegacy;
+    newClipWriter->asyncWrite = asyncWrite;
+
+    newClipWriter->projectEditRate.numerator = projectEditRate.numerator;
+    newClipWriter->projectEditRate.denominator = projectEditRate.denominator;
+
+    /* create track writer for each file package */
+    mxf_initialise_list_iter(&iter, &packageDefinitions->fileSourcePackages);
+    while (mxf_next_list_iter_element(&iter))
+    {
+        CHK_OFAIL(create_track_writer(newClipWriter, packageDefinitions, (Package*)mxf_get_iter_element(&iter)));
+    }
+    
+    /* start a worker thread for each track writer */
+    if (threadQueueSize > 0)
+    {
+        for (i = 0; i < newClipWriter->numTracks; i++)
+        {
+            CHK_OFAIL(start_track_worker(newClipWriter, newClipWriter->tracks[i], threadQueueSize));
+        }
+    }
+
+    *clipWriter = newClipWriter;
+    return 1;
+    
+fail:
+    if (newClipWriter != NULL)
+    {
+        stop_track_workers(newClipWriter);
+    }
+    free_avid_clip_writer(&newClipWriter);
+    return 0;
+}
+    
+int write_samples(AvidClipWriter* clipWriter, uint32_t materialTrackID, uint32_t numSamples,
+    const uint8_t* data, uint32_t size)
+{
+    TrackWriter* writer;
+    CHK_ORET(get_track_writer(clipWriter, materialTrackID, &writer));
+
+    if (writer->worker != NULL)
+    {
+        return queue_write_request(writer->worker, WRITE_SAMPLES_REQUEST, numSamples, data, size);
+    }
+
+    return write_track_samples(clipWriter, writer, numSamples, data, size);
+}
+
+int start_write_samples(AvidClipWriter* clipWriter, uint32_t materialTrackID)
+{
+    TrackWriter* writer;
+    CHK_ORET(get_track_writer(clipWriter, materialTrackID, &writer));
+
+    if (writer->worker != NULL)
+    {
+        return queue_write_request(writer->worker, START_WRITE_SAMPLES_REQUEST, 0, NULL, 0);
+    }
+
+    return start_track_samples(writer);
+}
+
+int write_sample_data(AvidClipWriter* clipWriter, uint32_t materialTrackID, const uint8_t* data, uint32_t size)
+{
+    TrackWriter* writer;
+    CHK_ORET(get_track_writer(clipWriter, materialTrackID, &writer));
+
+    if (writer->worker != NULL)
+    {
+        return queue_write_request(writer->worker, WRITE_SAMPLE_DATA_REQUEST, 0, data, size);
+    }
+
+    return write_track_sample_data(writer, data, size);
+}
+
+int end_write_samples(AvidClipWriter* clipWriter, uint32_t materialTrackID, uint32_t numSamples)
+{
+    TrackWriter* writer;
+    CHK_ORET(get_track_writer(clipWriter, materialTrackID, &writer));
+
+    if (writer->worker != NULL)
+    {
+        return queue_write_request(writer->worker, END_WRITE_SAMPLES_REQUEST, numSamples, NULL, 0);
+    }
+
+    return end_track_samples(writer, numSamples);
+}
+
+
 int get_num_samples(AvidClipWriter* clipWriter, uint32_t materialTrackID, int64_t* num_samples)
 {
     TrackWriter* writer;
     CHK_ORET(get_track_writer(clipWriter, materialTrackID, &writer));
     
+    if (writer->worker != NULL)
+    {
+        CHK_ORET(wait_for_track_worker(writer->worker));
+    }
+    
     *num_samples = writer->duration;
     return 1;
 }
@@ -2439,6 +2803,8 @@ void abort_writing(AvidClipWriter** clipWriter, int deleteFile)
     int i;
     TrackWriter* trackWriter;
 
+    stop_track_workers(*clipWriter);
+
     for (i = 0; i < (*clipWriter)->numTracks; i++)
     {
         trackWriter = (*clipWriter)->tracks[i];
@@ -2468,6 +2834,9 @@ int update_and_complete_writing(AvidClipWriter** clipWriter, PackageDefinitions*
     int i;
     Package* filePackage = NULL;
 
+    /* wait for the worker threads to write the remaining samples */
+    CHK_ORET(stop_track_workers(*clipWriter));
+
     if (packageDefinitions != NULL)
     {
         if (projectName != NULL)
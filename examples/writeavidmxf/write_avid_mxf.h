@@ -42,10 +42,17 @@ typedef enum
 } ProjectFormat;
 
 
-/* create the writer */
+/* create the writer
+    if threadQueueSize is 0 then the samples are written on the caller's thread. Otherwise each
+    track is written by its own worker thread, which processes a queue of up to threadQueueSize
+    write requests. The sample data is copied into the queue. A failure in a worker thread is
+    reported by the next write, get_num_samples or complete call for that track
+    if asyncWrite is true then each file is written through an MXFAsyncFile, which hands the
+    writes to a background thread (see mxf_async_file.h)
+*/
 int create_clip_writer(const char* projectName, ProjectFormat projectFormat,
-    mxfRational projectEditRate, int dropFrameFlag, int useLegacy, 
-    PackageDefinitions* packageDefinitions, AvidClipWriter** clipWriter);
+    mxfRational projectEditRate, int dropFrameFlag, int useLegacy, uint32_t threadQueueSize,
+    int asyncWrite, PackageDefinitions* packageDefinitions, AvidClipWriter** clipWriter);
     
 
 /* write essence samples
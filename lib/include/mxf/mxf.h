@@ -33,7 +33,10 @@ extern "C"
 #include <mxf/mxf_types.h>
 #include <mxf/mxf_version.h>
 #include <mxf/mxf_labels_and_keys.h>
+#include <mxf/mxf_arena.h>
 #include <mxf/mxf_list.h>
+#include <mxf/mxf_hash_table.h>
+#include <mxf/mxf_crc32.h>
 #include <mxf/mxf_logging.h>
 #include <mxf/mxf_file.h>
 #include <mxf/mxf_utils.h>
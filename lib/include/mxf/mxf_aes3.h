@@ -0,0 +1,77 @@
+/*
+ * $Id$
+ *
+ * Conversion between D-10 (SMPTE 331) AES3 sound elements and interleaved PCM
+ *
+ * Copyright (C) 2010  British Broadcasting Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __MXF_AES3_H__
+#define __MXF_AES3_H__
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/* A D-10 AES3 sound element starts with a 4 byte header (element header, 16-bit little-endian sample
+   count and the channel valid flags) followed by 8 channels x 4 bytes for each sample. Each 4 byte
+   channel word is little-endian with the 24-bit audio sample in bits 4-27 */
+#define MXF_AES3_HEADER_SIZE        4
+#define MXF_AES3_NUM_CHANNELS       8
+#define MXF_AES3_SAMPLE_SIZE        (MXF_AES3_NUM_CHANNELS * 4)
+
+#define MXF_AES3_ELEMENT_SIZE(sampleCount)     (MXF_AES3_HEADER_SIZE + (sampleCount) * MXF_AES3_SAMPLE_SIZE)
+
+
+typedef enum
+{
+    MXF_AES3_SCALAR_IMPL = 0,
+    MXF_AES3_SSSE3_IMPL,
+    MXF_AES3_AVX2_IMPL
+} MXFAES3Impl;
+
+
+/* Extracts the channels marked valid in the element header as interleaved PCM with blockAlign (1, 2
+   or 3) bytes per sample; the most significant bits of the 24-bit samples are kept.
+   pcmData may be the same as aesData, i.e. the conversion can be done in-place.
+   pcmData must have room for sampleCount x number of valid channels x blockAlign bytes */
+int mxf_convert_aes3_to_pcm(const uint8_t* aesData, uint64_t aesDataLen, uint32_t blockAlign,
+                            uint8_t* pcmData, uint64_t* pcmDataLen, uint32_t* numChannels);
+
+/* Creates an AES3 element from channelCount (1 to 8) interleaved PCM channels with blockAlign bytes per
+   sample. The channels are marked valid from channel 0 upwards and the remaining channels are zero.
+   elementHeader holds the FVUCP valid flag (bit 7) and the 5-sequence count (bits 0-2).
+   aesData must have room for MXF_AES3_ELEMENT_SIZE(sampleCount) bytes */
+int mxf_convert_pcm_to_aes3(const uint8_t* pcmData, uint32_t channelCount, uint32_t blockAlign,
+                            uint32_t sampleCount, uint8_t elementHeader, uint8_t* aesData);
+
+/* the implementation used is the best one supported by the compiler and CPU, limited by
+   mxf_set_max_aes3_impl, e.g. for testing or benchmarking */
+MXFAES3Impl mxf_get_aes3_impl(void);
+void mxf_set_max_aes3_impl(MXFAES3Impl impl);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif
+
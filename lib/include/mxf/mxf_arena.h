@@ -0,0 +1,65 @@
+/*
+ * $Id$
+ *
+ * Arena (region) allocator
+ *
+ * Copyright (C) 2010  British Broadcasting Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef __MXF_ARENA_H__
+#define __MXF_ARENA_H__
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/* memory is bump allocated from large blocks and only released when the arena is freed */
+
+typedef struct _MXFArenaBlock
+{
+    struct _MXFArenaBlock* next;
+    size_t size;
+    size_t used;
+} MXFArenaBlock;
+
+typedef struct _MXFArena
+{
+    MXFArenaBlock* blocks; /* the block currently allocated from is first */
+    size_t blockSize;
+} MXFArena;
+
+
+/* blockSize 0 selects the default block size */
+int mxf_create_arena(MXFArena** arena, size_t blockSize);
+void mxf_free_arena(MXFArena** arena);
+
+/* returns NULL for failure; the memory is aligned for any of the mxf types */
+void* mxf_arena_alloc(MXFArena* arena, size_t size);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif
+
+
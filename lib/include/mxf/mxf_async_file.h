@@ -0,0 +1,75 @@
+/*
+ * $Id$
+ *
+ * Asynchronous write-behind MXFFile wrapper
+ *
+ * Copyright (C) 2010  British Broadcasting Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __MXF_ASYNC_FILE_H__
+#define __MXF_ASYNC_FILE_H__
+
+
+#ifdef __cplusplus
+extern "C" 
+{
+#endif
+
+
+#include <mxf/mxf_file.h>
+
+
+#define MXF_ASYNC_FILE_DEFAULT_BUFFER_SIZE      (4 * 1024 * 1024)
+#define MXF_ASYNC_FILE_DEFAULT_NUM_BUFFERS      8
+
+
+typedef struct MXFAsyncFile MXFAsyncFile;
+
+typedef struct
+{
+    int64_t bytesWritten;       /* bytes written to the target file by the background thread */
+    uint32_t queueDepth;        /* number of buffers currently queued */
+    uint32_t maxQueueDepth;
+    int64_t numStalls;          /* number of times a write waited for a free buffer */
+    int64_t stallTime;          /* total time in microseconds writes waited for a free buffer */
+} MXFAsyncFileStats;
+
+
+/* wraps the target file, which is owned by the wrapper from here on and closed with it.
+   Writes are copied into a ring of numBuffers buffers of bufferSize bytes and written to the
+   target by a background thread. Reads, seeks, size and eof queries first wait for all queued
+   data to be written (a barrier) and are then passed on to the target.
+   The target is closed if wrapping fails. Set bufferSize or numBuffers to 0 to use the defaults */
+int mxf_async_file_wrap(MXFFile* target, uint32_t bufferSize, uint32_t numBuffers, MXFAsyncFile** asyncFile);
+
+MXFFile* mxf_async_file_get_file(MXFAsyncFile* asyncFile);
+
+/* waits until all data written so far has reached the target file.
+   Returns 0 if a background write failed; all subsequent writes will fail as well */
+int mxf_async_file_flush(MXFAsyncFile* asyncFile);
+
+void mxf_async_file_get_stats(MXFAsyncFile* asyncFile, MXFAsyncFileStats* stats);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif
+
+
@@ -57,6 +57,11 @@ typedef struct
 
 int mxf_avid_load_extensions(MXFDataModel* dataModel);
 
+/* returns a reference to the process-wide, read-only data model with the baseline and Avid extensions
+   definitions. It is shared in the same way as mxf_get_default_data_model and the reference is
+   released using mxf_free_data_model */
+int mxf_avid_get_default_data_model(MXFDataModel** dataModel);
+
 
 int mxf_avid_read_filtered_header_metadata(MXFFile* mxfFile, int skipDataDefs, MXFHeaderMetadata* headerMetadata, 
     uint64_t headerByteCount, const mxfKey* key, uint8_t llen, uint64_t len);
@@ -69,8 +69,28 @@ int mxf_initialise_metadict_read_filter(MXFReadFilter* filter);
 void mxf_clear_metadict_read_filter(MXFReadFilter* filter);
 
 
+typedef struct
+{
+    uint8_t* data;
+    uint32_t size;
+    uint32_t* setOffsets;
+    const mxfUUID* instanceUIDs;
+    uint32_t numSets;
+} MXFAvidMetaDictEncoding;
+
+/* builds the default meta-dictionary sets in the header metadata, e.g. if the sets need unique instance UIDs */
+int mxf_avid_build_default_metadictionary(MXFHeaderMetadata* headerMetadata, MXFMetadataSet** metaDictSet);
+
+/* the default meta-dictionary is built and serialised once per process and the sets are created from the 
+   serialised data. The sets have the same instance UIDs in every header metadata and the item values 
+   reference the shared data, i.e. they must be changed using the mxf_set_* functions and not in place */
 int mxf_avid_create_default_metadictionary(MXFHeaderMetadata* headerMetadata, MXFMetadataSet** metaDictSet);
 
+/* returns the serialised MetaDictionary and meta-definition sets for the minimum llen of mxfFile if the 
+   header metadata contains an unmodified default meta-dictionary, otherwise encoding is set to NULL */
+int mxf_avid_get_default_metadict_encoding(MXFFile* mxfFile, MXFHeaderMetadata* headerMetadata,
+    const MXFAvidMetaDictEncoding** encoding);
+
 
 
 #ifdef __cplusplus
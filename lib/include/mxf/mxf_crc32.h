@@ -0,0 +1,55 @@
+/*
+ * $Id$
+ *
+ * CRC-32 (ISO/IEC 8802-3) calculation
+ *
+ * Copyright (C) 2010  British Broadcasting Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __MXF_CRC32_H__
+#define __MXF_CRC32_H__
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/* The CRC-32 used by zlib, Ethernet and the archive MXF system item (reflected polynomial 0xedb88320,
+   initial value and final xor 0xffffffff).
+
+   mxf_update_crc32 is the incremental form: start with crc32 = 0 and pass in the result of the previous
+   call for each following block. The result after any call is the CRC-32 of all the data passed in so
+   far, i.e. mxf_calc_crc32 is mxf_update_crc32(0, data, size) */
+uint32_t mxf_calc_crc32(const uint8_t* data, uint32_t size);
+uint32_t mxf_update_crc32(uint32_t crc32, const uint8_t* data, uint32_t size);
+
+/* A carry-less multiplication (PCLMULQDQ) implementation is used for larger blocks if the compiler
+   supports it and the CPU reports it at runtime; otherwise a slicing-by-8 table implementation is used.
+   mxf_enable_crc32_simd(0) forces the table implementation, e.g. for testing or benchmarking */
+int mxf_have_crc32_simd(void);
+void mxf_enable_crc32_simd(int enable);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif
+
@@ -102,15 +102,21 @@ typedef struct _MXFSetDef
     mxfKey parentSetDefKey;
     mxfKey key;
     MXFList itemDefs;
+    MXFHashTable itemDefsIndex; /* key -> item def in itemDefs, built by mxf_finalise_data_model */
     struct _MXFSetDef* parentSetDef;
 } MXFSetDef;
 
-typedef struct
+typedef struct _MXFDataModel
 {
     MXFList itemDefs;
     MXFList setDefs;
+    MXFHashTable itemDefsIndex; /* key -> item def */
+    MXFHashTable setDefsIndex; /* key -> set def */
     MXFItemType types[128]; /* index 0 is not used */
     unsigned int lastTypeId;
+    int isReadOnly; /* shared data model that can't be changed */
+    unsigned int refCount; /* references to a shared data model, protected by a lock */
+    struct _MXFDataModel** sharedRef; /* holder of a shared data model, reset when it is freed */
 } MXFDataModel;
 
 
@@ -217,6 +223,21 @@ int mxf_load_data_model(MXFDataModel** dataModel);
 int mxf_load_extensions_data_model(MXFDataModel* dataModel);
 void mxf_free_data_model(MXFDataModel** dataModel);
 
+/* returns a reference to the process-wide default data model, which contains the baseline definitions
+   and is finalised. The data model is read-only: registering definitions or finalising it fails.
+   A finalised data model is not changed by the find, get and is_subclass_of functions below or by
+   reading and writing header metadata, and so the default data model can be used by multiple threads
+   concurrently. Release the reference using mxf_free_data_model; the data model is freed when the last
+   reference is released */
+int mxf_get_default_data_model(MXFDataModel** dataModel);
+
+/* returns a reference to the read-only data model held in *sharedDataModel, which is a static variable
+   owned by the caller. If it is NULL then loadFunc is called to create the finalised data model.
+   This is used to provide shared data models with extensions, eg. mxf_avid_get_default_data_model */
+typedef int (*mxf_load_shared_data_model_func)(MXFDataModel** dataModel);
+int mxf_get_shared_data_model(MXFDataModel** sharedDataModel, mxf_load_shared_data_model_func loadFunc,
+    MXFDataModel** dataModel);
+
 int mxf_register_set_def(MXFDataModel* dataModel, const char* name, const mxfKey* parentKey, 
     const mxfKey* key);
 int mxf_register_item_def(MXFDataModel* dataModel, const char* name, const mxfKey* setKey, 
@@ -53,6 +53,11 @@ int mxf_open_essence_element_read(MXFFile* mxfFile, const mxfKey* key, uint8_t l
 int mxf_read_essence_element_data(MXFFile* mxfFile, MXFEssenceElement* essenceElement,
     uint32_t len, uint8_t* data, uint32_t* numRead);
 
+/* copies len bytes, or the remainder of the source element if less, to the destination element being 
+   written. See mxf_file_copy */
+int mxf_copy_essence_element_data(MXFFile* sourceFile, MXFEssenceElement* sourceElement,
+    MXFFile* destFile, MXFEssenceElement* destElement, uint64_t len, uint64_t* numCopied);
+
 void mxf_close_essence_element(MXFEssenceElement** essenceElement);
 
 uint64_t mxf_get_essence_element_size(MXFEssenceElement* essenceElement);
@@ -36,6 +36,19 @@ extern "C"
 
 typedef struct MXFFileSysData MXFFileSysData;
 
+typedef enum
+{
+    MXF_FILE_ACCESS_NORMAL = 0,
+    MXF_FILE_ACCESS_SEQUENTIAL,
+    MXF_FILE_ACCESS_RANDOM
+} MXFFileAccessHint;
+
+typedef struct
+{
+    uint8_t* data;
+    uint32_t size;
+} MXFIOVector;
+
 typedef struct
 {
     /* MXF file implementations must set and implement these functions */
@@ -49,6 +62,16 @@ typedef struct
     int64_t (*tell)(MXFFileSysData* sysData);
     int (*is_seekable)(MXFFileSysData* sysData);
     int64_t (*size)(MXFFileSysData* sysData);
+    
+    /* optional direct access to the file data */
+    const uint8_t* (*get_data)(MXFFileSysData* sysData, int64_t offset, uint32_t count);
+    
+    /* optional read into multiple buffers using a single system call */
+    uint64_t (*read_vector)(MXFFileSysData* sysData, const MXFIOVector* vectors, int count);
+
+    /* optional file descriptor for copying data in the kernel. Pending writes are flushed first and -1 is 
+       returned if the descriptor is not available */
+    int (*get_fd)(MXFFileSysData* sysData);
 
     /* private data for the MXF file implementation */
     void (*free_sys_data)(MXFFileSysData* sysData);
@@ -62,19 +85,39 @@ typedef struct
 
 /* open files on disk */
 int mxf_disk_file_open_new(const char* filename, MXFFile** mxfFile);
+/* write whole blocks bypassing the page cache (O_DIRECT) for predictable sustained write throughput. 
+   Writes are buffered until the buffer is full or the file is read from or written to at another position */
+int mxf_disk_file_open_direct_new(const char* filename, MXFFile** mxfFile);
 int mxf_disk_file_open_read(const char* filename, MXFFile** mxfFile);
 int mxf_disk_file_open_modify(const char* filename, MXFFile** mxfFile);
 
+/* open a file on disk for reading through a read-only memory mapping. The accessHint is passed on to 
+   the system (madvise). mxf_file_get_data can be used to access the file data without copying */
+int mxf_disk_file_open_mmap_read(const char* filename, MXFFileAccessHint accessHint, MXFFile** mxfFile);
+
 /* wrap standard input in an MXF file */
 int mxf_stdin_wrap_read(MXFFile** mxfFile);
 
 /* wrap a read-only byte array */
 int mxf_byte_array_wrap_read(const uint8_t* byteArray, int64_t size, MXFFile** mxfFile);
 
+/* open a readable and writable file in memory that grows as data is written. allocSize is the initial 
+   allocation. mxf_file_get_data provides access to the data, which is freed when the file is closed */
+int mxf_mem_file_open_new(uint32_t allocSize, MXFFile** mxfFile);
+
 
 void mxf_file_close(MXFFile** mxfFile);
 uint32_t mxf_file_read(MXFFile* mxfFile, uint8_t* data, uint32_t count); 
 uint32_t mxf_file_write(MXFFile* mxfFile, const uint8_t* data, uint32_t count); 
+/* reads consecutive data into the sequence of buffers and returns the total number of bytes read. Files 
+   opened with mxf_disk_file_open_read use a single preadv call where available and other files read 
+   into each buffer in turn */
+uint64_t mxf_file_read_vector(MXFFile* mxfFile, const MXFIOVector* vectors, int count);
+/* copies count bytes from the position in the source file to the position in the destination file and returns 
+   the number of bytes copied. The data is copied in the kernel (copy_file_range or sendfile) if both are disk 
+   files opened with mxf_disk_file_open_new, _read or _modify and the system supports it, otherwise through a 
+   buffer */
+uint64_t mxf_file_copy(MXFFile* destFile, MXFFile* sourceFile, uint64_t count);
 int mxf_file_getc(MXFFile* mxfFile); 
 int mxf_file_putc(MXFFile* mxfFile, int c); 
 int mxf_file_eof(MXFFile* mxfFile); 
@@ -83,6 +126,11 @@ int64_t mxf_file_tell(MXFFile* mxfFile);
 int mxf_file_is_seekable(MXFFile* mxfFile);
 int64_t mxf_file_size(MXFFile* mxfFile);
 
+/* returns a pointer to count bytes at offset, or NULL if the range is invalid or the file doesn't 
+   support direct access (only memory mapped files, memory files and byte arrays do). The data is valid until the 
+   file is closed */
+const uint8_t* mxf_file_get_data(MXFFile* mxfFile, int64_t offset, uint32_t count);
+
 
 void mxf_file_set_min_llen(MXFFile* mxfFile, uint8_t llen);
 uint8_t mxf_get_min_llen(MXFFile* mxfFile);
@@ -0,0 +1,70 @@
+/*
+ * $Id$
+ *
+ * Hash table keyed by 16-byte identifiers (UUIDs, ULs, keys)
+ *
+ * Copyright (C) 2010  British Broadcasting Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#ifndef __MXF_HASH_TABLE_H__
+#define __MXF_HASH_TABLE_H__
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/* open addressing with linear probing; a slot is empty if data == NULL */
+typedef struct
+{
+    mxfUID id;
+    void* data;
+} MXFHashSlot;
+
+typedef struct
+{
+    MXFHashSlot* slots;
+    unsigned long numSlots;
+    long len;
+    free_func_type freeFunc;
+} MXFHashTable;
+
+
+int mxf_create_hash_table(MXFHashTable** table, free_func_type freeFunc);
+void mxf_free_hash_table(MXFHashTable** table);
+void mxf_initialise_hash_table(MXFHashTable* table, free_func_type freeFunc);
+void mxf_clear_hash_table(MXFHashTable* table);
+
+/* data must not be NULL.
+   returns 1 on success, 0 for failure, 2 if the id is already present and the existing element was kept */
+int mxf_add_hash_element(MXFHashTable* table, const mxfUID* id, void* data);
+void* mxf_find_hash_element(const MXFHashTable* table, const mxfUID* id);
+/* the element is only removed if data matches or data is NULL; the removed element's data is returned */
+void* mxf_remove_hash_element(MXFHashTable* table, const mxfUID* id, void* data);
+long mxf_get_hash_table_length(const MXFHashTable* table);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif
+
+
@@ -38,6 +38,8 @@ typedef struct
     uint16_t length;
     uint8_t* value;
     struct _MXFMetadataSet* set;
+    MXFArena* arena; /* item and value are allocated from the arena if not NULL */
+    int valueIsRef; /* value references a header metadata read buffer and is not owned by the item */
 } MXFMetadataItem;
 
 typedef struct _MXFMetadataSet
@@ -47,6 +49,7 @@ typedef struct _MXFMetadataSet
     MXFList items;
     struct _MXFHeaderMetadata* headerMetadata;
     uint64_t fixedSpaceAllocation;
+    MXFArena* arena; /* set and items list are allocated from the arena if not NULL */
 } MXFMetadataSet;
 
 typedef struct _MXFHeaderMetadata
@@ -54,6 +57,9 @@ typedef struct _MXFHeaderMetadata
     MXFDataModel* dataModel;
     MXFPrimerPack* primerPack;
     MXFList sets;
+    MXFHashTable setsIndex; /* instanceUID -> set, maintained by mxf_add_set and mxf_remove_set */
+    MXFArena* arena; /* owned; NULL unless created using mxf_create_arena_header_metadata */
+    MXFList readBuffers; /* owned; see mxf_read_buffered_header_metadata */
 } MXFHeaderMetadata;
 
 typedef struct
@@ -79,6 +85,11 @@ int mxf_is_header_metadata(const mxfKey* key);
 
 
 int mxf_create_header_metadata(MXFHeaderMetadata** headerMetadata, MXFDataModel* dataModel);
+/* sets, items, item values and list elements created for the header metadata are allocated from an arena 
+   that is released in one go by mxf_free_header_metadata. mxf_free_set and mxf_free_item can still be called 
+   but the memory is only reclaimed when the header metadata is freed, and the sets and items must not be used 
+   after that */
+int mxf_create_arena_header_metadata(MXFHeaderMetadata** headerMetadata, MXFDataModel* dataModel);
 int mxf_create_set(MXFHeaderMetadata* headerMetadata, const mxfKey* key, MXFMetadataSet** set);
 int mxf_create_item(MXFMetadataSet* set, const mxfKey* key, mxfLocalTag tag, MXFMetadataItem** item);
 void mxf_free_header_metadata(MXFHeaderMetadata** headerMetadata);
@@ -107,6 +118,14 @@ int mxf_read_header_metadata(MXFFile* mxfFile, MXFHeaderMetadata* headerMetadata
     uint64_t headerByteCount, const mxfKey* key, uint8_t llen, uint64_t len);
 int mxf_read_filtered_header_metadata(MXFFile* mxfFile, MXFReadFilter* filter, 
     MXFHeaderMetadata* headerMetadata, uint64_t headerByteCount, const mxfKey* key, uint8_t llen, uint64_t len);
+/* reads the header metadata into a single buffer owned by the header metadata and item values reference 
+   the buffer directly. The filter is optional */
+int mxf_read_buffered_header_metadata(MXFFile* mxfFile, MXFReadFilter* filter, 
+    MXFHeaderMetadata* headerMetadata, uint64_t headerByteCount, const mxfKey* key, uint8_t llen, uint64_t len);
+/* reads the sets in a byte array, e.g. sets serialised earlier using a memory file. Item values reference 
+   the data, which must not change and must outlive the header metadata. The item tags must already be 
+   registered in the primer pack */
+int mxf_read_referenced_sets(const uint8_t* data, uint32_t size, MXFHeaderMetadata* headerMetadata);
 int mxf_read_set(MXFFile* mxfFile, const mxfKey* key, uint64_t len,
     MXFHeaderMetadata* headerMetadata, int addToHeaderMetadata);
 /* returns 1 on success, 0 for failure, 2 if it is an unknown set and "set" parameter is set to NULL */
@@ -116,6 +135,10 @@ int mxf_read_item_tl(MXFFile* mxfFile, mxfLocalTag* itemTag, uint16_t* itemLen);
 int mxf_read_item(MXFFile* mxfFile, MXFMetadataItem* item, uint16_t len);
     
 int mxf_write_header_metadata(MXFFile* mxfFile, MXFHeaderMetadata* headerMetadata);
+/* serialises the primer pack and header sets into a new memory file (see mxf_mem_file_open_new) using the 
+   minimum llen of mxfFile. mxf_file_get_data and mxf_file_size give access to the bytes, e.g. to 
+   checksum or compare the header metadata without writing it to disk */
+int mxf_write_header_metadata_to_mem_file(MXFFile* mxfFile, MXFHeaderMetadata* headerMetadata, MXFFile** memFile);
 int mxf_write_header_primer_pack(MXFFile* mxfFile, MXFHeaderMetadata* headerMetadata);
 int mxf_write_header_sets(MXFFile* mxfFile, MXFHeaderMetadata* headerMetadata);
 int mxf_write_set(MXFFile* mxfFile, MXFMetadataSet* set);
@@ -66,6 +66,36 @@ typedef struct
     MXFIndexEntry* indexEntryArray;
 } MXFIndexTableSegment;
 
+/* alternative segment representation with the delta and index entries held in contiguous arrays.
+   The sliceOffsets and posTables arrays hold sliceCount and posTableCount values per index entry */
+typedef struct
+{
+    mxfUUID instanceUID;
+    mxfRational indexEditRate;
+    mxfPosition indexStartPosition;
+    mxfLength indexDuration;
+    uint32_t editUnitByteCount;
+    uint32_t indexSID;
+    uint32_t bodySID;
+    uint8_t sliceCount;
+    uint8_t posTableCount;
+    
+    uint32_t numDeltaEntries;
+    uint32_t allocDeltaEntries;
+    int8_t* deltaPosTableIndexes;
+    uint8_t* deltaSlices;
+    uint32_t* deltaElementData;
+    
+    uint32_t numIndexEntries;
+    uint32_t allocIndexEntries;
+    int8_t* temporalOffsets;
+    int8_t* keyFrameOffsets;
+    uint8_t* flags;
+    uint64_t* streamOffsets;
+    uint32_t* sliceOffsets;
+    mxfRational* posTables;
+} MXFCompactIndexTableSegment;
+
 
 typedef int (mxf_add_delta_entry)(void* data, uint32_t numEntries, MXFIndexTableSegment* segment, int8_t posTableIndex,
     uint8_t slice, uint32_t elementData);
@@ -104,6 +134,26 @@ int mxf_write_index_entry_array_header(MXFFile* mxfFile, uint8_t sliceCount, uin
 int mxf_write_index_entry(MXFFile* mxfFile, uint8_t sliceCount, uint8_t posTableCount, MXFIndexEntry* entry);
 
 
+int mxf_create_compact_index_table_segment(MXFCompactIndexTableSegment** segment);
+void mxf_free_compact_index_table_segment(MXFCompactIndexTableSegment** segment);
+
+/* sliceCount and posTableCount must be set before adding index entries */
+int mxf_allocate_compact_index_entries(MXFCompactIndexTableSegment* segment, uint32_t numEntries);
+int mxf_add_compact_delta_entry(MXFCompactIndexTableSegment* segment, int8_t posTableIndex, uint8_t slice,
+    uint32_t elementData);
+int mxf_add_compact_index_entry(MXFCompactIndexTableSegment* segment, int8_t temporalOffset,
+    int8_t keyFrameOffset, uint8_t flags, uint64_t streamOffset, 
+    const uint32_t* sliceOffset /* sliceCount values */, const mxfRational* posTable /* posTableCount values */);
+
+int mxf_write_compact_index_table_segment(MXFFile* mxfFile, const MXFCompactIndexTableSegment* segment);
+int mxf_read_compact_index_table_segment(MXFFile* mxfFile, uint64_t segmentLen, MXFCompactIndexTableSegment** segment);
+
+/* binary search for the segment containing the position in segments sorted by indexStartPosition.
+   The entry index is position - indexStartPosition; for CBE segments there are no index entries */
+int mxf_find_compact_index_entry(MXFCompactIndexTableSegment** segments, uint32_t numSegments, mxfPosition position,
+    uint32_t* segmentIndex, uint32_t* entryIndex);
+
+
 #ifdef __cplusplus
 }
 #endif
@@ -45,6 +45,7 @@ typedef struct
     MXFListElement* lastElement;
     long len;
     free_func_type freeFunc;
+    struct _MXFArena* arena; /* elements are allocated from the arena if not NULL */
 } MXFList;
 
 typedef struct
@@ -58,6 +59,7 @@ typedef struct
 int mxf_create_list(MXFList** list, free_func_type freeFunc);
 void mxf_free_list(MXFList** list);
 void mxf_initialise_list(MXFList* list, free_func_type freeFunc);
+void mxf_initialise_arena_list(MXFList* list, free_func_type freeFunc, struct _MXFArena* arena);
 void mxf_clear_list(MXFList* list);
 
 int mxf_append_list_element(MXFList* list, void* data);
@@ -27,6 +27,8 @@
 
 #include <stdarg.h>
 
+#include <mxf/mxf_types.h>
+
 
 #ifdef __cplusplus
 extern "C" 
@@ -64,6 +66,20 @@ void mxf_log_file_flush();
 void mxf_log_file_close();
 
 
+/* routes log messages through a lock-free ring buffer of numMessages entries (rounded up to a power
+   of 2; 0 selects the default) to a background thread, which passes them on to the mxf_vlog function
+   that was set before the call. Messages below g_mxfLogLevel are discarded before being formatted.
+   A thread logging a message never waits: the message is dropped if the buffer is full.
+   Start and stop when no other threads are logging */
+int mxf_log_async_start(uint32_t numMessages);
+
+/* outputs the remaining messages, stops the thread and restores the previous log functions */
+void mxf_log_async_stop();
+
+/* number of messages dropped because the buffer was full */
+uint32_t mxf_log_async_get_num_dropped();
+
+
 /* log level in function name */
 void mxf_log_debug(const char* format, ...);
 void mxf_log_info(const char* format, ...);
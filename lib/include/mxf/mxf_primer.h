@@ -41,6 +41,8 @@ typedef struct
 {
     mxfLocalTag nextTag;
     MXFList entries;
+    MXFHashTable uidIndex; /* uid -> entry */
+    MXFPrimerPackEntry** tagIndex[256]; /* tag -> entry, pages of 256 tags allocated on demand */
 } MXFPrimerPack;
 
 
@@ -0,0 +1,108 @@
+/*
+ * $Id$
+ *
+ * Portable threads, mutexes and condition variables
+ *
+ * Copyright (C) 2010  British Broadcasting Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#ifndef __MXF_THREAD_H__
+#define __MXF_THREAD_H__
+
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#include <mxf/mxf_types.h>
+
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+#if defined(_WIN32)
+typedef HANDLE MXFThread;
+typedef CRITICAL_SECTION MXFMutex;
+/* implemented with primitives available on Windows XP rather than the Vista CONDITION_VARIABLE */
+typedef struct
+{
+    HANDLE semaphore;
+    HANDLE wakeDoneEvent;
+    LONG numWaiters;
+    volatile LONG numWaking;
+} MXFCondition;
+typedef volatile LONG MXFOnce;
+#define MXF_ONCE_INIT   0
+#else
+typedef pthread_t MXFThread;
+typedef pthread_mutex_t MXFMutex;
+typedef pthread_cond_t MXFCondition;
+typedef pthread_once_t MXFOnce;
+#define MXF_ONCE_INIT   PTHREAD_ONCE_INIT
+#endif
+
+typedef void (*mxf_thread_func)(void* arg);
+typedef void (*mxf_once_func)(void);
+
+
+int mxf_create_thread(MXFThread* thread, mxf_thread_func func, void* arg);
+int mxf_join_thread(MXFThread* thread);
+
+int mxf_init_mutex(MXFMutex* mutex);
+void mxf_destroy_mutex(MXFMutex* mutex);
+void mxf_lock_mutex(MXFMutex* mutex);
+void mxf_unlock_mutex(MXFMutex* mutex);
+
+/* mxf_signal_condition and mxf_broadcast_condition must be called with the waiters' mutex locked */
+int mxf_init_condition(MXFCondition* condition);
+void mxf_destroy_condition(MXFCondition* condition);
+void mxf_wait_condition(MXFCondition* condition, MXFMutex* mutex);
+void mxf_signal_condition(MXFCondition* condition);
+void mxf_broadcast_condition(MXFCondition* condition);
+
+/* calls func exactly once for a MXFOnce initialised with MXF_ONCE_INIT, even if called concurrently */
+int mxf_call_once(MXFOnce* once, mxf_once_func func);
+
+/* microseconds from an arbitrary start point; not affected by changes to the system time */
+int64_t mxf_get_monotonic_time_usec(void);
+
+void mxf_sleep_usec(int64_t usec);
+
+
+/* atomic operations: load has acquire semantics, store has release semantics and
+   compare_and_swap and add are full barriers */
+uint32_t mxf_atomic_load_u32(volatile uint32_t* value);
+void mxf_atomic_store_u32(volatile uint32_t* value, uint32_t newValue);
+int mxf_atomic_compare_and_swap_u32(volatile uint32_t* value, uint32_t expected, uint32_t newValue);
+/* returns the new value */
+uint32_t mxf_atomic_add_u32(volatile uint32_t* value, uint32_t increment);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+
+#endif
+
+
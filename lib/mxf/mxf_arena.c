@@ -0,0 +1,136 @@
+/*
+ * $Id$
+ *
+ * Arena (region) allocator
+ *
+ * Copyright (C) 2010  British Broadcasting Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include <mxf/mxf.h>
+
+
+#define DEFAULT_BLOCK_SIZE      (64 * 1024)
+
+#define ALIGNMENT               8
+#define ALIGN_SIZE(size)        (((size) + ALIGNMENT - 1) & ~((size_t)ALIGNMENT - 1))
+
+/* the block header size is rounded up so that the block data is aligned */
+#define BLOCK_HEADER_SIZE       ALIGN_SIZE(sizeof(MXFArenaBlock))
+
+
+static MXFArenaBlock* create_block(size_t size)
+{
+    MXFArenaBlock* newBlock;
+
+    newBlock = (MXFArenaBlock*)malloc(BLOCK_HEADER_SIZE + size);
+    if (newBlock == NULL)
+    {
+        mxf_log_error("Failed to allocate arena block of size %lu" LOG_LOC_FORMAT, (unsigned long)size,
+            LOG_LOC_PARAMS);
+        return NULL;
+    }
+    newBlock->next = NULL;
+    newBlock->size = size;
+    newBlock->used = 0;
+
+    return newBlock;
+}
+
+
+
+int mxf_create_arena(MXFArena** arena, size_t blockSize)
+{
+    MXFArena* newArena;
+
+    CHK_MALLOC_ORET(newArena, MXFArena);
+    memset(newArena, 0, sizeof(MXFArena));
+    newArena->blockSize = ALIGN_SIZE(blockSize == 0 ? DEFAULT_BLOCK_SIZE : blockSize);
+
+    *arena = newArena;
+    return 1;
+}
+
+void mxf_free_arena(MXFArena** arena)
+{
+    MXFArenaBlock* block;
+    MXFArenaBlock* nextBlock;
+
+    if (*arena == NULL)
+    {
+        return;
+    }
+
+    block = (*arena)->blocks;
+    while (block != NULL)
+    {
+        nextBlock = block->next;
+        free(block);
+        block = nextBlock;
+    }
+
+    SAFE_FREE(arena);
+}
+
+void* mxf_arena_alloc(MXFArena* arena, size_t size)
+{
+    MXFArenaBlock* block = arena->blocks;
+    MXFArenaBlock* newBlock;
+    void* result;
+
+    size = ALIGN_SIZE(size);
+
+    if (block == NULL || block->size - block->used < size)
+    {
+        if (size > arena->blockSize / 4)
+        {
+            /* large allocations get a block of their own, leaving the current block in use */
+            if ((newBlock = create_block(size)) == NULL)
+            {
+                return NULL;
+            }
+            newBlock->used = size;
+            if (block == NULL)
+            {
+                arena->blocks = newBlock;
+            }
+            else
+            {
+                newBlock->next = block->next;
+                block->next = newBlock;
+            }
+            return (uint8_t*)newBlock + BLOCK_HEADER_SIZE;
+        }
+
+        if ((block = create_block(arena->blockSize)) == NULL)
+        {
+            return NULL;
+        }
+        block->next = arena->blocks;
+        arena->blocks = block;
+    }
+
+    result = (uint8_t*)block + BLOCK_HEADER_SIZE + block->used;
+    block->used += size;
+
+    return result;
+}
+
@@ -0,0 +1,247 @@
+/*
+ * $Id$
+ *
+ * CRC-32 (ISO/IEC 8802-3) calculation
+ *
+ * Copyright (C) 2010  British Broadcasting Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include <mxf/mxf.h>
+
+#include "mxf_crc32_data.h"
+
+
+#if defined(__GNUC__) && (__GNUC__ >= 5 || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_CLMUL_CRC32    1
+#define CLMUL_TARGET        __attribute__((target("pclmul,sse2")))
+#include <cpuid.h>
+#include <emmintrin.h>
+#include <wmmintrin.h>
+#elif defined(_MSC_VER) && _MSC_VER >= 1600 && (defined(_M_X64) || defined(_M_IX86))
+#define HAVE_CLMUL_CRC32    1
+#define CLMUL_TARGET
+#include <intrin.h>
+#endif
+
+
+/* the carry-less multiplication path needs at least 4 x 16 bytes to set up the folding */
+#define CLMUL_MIN_SIZE      64
+
+
+#if defined(HAVE_CLMUL_CRC32)
+
+/* -1: not checked yet, 0: not supported, 1: supported.
+   The check always produces the same value and so concurrent first calls are harmless */
+static volatile int g_cpuHasCLMul = -1;
+static volatile int g_simdEnabled = 1;
+
+static int cpu_has_clmul(void)
+{
+    if (g_cpuHasCLMul < 0)
+    {
+#if defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 1);
+        g_cpuHasCLMul = ((info[2] & (1 << 1)) && (info[3] & (1 << 26))) ? 1 : 0;
+#else
+        unsigned int eax, ebx, ecx, edx;
+        if (__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+        {
+            g_cpuHasCLMul = ((ecx & bit_PCLMUL) && (edx & bit_SSE2)) ? 1 : 0;
+        }
+        else
+        {
+            g_cpuHasCLMul = 0;
+        }
+#endif
+    }
+
+    return g_cpuHasCLMul;
+}
+
+/* Folds 4 x 128 bits in parallel, then down to 128 bits and finally uses a Barrett reduction to get to
+   32 bits. See "Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction", Intel, 2009.
+   The constants are the bit-reflected x^(4*128+32) mod P, x^(4*128-32) mod P, x^(128+32) mod P,
+   x^(128-32) mod P, x^64 mod P, P and the Barrett constant floor(x^64 / P).
+   size must be >= CLMUL_MIN_SIZE and a multiple of 16. crc is the (non-inverted) CRC register */
+CLMUL_TARGET static uint32_t clmul_update_crc32(uint32_t crc, const uint8_t* data, uint32_t size)
+{
+    const __m128i k1k2 = _mm_set_epi32(0x00000001, 0xc6e41596, 0x00000001, 0x54442bd4);
+    const __m128i k3k4 = _mm_set_epi32(0x00000000, 0xccaa009e, 0x00000001, 0x751997d0);
+    const __m128i k5k0 = _mm_set_epi32(0x00000000, 0x00000000, 0x00000001, 0x63cd6124);
+    const __m128i poly = _mm_set_epi32(0x00000001, 0xf7011641, 0x00000001, 0xdb710641);
+    const __m128i mask32 = _mm_set_epi32(0, ~0, 0, ~0);
+    __m128i x0, x1, x2, x3, x4, x5, x6, x7, x8;
+
+    x1 = _mm_loadu_si128((const __m128i*)(data + 0x00));
+    x2 = _mm_loadu_si128((const __m128i*)(data + 0x10));
+    x3 = _mm_loadu_si128((const __m128i*)(data + 0x20));
+    x4 = _mm_loadu_si128((const __m128i*)(data + 0x30));
+    x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128((int)crc));
+    data += 64;
+    size -= 64;
+
+    /* fold 4 x 128 bits in parallel */
+    x0 = k1k2;
+    while (size >= 64)
+    {
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x6 = _mm_clmulepi64_si128(x2, x0, 0x00);
+        x7 = _mm_clmulepi64_si128(x3, x0, 0x00);
+        x8 = _mm_clmulepi64_si128(x4, x0, 0x00);
+
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x2 = _mm_clmulepi64_si128(x2, x0, 0x11);
+        x3 = _mm_clmulepi64_si128(x3, x0, 0x11);
+        x4 = _mm_clmulepi64_si128(x4, x0, 0x11);
+
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128((const __m128i*)(data + 0x00)));
+        x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128((const __m128i*)(data + 0x10)));
+        x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128((const __m128i*)(data + 0x20)));
+        x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128((const __m128i*)(data + 0x30)));
+
+        data += 64;
+        size -= 64;
+    }
+
+    /* fold the 4 x 128 bits into 128 bits */
+    x0 = k3k4;
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x2), x5);
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x3), x5);
+
+    x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+    x1 = _mm_xor_si128(_mm_xor_si128(x1, x4), x5);
+
+    /* fold in the remaining 16 byte blocks */
+    while (size >= 16)
+    {
+        x5 = _mm_clmulepi64_si128(x1, x0, 0x00);
+        x1 = _mm_clmulepi64_si128(x1, x0, 0x11);
+        x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128((const __m128i*)data)), x5);
+
+        data += 16;
+        size -= 16;
+    }
+
+    /* fold 128 bits to 64 bits */
+    x2 = _mm_clmulepi64_si128(x1, x0, 0x10);
+    x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), x2);
+
+    x0 = k5k0;
+    x2 = _mm_srli_si128(x1, 4);
+    x1 = _mm_and_si128(x1, mask32);
+    x1 = _mm_clmulepi64_si128(x1, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    /* Barrett reduction to 32 bits */
+    x0 = poly;
+    x2 = _mm_and_si128(x1, mask32);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x10);
+    x2 = _mm_and_si128(x2, mask32);
+    x2 = _mm_clmulepi64_si128(x2, x0, 0x00);
+    x1 = _mm_xor_si128(x1, x2);
+
+    return (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(x1, 4));
+}
+
+#endif
+
+
+/* slicing-by-8; the 8 byte words are assembled byte by byte so that it is independent of the endianness.
+   crc is the (non-inverted) CRC register */
+static uint32_t table_update_crc32(uint32_t crc, const uint8_t* data, uint32_t size)
+{
+    uint32_t one;
+    uint32_t two;
+
+    while (size >= 8)
+    {
+        one = crc ^ (data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24));
+        two = data[4] | ((uint32_t)data[5] << 8) | ((uint32_t)data[6] << 16) | ((uint32_t)data[7] << 24);
+        crc = g_crc32Tables[7][one & 0xff] ^
+              g_crc32Tables[6][(one >> 8) & 0xff] ^
+              g_crc32Tables[5][(one >> 16) & 0xff] ^
+              g_crc32Tables[4][one >> 24] ^
+              g_crc32Tables[3][two & 0xff] ^
+              g_crc32Tables[2][(two >> 8) & 0xff] ^
+              g_crc32Tables[1][(two >> 16) & 0xff] ^
+              g_crc32Tables[0][two >> 24];
+
+        data += 8;
+        size -= 8;
+    }
+
+    while (size > 0)
+    {
+        crc = g_crc32Tables[0][(crc ^ *data) & 0xff] ^ (crc >> 8);
+        data++;
+        size--;
+    }
+
+    return crc;
+}
+
+
+
+uint32_t mxf_calc_crc32(const uint8_t* data, uint32_t size)
+{
+    return mxf_update_crc32(0, data, size);
+}
+
+uint32_t mxf_update_crc32(uint32_t crc32, const uint8_t* data, uint32_t size)
+{
+    uint32_t crc = ~crc32;
+#if defined(HAVE_CLMUL_CRC32)
+    uint32_t clmulSize;
+
+    if (size >= CLMUL_MIN_SIZE && g_simdEnabled && cpu_has_clmul())
+    {
+        clmulSize = size & ~(uint32_t)15;
+        crc = clmul_update_crc32(crc, data, clmulSize);
+        data += clmulSize;
+        size -= clmulSize;
+    }
+#endif
+
+    return ~table_update_crc32(crc, data, size);
+}
+
+int mxf_have_crc32_simd(void)
+{
+#if defined(HAVE_CLMUL_CRC32)
+    return g_simdEnabled && cpu_has_clmul();
+#else
+    return 0;
+#endif
+}
+
+void mxf_enable_crc32_simd(int enable)
+{
+#if defined(HAVE_CLMUL_CRC32)
+    g_simdEnabled = enable;
+#else
+    (void)enable;
+#endif
+}
+
@@ -26,6 +26,15 @@
 #include <stdio.h>
 
 #include <mxf/mxf.h>
+#include <mxf/mxf_thread.h>
+
+
+/* guards the references to all shared data models */
+static MXFOnce g_sharedDataModelOnce = MXF_ONCE_INIT;
+static MXFMutex g_sharedDataModelMutex;
+static int g_haveSharedDataModelMutex = 0;
+
+static MXFDataModel* g_defaultDataModel = NULL;
 
 
 
@@ -97,29 +106,24 @@ static void free_set_def_in_list(void* data)
     }
     
     setDef = (MXFSetDef*)data;
+    mxf_clear_hash_table(&setDef->itemDefsIndex);
     mxf_clear_list(&setDef->itemDefs);
     free_set_def(&setDef);
 }
 
-static int set_def_eq(void* data, void* info)
-{
-    assert(data != NULL && info != NULL);
-    
-    return mxf_equals_key((mxfKey*)info, &((MXFSetDef*)data)->key);
-}
-
-static int item_def_eq(void* data, void* info)
-{
-    assert(data != NULL && info != NULL);
-    
-    return mxf_equals_key((mxfKey*)info, &((MXFItemDef*)data)->key);
-}
+/* the first def registered with a key is the one found by the mxf_find_... functions,
+   duplicates are reported by mxf_check_data_model */
 
 static int add_set_def(MXFDataModel* dataModel, MXFSetDef* setDef)
 {
     assert(setDef != NULL);
     
-    CHK_ORET(mxf_append_list_element(&dataModel->setDefs, (void*)setDef));
+    CHK_ORET(mxf_add_hash_element(&dataModel->setDefsIndex, (const mxfUID*)&setDef->key, (void*)setDef));
+    if (!mxf_append_list_element(&dataModel->setDefs, (void*)setDef))
+    {
+        mxf_remove_hash_element(&dataModel->setDefsIndex, (const mxfUID*)&setDef->key, (void*)setDef);
+        return 0;
+    }
     
     return 1;
 }
@@ -128,7 +132,12 @@ static int add_item_def(MXFDataModel* dataModel, MXFItemDef* itemDef)
 {
     assert(itemDef != NULL);
     
-    CHK_ORET(mxf_append_list_element(&dataModel->itemDefs, (void*)itemDef));
+    CHK_ORET(mxf_add_hash_element(&dataModel->itemDefsIndex, (const mxfUID*)&itemDef->key, (void*)itemDef));
+    if (!mxf_append_list_element(&dataModel->itemDefs, (void*)itemDef))
+    {
+        mxf_remove_hash_element(&dataModel->itemDefsIndex, (const mxfUID*)&itemDef->key, (void*)itemDef);
+        return 0;
+    }
     
     return 1;
 }
@@ -214,6 +223,8 @@ int mxf_load_data_model(MXFDataModel** dataModel)
     memset(newDataModel, 0, sizeof(MXFDataModel));
     mxf_initialise_list(&newDataModel->itemDefs, free_item_def_in_list); 
     mxf_initialise_list(&newDataModel->setDefs, free_set_def_in_list); 
+    mxf_initialise_hash_table(&newDataModel->itemDefsIndex, NULL); 
+    mxf_initialise_hash_table(&newDataModel->setDefsIndex, NULL); 
     
 #include <mxf/mxf_baseline_data_model.h>
 
@@ -260,6 +271,55 @@ int mxf_load_extensions_data_model(MXFDataModel* dataModel)
 #pragma warning(pop)
 #endif
 
+static void init_shared_data_model_mutex(void)
+{
+    g_haveSharedDataModelMutex = mxf_init_mutex(&g_sharedDataModelMutex);
+}
+
+static int load_default_data_model(MXFDataModel** dataModel)
+{
+    MXFDataModel* newDataModel = NULL;
+
+    CHK_ORET(mxf_load_data_model(&newDataModel));
+    CHK_OFAIL(mxf_finalise_data_model(newDataModel));
+
+    *dataModel = newDataModel;
+    return 1;
+
+fail:
+    mxf_free_data_model(&newDataModel);
+    return 0;
+}
+
+int mxf_get_shared_data_model(MXFDataModel** sharedDataModel, mxf_load_shared_data_model_func loadFunc,
+    MXFDataModel** dataModel)
+{
+    CHK_ORET(mxf_call_once(&g_sharedDataModelOnce, init_shared_data_model_mutex));
+    CHK_ORET(g_haveSharedDataModelMutex);
+
+    mxf_lock_mutex(&g_sharedDataModelMutex);
+    if (*sharedDataModel == NULL)
+    {
+        if (!loadFunc(sharedDataModel))
+        {
+            mxf_unlock_mutex(&g_sharedDataModelMutex);
+            return 0;
+        }
+        (*sharedDataModel)->isReadOnly = 1;
+        (*sharedDataModel)->sharedRef = sharedDataModel;
+    }
+    (*sharedDataModel)->refCount++;
+    *dataModel = *sharedDataModel;
+    mxf_unlock_mutex(&g_sharedDataModelMutex);
+
+    return 1;
+}
+
+int mxf_get_default_data_model(MXFDataModel** dataModel)
+{
+    return mxf_get_shared_data_model(&g_defaultDataModel, load_default_data_model, dataModel);
+}
+
 void mxf_free_data_model(MXFDataModel** dataModel)
 {
     size_t i;
@@ -269,6 +329,23 @@ void mxf_free_data_model(MXFDataModel** dataModel)
         return;
     }
     
+    /* release a reference to a shared data model */
+    if ((*dataModel)->isReadOnly)
+    {
+        mxf_lock_mutex(&g_sharedDataModelMutex);
+        (*dataModel)->refCount--;
+        if ((*dataModel)->refCount > 0)
+        {
+            mxf_unlock_mutex(&g_sharedDataModelMutex);
+            *dataModel = NULL;
+            return;
+        }
+        *(*dataModel)->sharedRef = NULL;
+        mxf_unlock_mutex(&g_sharedDataModelMutex);
+    }
+    
+    mxf_clear_hash_table(&(*dataModel)->setDefsIndex);
+    mxf_clear_hash_table(&(*dataModel)->itemDefsIndex);
     mxf_clear_list(&(*dataModel)->setDefs);
     mxf_clear_list(&(*dataModel)->itemDefs);
     
@@ -287,6 +364,8 @@ int mxf_register_set_def(MXFDataModel* dataModel, const char* name, const mxfKey
 {
     MXFSetDef* newSetDef = NULL;
     
+    CHK_ORET(!dataModel->isReadOnly);
+    
     CHK_MALLOC_ORET(newSetDef, MXFSetDef);
     memset(newSetDef, 0, sizeof(MXFSetDef));
     if (name != NULL)
@@ -297,6 +376,7 @@ int mxf_register_set_def(MXFDataModel* dataModel, const char* name, const mxfKey
     newSetDef->parentSetDefKey = *parentKey;
     newSetDef->key = *key;
     mxf_initialise_list(&newSetDef->itemDefs, NULL);
+    mxf_initialise_hash_table(&newSetDef->itemDefsIndex, NULL);
     
     CHK_OFAIL(add_set_def(dataModel, newSetDef));
     
@@ -312,6 +392,8 @@ int mxf_register_item_def(MXFDataModel* dataModel, const char* name, const mxfKe
 {
     MXFItemDef* newItemDef = NULL;
     
+    CHK_ORET(!dataModel->isReadOnly);
+    
     CHK_MALLOC_ORET(newItemDef, MXFItemDef);
     memset(newItemDef, 0, sizeof(MXFItemDef));
     if (name != NULL)
@@ -339,6 +421,8 @@ MXFItemType* mxf_register_basic_type(MXFDataModel* dataModel, const char* name,
 {
     MXFItemType* type;
     
+    CHK_ORET(!dataModel->isReadOnly);
+    
     /* basic types can only be built-in */
     CHK_ORET(typeId > 0 && typeId < MXF_EXTENSION_TYPE);
     
@@ -368,6 +452,8 @@ MXFItemType* mxf_register_array_type(MXFDataModel* dataModel, const char* name,
     unsigned int actualTypeId;
     MXFItemType* type;
     
+    CHK_ORET(!dataModel->isReadOnly);
+    
     if (typeId <= 0)
     {
         actualTypeId = get_type_id(dataModel);
@@ -403,6 +489,8 @@ MXFItemType* mxf_register_compound_type(MXFDataModel* dataModel, const char* nam
     unsigned int actualTypeId;
     MXFItemType* type = NULL;
     
+    CHK_ORET(!dataModel->isReadOnly);
+    
     if (typeId == 0)
     {
         actualTypeId = get_type_id(dataModel);
@@ -467,6 +555,8 @@ MXFItemType* mxf_register_interpret_type(MXFDataModel* dataModel, const char* na
     unsigned int actualTypeId;
     MXFItemType* type;
     
+    CHK_ORET(!dataModel->isReadOnly);
+    
     if (typeId == 0)
     {
         actualTypeId = get_type_id(dataModel);
@@ -504,11 +594,14 @@ int mxf_finalise_data_model(MXFDataModel* dataModel)
     MXFItemDef* itemDef;
     MXFSetDef* setDef;
 
+    CHK_ORET(!dataModel->isReadOnly);
+
     /* reset set defs and set the parent set def if the parent set def key != g_Null_Key */
     mxf_initialise_list_iter(&iter, &dataModel->setDefs);
     while (mxf_next_list_iter_element(&iter))
     {
         setDef = (MXFSetDef*)mxf_get_iter_element(&iter);
+        mxf_clear_hash_table(&setDef->itemDefsIndex);
         mxf_clear_list(&setDef->itemDefs);
         setDef->parentSetDef = NULL;
 
@@ -526,6 +619,7 @@ int mxf_finalise_data_model(MXFDataModel* dataModel)
 
         CHK_ORET(mxf_find_set_def(dataModel, &itemDef->setDefKey, &setDef));
         CHK_ORET(mxf_append_list_element(&setDef->itemDefs, (void*)itemDef));
+        CHK_ORET(mxf_add_hash_element(&setDef->itemDefsIndex, (const mxfUID*)&itemDef->key, (void*)itemDef));
     }
     
     return 1;
@@ -533,102 +627,93 @@ int mxf_finalise_data_model(MXFDataModel* dataModel)
 
 int mxf_check_data_model(MXFDataModel* dataModel)
 {
-    MXFListIterator iter1;
-    MXFListIterator iter2;
-    MXFSetDef* setDef1;
-    MXFSetDef* setDef2;
-    MXFItemDef* itemDef1;
-    MXFItemDef* itemDef2;
-    long listIndex;
+    MXFListIterator iter;
+    MXFSetDef* setDef;
+    MXFItemDef* itemDef;
+    uint8_t* tagsInUse = NULL;
 
     
-    /* check that the set defs are unique */
-    listIndex = 0;
-    mxf_initialise_list_iter(&iter1, &dataModel->setDefs);
-    while (mxf_next_list_iter_element(&iter1))
+    /* check that the set defs are unique - the index holds the first set def registered with a key */
+    mxf_initialise_list_iter(&iter, &dataModel->setDefs);
+    while (mxf_next_list_iter_element(&iter))
     {
-        setDef1 = (MXFSetDef*)mxf_get_iter_element(&iter1);
+        setDef = (MXFSetDef*)mxf_get_iter_element(&iter);
 
-        /* check with set defs with higher index in list */        
-        mxf_initialise_list_iter_at(&iter2, &dataModel->setDefs, listIndex + 1);
-        while (mxf_next_list_iter_element(&iter2))
+        if (mxf_find_hash_element(&dataModel->setDefsIndex, (const mxfUID*)&setDef->key) != setDef)
         {
-            setDef2 = (MXFSetDef*)mxf_get_iter_element(&iter2);
-            if (mxf_equals_key(&setDef1->key, &setDef2->key))
-            {
-                char keyStr[KEY_STR_SIZE];
-                mxf_sprint_key(keyStr, &setDef1->key);
-                mxf_log_warn("Duplicate set def found. Key = %s" 
-                    LOG_LOC_FORMAT, keyStr, LOG_LOC_PARAMS); 
-                return 0;
-            }
+            char keyStr[KEY_STR_SIZE];
+            mxf_sprint_key(keyStr, &setDef->key);
+            mxf_log_warn("Duplicate set def found. Key = %s" 
+                LOG_LOC_FORMAT, keyStr, LOG_LOC_PARAMS); 
+            return 0;
         }
-        listIndex++;
     }
 
     /* check that the item defs are unique (both key and static local tag),
        , that the item def is contained in a set def
        and the item type is known */
-    listIndex = 0;
-    mxf_initialise_list_iter(&iter1, &dataModel->itemDefs);
-    while (mxf_next_list_iter_element(&iter1))
+    CHK_MALLOC_ARRAY_ORET(tagsInUse, uint8_t, 65536 / 8);
+    memset(tagsInUse, 0, 65536 / 8);
+    mxf_initialise_list_iter(&iter, &dataModel->itemDefs);
+    while (mxf_next_list_iter_element(&iter))
     {
-        itemDef1 = (MXFItemDef*)mxf_get_iter_element(&iter1);
+        itemDef = (MXFItemDef*)mxf_get_iter_element(&iter);
 
         /* check item def is contained in a set def */
-        if (mxf_equals_key(&itemDef1->setDefKey, &g_Null_Key))
+        if (mxf_equals_key(&itemDef->setDefKey, &g_Null_Key))
         {
             char keyStr[KEY_STR_SIZE];
-            mxf_sprint_key(keyStr, &itemDef1->key);
+            mxf_sprint_key(keyStr, &itemDef->key);
             mxf_log_warn("Found item def not contained in any set def. Key = %s" 
                 LOG_LOC_FORMAT, keyStr, LOG_LOC_PARAMS); 
-            return 0;
+            goto fail;
         }
         
-        /* check with item defs with higher index in list */        
-        mxf_initialise_list_iter_at(&iter2, &dataModel->itemDefs, listIndex + 1);
-        while (mxf_next_list_iter_element(&iter2))
+        if (mxf_find_hash_element(&dataModel->itemDefsIndex, (const mxfUID*)&itemDef->key) != itemDef)
         {
-            itemDef2 = (MXFItemDef*)mxf_get_iter_element(&iter2);
-            if (mxf_equals_key(&itemDef1->key, &itemDef2->key))
-            {
-                char keyStr[KEY_STR_SIZE];
-                mxf_sprint_key(keyStr, &itemDef1->key);
-                mxf_log_warn("Duplicate item def found. Key = %s" 
-                    LOG_LOC_FORMAT, keyStr, LOG_LOC_PARAMS); 
-                return 0;
-            }
-            if (itemDef1->localTag != 0 && itemDef1->localTag == itemDef2->localTag)
+            char keyStr[KEY_STR_SIZE];
+            mxf_sprint_key(keyStr, &itemDef->key);
+            mxf_log_warn("Duplicate item def found. Key = %s" 
+                LOG_LOC_FORMAT, keyStr, LOG_LOC_PARAMS); 
+            goto fail;
+        }
+        if (itemDef->localTag != 0)
+        {
+            if (tagsInUse[itemDef->localTag >> 3] & (1 << (itemDef->localTag & 0x07)))
             {
                 char keyStr[KEY_STR_SIZE];
-                mxf_sprint_key(keyStr, &itemDef1->key);
+                mxf_sprint_key(keyStr, &itemDef->key);
                 mxf_log_warn("Duplicate item def local tag found. LocalTag = 0x%04x, Key = %s" 
-                    LOG_LOC_FORMAT, itemDef1->localTag, keyStr, LOG_LOC_PARAMS); 
-                return 0;
+                    LOG_LOC_FORMAT, itemDef->localTag, keyStr, LOG_LOC_PARAMS); 
+                goto fail;
             }
+            tagsInUse[itemDef->localTag >> 3] |= (1 << (itemDef->localTag & 0x07));
         }
         
         /* check item type is valid and known */
-        if (mxf_get_item_def_type(dataModel, itemDef1->typeId) == NULL)
+        if (mxf_get_item_def_type(dataModel, itemDef->typeId) == NULL)
         {
             char keyStr[KEY_STR_SIZE];
-            mxf_sprint_key(keyStr, &itemDef1->key);
+            mxf_sprint_key(keyStr, &itemDef->key);
             mxf_log_warn("Item def has unknown type (%d). LocalTag = 0x%04x, Key = %s" 
-                LOG_LOC_FORMAT, itemDef1->typeId, itemDef1->localTag, keyStr, LOG_LOC_PARAMS); 
-            return 0;
+                LOG_LOC_FORMAT, itemDef->typeId, itemDef->localTag, keyStr, LOG_LOC_PARAMS); 
+            goto fail;
         }
-        
-        listIndex++;
     }
     
+    SAFE_FREE(&tagsInUse);
     return 1;
+    
+fail:
+    SAFE_FREE(&tagsInUse);
+    return 0;
 }
 
 int mxf_find_set_def(MXFDataModel* dataModel, const mxfKey* key, MXFSetDef** setDef)
 {
     void* result;
     
-    if ((result = mxf_find_list_element(&dataModel->setDefs, (void*)key, set_def_eq)) != NULL)
+    if ((result = mxf_find_hash_element(&dataModel->setDefsIndex, (const mxfUID*)key)) != NULL)
     {
         *setDef = (MXFSetDef*)result;
         return 1;
@@ -641,7 +726,7 @@ int mxf_find_item_def(MXFDataModel* dataModel, const mxfKey* key, MXFItemDef** i
 {
     void* result;
     
-    if ((result = mxf_find_list_element(&dataModel->itemDefs, (void*)key, item_def_eq)) != NULL)
+    if ((result = mxf_find_hash_element(&dataModel->itemDefsIndex, (const mxfUID*)key)) != NULL)
     {
         *itemDef = (MXFItemDef*)result;
         return 1;
@@ -653,16 +738,17 @@ int mxf_find_item_def(MXFDataModel* dataModel, const mxfKey* key, MXFItemDef** i
 int mxf_find_item_def_in_set_def(const mxfKey* key, const MXFSetDef* setDef, MXFItemDef** itemDef)
 {
     void* result;
+    const MXFSetDef* currentSetDef = setDef;
     
-    if ((result = mxf_find_list_element(&setDef->itemDefs, (void*)key, item_def_eq)) != NULL)
+    while (currentSetDef != NULL)
     {
-        *itemDef = (MXFItemDef*)result;
-        return 1;
-    }
-    
-    if (setDef->parentSetDef != NULL)
-    {
-        return mxf_find_item_def_in_set_def(key, setDef->parentSetDef, itemDef);
+        if ((result = mxf_find_hash_element(&currentSetDef->itemDefsIndex, (const mxfUID*)key)) != NULL)
+        {
+            *itemDef = (MXFItemDef*)result;
+            return 1;
+        }
+        
+        currentSetDef = currentSetDef->parentSetDef;
     }
     
     return 0;
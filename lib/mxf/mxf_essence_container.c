@@ -188,6 +188,31 @@ int mxf_read_essence_element_data(MXFFile* mxfFile, MXFEssenceElement* essenceEl
     return 1;
 }
 
+int mxf_copy_essence_element_data(MXFFile* sourceFile, MXFEssenceElement* sourceElement,
+    MXFFile* destFile, MXFEssenceElement* destElement, uint64_t len, uint64_t* numCopied)
+{
+    uint64_t remainder = 0;
+    uint64_t actualNumCopied;
+    
+    if ((uint64_t)(sourceElement->currentFilePos - sourceElement->startFilePos) < sourceElement->totalLen)
+    {
+        remainder = sourceElement->totalLen - (uint64_t)(sourceElement->currentFilePos - sourceElement->startFilePos);
+    }
+    if (len > remainder)
+    {
+        len = remainder;
+    }
+    
+    actualNumCopied = mxf_file_copy(destFile, sourceFile, len);
+    sourceElement->currentFilePos += actualNumCopied;
+    destElement->totalLen += actualNumCopied;
+    destElement->currentFilePos += actualNumCopied;
+    CHK_ORET(actualNumCopied == len);
+    
+    *numCopied = actualNumCopied;
+    return 1;
+}
+
 void mxf_close_essence_element(MXFEssenceElement** essenceElement)
 {
     free_essence_element(essenceElement);
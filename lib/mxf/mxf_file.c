@@ -21,10 +21,16 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
  */
  
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+/* required for O_DIRECT */
+#define _GNU_SOURCE
+#endif
+
 #include <assert.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <errno.h>
 
 #if defined(_WIN32)
 #include <io.h>
@@ -32,6 +38,17 @@
 #include <sys/stat.h>
 #else
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__)
+#include <sys/uio.h>
+#include <sys/sendfile.h>
+#include <sys/syscall.h>
+#define HAVE_PREADV 1
+#define HAVE_KERNEL_COPY 1
 #endif
 
 #include <mxf/mxf.h>
@@ -54,6 +71,19 @@
 /* size of buffer used to skip data by reading and discarding */
 #define SKIP_BUFFER_SIZE        2048
 
+/* direct (unbuffered) file writes are made in whole blocks from an aligned buffer */
+#define DIRECT_IO_ALIGNMENT     4096
+#define DIRECT_IO_BUFFER_SIZE   (4 * 1024 * 1024)
+
+/* maximum number of buffers passed to a single preadv call */
+#define MAX_READ_VECTORS        64
+
+/* size of the buffer used by mxf_file_copy if the data can't be copied in the kernel */
+#define COPY_BUFFER_SIZE        (4 * 1024 * 1024)
+
+/* maximum number of bytes passed to a single copy_file_range or sendfile call */
+#define MAX_KERNEL_COPY_SIZE    (1024 * 1024 * 1024)
+
 
 struct MXFFileSysData
 {
@@ -73,6 +103,24 @@ struct MXFFileSysData
     const uint8_t* data;
     int64_t dataSize;
     int64_t pos;
+    
+    /* used for memory files */
+    uint8_t* memData;
+    int64_t memAllocSize;
+    
+    /* used for memory mapped files */
+    void* mapping;
+    size_t mappingSize;
+    
+    /* used for direct files */
+    int directFileId;
+    int bufferedFileId;
+    uint8_t* buffer;
+    uint32_t bufferOffset; /* bufferStart % DIRECT_IO_ALIGNMENT */
+    uint32_t bufferLen;
+    int64_t bufferStart;
+    int64_t position;
+    int64_t fileSize;
 };
 
 
@@ -166,6 +214,80 @@ static int64_t disk_file_tell(MXFFileSysData* sysData)
 #endif
 }
 
+#if defined(HAVE_PREADV) && !defined(USE_LOW_LEVEL_IO)
+/* reads at the stream position using the file descriptor and then repositions the stream after the data. 
+   Only used for files opened read-only, i.e. the stream has no pending writes */
+static uint64_t disk_file_read_vector(MXFFileSysData* sysData, const MXFIOVector* vectors, int count)
+{
+    struct iovec iov[MAX_READ_VECTORS];
+    int fileId = fileno(sysData->file);
+    int64_t position;
+    uint64_t total = 0;
+    uint32_t vectorOffset = 0;
+    ssize_t numRead;
+    int numIOV;
+    int i = 0;
+    int j;
+
+    if ((position = ftello(sysData->file)) < 0)
+    {
+        return 0;
+    }
+
+    while (i < count)
+    {
+        numIOV = 0;
+        for (j = i; j < count && numIOV < MAX_READ_VECTORS; j++)
+        {
+            iov[numIOV].iov_base = vectors[j].data + (j == i ? vectorOffset : 0);
+            iov[numIOV].iov_len = vectors[j].size - (j == i ? vectorOffset : 0);
+            numIOV++;
+        }
+
+        numRead = preadv(fileId, iov, numIOV, position);
+        if (numRead < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (numRead <= 0)
+        {
+            break;
+        }
+        position += numRead;
+        total += numRead;
+
+        /* move past the buffers that have been filled */
+        while (i < count && (uint64_t)numRead >= vectors[i].size - vectorOffset)
+        {
+            numRead -= vectors[i].size - vectorOffset;
+            vectorOffset = 0;
+            i++;
+        }
+        vectorOffset += (uint32_t)numRead;
+    }
+
+    if (fseeko(sysData->file, position, SEEK_SET) != 0)
+    {
+        return 0;
+    }
+
+    return total;
+}
+#endif
+
+#if defined(HAVE_KERNEL_COPY) && !defined(USE_LOW_LEVEL_IO)
+/* flushes pending writes so that the file descriptor can be used directly */
+static int disk_file_get_fd(MXFFileSysData* sysData)
+{
+    if (fflush(sysData->file) != 0)
+    {
+        return -1;
+    }
+    
+    return fileno(sysData->file);
+}
+#endif
+
 static void free_disk_file(MXFFileSysData* sysData)
 {
     if (sysData == NULL)
@@ -447,7 +569,8 @@ static int byte_array_file_seek(MXFFileSysData* sysData, int64_t offset, int whe
 {
     if (whence == SEEK_SET)
     {
-        if (offset < 0 || offset >= sysData->dataSize)
+        /* positioning at the end of the data is allowed */
+        if (offset < 0 || offset > sysData->dataSize)
         {
             return 0;
         }
@@ -455,7 +578,7 @@ static int byte_array_file_seek(MXFFileSysData* sysData, int64_t offset, int whe
     }
     else if (whence == SEEK_CUR)
     {
-        if (sysData->pos + offset < 0 || sysData->pos + offset >= sysData->dataSize)
+        if (sysData->pos + offset < 0 || sysData->pos + offset > sysData->dataSize)
         {
             return 0;
         }
@@ -491,6 +614,16 @@ static int64_t byte_array_size(MXFFileSysData* sysData)
     return sysData->dataSize;
 }
 
+static const uint8_t* byte_array_file_get_data(MXFFileSysData* sysData, int64_t offset, uint32_t count)
+{
+    if (offset < 0 || offset + count > sysData->dataSize)
+    {
+        return NULL;
+    }
+    
+    return &sysData->data[offset];
+}
+
 static void free_byte_array_file(MXFFileSysData* sysData)
 {
     if (sysData == NULL)
@@ -502,6 +635,372 @@ static void free_byte_array_file(MXFFileSysData* sysData)
 }
 
 
+/* a memory file is a byte array that grows when written beyond the end of the allocated data */
+
+static int mem_file_reserve(MXFFileSysData* sysData, int64_t size)
+{
+    uint8_t* newData;
+    int64_t newAllocSize;
+    
+    if (size <= sysData->memAllocSize)
+    {
+        return 1;
+    }
+    
+    newAllocSize = (sysData->memAllocSize < 256) ? 256 : sysData->memAllocSize;
+    while (newAllocSize < size)
+    {
+        newAllocSize *= 2;
+    }
+    if ((uint64_t)(size_t)newAllocSize != (uint64_t)newAllocSize)
+    {
+        return 0;
+    }
+    
+    newData = (uint8_t*)realloc(sysData->memData, (size_t)newAllocSize);
+    if (newData == NULL)
+    {
+        return 0;
+    }
+    sysData->memData = newData;
+    sysData->memAllocSize = newAllocSize;
+    sysData->data = newData;
+    
+    return 1;
+}
+
+static void mem_file_close(MXFFileSysData* sysData)
+{
+    SAFE_FREE(&sysData->memData);
+    sysData->memAllocSize = 0;
+    byte_array_file_close(sysData);
+}
+
+static uint32_t mem_file_write(MXFFileSysData* sysData, const uint8_t* data, uint32_t count)
+{
+    if (!mem_file_reserve(sysData, sysData->pos + count))
+    {
+        return 0;
+    }
+    
+    memcpy(&sysData->memData[sysData->pos], data, count);
+    sysData->pos += count;
+    if (sysData->pos > sysData->dataSize)
+    {
+        sysData->dataSize = sysData->pos;
+    }
+    
+    return count;
+}
+
+static int mem_file_putchar(MXFFileSysData* sysData, int c)
+{
+    uint8_t value = (uint8_t)c;
+    
+    if (mem_file_write(sysData, &value, 1) != 1)
+    {
+        return EOF;
+    }
+    
+    return c;
+}
+
+
+#if !defined(_WIN32)
+
+/* a memory mapped file is read as a byte array over the mapping */
+
+static void mmap_file_close(MXFFileSysData* sysData)
+{
+    if (sysData->mapping != NULL)
+    {
+        munmap(sysData->mapping, sysData->mappingSize);
+        sysData->mapping = NULL;
+        sysData->mappingSize = 0;
+    }
+    byte_array_file_close(sysData);
+}
+
+
+/* a direct file collects writes in an aligned buffer. Whole aligned blocks are written using a file 
+   descriptor opened with O_DIRECT (or F_NOCACHE) and partial blocks, e.g. at the start and end of a 
+   sequence of writes following a seek, are written through the page cache */
+
+static int direct_file_pwrite(int fileId, const uint8_t* data, uint32_t count, int64_t offset)
+{
+    ssize_t numWritten;
+    
+    while (count > 0)
+    {
+        numWritten = pwrite(fileId, data, count, (off_t)offset);
+        if (numWritten < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return 0;
+        }
+        data += numWritten;
+        count -= (uint32_t)numWritten;
+        offset += numWritten;
+    }
+    
+    return 1;
+}
+
+static int direct_file_flush(MXFFileSysData* sysData)
+{
+    const uint8_t* data = &sysData->buffer[sysData->bufferOffset];
+    int64_t offset = sysData->bufferStart;
+    uint32_t len = sysData->bufferLen;
+    uint32_t headLen;
+    uint32_t directLen;
+    
+    if (len == 0)
+    {
+        return 1;
+    }
+    
+    /* partial block at the start */
+    if (sysData->bufferOffset > 0)
+    {
+        headLen = DIRECT_IO_ALIGNMENT - sysData->bufferOffset;
+        if (headLen > len)
+        {
+            headLen = len;
+        }
+        CHK_ORET(direct_file_pwrite(sysData->bufferedFileId, data, headLen, offset));
+        data += headLen;
+        offset += headLen;
+        len -= headLen;
+    }
+    
+    /* whole blocks; the buffer data is aligned in memory the same way as in the file */
+    directLen = len - len % DIRECT_IO_ALIGNMENT;
+    if (directLen > 0)
+    {
+        if (!direct_file_pwrite(sysData->directFileId, data, directLen, offset))
+        {
+            /* e.g. the file system doesn't support direct I/O for this file */
+            CHK_ORET(sysData->directFileId != sysData->bufferedFileId);
+            mxf_log_warn("Direct write failed (%s); falling back to buffered writes" LOG_LOC_FORMAT,
+                strerror(errno), LOG_LOC_PARAMS);
+            close(sysData->directFileId);
+            sysData->directFileId = sysData->bufferedFileId;
+            CHK_ORET(direct_file_pwrite(sysData->bufferedFileId, data, directLen, offset));
+        }
+        data += directLen;
+        offset += directLen;
+        len -= directLen;
+    }
+    
+    /* partial block at the end */
+    if (len > 0)
+    {
+        CHK_ORET(direct_file_pwrite(sysData->bufferedFileId, data, len, offset));
+    }
+    
+    if (sysData->bufferStart + sysData->bufferLen > sysData->fileSize)
+    {
+        sysData->fileSize = sysData->bufferStart + sysData->bufferLen;
+    }
+    sysData->bufferStart += sysData->bufferLen;
+    sysData->bufferOffset = (uint32_t)(sysData->bufferStart % DIRECT_IO_ALIGNMENT);
+    sysData->bufferLen = 0;
+    
+    return 1;
+}
+
+static void direct_file_close(MXFFileSysData* sysData)
+{
+    if (sysData->bufferedFileId != -1)
+    {
+        if (!direct_file_flush(sysData))
+        {
+            mxf_log_error("Failed to flush direct file buffer" LOG_LOC_FORMAT, LOG_LOC_PARAMS);
+        }
+        if (sysData->directFileId != sysData->bufferedFileId)
+        {
+            close(sysData->directFileId);
+        }
+        close(sysData->bufferedFileId);
+        sysData->directFileId = -1;
+        sysData->bufferedFileId = -1;
+    }
+}
+
+static uint32_t direct_file_read(MXFFileSysData* sysData, uint8_t* data, uint32_t count)
+{
+    ssize_t numRead;
+    
+    if (!direct_file_flush(sysData))
+    {
+        return 0;
+    }
+    
+    do
+    {
+        numRead = pread(sysData->bufferedFileId, data, count, (off_t)sysData->position);
+    }
+    while (numRead < 0 && errno == EINTR);
+    if (numRead < 0)
+    {
+        return 0;
+    }
+    sysData->position += numRead;
+    
+    return (uint32_t)numRead;
+}
+
+static uint32_t direct_file_write(MXFFileSysData* sysData, const uint8_t* data, uint32_t count)
+{
+    uint32_t totalWritten = 0;
+    uint32_t numWrite;
+    
+    /* start a new sequence of writes if the position has changed */
+    if (sysData->position != sysData->bufferStart + sysData->bufferLen)
+    {
+        if (!direct_file_flush(sysData))
+        {
+            return 0;
+        }
+        sysData->bufferStart = sysData->position;
+        sysData->bufferOffset = (uint32_t)(sysData->position % DIRECT_IO_ALIGNMENT);
+    }
+    
+    while (totalWritten < count)
+    {
+        numWrite = DIRECT_IO_BUFFER_SIZE - sysData->bufferOffset - sysData->bufferLen;
+        if (numWrite > count - totalWritten)
+        {
+            numWrite = count - totalWritten;
+        }
+        memcpy(&sysData->buffer[sysData->bufferOffset + sysData->bufferLen], &data[totalWritten], numWrite);
+        sysData->bufferLen += numWrite;
+        sysData->position += numWrite;
+        totalWritten += numWrite;
+        
+        if (sysData->bufferOffset + sysData->bufferLen == DIRECT_IO_BUFFER_SIZE)
+        {
+            if (!direct_file_flush(sysData))
+            {
+                return 0;
+            }
+        }
+    }
+    
+    return totalWritten;
+}
+
+static int direct_file_getchar(MXFFileSysData* sysData)
+{
+    uint8_t c;
+    
+    if (direct_file_read(sysData, &c, 1) != 1)
+    {
+        return EOF;
+    }
+    return c;
+}
+
+static int direct_file_putchar(MXFFileSysData* sysData, int c)
+{
+    uint8_t cbyte = (uint8_t)c;
+    
+    if (direct_file_write(sysData, &cbyte, 1) != 1)
+    {
+        return EOF;
+    }
+    return c;
+}
+
+static int64_t direct_file_size(MXFFileSysData* sysData)
+{
+    if (sysData->bufferStart + sysData->bufferLen > sysData->fileSize)
+    {
+        return sysData->bufferStart + sysData->bufferLen;
+    }
+    return sysData->fileSize;
+}
+
+static int direct_file_eof(MXFFileSysData* sysData)
+{
+    return sysData->position >= direct_file_size(sysData);
+}
+
+static int direct_file_seek(MXFFileSysData* sysData, int64_t offset, int whence)
+{
+    int64_t newPosition;
+    
+    if (whence == SEEK_SET)
+    {
+        newPosition = offset;
+    }
+    else if (whence == SEEK_CUR)
+    {
+        newPosition = sysData->position + offset;
+    }
+    else /* SEEK_END */
+    {
+        newPosition = direct_file_size(sysData) + offset;
+    }
+    if (newPosition < 0)
+    {
+        return 0;
+    }
+    
+    /* the buffer is flushed on the next write or read if the position has changed */
+    sysData->position = newPosition;
+    return 1;
+}
+
+static int64_t direct_file_tell(MXFFileSysData* sysData)
+{
+    return sysData->position;
+}
+
+static int direct_file_is_seekable(MXFFileSysData* sysData)
+{
+    (void)sysData;
+    
+    return 1;
+}
+
+static void free_direct_file(MXFFileSysData* sysData)
+{
+    if (sysData == NULL)
+    {
+        return;
+    }
+    
+    free(sysData->buffer);
+    free(sysData);
+}
+
+static int open_direct_file_id(const char* filename)
+{
+#if defined(O_DIRECT)
+    return open(filename, O_WRONLY | O_DIRECT);
+#elif defined(F_NOCACHE)
+    int fileId;
+    
+    if ((fileId = open(filename, O_WRONLY)) != -1 && fcntl(fileId, F_NOCACHE, 1) == -1)
+    {
+        close(fileId);
+        fileId = -1;
+    }
+    return fileId;
+#else
+    (void)filename;
+    
+    return -1;
+#endif
+}
+
+#endif
+
+
 int mxf_disk_file_open_new(const char* filename, MXFFile** mxfFile)
 {
     MXFFile* newMXFFile = NULL;
@@ -531,6 +1030,9 @@ int mxf_disk_file_open_new(const char* filename, MXFFile** mxfFile)
     newMXFFile->tell = disk_file_tell;
     newMXFFile->is_seekable = disk_file_is_seekable;
     newMXFFile->size = disk_file_size;
+#if defined(HAVE_KERNEL_COPY) && !defined(USE_LOW_LEVEL_IO)
+    newMXFFile->get_fd = disk_file_get_fd;
+#endif
     newMXFFile->sysData = newDiskFile;
     newMXFFile->free_sys_data = free_disk_file;
     
@@ -543,6 +1045,67 @@ fail:
     return 0;
 }
 
+int mxf_disk_file_open_direct_new(const char* filename, MXFFile** mxfFile)
+{
+#if defined(_WIN32)
+    return mxf_disk_file_open_new(filename, mxfFile);
+#else
+    MXFFile* newMXFFile = NULL;
+    MXFFileSysData* newSysData = NULL;
+    void* buffer;
+    
+    CHK_MALLOC_ORET(newMXFFile, MXFFile);
+    memset(newMXFFile, 0, sizeof(MXFFile));
+    CHK_MALLOC_OFAIL(newSysData, MXFFileSysData);
+    memset(newSysData, 0, sizeof(MXFFileSysData));
+    newSysData->directFileId = -1;
+    newSysData->bufferedFileId = -1;
+    
+    CHK_OFAIL(posix_memalign(&buffer, DIRECT_IO_ALIGNMENT, DIRECT_IO_BUFFER_SIZE) == 0);
+    newSysData->buffer = (uint8_t*)buffer;
+    
+    if ((newSysData->bufferedFileId = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0666)) == -1)
+    {
+        goto fail;
+    }
+    if ((newSysData->directFileId = open_direct_file_id(filename)) == -1)
+    {
+        mxf_log_warn("Direct I/O is not available for '%s'; using buffered writes" LOG_LOC_FORMAT, 
+            filename, LOG_LOC_PARAMS);
+        newSysData->directFileId = newSysData->bufferedFileId;
+    }
+    
+    newMXFFile->close = direct_file_close;
+    newMXFFile->read = direct_file_read;
+    newMXFFile->write = direct_file_write;
+    newMXFFile->get_char = direct_file_getchar;
+    newMXFFile->put_char = direct_file_putchar;
+    newMXFFile->eof = direct_file_eof;
+    newMXFFile->seek = direct_file_seek;
+    newMXFFile->tell = direct_file_tell;
+    newMXFFile->is_seekable = direct_file_is_seekable;
+    newMXFFile->size = direct_file_size;
+    newMXFFile->sysData = newSysData;
+    newMXFFile->free_sys_data = free_direct_file;
+    
+    *mxfFile = newMXFFile;
+    return 1;
+    
+fail:
+    if (newSysData != NULL)
+    {
+        if (newSysData->bufferedFileId != -1)
+        {
+            close(newSysData->bufferedFileId);
+        }
+        free(newSysData->buffer);
+    }
+    SAFE_FREE(&newMXFFile);
+    SAFE_FREE(&newSysData);
+    return 0;
+#endif
+}
+
 int mxf_disk_file_open_read(const char* filename, MXFFile** mxfFile)
 {
     MXFFile* newMXFFile = NULL;
@@ -572,6 +1135,12 @@ int mxf_disk_file_open_read(const char* filename, MXFFile** mxfFile)
     newMXFFile->tell = disk_file_tell;
     newMXFFile->is_seekable = disk_file_is_seekable;
     newMXFFile->size = disk_file_size;
+#if defined(HAVE_PREADV) && !defined(USE_LOW_LEVEL_IO)
+    newMXFFile->read_vector = disk_file_read_vector;
+#endif
+#if defined(HAVE_KERNEL_COPY) && !defined(USE_LOW_LEVEL_IO)
+    newMXFFile->get_fd = disk_file_get_fd;
+#endif
     newMXFFile->sysData = newDiskFile;
     newMXFFile->free_sys_data = free_disk_file;
     
@@ -584,6 +1153,102 @@ fail:
     return 0;
 }
 
+int mxf_disk_file_open_mmap_read(const char* filename, MXFFileAccessHint accessHint, MXFFile** mxfFile)
+{
+#if defined(_WIN32)
+    /* memory mapping is not supported; mxf_file_get_data will return NULL */
+    (void)accessHint;
+    
+    return mxf_disk_file_open_read(filename, mxfFile);
+#else
+    MXFFile* newMXFFile = NULL;
+    MXFFileSysData* newSysData = NULL;
+    struct stat statBuf;
+    int fileId = -1;
+    int advice;
+    
+    CHK_MALLOC_ORET(newMXFFile, MXFFile);
+    memset(newMXFFile, 0, sizeof(MXFFile));
+    CHK_MALLOC_OFAIL(newSysData, MXFFileSysData);
+    memset(newSysData, 0, sizeof(MXFFileSysData));
+    
+    if ((fileId = open(filename, O_RDONLY)) == -1)
+    {
+        goto fail;
+    }
+    CHK_OFAIL(fstat(fileId, &statBuf) == 0);
+    CHK_OFAIL((uint64_t)statBuf.st_size <= (size_t)(-1));
+    
+    /* an empty file can't be mapped */
+    if (statBuf.st_size > 0)
+    {
+        newSysData->mappingSize = (size_t)statBuf.st_size;
+        newSysData->mapping = mmap(NULL, newSysData->mappingSize, PROT_READ, MAP_SHARED, fileId, 0);
+        if (newSysData->mapping == MAP_FAILED)
+        {
+            mxf_log_error("Failed to memory map '%s'" LOG_LOC_FORMAT, filename, LOG_LOC_PARAMS);
+            newSysData->mapping = NULL;
+            goto fail;
+        }
+        
+        switch (accessHint)
+        {
+            case MXF_FILE_ACCESS_SEQUENTIAL:
+                advice = MADV_SEQUENTIAL;
+                break;
+            case MXF_FILE_ACCESS_RANDOM:
+                advice = MADV_RANDOM;
+                break;
+            case MXF_FILE_ACCESS_NORMAL:
+            default:
+                advice = MADV_NORMAL;
+                break;
+        }
+        if (madvise(newSysData->mapping, newSysData->mappingSize, advice) != 0)
+        {
+            mxf_log_warn("Failed to set memory map access hint for '%s'" LOG_LOC_FORMAT, filename, LOG_LOC_PARAMS);
+        }
+    }
+    
+    /* the mapping remains valid after the file is closed */
+    close(fileId);
+    fileId = -1;
+    
+    newSysData->data = (const uint8_t*)newSysData->mapping;
+    newSysData->dataSize = (int64_t)newSysData->mappingSize;
+    
+    newMXFFile->close = mmap_file_close;
+    newMXFFile->read = byte_array_file_read;
+    newMXFFile->write = byte_array_file_write;
+    newMXFFile->get_char = byte_array_file_getchar;
+    newMXFFile->put_char = byte_array_file_putchar;
+    newMXFFile->eof = byte_array_file_eof;
+    newMXFFile->seek = byte_array_file_seek;
+    newMXFFile->tell = byte_array_file_tell;
+    newMXFFile->is_seekable = byte_array_file_is_seekable;
+    newMXFFile->size = byte_array_size;
+    newMXFFile->get_data = byte_array_file_get_data;
+    newMXFFile->sysData = newSysData;
+    newMXFFile->free_sys_data = free_byte_array_file;
+    
+    *mxfFile = newMXFFile;
+    return 1;
+    
+fail:
+    if (fileId != -1)
+    {
+        close(fileId);
+    }
+    if (newSysData != NULL && newSysData->mapping != NULL)
+    {
+        munmap(newSysData->mapping, newSysData->mappingSize);
+    }
+    SAFE_FREE(&newMXFFile);
+    SAFE_FREE(&newSysData);
+    return 0;
+#endif
+}
+
 int mxf_disk_file_open_modify(const char* filename, MXFFile** mxfFile)
 {
     MXFFile* newMXFFile = NULL;
@@ -613,6 +1278,9 @@ int mxf_disk_file_open_modify(const char* filename, MXFFile** mxfFile)
     newMXFFile->tell = disk_file_tell;
     newMXFFile->is_seekable = disk_file_is_seekable;
     newMXFFile->size = disk_file_size;
+#if defined(HAVE_KERNEL_COPY) && !defined(USE_LOW_LEVEL_IO)
+    newMXFFile->get_fd = disk_file_get_fd;
+#endif
     newMXFFile->sysData = newDiskFile;
     newMXFFile->free_sys_data = free_disk_file;
     
@@ -693,6 +1361,7 @@ int mxf_byte_array_wrap_read(const uint8_t* data, int64_t dataSize, MXFFile **mx
     newMXFFile->tell = byte_array_file_tell;
     newMXFFile->is_seekable = byte_array_file_is_seekable;
     newMXFFile->size = byte_array_size;
+    newMXFFile->get_data = byte_array_file_get_data;
     newMXFFile->sysData = newSysData;
     newMXFFile->free_sys_data = free_byte_array_file;
     
@@ -706,6 +1375,46 @@ fail:
     return 0;
 }
 
+int mxf_mem_file_open_new(uint32_t allocSize, MXFFile** mxfFile)
+{
+    MXFFile* newMXFFile = NULL;
+    MXFFileSysData* newSysData = NULL;
+    
+    CHK_MALLOC_ORET(newMXFFile, MXFFile);
+    memset(newMXFFile, 0, sizeof(MXFFile));
+    CHK_MALLOC_OFAIL(newSysData, MXFFileSysData);
+    memset(newSysData, 0, sizeof(MXFFileSysData));
+    
+    CHK_OFAIL(mem_file_reserve(newSysData, allocSize));
+
+    newMXFFile->close = mem_file_close;
+    newMXFFile->read = byte_array_file_read;
+    newMXFFile->write = mem_file_write;
+    newMXFFile->get_char = byte_array_file_getchar;
+    newMXFFile->put_char = mem_file_putchar;
+    newMXFFile->eof = byte_array_file_eof;
+    newMXFFile->seek = byte_array_file_seek;
+    newMXFFile->tell = byte_array_file_tell;
+    newMXFFile->is_seekable = byte_array_file_is_seekable;
+    newMXFFile->size = byte_array_size;
+    newMXFFile->get_data = byte_array_file_get_data;
+    newMXFFile->sysData = newSysData;
+    newMXFFile->free_sys_data = free_byte_array_file;
+    
+
+    *mxfFile = newMXFFile;
+    return 1;
+
+fail:
+    SAFE_FREE(&newMXFFile);
+    if (newSysData != NULL)
+    {
+        SAFE_FREE(&newSysData->memData);
+    }
+    SAFE_FREE(&newSysData);
+    return 0;
+}
+
 
 
 void mxf_file_close(MXFFile** mxfFile)
@@ -737,6 +1446,156 @@ uint32_t mxf_file_write(MXFFile* mxfFile, const uint8_t* data, uint32_t count)
     return mxfFile->write(mxfFile->sysData, data, count);
 }
 
+uint64_t mxf_file_read_vector(MXFFile* mxfFile, const MXFIOVector* vectors, int count)
+{
+    uint64_t total = 0;
+    uint32_t numRead;
+    int i;
+    
+    if (mxfFile->read_vector != NULL)
+    {
+        return mxfFile->read_vector(mxfFile->sysData, vectors, count);
+    }
+    
+    for (i = 0; i < count; i++)
+    {
+        numRead = mxfFile->read(mxfFile->sysData, vectors[i].data, vectors[i].size);
+        total += numRead;
+        if (numRead != vectors[i].size)
+        {
+            break;
+        }
+    }
+    
+    return total;
+}
+
+#if defined(HAVE_KERNEL_COPY)
+/* copies using copy_file_range and falls back to sendfile if the files are on file systems that don't 
+   support it. The file offsets are left undefined */
+static uint64_t kernel_file_copy(int destFd, int64_t destPos, int sourceFd, int64_t sourcePos, uint64_t count)
+{
+    int64_t sourceOffset = sourcePos;
+    int64_t destOffset = destPos;
+    off_t sendOffset;
+    uint64_t total = 0;
+    size_t chunkSize;
+    ssize_t numCopied;
+    int useSendFile = 0;
+
+#if !defined(__NR_copy_file_range)
+    useSendFile = 1;
+#endif
+    
+    while (total < count)
+    {
+        chunkSize = (size_t)(count - total > MAX_KERNEL_COPY_SIZE ? MAX_KERNEL_COPY_SIZE : count - total);
+        
+#if defined(__NR_copy_file_range)
+        if (!useSendFile)
+        {
+            numCopied = syscall(__NR_copy_file_range, sourceFd, &sourceOffset, destFd, &destOffset, chunkSize, 0);
+            if (numCopied < 0 && errno != EINTR)
+            {
+                useSendFile = 1;
+                continue;
+            }
+        }
+        else
+#endif
+        {
+            /* sendfile writes at the destination file offset */
+            if (lseek(destFd, destOffset, SEEK_SET) != destOffset)
+            {
+                break;
+            }
+            sendOffset = sourceOffset;
+            numCopied = sendfile(destFd, sourceFd, &sendOffset, chunkSize);
+            if (numCopied < 0 && errno != EINTR)
+            {
+                break;
+            }
+            if (numCopied > 0)
+            {
+                sourceOffset += numCopied;
+                destOffset += numCopied;
+            }
+        }
+        
+        if (numCopied == 0)
+        {
+            /* end of the source file */
+            break;
+        }
+        if (numCopied > 0)
+        {
+            total += numCopied;
+        }
+    }
+    
+    return total;
+}
+#endif
+
+uint64_t mxf_file_copy(MXFFile* destFile, MXFFile* sourceFile, uint64_t count)
+{
+    uint8_t* buffer;
+    uint64_t total = 0;
+    uint32_t chunkSize;
+    uint32_t numRead;
+#if defined(HAVE_KERNEL_COPY)
+    int64_t sourcePos;
+    int64_t destPos;
+    int sourceFd;
+    int destFd;
+
+    if (sourceFile->get_fd != NULL && destFile->get_fd != NULL &&
+        (sourcePos = mxf_file_tell(sourceFile)) >= 0 && (destPos = mxf_file_tell(destFile)) >= 0 &&
+        (sourceFd = sourceFile->get_fd(sourceFile->sysData)) >= 0 &&
+        (destFd = destFile->get_fd(destFile->sysData)) >= 0)
+    {
+        total = kernel_file_copy(destFd, destPos, sourceFd, sourcePos, count);
+        
+        /* continue after the copied data, also resynchronizing the file offsets */
+        if (!mxf_file_seek(sourceFile, sourcePos + total, SEEK_SET) ||
+            !mxf_file_seek(destFile, destPos + total, SEEK_SET))
+        {
+            return 0;
+        }
+    }
+#endif
+
+    /* copy the (remaining) data through a buffer */
+    if (total == count)
+    {
+        return total;
+    }
+    chunkSize = (uint32_t)(count - total < COPY_BUFFER_SIZE ? count - total : COPY_BUFFER_SIZE);
+    if ((buffer = (uint8_t*)malloc(chunkSize)) == NULL)
+    {
+        mxf_log_error("Failed to allocate copy buffer" LOG_LOC_FORMAT, LOG_LOC_PARAMS);
+        return total;
+    }
+    
+    while (total < count)
+    {
+        chunkSize = (uint32_t)(count - total < COPY_BUFFER_SIZE ? count - total : COPY_BUFFER_SIZE);
+        numRead = mxf_file_read(sourceFile, buffer, chunkSize);
+        if (mxf_file_write(destFile, buffer, numRead) != numRead)
+        {
+            break;
+        }
+        total += numRead;
+        if (numRead != chunkSize)
+        {
+            break;
+        }
+    }
+    
+    free(buffer);
+    return total;
+}
+
 int mxf_file_getc(MXFFile* mxfFile)
 {
     return mxfFile->get_char(mxfFile->sysData);
@@ -772,6 +1631,16 @@ int64_t mxf_file_size(MXFFile* mxfFile)
     return mxfFile->size(mxfFile->sysData);
 }
 
+const uint8_t* mxf_file_get_data(MXFFile* mxfFile, int64_t offset, uint32_t count)
+{
+    if (mxfFile->get_data == NULL)
+    {
+        return NULL;
+    }
+    
+    return mxfFile->get_data(mxfFile->sysData, offset, count);
+}
+
 
 void mxf_file_set_min_llen(MXFFile* mxfFile, uint8_t llen)
 {
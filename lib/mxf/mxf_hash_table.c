@@ -0,0 +1,234 @@
+/*
+ * $Id$
+ *
+ * Hash table keyed by 16-byte identifiers (UUIDs, ULs, keys)
+ *
+ * Copyright (C) 2010  British Broadcasting Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include <mxf/mxf.h>
+
+
+/* number of slots is always a power of 2 */
+#define INITIAL_NUM_SLOTS       16
+
+
+/* FNV-1a over all 16 bytes. ULs share long common prefixes so every byte is used */
+static unsigned long hash_id(const mxfUID* id)
+{
+    const uint8_t* bytes = (const uint8_t*)id;
+    uint32_t hash = 2166136261U;
+    int i;
+
+    for (i = 0; i < mxfUID_extlen; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 16777619U;
+    }
+
+    return (unsigned long)hash;
+}
+
+/* returns the index of the slot holding the id, or the empty slot where it would be added */
+static unsigned long find_slot(const MXFHashTable* table, const mxfUID* id)
+{
+    unsigned long mask = table->numSlots - 1;
+    unsigned long index = hash_id(id) & mask;
+
+    while (table->slots[index].data != NULL && !mxf_equals_uid(id, &table->slots[index].id))
+    {
+        index = (index + 1) & mask;
+    }
+
+    return index;
+}
+
+static int resize_slots(MXFHashTable* table, unsigned long numSlots)
+{
+    MXFHashSlot* oldSlots = table->slots;
+    unsigned long oldNumSlots = table->numSlots;
+    MXFHashSlot* newSlots;
+    unsigned long i;
+
+    CHK_MALLOC_ARRAY_ORET(newSlots, MXFHashSlot, numSlots);
+    memset(newSlots, 0, sizeof(MXFHashSlot) * numSlots);
+
+    table->slots = newSlots;
+    table->numSlots = numSlots;
+    for (i = 0; i < oldNumSlots; i++)
+    {
+        if (oldSlots[i].data != NULL)
+        {
+            table->slots[find_slot(table, &oldSlots[i].id)] = oldSlots[i];
+        }
+    }
+
+    SAFE_FREE(&oldSlots);
+    return 1;
+}
+
+
+
+int mxf_create_hash_table(MXFHashTable** table, free_func_type freeFunc)
+{
+    MXFHashTable* newTable;
+
+    CHK_MALLOC_ORET(newTable, MXFHashTable);
+    mxf_initialise_hash_table(newTable, freeFunc);
+
+    *table = newTable;
+    return 1;
+}
+
+void mxf_free_hash_table(MXFHashTable** table)
+{
+    if (*table == NULL)
+    {
+        return;
+    }
+
+    mxf_clear_hash_table(*table);
+    SAFE_FREE(table);
+}
+
+void mxf_initialise_hash_table(MXFHashTable* table, free_func_type freeFunc)
+{
+    memset(table, 0, sizeof(MXFHashTable));
+    table->freeFunc = freeFunc;
+}
+
+void mxf_clear_hash_table(MXFHashTable* table)
+{
+    unsigned long i;
+
+    if (table == NULL)
+    {
+        return;
+    }
+
+    if (table->freeFunc != NULL)
+    {
+        for (i = 0; i < table->numSlots; i++)
+        {
+            if (table->slots[i].data != NULL)
+            {
+                table->freeFunc(table->slots[i].data);
+            }
+        }
+    }
+
+    SAFE_FREE(&table->slots);
+    table->numSlots = 0;
+    table->len = 0;
+}
+
+int mxf_add_hash_element(MXFHashTable* table, const mxfUID* id, void* data)
+{
+    unsigned long index;
+
+    assert(data != NULL);
+
+    /* keep the load factor <= 0.5 */
+    if (table->numSlots == 0)
+    {
+        CHK_ORET(resize_slots(table, INITIAL_NUM_SLOTS));
+    }
+    else if ((unsigned long)(table->len + 1) * 2 > table->numSlots)
+    {
+        CHK_ORET(resize_slots(table, table->numSlots * 2));
+    }
+
+    /* first one added wins */
+    index = find_slot(table, id);
+    if (table->slots[index].data != NULL)
+    {
+        return 2;
+    }
+
+    table->slots[index].id = *id;
+    table->slots[index].data = data;
+
+    table->len++;
+    return 1;
+}
+
+void* mxf_find_hash_element(const MXFHashTable* table, const mxfUID* id)
+{
+    if (table->numSlots == 0)
+    {
+        return NULL;
+    }
+
+    return table->slots[find_slot(table, id)].data;
+}
+
+void* mxf_remove_hash_element(MXFHashTable* table, const mxfUID* id, void* data)
+{
+    unsigned long mask;
+    unsigned long index;
+    unsigned long nextIndex;
+    unsigned long homeIndex;
+    void* result;
+
+    if (table->numSlots == 0)
+    {
+        return NULL;
+    }
+
+    index = find_slot(table, id);
+    result = table->slots[index].data;
+    if (result == NULL || (data != NULL && result != data))
+    {
+        return NULL;
+    }
+
+    /* shift back following elements in the probe sequence to fill the gap */
+    mask = table->numSlots - 1;
+    nextIndex = index;
+    for (;;)
+    {
+        nextIndex = (nextIndex + 1) & mask;
+        if (table->slots[nextIndex].data == NULL)
+        {
+            break;
+        }
+
+        /* the element can fill the gap if its home slot is not cyclically within (index, nextIndex] */
+        homeIndex = hash_id(&table->slots[nextIndex].id) & mask;
+        if ((nextIndex > index && (homeIndex <= index || homeIndex > nextIndex)) ||
+            (nextIndex < index && (homeIndex <= index && homeIndex > nextIndex)))
+        {
+            table->slots[index] = table->slots[nextIndex];
+            index = nextIndex;
+        }
+    }
+    table->slots[index].data = NULL;
+
+    table->len--;
+    return result;
+}
+
+long mxf_get_hash_table_length(const MXFHashTable* table)
+{
+    return table->len;
+}
+
@@ -30,10 +30,32 @@
 
 static void free_metadata_item_value(MXFMetadataItem* item)
 {
-    SAFE_FREE(&item->value);
+    if (item->arena != NULL || item->valueIsRef)
+    {
+        item->value = NULL;
+        item->valueIsRef = 0;
+    }
+    else
+    {
+        SAFE_FREE(&item->value);
+    }
     item->length = 0;
 }
 
+static int alloc_metadata_item_value(MXFMetadataItem* item, uint16_t len)
+{
+    if (item->arena != NULL)
+    {
+        CHK_ORET((item->value = (uint8_t*)mxf_arena_alloc(item->arena, len)) != NULL);
+    }
+    else
+    {
+        CHK_MALLOC_ARRAY_ORET(item->value, uint8_t, len);
+    }
+    
+    return 1;
+}
+
 static void free_metadata_set_in_list(void* data)
 {
     MXFMetadataSet* set;
@@ -60,13 +82,6 @@ static void free_metadata_item_in_list(void* data)
     mxf_free_item(&item);
 }
 
-static int set_eq_instanceuid(void* data, void* info)
-{
-    assert(data != NULL && info != NULL);
-    
-    return mxf_equals_uuid((mxfUUID*)info, &((MXFMetadataSet*)data)->instanceUID);
-}
-
 static int item_eq_key(void* data, void* info)
 {
     assert(data != NULL && info != NULL);
@@ -107,15 +122,23 @@ static int get_or_create_set_item(MXFHeaderMetadata* headerMetadata, MXFMetadata
     return 1;    
 }
 
-static int create_empty_set(const mxfKey* key, MXFMetadataSet** set)
+static int create_empty_set(MXFArena* arena, const mxfKey* key, MXFMetadataSet** set)
 {
     MXFMetadataSet* newSet;
     
-    CHK_MALLOC_ORET(newSet, MXFMetadataSet);
+    if (arena != NULL)
+    {
+        CHK_ORET((newSet = (MXFMetadataSet*)mxf_arena_alloc(arena, sizeof(MXFMetadataSet))) != NULL);
+    }
+    else
+    {
+        CHK_MALLOC_ORET(newSet, MXFMetadataSet);
+    }
     memset(newSet, 0, sizeof(MXFMetadataSet));
     newSet->key = *key;
     newSet->instanceUID = g_Null_UUID;
-    mxf_initialise_list(&newSet->items, free_metadata_item_in_list);
+    newSet->arena = arena;
+    mxf_initialise_arena_list(&newSet->items, free_metadata_item_in_list, arena);
 
     *set = newSet;
     return 1;
@@ -137,23 +160,20 @@ static int add_item(MXFMetadataSet* set, MXFMetadataItem* item)
     return 1;
 }
 
-
-
-
-int mxf_is_header_metadata(const mxfKey* key)
-{
-    return mxf_is_primer_pack(key);
-}
-
-
-int mxf_create_header_metadata(MXFHeaderMetadata** headerMetadata, MXFDataModel* dataModel)
+static int create_header_metadata(MXFHeaderMetadata** headerMetadata, MXFDataModel* dataModel, int useArena)
 {
     MXFHeaderMetadata* newHeaderMetadata;
     
     CHK_MALLOC_ORET(newHeaderMetadata, MXFHeaderMetadata);
     memset(newHeaderMetadata, 0, sizeof(MXFHeaderMetadata));
     newHeaderMetadata->dataModel = dataModel;
-    mxf_initialise_list(&newHeaderMetadata->sets, free_metadata_set_in_list);
+    if (useArena)
+    {
+        CHK_OFAIL(mxf_create_arena(&newHeaderMetadata->arena, 0));
+    }
+    mxf_initialise_arena_list(&newHeaderMetadata->sets, free_metadata_set_in_list, newHeaderMetadata->arena);
+    mxf_initialise_hash_table(&newHeaderMetadata->setsIndex, NULL); /* index doesn't own the sets */
+    mxf_initialise_list(&newHeaderMetadata->readBuffers, free);
     CHK_OFAIL(mxf_create_primer_pack(&newHeaderMetadata->primerPack));
     
     *headerMetadata = newHeaderMetadata;
@@ -164,12 +184,31 @@ fail:
     return 0;
 }
 
+
+
+
+int mxf_is_header_metadata(const mxfKey* key)
+{
+    return mxf_is_primer_pack(key);
+}
+
+
+int mxf_create_header_metadata(MXFHeaderMetadata** headerMetadata, MXFDataModel* dataModel)
+{
+    return create_header_metadata(headerMetadata, dataModel, 0);
+}
+
+int mxf_create_arena_header_metadata(MXFHeaderMetadata** headerMetadata, MXFDataModel* dataModel)
+{
+    return create_header_metadata(headerMetadata, dataModel, 1);
+}
+
 int mxf_create_set(MXFHeaderMetadata* headerMetadata, const mxfKey* key, MXFMetadataSet** set)
 {
     MXFMetadataSet* newSet;
     mxfUUID uuid;
     
-    CHK_ORET(create_empty_set(key, &newSet));
+    CHK_ORET(create_empty_set(headerMetadata->arena, key, &newSet));
     
     mxf_generate_uuid(&uuid);
     newSet->instanceUID = uuid;
@@ -190,8 +229,16 @@ int mxf_create_item(MXFMetadataSet* set, const mxfKey* key, mxfLocalTag tag, MXF
 {
     MXFMetadataItem* newItem;
     
-    CHK_MALLOC_ORET(newItem, MXFMetadataItem);
+    if (set->arena != NULL)
+    {
+        CHK_ORET((newItem = (MXFMetadataItem*)mxf_arena_alloc(set->arena, sizeof(MXFMetadataItem))) != NULL);
+    }
+    else
+    {
+        CHK_MALLOC_ORET(newItem, MXFMetadataItem);
+    }
     memset(newItem, 0, sizeof(MXFMetadataItem));
+    newItem->arena = set->arena;
     newItem->tag = tag;
     newItem->isPersistent = 0;
     newItem->key = *key;
@@ -213,8 +260,11 @@ void mxf_free_header_metadata(MXFHeaderMetadata** headerMetadata)
         return;
     }
     
+    mxf_clear_hash_table(&(*headerMetadata)->setsIndex);
     mxf_clear_list(&(*headerMetadata)->sets);
     mxf_free_primer_pack(&(*headerMetadata)->primerPack);
+    mxf_clear_list(&(*headerMetadata)->readBuffers);
+    mxf_free_arena(&(*headerMetadata)->arena);
     SAFE_FREE(headerMetadata);
 }
 
@@ -226,7 +276,14 @@ void mxf_free_set(MXFMetadataSet** set)
     }
     
     mxf_clear_list(&(*set)->items);
-    SAFE_FREE(set);
+    if ((*set)->arena != NULL)
+    {
+        *set = NULL;
+    }
+    else
+    {
+        SAFE_FREE(set);
+    }
 }
 
 void mxf_free_item(MXFMetadataItem** item)
@@ -237,7 +294,14 @@ void mxf_free_item(MXFMetadataItem** item)
     }
     
     free_metadata_item_value(*item);
-    SAFE_FREE(item);
+    if ((*item)->arena != NULL)
+    {
+        *item = NULL;
+    }
+    else
+    {
+        SAFE_FREE(item);
+    }
 }
 
 
@@ -256,6 +320,14 @@ int mxf_add_set(MXFHeaderMetadata* headerMetadata, MXFMetadataSet* set)
     
     CHK_ORET(mxf_append_list_element(&headerMetadata->sets, (void*)set));
     set->headerMetadata = headerMetadata;
+    
+    /* a set with a duplicate instanceUID is not indexed; the first one added is found by mxf_dereference */
+    if (!mxf_add_hash_element(&headerMetadata->setsIndex, (const mxfUID*)&set->instanceUID, (void*)set))
+    {
+        mxf_remove_list_element(&headerMetadata->sets, (void*)set, eq_pointer);
+        set->headerMetadata = NULL;
+        return 0;
+    }
 
     return 1;
 }
@@ -311,9 +383,28 @@ int mxf_remove_set(MXFHeaderMetadata* headerMetadata, MXFMetadataSet* set)
 {
     void* result;
     
+    MXFListIterator iter;
+    MXFMetadataSet* otherSet;
+    
     if ((result = mxf_remove_list_element(&headerMetadata->sets, (void*)set, eq_pointer)) != NULL)
     {
         set->headerMetadata = NULL;
+        
+        if (mxf_remove_hash_element(&headerMetadata->setsIndex, (const mxfUID*)&set->instanceUID, (void*)set) != NULL)
+        {
+            /* index the next set with the same instanceUID, if any */
+            mxf_initialise_list_iter(&iter, &headerMetadata->sets);
+            while (mxf_next_list_iter_element(&iter))
+            {
+                otherSet = (MXFMetadataSet*)mxf_get_iter_element(&iter);
+                if (mxf_equals_uuid(&set->instanceUID, &otherSet->instanceUID))
+                {
+                    CHK_ORET(mxf_add_hash_element(&headerMetadata->setsIndex, (const mxfUID*)&otherSet->instanceUID,
+                        (void*)otherSet));
+                    break;
+                }
+            }
+        }
         return 1;
     }
     
@@ -409,19 +500,123 @@ int mxf_set_is_subclass_of(MXFMetadataSet* set, const mxfKey* parentSetKey)
 
 
 
-int mxf_read_header_metadata(MXFFile* mxfFile, MXFHeaderMetadata* headerMetadata,
-    uint64_t headerByteCount, const mxfKey* pkey, uint8_t pllen, uint64_t plen)
+/* item values reference the valueBuffer if it is not NULL, in which case mxfFile must wrap the valueBuffer */
+static int read_item_value(MXFFile* mxfFile, const uint8_t* valueBuffer, MXFMetadataItem* item, uint16_t len)
 {
-    return mxf_read_filtered_header_metadata(mxfFile, NULL, headerMetadata, headerByteCount, pkey,
-        pllen, plen);
+    int64_t filePos;
+    
+    if (valueBuffer == NULL)
+    {
+        return mxf_read_item(mxfFile, item, len);
+    }
+    
+    CHK_ORET((filePos = mxf_file_tell(mxfFile)) >= 0);
+    CHK_ORET(mxf_skip(mxfFile, len));
+    
+    free_metadata_item_value(item);
+    item->value = (uint8_t*)&valueBuffer[filePos];
+    item->length = len;
+    item->valueIsRef = 1;
+    
+    return 1;
+}
+
+static int read_and_return_set(MXFFile* mxfFile, const uint8_t* valueBuffer, const mxfKey* key, uint64_t len,
+    MXFHeaderMetadata* headerMetadata, int addToHeaderMetadata, MXFMetadataSet** set)
+{
+    MXFMetadataSet* newSet = NULL;
+    MXFSetDef* setDef = NULL;
+    uint64_t totalLen = 0;
+    mxfLocalTag itemTag;
+    uint16_t itemLen;
+    int haveInstanceUID = 0;
+    mxfKey itemKey;
+    MXFItemDef* itemDef = NULL;
+    MXFMetadataItem* newItem;
+
+    assert(headerMetadata->primerPack != NULL);
+
+    /* only read sets with known definitions */    
+    if (mxf_find_set_def(headerMetadata->dataModel, key, &setDef))
+    {
+        CHK_ORET(create_empty_set(headerMetadata->arena, key, &newSet));
+    
+        /* read each item in the set*/
+        haveInstanceUID = 0;
+        do
+        {
+            CHK_OFAIL(mxf_read_item_tl(mxfFile, &itemTag, &itemLen));
+            /* check the item tag is registered in the primer */
+            if (mxf_get_item_key(headerMetadata->primerPack, itemTag, &itemKey))
+            {
+                /* only read items with known definition */
+                if (mxf_find_item_def_in_set_def(&itemKey, setDef, &itemDef))
+                {
+                    CHK_OFAIL(mxf_create_item(newSet, &itemKey, itemTag, &newItem));
+                    newItem->isPersistent = 1;
+                    CHK_OFAIL(read_item_value(mxfFile, valueBuffer, newItem, itemLen));
+                    if (mxf_equals_key(&MXF_ITEM_K(InterchangeObject, InstanceUID), &itemKey))
+                    {
+                        mxf_get_uuid(newItem->value, &newSet->instanceUID);
+                        haveInstanceUID = 1;
+                    }
+                }
+                /* skip items with unknown definition */
+                else
+                {
+                    CHK_OFAIL(mxf_skip(mxfFile, (int64_t)itemLen));
+                }
+            }
+            /* skip items not registered in the primer. Log warning because the file is invalid */
+            else
+            {
+                mxf_log_warn("Encountered item with tag %d not registered in the primer" LOG_LOC_FORMAT,
+                    itemTag, LOG_LOC_PARAMS);
+                CHK_OFAIL(mxf_skip(mxfFile, (int64_t)itemLen));
+            }
+            
+            totalLen += 4 + itemLen;        
+        }
+        while (totalLen < len);
+        
+        if (totalLen != len)
+        {
+            mxf_log_error("Incorrect metadata set length encountered" LOG_LOC_FORMAT, LOG_LOC_PARAMS);
+            goto fail;
+        }
+        if (!haveInstanceUID)
+        {
+            mxf_log_error("Metadata set does not have InstanceUID item" LOG_LOC_FORMAT, LOG_LOC_PARAMS);
+            goto fail;
+        }
+
+        /* ok to add set */
+        if (addToHeaderMetadata)
+        {
+            CHK_OFAIL(mxf_add_set(headerMetadata, newSet));
+        }
+    
+        *set = newSet;
+        return 1;
+    }
+
+    /* skip the set if the def is unknown */
+    CHK_ORET(mxf_skip(mxfFile, (int64_t)len));
+    *set = NULL;
+    return 2;
+
+fail:
+    mxf_free_set(&newSet);
+    return 0;    
 }
 
 /* Read primer pack followed by sets. The inputs pkey, pllen, plen must 
    correspond to that for the primer pack */
-int mxf_read_filtered_header_metadata(MXFFile* mxfFile, MXFReadFilter* filter, 
+static int read_header_metadata(MXFFile* mxfFile, const uint8_t* valueBuffer, MXFReadFilter* filter, 
     MXFHeaderMetadata* headerMetadata, uint64_t headerByteCount, 
     const mxfKey* pkey, uint8_t pllen, uint64_t plen)
 {
+    MXFMetadataSet* set;
     mxfKey key;
     uint8_t llen;
     uint64_t len;    
@@ -465,7 +660,8 @@ int mxf_read_filtered_header_metadata(MXFFile* mxfFile, MXFReadFilter* filter,
                 
                 if (!skip)
                 {
-                    CHK_ORET((result = mxf_read_and_return_set(mxfFile, &key, len, headerMetadata, 0, &newSet)) > 0);
+                    CHK_ORET((result = read_and_return_set(mxfFile, valueBuffer, &key, len, headerMetadata, 0, 
+                        &newSet)) > 0);
 
                     if (result == 1) /* set was read and returned in "set" parameter */
                     {
@@ -493,7 +689,7 @@ int mxf_read_filtered_header_metadata(MXFFile* mxfFile, MXFReadFilter* filter,
             }
             else
             {
-                CHK_ORET(mxf_read_set(mxfFile, &key, len, headerMetadata, 1) > 0);
+                CHK_ORET(read_and_return_set(mxfFile, valueBuffer, &key, len, headerMetadata, 1, &set) > 0);
             }
         }
         count += len;
@@ -507,100 +703,100 @@ fail:
     return 0;
 }
 
-int mxf_read_set(MXFFile* mxfFile, const mxfKey* key, uint64_t len, 
-    MXFHeaderMetadata* headerMetadata, int addToHeaderMetadata)
+int mxf_read_header_metadata(MXFFile* mxfFile, MXFHeaderMetadata* headerMetadata,
+    uint64_t headerByteCount, const mxfKey* pkey, uint8_t pllen, uint64_t plen)
 {
-    MXFMetadataSet* set;
-    return mxf_read_and_return_set(mxfFile, key, len, headerMetadata, addToHeaderMetadata, &set);
+    return mxf_read_filtered_header_metadata(mxfFile, NULL, headerMetadata, headerByteCount, pkey,
+        pllen, plen);
 }
 
-int mxf_read_and_return_set(MXFFile* mxfFile, const mxfKey* key, uint64_t len,
-    MXFHeaderMetadata* headerMetadata, int addToHeaderMetadata, MXFMetadataSet** set)
+int mxf_read_filtered_header_metadata(MXFFile* mxfFile, MXFReadFilter* filter, 
+    MXFHeaderMetadata* headerMetadata, uint64_t headerByteCount, 
+    const mxfKey* pkey, uint8_t pllen, uint64_t plen)
 {
-    MXFMetadataSet* newSet = NULL;
-    MXFSetDef* setDef = NULL;
-    uint64_t totalLen = 0;
-    mxfLocalTag itemTag;
-    uint16_t itemLen;
-    int haveInstanceUID = 0;
-    mxfKey itemKey;
-    MXFItemDef* itemDef = NULL;
-    MXFMetadataItem* newItem;
-
-    assert(headerMetadata->primerPack != NULL);
+    return read_header_metadata(mxfFile, NULL, filter, headerMetadata, headerByteCount, pkey, pllen, plen);
+}
 
-    /* only read sets with known definitions */    
-    if (mxf_find_set_def(headerMetadata->dataModel, key, &setDef))
+int mxf_read_buffered_header_metadata(MXFFile* mxfFile, MXFReadFilter* filter, 
+    MXFHeaderMetadata* headerMetadata, uint64_t headerByteCount, 
+    const mxfKey* pkey, uint8_t pllen, uint64_t plen)
+{
+    MXFFile* bufferFile = NULL;
+    uint8_t* buffer = NULL;
+    uint64_t bufferSize;
+    
+    /* the buffer holds the remainder of the header metadata following the primer pack key and length */
+    CHK_ORET(headerByteCount > (uint64_t)(mxfKey_extlen + pllen));
+    bufferSize = headerByteCount - mxfKey_extlen - pllen;
+    CHK_ORET(bufferSize <= 0xffffffff);
+    
+    CHK_MALLOC_ARRAY_ORET(buffer, uint8_t, bufferSize);
+    if (!mxf_append_list_element(&headerMetadata->readBuffers, buffer))
     {
-        CHK_ORET(create_empty_set(key, &newSet));
+        SAFE_FREE(&buffer);
+        return 0;
+    }
     
-        /* read each item in the set*/
-        haveInstanceUID = 0;
-        do
-        {
-            CHK_OFAIL(mxf_read_item_tl(mxfFile, &itemTag, &itemLen));
-            /* check the item tag is registered in the primer */
-            if (mxf_get_item_key(headerMetadata->primerPack, itemTag, &itemKey))
-            {
-                /* only read items with known definition */
-                if (mxf_find_item_def_in_set_def(&itemKey, setDef, &itemDef))
-                {
-                    CHK_OFAIL(mxf_create_item(newSet, &itemKey, itemTag, &newItem));
-                    newItem->isPersistent = 1;
-                    CHK_OFAIL(mxf_read_item(mxfFile, newItem, itemLen));
-                    if (mxf_equals_key(&MXF_ITEM_K(InterchangeObject, InstanceUID), &itemKey))
-                    {
-                        mxf_get_uuid(newItem->value, &newSet->instanceUID);
-                        haveInstanceUID = 1;
-                    }
-                }
-                /* skip items with unknown definition */
-                else
-                {
-                    CHK_OFAIL(mxf_skip(mxfFile, (int64_t)itemLen));
-                }
-            }
-            /* skip items not registered in the primer. Log warning because the file is invalid */
-            else
-            {
-                mxf_log_warn("Encountered item with tag %d not registered in the primer" LOG_LOC_FORMAT,
-                    itemTag, LOG_LOC_PARAMS);
-                CHK_OFAIL(mxf_skip(mxfFile, (int64_t)itemLen));
-            }
-            
-            totalLen += 4 + itemLen;        
-        }
-        while (totalLen < len);
+    CHK_ORET(mxf_file_read(mxfFile, buffer, (uint32_t)bufferSize) == bufferSize);
+    CHK_ORET(mxf_byte_array_wrap_read(buffer, (int64_t)bufferSize, &bufferFile));
+    
+    CHK_OFAIL(read_header_metadata(bufferFile, buffer, filter, headerMetadata, headerByteCount, pkey, pllen, plen));
+    
+    mxf_file_close(&bufferFile);
+    return 1;
+    
+fail:
+    mxf_file_close(&bufferFile);
+    return 0;
+}
+
+int mxf_read_referenced_sets(const uint8_t* data, uint32_t size, MXFHeaderMetadata* headerMetadata)
+{
+    MXFFile* bufferFile = NULL;
+    MXFMetadataSet* set;
+    mxfKey key;
+    uint8_t llen;
+    uint64_t len;
+    uint64_t count = 0;
+    
+    CHK_ORET(mxf_byte_array_wrap_read(data, size, &bufferFile));
+    
+    while (count < size)
+    {
+        CHK_OFAIL(mxf_read_kl(bufferFile, &key, &llen, &len));
+        count += mxfKey_extlen + llen;
         
-        if (totalLen != len)
-        {
-            mxf_log_error("Incorrect metadata set length encountered" LOG_LOC_FORMAT, LOG_LOC_PARAMS);
-            goto fail;
-        }
-        if (!haveInstanceUID)
+        if (mxf_is_filler(&key))
         {
-            mxf_log_error("Metadata set does not have InstanceUID item" LOG_LOC_FORMAT, LOG_LOC_PARAMS);
-            goto fail;
+            CHK_OFAIL(mxf_skip(bufferFile, len));
         }
-
-        /* ok to add set */
-        if (addToHeaderMetadata)
+        else
         {
-            CHK_OFAIL(mxf_add_set(headerMetadata, newSet));
+            CHK_OFAIL(read_and_return_set(bufferFile, data, &key, len, headerMetadata, 1, &set) > 0);
         }
-    
-        *set = newSet;
-        return 1;
+        count += len;
     }
+    CHK_OFAIL(count == size);
+    
+    mxf_file_close(&bufferFile);
+    return 1;
+    
+fail:
+    mxf_file_close(&bufferFile);
+    return 0;
+}
 
-    /* skip the set if the def is unknown */
-    CHK_ORET(mxf_skip(mxfFile, (int64_t)len));
-    *set = NULL;
-    return 2;
+int mxf_read_set(MXFFile* mxfFile, const mxfKey* key, uint64_t len, 
+    MXFHeaderMetadata* headerMetadata, int addToHeaderMetadata)
+{
+    MXFMetadataSet* set;
+    return mxf_read_and_return_set(mxfFile, key, len, headerMetadata, addToHeaderMetadata, &set);
+}
 
-fail:
-    mxf_free_set(&newSet);
-    return 0;    
+int mxf_read_and_return_set(MXFFile* mxfFile, const mxfKey* key, uint64_t len,
+    MXFHeaderMetadata* headerMetadata, int addToHeaderMetadata, MXFMetadataSet** set)
+{
+    return read_and_return_set(mxfFile, NULL, key, len, headerMetadata, addToHeaderMetadata, set);
 }
 
 int mxf_read_item_tl(MXFFile* mxfFile, mxfLocalTag* itemTag, uint16_t* itemLen)
@@ -617,7 +813,7 @@ int mxf_read_item(MXFFile* mxfFile, MXFMetadataItem* item, uint16_t len)
 
     CHK_ORET(mxf_file_read(mxfFile, buffer, len) == len);
 
-    CHK_MALLOC_ARRAY_ORET(item->value, uint8_t, len);
+    CHK_ORET(alloc_metadata_item_value(item, len));
     memcpy(item->value, buffer, len);
     item->length = len;
     
@@ -626,10 +822,45 @@ int mxf_read_item(MXFFile* mxfFile, MXFMetadataItem* item, uint16_t len)
 
 int mxf_write_header_metadata(MXFFile* mxfFile, MXFHeaderMetadata* headerMetadata)
 {
-    CHK_ORET(mxf_write_header_primer_pack(mxfFile, headerMetadata));
-    CHK_ORET(mxf_write_header_sets(mxfFile, headerMetadata));
+    MXFFile* memFile = NULL;
+    int64_t size;
+    
+    /* serialise into memory and write the result in one go rather than a few bytes at a time */
+    CHK_ORET(mxf_write_header_metadata_to_mem_file(mxfFile, headerMetadata, &memFile));
     
+    size = mxf_file_size(memFile);
+    CHK_OFAIL(size <= 0xffffffff);
+    CHK_OFAIL(mxf_file_write(mxfFile, mxf_file_get_data(memFile, 0, (uint32_t)size), (uint32_t)size) == 
+        (uint32_t)size);
+    
+    mxf_file_close(&memFile);
     return 1;
+    
+fail:
+    mxf_file_close(&memFile);
+    return 0;
+}
+
+int mxf_write_header_metadata_to_mem_file(MXFFile* mxfFile, MXFHeaderMetadata* headerMetadata, MXFFile** memFile)
+{
+    MXFFile* newMemFile = NULL;
+    uint64_t size;
+    
+    mxf_get_header_metadata_size(mxfFile, headerMetadata, &size);
+    CHK_ORET(size <= 0xffffffff);
+    
+    CHK_ORET(mxf_mem_file_open_new((uint32_t)size, &newMemFile));
+    mxf_file_set_min_llen(newMemFile, mxf_get_min_llen(mxfFile));
+    
+    CHK_OFAIL(mxf_write_header_primer_pack(newMemFile, headerMetadata));
+    CHK_OFAIL(mxf_write_header_sets(newMemFile, headerMetadata));
+    
+    *memFile = newMemFile;
+    return 1;
+    
+fail:
+    mxf_file_close(&newMemFile);
+    return 0;
 }
 
 int mxf_write_header_primer_pack(MXFFile* mxfFile, MXFHeaderMetadata* headerMetadata)
@@ -959,7 +1190,7 @@ int mxf_dereference(MXFHeaderMetadata* headerMetadata, const mxfUUID* uuid, MXFM
 {
     void* result;
     
-    if ((result = mxf_find_list_element(&headerMetadata->sets, (void*)uuid, set_eq_instanceuid)) == NULL)
+    if ((result = mxf_find_hash_element(&headerMetadata->setsIndex, (const mxfUID*)uuid)) == NULL)
     {
         return 0;
     }
@@ -990,49 +1221,13 @@ int mxf_get_weakref_s(MXFHeaderMetadata* headerMetadata, MXFListIterator* setsIt
     return mxf_dereference_s(headerMetadata, setsIter, &uuid, set);
 }
 
-/* this will be faster is we de-reference multiple sets in the same order as they were written */
+/* the sets iterator is no longer needed for fast de-referencing and is left unchanged. The _s functions
+   are kept for backwards compatibility */
 int mxf_dereference_s(MXFHeaderMetadata* headerMetadata, MXFListIterator* setsIter, const mxfUUID* uuid, MXFMetadataSet** set)
 {
-    MXFMetadataSet* setInList;
-    long startIndex = mxf_get_list_iter_index(setsIter);
-
-    /* try find it at the previous position in the list */
-    if (startIndex >= 0)
-    {
-        setInList = (MXFMetadataSet*)mxf_get_iter_element(setsIter);
-        if (mxf_equals_uuid(uuid, &setInList->instanceUID))
-        {
-            *set = setInList;
-            return 1;
-        }
-    }
-        
-    /* try find it starting from the previous position in the list */
-    while (mxf_next_list_iter_element(setsIter))
-    {
-        setInList = (MXFMetadataSet*)mxf_get_iter_element(setsIter);
-        
-        if (mxf_equals_uuid(uuid, &setInList->instanceUID))
-        {
-            *set = setInList;
-            return 1;
-        }
-    }
+    (void)setsIter;
     
-    /* go back to beginning and try find it before the previous position in the list */
-    initialise_sets_iter(headerMetadata, setsIter);
-    while (mxf_next_list_iter_element(setsIter) && mxf_get_list_iter_index(setsIter) < startIndex)
-    {
-        setInList = (MXFMetadataSet*)mxf_get_iter_element(setsIter);
-        
-        if (mxf_equals_uuid(uuid, &setInList->instanceUID))
-        {
-            *set = setInList;
-            return 1;
-        }
-    }
-
-    return 0;
+    return mxf_dereference(headerMetadata, uuid, set);
 }
 
 
@@ -1215,13 +1410,14 @@ void mxf_set_array_header(uint32_t arrayLen, uint32_t arrayElementLen, uint8_t*
 
 int mxf_set_item_value(MXFMetadataItem* item, const uint8_t* value, uint16_t len)
 {
-    if (item->value != NULL && item->length != len)
+    /* values referencing a read buffer are copied on write */
+    if (item->value != NULL && (item->length != len || item->valueIsRef))
     {
         free_metadata_item_value(item);
     }
     if (item->value == NULL)
     {
-        CHK_MALLOC_ARRAY_ORET(item->value, uint8_t, len);
+        CHK_ORET(alloc_metadata_item_value(item, len));
     }
     memcpy(item->value, value, len);
     item->length = len;
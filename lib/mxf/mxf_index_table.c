@@ -578,3 +578,506 @@ int mxf_write_index_entry(MXFFile* mxfFile, uint8_t sliceCount, uint8_t posTable
     return 1;
 }
 
+
+
+static int grow_compact_delta_entries(MXFCompactIndexTableSegment* segment, uint32_t numEntries)
+{
+    int8_t* newPosTableIndexes = NULL;
+    uint8_t* newSlices = NULL;
+    uint32_t* newElementData = NULL;
+    
+    if (numEntries <= segment->allocDeltaEntries)
+    {
+        return 1;
+    }
+    
+    CHK_MALLOC_ARRAY_OFAIL(newPosTableIndexes, int8_t, numEntries);
+    CHK_MALLOC_ARRAY_OFAIL(newSlices, uint8_t, numEntries);
+    CHK_MALLOC_ARRAY_OFAIL(newElementData, uint32_t, numEntries);
+    if (segment->numDeltaEntries > 0)
+    {
+        memcpy(newPosTableIndexes, segment->deltaPosTableIndexes, segment->numDeltaEntries);
+        memcpy(newSlices, segment->deltaSlices, segment->numDeltaEntries);
+        memcpy(newElementData, segment->deltaElementData, sizeof(uint32_t) * segment->numDeltaEntries);
+    }
+    SAFE_FREE(&segment->deltaPosTableIndexes);
+    SAFE_FREE(&segment->deltaSlices);
+    SAFE_FREE(&segment->deltaElementData);
+    segment->deltaPosTableIndexes = newPosTableIndexes;
+    segment->deltaSlices = newSlices;
+    segment->deltaElementData = newElementData;
+    segment->allocDeltaEntries = numEntries;
+    
+    return 1;
+    
+fail:
+    SAFE_FREE(&newPosTableIndexes);
+    SAFE_FREE(&newSlices);
+    SAFE_FREE(&newElementData);
+    return 0;
+}
+
+static uint32_t get_index_entry_len(uint8_t sliceCount, uint8_t posTableCount)
+{
+    return 11 + sliceCount * 4 + posTableCount * 8;
+}
+
+
+
+int mxf_create_compact_index_table_segment(MXFCompactIndexTableSegment** segment)
+{
+    MXFCompactIndexTableSegment* newSegment;
+    
+    CHK_MALLOC_ORET(newSegment, MXFCompactIndexTableSegment);
+    memset(newSegment, 0, sizeof(MXFCompactIndexTableSegment));
+    
+    *segment = newSegment;
+    return 1;   
+}
+
+void mxf_free_compact_index_table_segment(MXFCompactIndexTableSegment** segment)
+{
+    if (*segment == NULL)
+    {
+        return;
+    }
+    
+    SAFE_FREE(&(*segment)->deltaPosTableIndexes);
+    SAFE_FREE(&(*segment)->deltaSlices);
+    SAFE_FREE(&(*segment)->deltaElementData);
+    
+    SAFE_FREE(&(*segment)->temporalOffsets);
+    SAFE_FREE(&(*segment)->keyFrameOffsets);
+    SAFE_FREE(&(*segment)->flags);
+    SAFE_FREE(&(*segment)->streamOffsets);
+    SAFE_FREE(&(*segment)->sliceOffsets);
+    SAFE_FREE(&(*segment)->posTables);
+    
+    SAFE_FREE(segment);
+}
+
+int mxf_allocate_compact_index_entries(MXFCompactIndexTableSegment* segment, uint32_t numEntries)
+{
+    int8_t* newTemporalOffsets = NULL;
+    int8_t* newKeyFrameOffsets = NULL;
+    uint8_t* newFlags = NULL;
+    uint64_t* newStreamOffsets = NULL;
+    uint32_t* newSliceOffsets = NULL;
+    mxfRational* newPosTables = NULL;
+    
+    if (numEntries <= segment->allocIndexEntries)
+    {
+        return 1;
+    }
+    
+    CHK_MALLOC_ARRAY_OFAIL(newTemporalOffsets, int8_t, numEntries);
+    CHK_MALLOC_ARRAY_OFAIL(newKeyFrameOffsets, int8_t, numEntries);
+    CHK_MALLOC_ARRAY_OFAIL(newFlags, uint8_t, numEntries);
+    CHK_MALLOC_ARRAY_OFAIL(newStreamOffsets, uint64_t, numEntries);
+    if (segment->sliceCount > 0)
+    {
+        CHK_MALLOC_ARRAY_OFAIL(newSliceOffsets, uint32_t, numEntries * segment->sliceCount);
+    }
+    if (segment->posTableCount > 0)
+    {
+        CHK_MALLOC_ARRAY_OFAIL(newPosTables, mxfRational, numEntries * segment->posTableCount);
+    }
+    
+    if (segment->numIndexEntries > 0)
+    {
+        memcpy(newTemporalOffsets, segment->temporalOffsets, segment->numIndexEntries);
+        memcpy(newKeyFrameOffsets, segment->keyFrameOffsets, segment->numIndexEntries);
+        memcpy(newFlags, segment->flags, segment->numIndexEntries);
+        memcpy(newStreamOffsets, segment->streamOffsets, sizeof(uint64_t) * segment->numIndexEntries);
+        if (segment->sliceCount > 0)
+        {
+            memcpy(newSliceOffsets, segment->sliceOffsets, 
+                sizeof(uint32_t) * segment->numIndexEntries * segment->sliceCount);
+        }
+        if (segment->posTableCount > 0)
+        {
+            memcpy(newPosTables, segment->posTables, 
+                sizeof(mxfRational) * segment->numIndexEntries * segment->posTableCount);
+        }
+    }
+    
+    SAFE_FREE(&segment->temporalOffsets);
+    SAFE_FREE(&segment->keyFrameOffsets);
+    SAFE_FREE(&segment->flags);
+    SAFE_FREE(&segment->streamOffsets);
+    SAFE_FREE(&segment->sliceOffsets);
+    SAFE_FREE(&segment->posTables);
+    segment->temporalOffsets = newTemporalOffsets;
+    segment->keyFrameOffsets = newKeyFrameOffsets;
+    segment->flags = newFlags;
+    segment->streamOffsets = newStreamOffsets;
+    segment->sliceOffsets = newSliceOffsets;
+    segment->posTables = newPosTables;
+    segment->allocIndexEntries = numEntries;
+    
+    return 1;
+    
+fail:
+    SAFE_FREE(&newTemporalOffsets);
+    SAFE_FREE(&newKeyFrameOffsets);
+    SAFE_FREE(&newFlags);
+    SAFE_FREE(&newStreamOffsets);
+    SAFE_FREE(&newSliceOffsets);
+    SAFE_FREE(&newPosTables);
+    return 0;
+}
+
+int mxf_add_compact_delta_entry(MXFCompactIndexTableSegment* segment, int8_t posTableIndex, uint8_t slice,
+    uint32_t elementData)
+{
+    uint32_t i = segment->numDeltaEntries;
+    
+    CHK_ORET(8 + (i + 1) * 6 <= 0xffff);
+    if (i == segment->allocDeltaEntries)
+    {
+        CHK_ORET(grow_compact_delta_entries(segment, i == 0 ? 4 : i * 2));
+    }
+    
+    segment->deltaPosTableIndexes[i] = posTableIndex;
+    segment->deltaSlices[i] = slice;
+    segment->deltaElementData[i] = elementData;
+    segment->numDeltaEntries++;
+    
+    return 1;
+}
+
+int mxf_add_compact_index_entry(MXFCompactIndexTableSegment* segment, int8_t temporalOffset,
+    int8_t keyFrameOffset, uint8_t flags, uint64_t streamOffset, 
+    const uint32_t* sliceOffset, const mxfRational* posTable)
+{
+    uint32_t i = segment->numIndexEntries;
+    
+    CHK_ORET(8 + (i + 1) * get_index_entry_len(segment->sliceCount, segment->posTableCount) <= 0xffff);
+    if (i == segment->allocIndexEntries)
+    {
+        CHK_ORET(mxf_allocate_compact_index_entries(segment, i == 0 ? 64 : i * 2));
+    }
+    
+    segment->temporalOffsets[i] = temporalOffset;
+    segment->keyFrameOffsets[i] = keyFrameOffset;
+    segment->flags[i] = flags;
+    segment->streamOffsets[i] = streamOffset;
+    if (segment->sliceCount > 0)
+    {
+        memcpy(&segment->sliceOffsets[i * segment->sliceCount], sliceOffset, sizeof(uint32_t) * segment->sliceCount);
+    }
+    if (segment->posTableCount > 0)
+    {
+        memcpy(&segment->posTables[i * segment->posTableCount], posTable, 
+            sizeof(mxfRational) * segment->posTableCount);
+    }
+    segment->numIndexEntries++;
+    
+    return 1;
+}
+
+int mxf_write_compact_index_table_segment(MXFFile* mxfFile, const MXFCompactIndexTableSegment* segment)
+{
+    uint32_t indexEntryLen = get_index_entry_len(segment->sliceCount, segment->posTableCount);
+    uint64_t segmentLen = 80;
+    uint8_t* buffer = NULL;
+    uint8_t* bufPtr;
+    uint32_t i;
+    uint32_t k;
+    
+    if (segment->numDeltaEntries > 0)
+    {
+        segmentLen += 12 + segment->numDeltaEntries * 6;
+    }
+    if (segment->numIndexEntries > 0)
+    {
+        segmentLen += 22 /* includes PosTableCount and SliceCount */ + segment->numIndexEntries * indexEntryLen;
+    }
+    
+    /* serialise the local set into a single buffer */
+    CHK_MALLOC_ARRAY_ORET(buffer, uint8_t, (size_t)segmentLen);
+    bufPtr = buffer;
+    
+    mxf_set_uint16(0x3c0a, bufPtr);
+    mxf_set_uint16(mxfUUID_extlen, bufPtr + 2);
+    mxf_set_uuid(&segment->instanceUID, bufPtr + 4);
+    bufPtr += 4 + mxfUUID_extlen;
+    mxf_set_uint16(0x3f0b, bufPtr);
+    mxf_set_uint16(8, bufPtr + 2);
+    mxf_set_rational(&segment->indexEditRate, bufPtr + 4);
+    bufPtr += 12;
+    mxf_set_uint16(0x3f0c, bufPtr);
+    mxf_set_uint16(8, bufPtr + 2);
+    mxf_set_int64(segment->indexStartPosition, bufPtr + 4);
+    bufPtr += 12;
+    mxf_set_uint16(0x3f0d, bufPtr);
+    mxf_set_uint16(8, bufPtr + 2);
+    mxf_set_int64(segment->indexDuration, bufPtr + 4);
+    bufPtr += 12;
+    mxf_set_uint16(0x3f05, bufPtr);
+    mxf_set_uint16(4, bufPtr + 2);
+    mxf_set_uint32(segment->editUnitByteCount, bufPtr + 4);
+    bufPtr += 8;
+    mxf_set_uint16(0x3f06, bufPtr);
+    mxf_set_uint16(4, bufPtr + 2);
+    mxf_set_uint32(segment->indexSID, bufPtr + 4);
+    bufPtr += 8;
+    mxf_set_uint16(0x3f07, bufPtr);
+    mxf_set_uint16(4, bufPtr + 2);
+    mxf_set_uint32(segment->bodySID, bufPtr + 4);
+    bufPtr += 8;
+    if (segment->numIndexEntries > 0)
+    {
+        mxf_set_uint16(0x3f08, bufPtr);
+        mxf_set_uint16(1, bufPtr + 2);
+        mxf_set_uint8(segment->sliceCount, bufPtr + 4);
+        bufPtr += 5;
+        mxf_set_uint16(0x3f0e, bufPtr);
+        mxf_set_uint16(1, bufPtr + 2);
+        mxf_set_uint8(segment->posTableCount, bufPtr + 4);
+        bufPtr += 5;
+    }
+    
+    if (segment->numDeltaEntries > 0)
+    {
+        CHK_OFAIL(8 + segment->numDeltaEntries * 6 <= 0xffff);
+        mxf_set_uint16(0x3f09, bufPtr);
+        mxf_set_uint16((uint16_t)(8 + segment->numDeltaEntries * 6), bufPtr + 2);
+        mxf_set_array_header(segment->numDeltaEntries, 6, bufPtr + 4);
+        bufPtr += 12;
+        for (i = 0; i < segment->numDeltaEntries; i++)
+        {
+            mxf_set_int8(segment->deltaPosTableIndexes[i], bufPtr);
+            mxf_set_uint8(segment->deltaSlices[i], bufPtr + 1);
+            mxf_set_uint32(segment->deltaElementData[i], bufPtr + 2);
+            bufPtr += 6;
+        }
+    }
+    if (segment->numIndexEntries > 0)
+    {
+        CHK_OFAIL(8 + segment->numIndexEntries * indexEntryLen <= 0xffff);
+        mxf_set_uint16(0x3f0a, bufPtr);
+        mxf_set_uint16((uint16_t)(8 + segment->numIndexEntries * indexEntryLen), bufPtr + 2);
+        mxf_set_array_header(segment->numIndexEntries, indexEntryLen, bufPtr + 4);
+        bufPtr += 12;
+        for (i = 0; i < segment->numIndexEntries; i++)
+        {
+            mxf_set_int8(segment->temporalOffsets[i], bufPtr);
+            mxf_set_int8(segment->keyFrameOffsets[i], bufPtr + 1);
+            mxf_set_uint8(segment->flags[i], bufPtr + 2);
+            mxf_set_uint64(segment->streamOffsets[i], bufPtr + 3);
+            bufPtr += 11;
+            for (k = 0; k < segment->sliceCount; k++)
+            {
+                mxf_set_uint32(segment->sliceOffsets[i * segment->sliceCount + k], bufPtr);
+                bufPtr += 4;
+            }
+            for (k = 0; k < segment->posTableCount; k++)
+            {
+                mxf_set_rational(&segment->posTables[i * segment->posTableCount + k], bufPtr);
+                bufPtr += 8;
+            }
+        }
+    }
+    assert((uint64_t)(bufPtr - buffer) == segmentLen);
+    
+    CHK_OFAIL(mxf_write_kl(mxfFile, &g_IndexTableSegment_key, segmentLen));
+    CHK_OFAIL(mxf_file_write(mxfFile, buffer, (uint32_t)segmentLen) == segmentLen);
+    
+    SAFE_FREE(&buffer);
+    return 1;
+    
+fail:
+    SAFE_FREE(&buffer);
+    return 0;
+}
+
+int mxf_read_compact_index_table_segment(MXFFile* mxfFile, uint64_t segmentLen, MXFCompactIndexTableSegment** segment)
+{
+    MXFCompactIndexTableSegment* newSegment = NULL;
+    uint8_t* buffer = NULL;
+    const uint8_t* bufPtr;
+    const uint8_t* bufEnd;
+    mxfLocalTag localTag;
+    uint16_t localLen;
+    uint32_t arrayLen;
+    uint32_t arrayItemLen;
+    uint32_t i;
+    uint32_t k;
+    
+    CHK_ORET(mxf_create_compact_index_table_segment(&newSegment));
+    
+    /* read the whole local set at once and parse it in memory */
+    CHK_MALLOC_ARRAY_OFAIL(buffer, uint8_t, (size_t)segmentLen);
+    CHK_OFAIL(mxf_file_read(mxfFile, buffer, (uint32_t)segmentLen) == segmentLen);
+    
+    bufPtr = buffer;
+    bufEnd = buffer + segmentLen;
+    while (bufPtr < bufEnd)
+    {
+        CHK_OFAIL(bufEnd - bufPtr >= 4);
+        mxf_get_uint16(bufPtr, &localTag);
+        mxf_get_uint16(bufPtr + 2, &localLen);
+        bufPtr += 4;
+        CHK_OFAIL(bufEnd - bufPtr >= localLen);
+        
+        switch (localTag)
+        {
+            case 0x3c0a:
+                CHK_OFAIL(localLen == mxfUUID_extlen);
+                mxf_get_uuid(bufPtr, &newSegment->instanceUID);
+                break;
+            case 0x3f0b:
+                CHK_OFAIL(localLen == 8);
+                mxf_get_rational(bufPtr, &newSegment->indexEditRate);
+                break;
+            case 0x3f0c:
+                CHK_OFAIL(localLen == 8);
+                mxf_get_position(bufPtr, &newSegment->indexStartPosition);
+                break;
+            case 0x3f0d:
+                CHK_OFAIL(localLen == 8);
+                mxf_get_length(bufPtr, &newSegment->indexDuration);
+                break;
+            case 0x3f05:
+                CHK_OFAIL(localLen == 4);
+                mxf_get_uint32(bufPtr, &newSegment->editUnitByteCount);
+                break;
+            case 0x3f06:
+                CHK_OFAIL(localLen == 4);
+                mxf_get_uint32(bufPtr, &newSegment->indexSID);
+                break;
+            case 0x3f07:
+                CHK_OFAIL(localLen == 4);
+                mxf_get_uint32(bufPtr, &newSegment->bodySID);
+                break;
+            case 0x3f08:
+                CHK_OFAIL(localLen == 1);
+                CHK_OFAIL(newSegment->numIndexEntries == 0);
+                mxf_get_uint8(bufPtr, &newSegment->sliceCount);
+                break;
+            case 0x3f0e:
+                CHK_OFAIL(localLen == 1);
+                CHK_OFAIL(newSegment->numIndexEntries == 0);
+                mxf_get_uint8(bufPtr, &newSegment->posTableCount);
+                break;
+            case 0x3f09:
+                CHK_OFAIL(localLen >= 8);
+                mxf_get_array_header(bufPtr, &arrayLen, &arrayItemLen);
+                CHK_OFAIL(arrayLen <= localLen);
+                if (arrayLen != 0)
+                {
+                    CHK_OFAIL(arrayItemLen == 6);
+                }
+                CHK_OFAIL(localLen == 8 + arrayLen * 6);
+                CHK_OFAIL(grow_compact_delta_entries(newSegment, arrayLen));
+                for (i = 0; i < arrayLen; i++)
+                {
+                    mxf_get_int8(bufPtr + 8 + i * 6, &newSegment->deltaPosTableIndexes[i]);
+                    mxf_get_uint8(bufPtr + 8 + i * 6 + 1, &newSegment->deltaSlices[i]);
+                    mxf_get_uint32(bufPtr + 8 + i * 6 + 2, &newSegment->deltaElementData[i]);
+                }
+                newSegment->numDeltaEntries = arrayLen;
+                break;
+            case 0x3f0a:
+            {
+                const uint8_t* entryPtr;
+                
+                /* SliceCount and PosTableCount precede the IndexEntryArray */
+                CHK_OFAIL(localLen >= 8);
+                mxf_get_array_header(bufPtr, &arrayLen, &arrayItemLen);
+                CHK_OFAIL(arrayLen <= localLen);
+                if (arrayLen != 0)
+                {
+                    CHK_OFAIL(arrayItemLen == get_index_entry_len(newSegment->sliceCount, newSegment->posTableCount));
+                }
+                CHK_OFAIL(localLen == 8 + arrayLen * get_index_entry_len(newSegment->sliceCount, 
+                    newSegment->posTableCount));
+                CHK_OFAIL(mxf_allocate_compact_index_entries(newSegment, arrayLen));
+                entryPtr = bufPtr + 8;
+                for (i = 0; i < arrayLen; i++)
+                {
+                    mxf_get_int8(entryPtr, &newSegment->temporalOffsets[i]);
+                    mxf_get_int8(entryPtr + 1, &newSegment->keyFrameOffsets[i]);
+                    mxf_get_uint8(entryPtr + 2, &newSegment->flags[i]);
+                    mxf_get_uint64(entryPtr + 3, &newSegment->streamOffsets[i]);
+                    entryPtr += 11;
+                    for (k = 0; k < newSegment->sliceCount; k++)
+                    {
+                        mxf_get_uint32(entryPtr, &newSegment->sliceOffsets[i * newSegment->sliceCount + k]);
+                        entryPtr += 4;
+                    }
+                    for (k = 0; k < newSegment->posTableCount; k++)
+                    {
+                        mxf_get_rational(entryPtr, &newSegment->posTables[i * newSegment->posTableCount + k]);
+                        entryPtr += 8;
+                    }
+                }
+                newSegment->numIndexEntries = arrayLen;
+                break;
+            }
+            default:
+                mxf_log_warn("Unknown local item (%u) in index table segment", localTag);
+                break;
+        }
+        
+        bufPtr += localLen;
+    }
+    
+    SAFE_FREE(&buffer);
+    *segment = newSegment;
+    return 1;
+    
+fail:
+    SAFE_FREE(&buffer);
+    mxf_free_compact_index_table_segment(&newSegment);
+    return 0;
+}
+
+int mxf_find_compact_index_entry(MXFCompactIndexTableSegment** segments, uint32_t numSegments, mxfPosition position,
+    uint32_t* segmentIndex, uint32_t* entryIndex)
+{
+    MXFCompactIndexTableSegment* segment;
+    uint32_t low = 0;
+    uint32_t high = numSegments;
+    uint32_t mid;
+    int64_t duration;
+    
+    /* find the last segment starting at or before the position */
+    while (low < high)
+    {
+        mid = low + (high - low) / 2;
+        if (segments[mid]->indexStartPosition <= position)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    if (low == 0)
+    {
+        return 0;
+    }
+    segment = segments[low - 1];
+    
+    /* a CBE segment with a zero duration covers all remaining edit units */
+    if (segment->editUnitByteCount > 0)
+    {
+        duration = segment->indexDuration;
+    }
+    else
+    {
+        duration = segment->numIndexEntries;
+    }
+    if ((segment->editUnitByteCount == 0 || duration > 0) && position - segment->indexStartPosition >= duration)
+    {
+        return 0;
+    }
+    
+    *segmentIndex = low - 1;
+    *entryIndex = (uint32_t)(position - segment->indexStartPosition);
+    return 1;
+}
+
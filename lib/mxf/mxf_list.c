@@ -28,6 +28,39 @@
 #include <mxf/mxf.h>
 
 
+static MXFListElement* create_element(MXFList* list, void* data)
+{
+    MXFListElement* newElement;
+
+    if (list->arena != NULL)
+    {
+        newElement = (MXFListElement*)mxf_arena_alloc(list->arena, sizeof(MXFListElement));
+        CHK_ORET(newElement != NULL);
+    }
+    else
+    {
+        CHK_MALLOC_ORET(newElement, MXFListElement);
+    }
+    newElement->next = NULL;
+    newElement->data = data;
+
+    return newElement;
+}
+
+static void free_element(MXFList* list, MXFListElement** element)
+{
+    /* elements allocated from an arena are released with the arena */
+    if (list->arena != NULL)
+    {
+        *element = NULL;
+    }
+    else
+    {
+        SAFE_FREE(element);
+    }
+}
+
+
 
 int mxf_create_list(MXFList** list, free_func_type freeFunc)
 {
@@ -57,6 +90,12 @@ void mxf_initialise_list(MXFList* list, free_func_type freeFunc)
     list->freeFunc = freeFunc;
 }
 
+void mxf_initialise_arena_list(MXFList* list, free_func_type freeFunc, MXFArena* arena)
+{
+    mxf_initialise_list(list, freeFunc);
+    list->arena = arena;
+}
+
 void mxf_clear_list(MXFList* list)
 {
     MXFListElement* element;
@@ -76,7 +115,7 @@ void mxf_clear_list(MXFList* list)
         {
             list->freeFunc(element->data);
         }
-        SAFE_FREE(&element);
+        free_element(list, &element);
         
         element = nextElement;
     }
@@ -90,9 +129,7 @@ int mxf_append_list_element(MXFList* list, void* data)
 {
     MXFListElement* newElement;
     
-    CHK_MALLOC_ORET(newElement, MXFListElement);
-    memset(newElement, 0, sizeof(MXFListElement));
-    newElement->data = data;
+    CHK_ORET((newElement = create_element(list, data)) != NULL);
 
     if (list->elements == NULL)
     {
@@ -112,9 +149,7 @@ int mxf_prepend_list_element(MXFList* list, void* data)
 {
     MXFListElement* newElement;
     
-    CHK_MALLOC_ORET(newElement, MXFListElement);
-    memset(newElement, 0, sizeof(MXFListElement));
-    newElement->data = data;
+    CHK_ORET((newElement = create_element(list, data)) != NULL);
 
     if (list->elements == NULL)
     {
@@ -140,9 +175,7 @@ int mxf_insert_list_element(MXFList* list, long index, int before, void* data)
 
     
     /* create new element */
-    CHK_MALLOC_ORET(newElement, MXFListElement);
-    memset(newElement, 0, sizeof(MXFListElement));
-    newElement->data = data;
+    CHK_ORET((newElement = create_element(list, data)) != NULL);
 
     /* special case when list is empty */
     if (list->elements == NULL)
@@ -204,7 +237,7 @@ int mxf_insert_list_element(MXFList* list, long index, int before, void* data)
     return 1;
     
 fail:
-    SAFE_FREE(&newElement);
+    free_element(list, &newElement);
     return 0;
 }
 
@@ -258,7 +291,7 @@ void* mxf_remove_list_element(MXFList* list, void* info, eq_func_type eqFunc)
                     list->lastElement = prevElement;
                 }
             }
-            SAFE_FREE(&element); /* must free the wrapper element because we only return the data */
+            free_element(list, &element); /* must free the wrapper element because we only return the data */
             list->len--;
             break;
         }
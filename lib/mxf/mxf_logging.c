@@ -28,7 +28,39 @@
 #include <time.h>
 
 
-#include <mxf/mxf_logging.h>
+#include <mxf/mxf.h>
+#include <mxf/mxf_thread.h>
+
+
+#define ASYNC_LOG_DEFAULT_NUM_MESSAGES  1024
+#define ASYNC_LOG_MESSAGE_SIZE          512
+
+/* time the drain thread sleeps when the ring buffer is empty */
+#define ASYNC_LOG_IDLE_USEC             2000
+
+
+/* a message slot is free for the producer claiming position pos if sequence == pos and
+   holds a message for the drain thread if sequence == pos + 1 */
+typedef struct
+{
+    volatile uint32_t sequence;
+    MXFLogLevel level;
+    char message[ASYNC_LOG_MESSAGE_SIZE];
+} AsyncLogMessage;
+
+typedef struct
+{
+    AsyncLogMessage* messages;
+    uint32_t mask;
+    volatile uint32_t writePos;
+    uint32_t readPos;
+    volatile uint32_t numDropped;
+    volatile uint32_t stopThread;
+    MXFThread thread;
+
+    mxf_vlog_func targetVLog;
+    mxf_log_func prevLog;
+} AsyncLog;
 
 
 mxf_vlog_func mxf_vlog = mxf_vlog_default;
@@ -38,6 +70,9 @@ MXFLogLevel g_mxfLogLevel = MXF_DLOG;
 
 static FILE* g_mxfFileLog = NULL;
 
+static AsyncLog g_asyncLog;
+static int g_haveAsyncLog = 0;
+
 static void logmsg(FILE* file, MXFLogLevel level, const char* format, va_list p_arg)
 {
     switch (level)
@@ -150,10 +185,178 @@ void mxf_log_file_close()
 }
 
 
+static void target_log(MXFLogLevel level, const char* format, ...)
+{
+    va_list p_arg;
+
+    va_start(p_arg, format);
+    g_asyncLog.targetVLog(level, format, p_arg);
+    va_end(p_arg);
+}
+
+static int drain_async_log(void)
+{
+    AsyncLogMessage* message;
+    int haveMessage = 0;
+
+    for (;;)
+    {
+        message = &g_asyncLog.messages[g_asyncLog.readPos & g_asyncLog.mask];
+        if (mxf_atomic_load_u32(&message->sequence) != g_asyncLog.readPos + 1)
+        {
+            break;
+        }
+
+        target_log(message->level, "%s", message->message);
+
+        /* make the slot available to the producer that wraps around to it */
+        mxf_atomic_store_u32(&message->sequence, g_asyncLog.readPos + g_asyncLog.mask + 1);
+        g_asyncLog.readPos++;
+        haveMessage = 1;
+    }
+
+    return haveMessage;
+}
+
+static void async_log_thread(void* arg)
+{
+    (void)arg;
+
+    while (!mxf_atomic_load_u32(&g_asyncLog.stopThread))
+    {
+        if (!drain_async_log())
+        {
+            mxf_sleep_usec(ASYNC_LOG_IDLE_USEC);
+        }
+    }
+
+    drain_async_log();
+}
+
+static void vlog_to_async(MXFLogLevel level, const char* format, va_list p_arg)
+{
+    AsyncLogMessage* message;
+    uint32_t pos;
+    uint32_t sequence;
+
+    if (level < g_mxfLogLevel)
+    {
+        return;
+    }
+
+    /* claim a free slot */
+    pos = mxf_atomic_load_u32(&g_asyncLog.writePos);
+    for (;;)
+    {
+        message = &g_asyncLog.messages[pos & g_asyncLog.mask];
+        sequence = mxf_atomic_load_u32(&message->sequence);
+        if (sequence == pos)
+        {
+            if (mxf_atomic_compare_and_swap_u32(&g_asyncLog.writePos, pos, pos + 1))
+            {
+                break;
+            }
+            pos = mxf_atomic_load_u32(&g_asyncLog.writePos);
+        }
+        else if ((int32_t)(sequence - pos) < 0)
+        {
+            /* the buffer is full */
+            mxf_atomic_add_u32(&g_asyncLog.numDropped, 1);
+            return;
+        }
+        else
+        {
+            pos = mxf_atomic_load_u32(&g_asyncLog.writePos);
+        }
+    }
+
+    message->level = level;
+#if defined(_MSC_VER)
+    _vsnprintf(
+#else
+    vsnprintf(
+#endif
+        message->message, sizeof(message->message), format, p_arg);
+    message->message[sizeof(message->message) - 1] = '\0';
+
+    mxf_atomic_store_u32(&message->sequence, pos + 1);
+}
+
+static void log_to_async(MXFLogLevel level, const char* format, ...)
+{
+    va_list p_arg;
+
+    va_start(p_arg, format);
+    vlog_to_async(level, format, p_arg);
+    va_end(p_arg);
+}
+
+int mxf_log_async_start(uint32_t numMessages)
+{
+    uint32_t allocMessages = 1;
+    uint32_t i;
+
+    CHK_ORET(!g_haveAsyncLog);
+
+    while (allocMessages < (numMessages == 0 ? ASYNC_LOG_DEFAULT_NUM_MESSAGES : numMessages))
+    {
+        allocMessages <<= 1;
+    }
+
+    memset(&g_asyncLog, 0, sizeof(g_asyncLog));
+    CHK_MALLOC_ARRAY_ORET(g_asyncLog.messages, AsyncLogMessage, allocMessages);
+    for (i = 0; i < allocMessages; i++)
+    {
+        g_asyncLog.messages[i].sequence = i;
+    }
+    g_asyncLog.mask = allocMessages - 1;
+    g_asyncLog.targetVLog = mxf_vlog;
+    g_asyncLog.prevLog = mxf_log;
+
+    if (!mxf_create_thread(&g_asyncLog.thread, async_log_thread, NULL))
+    {
+        SAFE_FREE(&g_asyncLog.messages);
+        return 0;
+    }
+    g_haveAsyncLog = 1;
+
+    mxf_vlog = vlog_to_async;
+    mxf_log = log_to_async;
+    return 1;
+}
+
+void mxf_log_async_stop()
+{
+    if (!g_haveAsyncLog)
+    {
+        return;
+    }
+
+    mxf_vlog = g_asyncLog.targetVLog;
+    mxf_log = g_asyncLog.prevLog;
+
+    mxf_atomic_store_u32(&g_asyncLog.stopThread, 1);
+    mxf_join_thread(&g_asyncLog.thread);
+    g_haveAsyncLog = 0;
+
+    SAFE_FREE(&g_asyncLog.messages);
+}
+
+uint32_t mxf_log_async_get_num_dropped()
+{
+    return mxf_atomic_load_u32(&g_asyncLog.numDropped);
+}
+
+
 void mxf_log_debug(const char* format, ...)
 {
     va_list p_arg;
     
+    if (MXF_DLOG < g_mxfLogLevel)
+    {
+        return;
+    }
+    
     va_start(p_arg, format);
     mxf_vlog(MXF_DLOG, format, p_arg);
     va_end(p_arg);
@@ -163,6 +366,11 @@ void mxf_log_info(const char* format, ...)
 {
     va_list p_arg;
     
+    if (MXF_ILOG < g_mxfLogLevel)
+    {
+        return;
+    }
+    
     va_start(p_arg, format);
     mxf_vlog(MXF_ILOG, format, p_arg);
     va_end(p_arg);
@@ -172,6 +380,11 @@ void mxf_log_warn(const char* format, ...)
 {
     va_list p_arg;
     
+    if (MXF_WLOG < g_mxfLogLevel)
+    {
+        return;
+    }
+    
     va_start(p_arg, format);
     mxf_vlog(MXF_WLOG, format, p_arg);
     va_end(p_arg);
@@ -181,6 +394,11 @@ void mxf_log_error(const char* format, ...)
 {
     va_list p_arg;
     
+    if (MXF_ELOG < g_mxfLogLevel)
+    {
+        return;
+    }
+    
     va_start(p_arg, format);
     mxf_vlog(MXF_ELOG, format, p_arg);
     va_end(p_arg);
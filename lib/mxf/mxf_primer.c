@@ -29,10 +29,10 @@
 
 
 static void free_primer_pack_entry_in_list(void* data);
-static int entry_eq_uid(void* data, void* info);
-static int entry_eq_tag(void* data, void* info);
+static MXFPrimerPackEntry* find_entry_by_tag(MXFPrimerPack* primerPack, mxfLocalTag localTag);
 static int add_primer_pack_entry(MXFPrimerPack* primerPack, MXFPrimerPackEntry* entry);
-static int create_primer_pack_entry(MXFPrimerPack* primerPack, MXFPrimerPackEntry** entry);
+static int create_primer_pack_entry(MXFPrimerPack* primerPack, mxfLocalTag localTag, const mxfUID* uid, 
+    MXFPrimerPackEntry** entry);
 static void free_primer_pack_entry(MXFPrimerPackEntry** entry);
 
 
@@ -49,33 +49,54 @@ static void free_primer_pack_entry_in_list(void* data)
     free_primer_pack_entry(&entry);
 }
 
-static int entry_eq_uid(void* data, void* info)
+static MXFPrimerPackEntry* find_entry_by_tag(MXFPrimerPack* primerPack, mxfLocalTag localTag)
 {
-    assert(data != NULL && info != NULL);
+    MXFPrimerPackEntry** page = primerPack->tagIndex[localTag >> 8];
     
-    return mxf_equals_uid((mxfUID*)info, &((MXFPrimerPackEntry*)data)->uid);
-}
-
-static int entry_eq_tag(void* data, void* info)
-{
-    assert(data != NULL && info != NULL);
+    if (page == NULL)
+    {
+        return NULL;
+    }
     
-    return *(mxfLocalTag*)info == ((MXFPrimerPackEntry*)data)->localTag;
+    return page[localTag & 0xff];
 }
 
+/* Note: the entry's localTag and uid must be set before it is added. The first entry 
+   added for a tag or uid is the one found by the lookup functions */
 static int add_primer_pack_entry(MXFPrimerPack* primerPack, MXFPrimerPackEntry* entry)
 {
-    CHK_ORET(mxf_append_list_element(&primerPack->entries, (void*)entry));
+    MXFPrimerPackEntry*** page = &primerPack->tagIndex[entry->localTag >> 8];
+    
+    if (*page == NULL)
+    {
+        CHK_MALLOC_ARRAY_ORET(*page, MXFPrimerPackEntry*, 256);
+        memset(*page, 0, 256 * sizeof(MXFPrimerPackEntry*));
+    }
+    
+    CHK_ORET(mxf_add_hash_element(&primerPack->uidIndex, &entry->uid, (void*)entry));
+    CHK_OFAIL(mxf_append_list_element(&primerPack->entries, (void*)entry));
+    
+    if ((*page)[entry->localTag & 0xff] == NULL)
+    {
+        (*page)[entry->localTag & 0xff] = entry;
+    }
     
     return 1;
+    
+fail:
+    mxf_remove_hash_element(&primerPack->uidIndex, &entry->uid, (void*)entry);
+    return 0;
 }
 
-static int create_primer_pack_entry(MXFPrimerPack* primerPack, MXFPrimerPackEntry** entry)
+static int create_primer_pack_entry(MXFPrimerPack* primerPack, mxfLocalTag localTag, const mxfUID* uid, 
+    MXFPrimerPackEntry** entry)
 {
     MXFPrimerPackEntry* newEntry;
     
     CHK_MALLOC_ORET(newEntry, MXFPrimerPackEntry);
     memset(newEntry, 0, sizeof(MXFPrimerPackEntry));
+    newEntry->localTag = localTag;
+    newEntry->uid = *uid;
     
     CHK_OFAIL(add_primer_pack_entry(primerPack, newEntry));
     
@@ -111,6 +132,7 @@ int mxf_create_primer_pack(MXFPrimerPack** primerPack)
     CHK_MALLOC_ORET(newPrimerPack, MXFPrimerPack);
     memset(newPrimerPack, 0, sizeof(MXFPrimerPack));
     mxf_initialise_list(&newPrimerPack->entries, free_primer_pack_entry_in_list);
+    mxf_initialise_hash_table(&newPrimerPack->uidIndex, NULL); /* index doesn't own the entries */
     newPrimerPack->nextTag = 0xffff; /* we count down when assigning dynamic tags */
     
     *primerPack = newPrimerPack;
@@ -119,11 +141,18 @@ int mxf_create_primer_pack(MXFPrimerPack** primerPack)
 
 void mxf_free_primer_pack(MXFPrimerPack** primerPack)
 {
+    int i;
+    
     if (*primerPack == NULL)
     {
         return;
     }
     
+    for (i = 0; i < 256; i++)
+    {
+        SAFE_FREE(&(*primerPack)->tagIndex[i]);
+    }
+    mxf_clear_hash_table(&(*primerPack)->uidIndex);
     mxf_clear_list(&(*primerPack)->entries);
     SAFE_FREE(primerPack);
 }
@@ -136,31 +165,27 @@ int mxf_register_primer_entry(MXFPrimerPack* primerPack, const mxfUID* itemUID,
     void* result;
     
     /* if already exists, then return already assigned tag */
-    if ((result = mxf_find_list_element(&primerPack->entries, (void*)itemUID, entry_eq_uid)) != NULL)
+    if ((result = mxf_find_hash_element(&primerPack->uidIndex, itemUID)) != NULL)
     {
         *assignedTag = ((MXFPrimerPackEntry*)result)->localTag;
     }
     /* use the tag */
     else if (newTag != g_Null_LocalTag)
     {
-        if (mxf_find_list_element(&primerPack->entries, (void*)&newTag, entry_eq_tag) != NULL)
+        if (find_entry_by_tag(primerPack, newTag) != NULL)
         {
             mxf_log_error("Local tag %x already in use" LOG_LOC_FORMAT, newTag, LOG_LOC_PARAMS);
             return 0;
         }
 
-        CHK_ORET(create_primer_pack_entry(primerPack, &newEntry));
-        newEntry->localTag = newTag;
-        newEntry->uid = *itemUID;
+        CHK_ORET(create_primer_pack_entry(primerPack, newTag, itemUID, &newEntry));
         *assignedTag = newTag;
     }
     /* create a new entry with new tag */
     else
     {
         CHK_ORET(mxf_create_item_tag(primerPack, &tag));
-        CHK_ORET(create_primer_pack_entry(primerPack, &newEntry));
-        newEntry->localTag = tag;
-        newEntry->uid = *itemUID;
+        CHK_ORET(create_primer_pack_entry(primerPack, tag, itemUID, &newEntry));
         *assignedTag = tag;
     }
     
@@ -170,11 +195,11 @@ int mxf_register_primer_entry(MXFPrimerPack* primerPack, const mxfUID* itemUID,
 
 int mxf_get_item_key(MXFPrimerPack* primerPack, mxfLocalTag localTag, mxfKey* key)
 {
-    void* result;
+    MXFPrimerPackEntry* entry;
 
-    if ((result = mxf_find_list_element(&primerPack->entries, (void*)&localTag, entry_eq_tag)) != NULL)
+    if ((entry = find_entry_by_tag(primerPack, localTag)) != NULL)
     {
-        *key = ((MXFPrimerPackEntry*)result)->uid;
+        *key = entry->uid;
         return 1;
     }
 
@@ -185,7 +210,7 @@ int mxf_get_item_tag(MXFPrimerPack* primerPack, const mxfKey* key, mxfLocalTag*
 {
     void* result;
 
-    if ((result = mxf_find_list_element(&primerPack->entries, (void*)(const mxfUID*)key, entry_eq_uid)) != NULL)
+    if ((result = mxf_find_hash_element(&primerPack->uidIndex, (const mxfUID*)key)) != NULL)
     {
         *localTag = ((MXFPrimerPackEntry*)result)->localTag;
         return 1;
@@ -206,7 +231,7 @@ int mxf_create_item_tag(MXFPrimerPack* primerPack, mxfLocalTag* localTag)
             mxf_log_error("Could not create a unique tag - reached the end of the allowed dynamic tag values" LOG_LOC_FORMAT, LOG_LOC_PARAMS);
             return 0;
         }
-        if (mxf_find_list_element(&primerPack->entries, (void*)&tag, entry_eq_tag) == NULL)
+        if (find_entry_by_tag(primerPack, tag) == NULL)
         {
             break;
         }
@@ -236,9 +261,7 @@ int mxf_read_primer_pack(MXFFile* mxfFile, MXFPrimerPack** primerPack)
         CHK_OFAIL(mxf_read_local_tag(mxfFile, &localTag));
         CHK_OFAIL(mxf_read_uid(mxfFile, &uid));
         
-        CHK_OFAIL(create_primer_pack_entry(newPrimerPack, &newEntry));
-        newEntry->localTag = localTag;
-        newEntry->uid = uid;
+        CHK_OFAIL(create_primer_pack_entry(newPrimerPack, localTag, &uid, &newEntry));
     }
     
     *primerPack = newPrimerPack;
@@ -0,0 +1,326 @@
+/*
+ * $Id$
+ *
+ * Portable threads, mutexes and condition variables
+ *
+ * Copyright (C) 2010  British Broadcasting Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#if !defined(_WIN32)
+#include <time.h>
+#include <sys/time.h>
+#endif
+
+#include <mxf/mxf.h>
+#include <mxf/mxf_thread.h>
+
+
+typedef struct
+{
+    mxf_thread_func func;
+    void* arg;
+} ThreadStart;
+
+
+#if defined(_WIN32)
+static DWORD WINAPI thread_start(LPVOID param)
+#else
+static void* thread_start(void* param)
+#endif
+{
+    ThreadStart start = *(ThreadStart*)param;
+
+    free(param);
+    start.func(start.arg);
+
+    return 0;
+}
+
+#if defined(_WIN32)
+#define ONCE_RUNNING    1
+#define ONCE_DONE       2
+#endif
+
+
+
+int mxf_create_thread(MXFThread* thread, mxf_thread_func func, void* arg)
+{
+    ThreadStart* start;
+
+    CHK_MALLOC_ORET(start, ThreadStart);
+    start->func = func;
+    start->arg = arg;
+
+#if defined(_WIN32)
+    if ((*thread = CreateThread(NULL, 0, thread_start, start, 0, NULL)) == NULL)
+#else
+    if (pthread_create(thread, NULL, thread_start, start) != 0)
+#endif
+    {
+        mxf_log_error("Failed to create thread" LOG_LOC_FORMAT, LOG_LOC_PARAMS);
+        free(start);
+        return 0;
+    }
+
+    return 1;
+}
+
+int mxf_join_thread(MXFThread* thread)
+{
+#if defined(_WIN32)
+    CHK_ORET(WaitForSingleObject(*thread, INFINITE) == WAIT_OBJECT_0);
+    CloseHandle(*thread);
+#else
+    CHK_ORET(pthread_join(*thread, NULL) == 0);
+#endif
+
+    return 1;
+}
+
+
+int mxf_init_mutex(MXFMutex* mutex)
+{
+#if defined(_WIN32)
+    InitializeCriticalSection(mutex);
+#else
+    CHK_ORET(pthread_mutex_init(mutex, NULL) == 0);
+#endif
+
+    return 1;
+}
+
+void mxf_destroy_mutex(MXFMutex* mutex)
+{
+#if defined(_WIN32)
+    DeleteCriticalSection(mutex);
+#else
+    pthread_mutex_destroy(mutex);
+#endif
+}
+
+void mxf_lock_mutex(MXFMutex* mutex)
+{
+#if defined(_WIN32)
+    EnterCriticalSection(mutex);
+#else
+    pthread_mutex_lock(mutex);
+#endif
+}
+
+void mxf_unlock_mutex(MXFMutex* mutex)
+{
+#if defined(_WIN32)
+    LeaveCriticalSection(mutex);
+#else
+    pthread_mutex_unlock(mutex);
+#endif
+}
+
+
+int mxf_init_condition(MXFCondition* condition)
+{
+#if defined(_WIN32)
+    condition->numWaiters = 0;
+    condition->numWaking = 0;
+    CHK_ORET((condition->semaphore = CreateSemaphore(NULL, 0, 0x7fffffff, NULL)) != NULL);
+    if ((condition->wakeDoneEvent = CreateEvent(NULL, FALSE, FALSE, NULL)) == NULL)
+    {
+        CloseHandle(condition->semaphore);
+        return 0;
+    }
+#else
+    CHK_ORET(pthread_cond_init(condition, NULL) == 0);
+#endif
+
+    return 1;
+}
+
+void mxf_destroy_condition(MXFCondition* condition)
+{
+#if defined(_WIN32)
+    CloseHandle(condition->semaphore);
+    CloseHandle(condition->wakeDoneEvent);
+#else
+    pthread_cond_destroy(condition);
+#endif
+}
+
+#if defined(_WIN32)
+/* releases the given number of waiters and waits until they have all woken up. The mutex is held by the 
+   caller, which prevents a new waiter from taking a release meant for an existing waiter */
+static void wake_waiters(MXFCondition* condition, LONG numWake)
+{
+    condition->numWaiters -= numWake;
+    condition->numWaking = numWake;
+    ReleaseSemaphore(condition->semaphore, numWake, NULL);
+    WaitForSingleObject(condition->wakeDoneEvent, INFINITE);
+}
+#endif
+
+void mxf_wait_condition(MXFCondition* condition, MXFMutex* mutex)
+{
+#if defined(_WIN32)
+    condition->numWaiters++;
+    LeaveCriticalSection(mutex);
+
+    WaitForSingleObject(condition->semaphore, INFINITE);
+    if (InterlockedDecrement(&condition->numWaking) == 0)
+    {
+        SetEvent(condition->wakeDoneEvent);
+    }
+
+    EnterCriticalSection(mutex);
+#else
+    pthread_cond_wait(condition, mutex);
+#endif
+}
+
+void mxf_signal_condition(MXFCondition* condition)
+{
+#if defined(_WIN32)
+    if (condition->numWaiters > 0)
+    {
+        wake_waiters(condition, 1);
+    }
+#else
+    pthread_cond_signal(condition);
+#endif
+}
+
+void mxf_broadcast_condition(MXFCondition* condition)
+{
+#if defined(_WIN32)
+    if (condition->numWaiters > 0)
+    {
+        wake_waiters(condition, condition->numWaiters);
+    }
+#else
+    pthread_cond_broadcast(condition);
+#endif
+}
+
+
+int mxf_call_once(MXFOnce* once, mxf_once_func func)
+{
+#if defined(_WIN32)
+    if (InterlockedCompareExchange(once, ONCE_RUNNING, 0) == 0)
+    {
+        func();
+        InterlockedExchange(once, ONCE_DONE);
+    }
+    else
+    {
+        /* another thread is calling func; the wait is short and only happens during initialisation */
+        while (InterlockedCompareExchange(once, ONCE_DONE, ONCE_DONE) != ONCE_DONE)
+        {
+            Sleep(0);
+        }
+    }
+#else
+    CHK_ORET(pthread_once(once, func) == 0);
+#endif
+
+    return 1;
+}
+
+
+int64_t mxf_get_monotonic_time_usec(void)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER count;
+
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&count);
+
+    return (int64_t)(count.QuadPart / frequency.QuadPart * 1000000 +
+        count.QuadPart % frequency.QuadPart * 1000000 / frequency.QuadPart);
+#elif defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#else
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+
+    return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+#endif
+}
+
+void mxf_sleep_usec(int64_t usec)
+{
+#if defined(_WIN32)
+    Sleep((DWORD)((usec + 999) / 1000));
+#else
+    struct timespec ts;
+
+    ts.tv_sec = (time_t)(usec / 1000000);
+    ts.tv_nsec = (long)(usec % 1000000) * 1000;
+    nanosleep(&ts, NULL);
+#endif
+}
+
+
+uint32_t mxf_atomic_load_u32(volatile uint32_t* value)
+{
+#if defined(_WIN32)
+    return (uint32_t)InterlockedCompareExchange((volatile LONG*)value, 0, 0);
+#elif defined(__ATOMIC_ACQUIRE)
+    return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+#else
+    return __sync_val_compare_and_swap(value, 0, 0);
+#endif
+}
+
+void mxf_atomic_store_u32(volatile uint32_t* value, uint32_t newValue)
+{
+#if defined(_WIN32)
+    InterlockedExchange((volatile LONG*)value, (LONG)newValue);
+#elif defined(__ATOMIC_RELEASE)
+    __atomic_store_n(value, newValue, __ATOMIC_RELEASE);
+#else
+    __sync_synchronize();
+    *value = newValue;
+#endif
+}
+
+int mxf_atomic_compare_and_swap_u32(volatile uint32_t* value, uint32_t expected, uint32_t newValue)
+{
+#if defined(_WIN32)
+    return InterlockedCompareExchange((volatile LONG*)value, (LONG)newValue, (LONG)expected) == (LONG)expected;
+#else
+    return __sync_bool_compare_and_swap(value, expected, newValue);
+#endif
+}
+
+uint32_t mxf_atomic_add_u32(volatile uint32_t* value, uint32_t increment)
+{
+#if defined(_WIN32)
+    return (uint32_t)InterlockedExchangeAdd((volatile LONG*)value, (LONG)increment) + increment;
+#else
+    return __sync_add_and_fetch(value, increment);
+#endif
+}
+
@@ -79,6 +79,9 @@ typedef struct
 } MXFAvidReadFilter;
     
 
+static MXFDataModel* g_avidDefaultDataModel = NULL;
+
+
 
 
 static int avid_before_set_read(void* privateData, MXFHeaderMetadata* headerMetadata, 
@@ -286,10 +289,26 @@ static int write_metadict_sets(MXFFile* mxfFile, MXFHeaderMetadata* headerMetada
 {
     MXFListIterator iter;
     MXFMetadataSet* metaDictSet;
+    const MXFAvidMetaDictEncoding* encoding;
     int64_t offset;
+    uint32_t i;
     
     CHK_ORET((offset = mxf_file_tell(mxfFile)) >= 0);
     
+    /* write the shared serialised default meta-dictionary in one go if it is unmodified */
+    CHK_ORET(mxf_avid_get_default_metadict_encoding(mxfFile, headerMetadata, &encoding));
+    if (encoding != NULL)
+    {
+        for (i = 0; i < encoding->numSets; i++)
+        {
+            CHK_ORET(add_object_directory_entry(objectDirectory, &encoding->instanceUIDs[i], 
+                offset + encoding->setOffsets[i], 0x00));
+        }
+        CHK_ORET(mxf_file_write(mxfFile, encoding->data, encoding->size) == encoding->size);
+        
+        return 1;
+    }
+    
     /* must write the MetaDictionary set first */
     CHK_ORET(mxf_find_singular_set_by_key(headerMetadata, &MXF_SET_K(MetaDictionary), &metaDictSet));
     CHK_ORET(write_set(mxfFile, metaDictSet, &offset, objectDirectory));
@@ -482,6 +501,27 @@ int mxf_avid_load_extensions(MXFDataModel* dataModel)
 #pragma warning(pop)
 #endif
 
+static int load_avid_default_data_model(MXFDataModel** dataModel)
+{
+    MXFDataModel* newDataModel = NULL;
+
+    CHK_ORET(mxf_load_data_model(&newDataModel));
+    CHK_OFAIL(mxf_avid_load_extensions(newDataModel));
+    CHK_OFAIL(mxf_finalise_data_model(newDataModel));
+
+    *dataModel = newDataModel;
+    return 1;
+
+fail:
+    mxf_free_data_model(&newDataModel);
+    return 0;
+}
+
+int mxf_avid_get_default_data_model(MXFDataModel** dataModel)
+{
+    return mxf_get_shared_data_model(&g_avidDefaultDataModel, load_avid_default_data_model, dataModel);
+}
+
 
 int mxf_avid_read_filtered_header_metadata(MXFFile* mxfFile, int skipDataDefs, MXFHeaderMetadata* headerMetadata, 
     uint64_t headerByteCount, const mxfKey* key, uint8_t llen, uint64_t len)
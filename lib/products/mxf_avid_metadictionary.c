@@ -26,14 +26,9 @@
 
 #include <mxf/mxf.h>
 #include <mxf/mxf_avid.h>
+#include <mxf/mxf_thread.h>
 
 
-typedef struct
-{
-    mxfUL identification;
-    mxfUUID instanceUID;
-} MetaDefData;
-
 typedef struct
 {
     MXFMetadataItem* item;
@@ -41,6 +36,25 @@ typedef struct
     mxfUL targetIdentification;
 } WeakRefData;
 
+/* the default meta-dictionary built once per process. The sets are serialised using 4-byte lengths in the 
+   base encoding, which is referenced by the item values of the sets instantiated in each header metadata. 
+   Encodings for larger minimum llen values are created on demand */
+typedef struct
+{
+    MXFPrimerPackEntry* primerEntries;
+    uint32_t numPrimerEntries;
+    mxfUUID* instanceUIDs;
+    long* numItems;
+    uint32_t numSets;
+    MXFAvidMetaDictEncoding* encodings[10]; /* indexed by llen, 4 to 9 */
+} MetaDictTemplate;
+
+
+static MXFOnce g_metaDictTemplateOnce = MXF_ONCE_INIT;
+static MXFMutex g_metaDictTemplateMutex;
+static int g_haveMetaDictTemplateMutex = 0;
+static MetaDictTemplate* g_metaDictTemplate = NULL;
+
 
 
 static int add_weakref_to_list(MXFList* list, MXFMetadataItem* item, int arrayIndex, const mxfUL* targetIdentification)
@@ -62,16 +76,20 @@ fail:
     return 0;
 }
 
-static int add_metadef_to_list(MXFList* list, const mxfUL* identification, const mxfUUID* instanceUID)
+/* the first meta-definition with a given identification is the weak reference target */
+static int add_metadef_to_table(MXFHashTable* table, const mxfUL* identification, const mxfUUID* instanceUID)
 {
-    MetaDefData* data = NULL;
+    mxfUUID* data = NULL;
+    int result;
     
-    CHK_MALLOC_ORET(data, MetaDefData);
-    data->identification = *identification;
-    data->instanceUID = *instanceUID;
+    CHK_MALLOC_ORET(data, mxfUUID);
+    *data = *instanceUID;
     
-    CHK_OFAIL(mxf_append_list_element(list, (void*)data));
-    data = NULL;
+    CHK_OFAIL((result = mxf_add_hash_element(table, (const mxfUID*)identification, (void*)data)) > 0);
+    if (result == 2)
+    {
+        SAFE_FREE(&data);
+    }
     
     return 1;
     
@@ -90,23 +108,17 @@ static uint8_t* get_array_element(MXFMetadataItem* item, int index)
     return item->value + 8 + index * arrayItemLen;
 }
 
-static int find_weakref_target_instance_uid(MXFList* mapList, const mxfUL* targetIdentification, mxfUUID* instanceUID)
+static int find_weakref_target_instance_uid(MXFHashTable* table, const mxfUL* targetIdentification, mxfUUID* instanceUID)
 {
-    MXFListIterator iter;
+    mxfUUID* data;
     
-    mxf_initialise_list_iter(&iter, mapList);
-    while (mxf_next_list_iter_element(&iter))
+    if ((data = (mxfUUID*)mxf_find_hash_element(table, (const mxfUID*)targetIdentification)) == NULL)
     {
-        MetaDefData* data = (MetaDefData*)mxf_get_iter_element(&iter);
-        
-        if (mxf_equals_ul(&data->identification, targetIdentification))
-        {
-            *instanceUID = data->instanceUID;
-            return 1;
-        }
+        return 0;
     }
     
-    return 0;
+    *instanceUID = *data;
+    return 1;
 }
 
 
@@ -506,7 +518,7 @@ void mxf_clear_metadict_read_filter(MXFReadFilter* filter)
 
 
 
-int mxf_avid_create_default_metadictionary(MXFHeaderMetadata* headerMetadata, MXFMetadataSet** metaDictSet)
+int mxf_avid_build_default_metadictionary(MXFHeaderMetadata* headerMetadata, MXFMetadataSet** metaDictSet)
 {
     MXFMetadataSet* newMetaDictSet = NULL;
     MXFMetadataSet* classDefSet;
@@ -514,8 +526,8 @@ int mxf_avid_create_default_metadictionary(MXFHeaderMetadata* headerMetadata, MX
     mxfUL label1;
     mxfUL label2;
     mxfUL label3;
-    MXFList classMetaDefList;
-    MXFList typeMetaDefList;
+    MXFHashTable classMetaDefs;
+    MXFHashTable typeMetaDefs;
     MXFList classWeakRefList;
     MXFList typeWeakRefList;
     MXFMetadataItem* item;
@@ -523,8 +535,8 @@ int mxf_avid_create_default_metadictionary(MXFHeaderMetadata* headerMetadata, MX
     mxfUUID targetInstanceUID;
     int arrayIndex;
     
-    mxf_initialise_list(&classMetaDefList, free);
-    mxf_initialise_list(&typeMetaDefList, free);
+    mxf_initialise_hash_table(&classMetaDefs, free);
+    mxf_initialise_hash_table(&typeMetaDefs, free);
     mxf_initialise_list(&classWeakRefList, free);
     mxf_initialise_list(&typeWeakRefList, free);
 
@@ -547,7 +559,7 @@ int mxf_avid_create_default_metadictionary(MXFHeaderMetadata* headerMetadata, MX
     CHK_OFAIL(mxf_avid_create_classdef(newMetaDictSet, id, name, description, parentId, isConcrete, &classDefSet)); \
     CHK_OFAIL(mxf_get_item(classDefSet, &MXF_ITEM_K(ClassDefinition, ParentClass), &item)); \
     CHK_OFAIL(add_weakref_to_list(&classWeakRefList, item, -1, parentId)); \
-    CHK_OFAIL(add_metadef_to_list(&classMetaDefList, id, &classDefSet->instanceUID));
+    CHK_OFAIL(add_metadef_to_table(&classMetaDefs, id, &classDefSet->instanceUID));
     
 #define PROPERTY_DEF(id, name, description, typeId, isOptional, localId, isUniqueId) \
     CHK_OFAIL(mxf_avid_create_propertydef(classDefSet->headerMetadata->primerPack, classDefSet, \
@@ -555,19 +567,19 @@ int mxf_avid_create_default_metadictionary(MXFHeaderMetadata* headerMetadata, MX
     
 #define CHARACTER_DEF(id, name, description) \
     CHK_OFAIL(mxf_avid_create_typedef_char(newMetaDictSet, id, name, description, &set)); \
-    CHK_OFAIL(add_metadef_to_list(&typeMetaDefList, id, &set->instanceUID));
+    CHK_OFAIL(add_metadef_to_table(&typeMetaDefs, id, &set->instanceUID));
 
 #define ENUM_DEF(id, name, description, typeId) \
     CHK_OFAIL(mxf_avid_create_typedef_enum(newMetaDictSet, id, name, description, typeId, &set)); \
     CHK_OFAIL(mxf_get_item(set, &MXF_ITEM_K(TypeDefinitionEnumeration, Type), &item)); \
     CHK_OFAIL(add_weakref_to_list(&typeWeakRefList, item, -1, typeId)); \
-    CHK_OFAIL(add_metadef_to_list(&typeMetaDefList, id, &set->instanceUID));
+    CHK_OFAIL(add_metadef_to_table(&typeMetaDefs, id, &set->instanceUID));
 #define ENUM_ELEMENT(name, value) \
     CHK_OFAIL(mxf_avid_add_typedef_enum_element(set, name, value));
 
 #define EXTENUM_DEF(id, name, description) \
     CHK_OFAIL(mxf_avid_create_typedef_extenum(newMetaDictSet, id, name, description, &set)); \
-    CHK_OFAIL(add_metadef_to_list(&typeMetaDefList, id, &set->instanceUID));
+    CHK_OFAIL(add_metadef_to_table(&typeMetaDefs, id, &set->instanceUID));
 #define EXTENUM_ELEMENT(name, value) \
     CHK_OFAIL(mxf_avid_add_typedef_extenum_element(set, name, value));
 
@@ -575,29 +587,29 @@ int mxf_avid_create_default_metadictionary(MXFHeaderMetadata* headerMetadata, MX
     CHK_OFAIL(mxf_avid_create_typedef_fixedarray(newMetaDictSet, id, name, description, typeId, count, &set)); \
     CHK_OFAIL(mxf_get_item(set, &MXF_ITEM_K(TypeDefinitionFixedArray, ElementType), &item)); \
     CHK_OFAIL(add_weakref_to_list(&typeWeakRefList, item, -1, typeId)); \
-    CHK_OFAIL(add_metadef_to_list(&typeMetaDefList, id, &set->instanceUID));
+    CHK_OFAIL(add_metadef_to_table(&typeMetaDefs, id, &set->instanceUID));
 
 #define INDIRECT_DEF(id, name, description) \
     CHK_OFAIL(mxf_avid_create_typedef_indirect(newMetaDictSet, id, name, description, &set)); \
-    CHK_OFAIL(add_metadef_to_list(&typeMetaDefList, id, &set->instanceUID));
+    CHK_OFAIL(add_metadef_to_table(&typeMetaDefs, id, &set->instanceUID));
 
 #define INTEGER_DEF(id, name, description, size, isSigned) \
     CHK_OFAIL(mxf_avid_create_typedef_integer(newMetaDictSet, id, name, description, size, isSigned, &set)); \
-    CHK_OFAIL(add_metadef_to_list(&typeMetaDefList, id, &set->instanceUID));
+    CHK_OFAIL(add_metadef_to_table(&typeMetaDefs, id, &set->instanceUID));
 
 #define OPAQUE_DEF(id, name, description) \
     CHK_OFAIL(mxf_avid_create_typedef_opaque(newMetaDictSet, id, name, description, &set)); \
-    CHK_OFAIL(add_metadef_to_list(&typeMetaDefList, id, &set->instanceUID));
+    CHK_OFAIL(add_metadef_to_table(&typeMetaDefs, id, &set->instanceUID));
 
 #define RENAME_DEF(id, name, description, typeId) \
     CHK_OFAIL(mxf_avid_create_typedef_rename(newMetaDictSet, id, name, description, typeId, &set)); \
     CHK_OFAIL(mxf_get_item(set, &MXF_ITEM_K(TypeDefinitionRename, RenamedType), &item)); \
     CHK_OFAIL(add_weakref_to_list(&typeWeakRefList, item, -1, typeId)); \
-    CHK_OFAIL(add_metadef_to_list(&typeMetaDefList, id, &set->instanceUID));
+    CHK_OFAIL(add_metadef_to_table(&typeMetaDefs, id, &set->instanceUID));
 
 #define RECORD_DEF(id, name, description) \
     CHK_OFAIL(mxf_avid_create_typedef_record(newMetaDictSet, id, name, description, &set)); \
-    CHK_OFAIL(add_metadef_to_list(&typeMetaDefList, id, &set->instanceUID)); \
+    CHK_OFAIL(add_metadef_to_table(&typeMetaDefs, id, &set->instanceUID)); \
     arrayIndex = 0;
 #define RECORD_MEMBER(name, type) \
     CHK_OFAIL(mxf_avid_add_typedef_record_member(set, name, type)); \
@@ -609,29 +621,29 @@ int mxf_avid_create_default_metadictionary(MXFHeaderMetadata* headerMetadata, MX
     CHK_OFAIL(mxf_avid_create_typedef_set(newMetaDictSet, id, name, description, typeId, &set)); \
     CHK_OFAIL(mxf_get_item(set, &MXF_ITEM_K(TypeDefinitionSet, ElementType), &item)); \
     CHK_OFAIL(add_weakref_to_list(&typeWeakRefList, item, -1, typeId)); \
-    CHK_OFAIL(add_metadef_to_list(&typeMetaDefList, id, &set->instanceUID));
+    CHK_OFAIL(add_metadef_to_table(&typeMetaDefs, id, &set->instanceUID));
 
 #define STREAM_DEF(id, name, description) \
     CHK_OFAIL(mxf_avid_create_typedef_stream(newMetaDictSet, id, name, description, &set)); \
-    CHK_OFAIL(add_metadef_to_list(&typeMetaDefList, id, &set->instanceUID));
+    CHK_OFAIL(add_metadef_to_table(&typeMetaDefs, id, &set->instanceUID));
 
 #define STRING_DEF(id, name, description, typeId) \
     CHK_OFAIL(mxf_avid_create_typedef_string(newMetaDictSet, id, name, description, typeId, &set)); \
     CHK_OFAIL(mxf_get_item(set, &MXF_ITEM_K(TypeDefinitionString, ElementType), &item)); \
     CHK_OFAIL(add_weakref_to_list(&typeWeakRefList, item, -1, typeId)); \
-    CHK_OFAIL(add_metadef_to_list(&typeMetaDefList, id, &set->instanceUID));
+    CHK_OFAIL(add_metadef_to_table(&typeMetaDefs, id, &set->instanceUID));
 
 #define STRONGOBJREF_DEF(id, name, description, refTypeId) \
     CHK_OFAIL(mxf_avid_create_typedef_strongref(newMetaDictSet, id, name, description, refTypeId, &set)); \
     CHK_OFAIL(mxf_get_item(set, &MXF_ITEM_K(TypeDefinitionStrongObjectReference, ReferencedType), &item)); \
     CHK_OFAIL(add_weakref_to_list(&classWeakRefList, item, -1, refTypeId)); \
-    CHK_OFAIL(add_metadef_to_list(&typeMetaDefList, id, &set->instanceUID));
+    CHK_OFAIL(add_metadef_to_table(&typeMetaDefs, id, &set->instanceUID));
 
 #define WEAKOBJREF_DEF(id, name, description, refTypeId) \
     CHK_OFAIL(mxf_avid_create_typedef_weakref(newMetaDictSet, id, name, description, refTypeId, &set)); \
     CHK_OFAIL(mxf_get_item(set, &MXF_ITEM_K(TypeDefinitionWeakObjectReference, ReferencedType), &item)); \
     CHK_OFAIL(add_weakref_to_list(&classWeakRefList, item, -1, refTypeId)); \
-    CHK_OFAIL(add_metadef_to_list(&typeMetaDefList, id, &set->instanceUID));
+    CHK_OFAIL(add_metadef_to_table(&typeMetaDefs, id, &set->instanceUID));
 #define WEAKOBJREF_TARGET_ELEMENT(id) \
     CHK_OFAIL(mxf_avid_add_typedef_weakref_target(set, id));
 
@@ -639,7 +651,7 @@ int mxf_avid_create_default_metadictionary(MXFHeaderMetadata* headerMetadata, MX
     CHK_OFAIL(mxf_avid_create_typedef_vararray(newMetaDictSet, id, name, description, typeId, &set)); \
     CHK_OFAIL(mxf_get_item(set, &MXF_ITEM_K(TypeDefinitionVariableArray, ElementType), &item)); \
     CHK_OFAIL(add_weakref_to_list(&typeWeakRefList, item, -1, typeId)); \
-    CHK_OFAIL(add_metadef_to_list(&typeMetaDefList, id, &set->instanceUID));
+    CHK_OFAIL(add_metadef_to_table(&typeMetaDefs, id, &set->instanceUID));
     
 
     
@@ -655,7 +667,7 @@ int mxf_avid_create_default_metadictionary(MXFHeaderMetadata* headerMetadata, MX
     {
         WeakRefData* data = (WeakRefData*)mxf_get_iter_element(&iter);
         
-        CHK_OFAIL(find_weakref_target_instance_uid(&classMetaDefList, &data->targetIdentification, &targetInstanceUID));
+        CHK_OFAIL(find_weakref_target_instance_uid(&classMetaDefs, &data->targetIdentification, &targetInstanceUID));
         
         if (data->arrayIndex >= 0)
         {
@@ -672,7 +684,7 @@ int mxf_avid_create_default_metadictionary(MXFHeaderMetadata* headerMetadata, MX
     {
         WeakRefData* data = (WeakRefData*)mxf_get_iter_element(&iter);
         
-        CHK_OFAIL(find_weakref_target_instance_uid(&typeMetaDefList, &data->targetIdentification, &targetInstanceUID));
+        CHK_OFAIL(find_weakref_target_instance_uid(&typeMetaDefs, &data->targetIdentification, &targetInstanceUID));
         
         if (data->arrayIndex >= 0)
         {
@@ -686,8 +698,8 @@ int mxf_avid_create_default_metadictionary(MXFHeaderMetadata* headerMetadata, MX
     
 
 
-    mxf_clear_list(&classMetaDefList);
-    mxf_clear_list(&typeMetaDefList);
+    mxf_clear_hash_table(&classMetaDefs);
+    mxf_clear_hash_table(&typeMetaDefs);
     mxf_clear_list(&classWeakRefList);
     mxf_clear_list(&typeWeakRefList);
 
@@ -701,8 +713,8 @@ fail:
         mxf_free_set(&newMetaDictSet);
     }
 
-    mxf_clear_list(&classMetaDefList);
-    mxf_clear_list(&typeMetaDefList);
+    mxf_clear_hash_table(&classMetaDefs);
+    mxf_clear_hash_table(&typeMetaDefs);
     mxf_clear_list(&classWeakRefList);
     mxf_clear_list(&typeWeakRefList);
 
@@ -710,3 +722,336 @@ fail:
 }
 
 
+static void init_metadict_template_mutex(void)
+{
+    g_haveMetaDictTemplateMutex = mxf_init_mutex(&g_metaDictTemplateMutex);
+}
+
+static void free_metadict_encoding(MXFAvidMetaDictEncoding** encoding)
+{
+    if (*encoding == NULL)
+    {
+        return;
+    }
+    
+    SAFE_FREE(&(*encoding)->data);
+    SAFE_FREE(&(*encoding)->setOffsets);
+    SAFE_FREE(encoding);
+}
+
+static void free_metadict_template(MetaDictTemplate** tmpl)
+{
+    int i;
+    
+    if (*tmpl == NULL)
+    {
+        return;
+    }
+    
+    for (i = 0; i < (int)(sizeof((*tmpl)->encodings) / sizeof((*tmpl)->encodings[0])); i++)
+    {
+        free_metadict_encoding(&(*tmpl)->encodings[i]);
+    }
+    SAFE_FREE(&(*tmpl)->primerEntries);
+    SAFE_FREE(&(*tmpl)->instanceUIDs);
+    SAFE_FREE(&(*tmpl)->numItems);
+    SAFE_FREE(tmpl);
+}
+
+static uint8_t get_encoding_llen(MXFFile* mxfFile)
+{
+    /* sets are written with a 4-byte length unless a larger minimum llen is set */
+    uint8_t llen = mxf_get_min_llen(mxfFile);
+    
+    return llen < 4 ? 4 : llen;
+}
+
+/* returns the MetaDictionary set followed by the meta-definition sets, which is the order in which they 
+   are written. The caller frees the array */
+static int get_metadict_sets(MXFHeaderMetadata* headerMetadata, MXFMetadataSet*** sets, uint32_t* numSets)
+{
+    MXFMetadataSet** newSets = NULL;
+    uint32_t count = 0;
+    MXFListIterator iter;
+    
+    CHK_MALLOC_ARRAY_ORET(newSets, MXFMetadataSet*, mxf_get_list_length(&headerMetadata->sets) + 1);
+    
+    CHK_OFAIL(mxf_find_singular_set_by_key(headerMetadata, &MXF_SET_K(MetaDictionary), &newSets[count]));
+    count++;
+    
+    mxf_initialise_list_iter(&iter, &headerMetadata->sets);
+    while (mxf_next_list_iter_element(&iter))
+    {
+        MXFMetadataSet* set = (MXFMetadataSet*)mxf_get_iter_element(&iter);
+        
+        if (mxf_is_subclass_of(headerMetadata->dataModel, &set->key, &MXF_SET_K(MetaDefinition)))
+        {
+            newSets[count++] = set;
+        }
+    }
+    
+    *sets = newSets;
+    *numSets = count;
+    return 1;
+    
+fail:
+    SAFE_FREE(&newSets);
+    return 0;
+}
+
+static int create_metadict_encoding(MXFMetadataSet** sets, uint32_t numSets, const mxfUUID* instanceUIDs,
+    uint8_t llen, MXFAvidMetaDictEncoding** encoding)
+{
+    MXFAvidMetaDictEncoding* newEncoding = NULL;
+    MXFFile* memFile = NULL;
+    int64_t size;
+    uint32_t i;
+    
+    CHK_MALLOC_ORET(newEncoding, MXFAvidMetaDictEncoding);
+    memset(newEncoding, 0, sizeof(MXFAvidMetaDictEncoding));
+    CHK_MALLOC_ARRAY_OFAIL(newEncoding->setOffsets, uint32_t, numSets);
+    newEncoding->instanceUIDs = instanceUIDs;
+    newEncoding->numSets = numSets;
+    
+    CHK_OFAIL(mxf_mem_file_open_new(0, &memFile));
+    mxf_file_set_min_llen(memFile, llen);
+    for (i = 0; i < numSets; i++)
+    {
+        newEncoding->setOffsets[i] = (uint32_t)mxf_file_tell(memFile);
+        CHK_OFAIL(mxf_write_set(memFile, sets[i]));
+    }
+    
+    size = mxf_file_size(memFile);
+    CHK_OFAIL(size > 0 && size <= 0xffffffff);
+    newEncoding->size = (uint32_t)size;
+    CHK_MALLOC_ARRAY_OFAIL(newEncoding->data, uint8_t, newEncoding->size);
+    memcpy(newEncoding->data, mxf_file_get_data(memFile, 0, newEncoding->size), newEncoding->size);
+    mxf_file_close(&memFile);
+    
+    *encoding = newEncoding;
+    return 1;
+    
+fail:
+    mxf_file_close(&memFile);
+    free_metadict_encoding(&newEncoding);
+    return 0;
+}
+
+static int create_metadict_template(MXFDataModel* dataModel, MetaDictTemplate** tmpl)
+{
+    MetaDictTemplate* newTemplate = NULL;
+    MXFHeaderMetadata* headerMetadata = NULL;
+    MXFMetadataSet* metaDictSet;
+    MXFMetadataSet** sets = NULL;
+    MXFListIterator iter;
+    uint32_t i;
+    
+    CHK_MALLOC_ORET(newTemplate, MetaDictTemplate);
+    memset(newTemplate, 0, sizeof(MetaDictTemplate));
+    
+    CHK_OFAIL(mxf_create_header_metadata(&headerMetadata, dataModel));
+    CHK_OFAIL(mxf_avid_build_default_metadictionary(headerMetadata, &metaDictSet));
+    
+    /* the primer entries registered by the meta-dictionary */
+    newTemplate->numPrimerEntries = (uint32_t)mxf_get_list_length(&headerMetadata->primerPack->entries);
+    CHK_MALLOC_ARRAY_OFAIL(newTemplate->primerEntries, MXFPrimerPackEntry, newTemplate->numPrimerEntries);
+    i = 0;
+    mxf_initialise_list_iter(&iter, &headerMetadata->primerPack->entries);
+    while (mxf_next_list_iter_element(&iter))
+    {
+        newTemplate->primerEntries[i++] = *(MXFPrimerPackEntry*)mxf_get_iter_element(&iter);
+    }
+    
+    CHK_OFAIL(get_metadict_sets(headerMetadata, &sets, &newTemplate->numSets));
+    CHK_MALLOC_ARRAY_OFAIL(newTemplate->instanceUIDs, mxfUUID, newTemplate->numSets);
+    CHK_MALLOC_ARRAY_OFAIL(newTemplate->numItems, long, newTemplate->numSets);
+    for (i = 0; i < newTemplate->numSets; i++)
+    {
+        newTemplate->instanceUIDs[i] = sets[i]->instanceUID;
+        newTemplate->numItems[i] = mxf_get_list_length(&sets[i]->items);
+    }
+    
+    CHK_OFAIL(create_metadict_encoding(sets, newTemplate->numSets, newTemplate->instanceUIDs, 4,
+        &newTemplate->encodings[4]));
+    
+    SAFE_FREE(&sets);
+    mxf_free_header_metadata(&headerMetadata);
+    
+    *tmpl = newTemplate;
+    return 1;
+    
+fail:
+    SAFE_FREE(&sets);
+    mxf_free_header_metadata(&headerMetadata);
+    free_metadict_template(&newTemplate);
+    return 0;
+}
+
+static int get_metadict_template(MXFDataModel* dataModel, const MetaDictTemplate** tmpl)
+{
+    CHK_ORET(mxf_call_once(&g_metaDictTemplateOnce, init_metadict_template_mutex));
+    CHK_ORET(g_haveMetaDictTemplateMutex);
+    
+    mxf_lock_mutex(&g_metaDictTemplateMutex);
+    if (g_metaDictTemplate == NULL && !create_metadict_template(dataModel, &g_metaDictTemplate))
+    {
+        mxf_unlock_mutex(&g_metaDictTemplateMutex);
+        return 0;
+    }
+    *tmpl = g_metaDictTemplate;
+    mxf_unlock_mutex(&g_metaDictTemplateMutex);
+    
+    return 1;
+}
+
+/* returns 2 if the primer pack already has entries that conflict with the template's entries */
+static int instantiate_metadict_template(const MetaDictTemplate* tmpl, MXFHeaderMetadata* headerMetadata,
+    MXFMetadataSet** metaDictSet)
+{
+    MXFPrimerPack* primerPack = headerMetadata->primerPack;
+    const MXFAvidMetaDictEncoding* baseEncoding = tmpl->encodings[4];
+    mxfLocalTag localTag;
+    mxfKey itemKey;
+    long numSets;
+    uint32_t i;
+    
+    for (i = 0; i < tmpl->numPrimerEntries; i++)
+    {
+        if (mxf_get_item_tag(primerPack, (const mxfKey*)&tmpl->primerEntries[i].uid, &localTag))
+        {
+            if (localTag != tmpl->primerEntries[i].localTag)
+            {
+                return 2;
+            }
+        }
+        else if (mxf_get_item_key(primerPack, tmpl->primerEntries[i].localTag, &itemKey))
+        {
+            return 2;
+        }
+    }
+    
+    for (i = 0; i < tmpl->numPrimerEntries; i++)
+    {
+        CHK_ORET(mxf_register_primer_entry(primerPack, &tmpl->primerEntries[i].uid, 
+            tmpl->primerEntries[i].localTag, &localTag));
+    }
+    
+    numSets = mxf_get_list_length(&headerMetadata->sets);
+    CHK_ORET(mxf_read_referenced_sets(baseEncoding->data, baseEncoding->size, headerMetadata));
+    if (mxf_get_list_length(&headerMetadata->sets) - numSets != (long)tmpl->numSets)
+    {
+        mxf_log_error("Data model is missing meta-dictionary set definitions" LOG_LOC_FORMAT, LOG_LOC_PARAMS);
+        return 0;
+    }
+    
+    CHK_ORET(mxf_dereference(headerMetadata, &tmpl->instanceUIDs[0], metaDictSet));
+    
+    return 1;
+}
+
+/* the sets are unmodified if the items still reference the base encoding */
+static int is_unmodified_template_set(const MetaDictTemplate* tmpl, uint32_t index, MXFMetadataSet* set)
+{
+    const MXFAvidMetaDictEncoding* baseEncoding = tmpl->encodings[4];
+    MXFListIterator iter;
+    
+    if (!mxf_equals_uuid(&set->instanceUID, &tmpl->instanceUIDs[index]) ||
+        set->fixedSpaceAllocation != 0 ||
+        mxf_get_list_length(&set->items) != tmpl->numItems[index])
+    {
+        return 0;
+    }
+    
+    mxf_initialise_list_iter(&iter, &set->items);
+    while (mxf_next_list_iter_element(&iter))
+    {
+        MXFMetadataItem* item = (MXFMetadataItem*)mxf_get_iter_element(&iter);
+        
+        if (!item->valueIsRef ||
+            item->value < baseEncoding->data ||
+            item->value >= baseEncoding->data + baseEncoding->size)
+        {
+            return 0;
+        }
+    }
+    
+    return 1;
+}
+
+
+int mxf_avid_create_default_metadictionary(MXFHeaderMetadata* headerMetadata, MXFMetadataSet** metaDictSet)
+{
+    const MetaDictTemplate* tmpl;
+    int result;
+    
+    if (get_metadict_template(headerMetadata->dataModel, &tmpl))
+    {
+        CHK_ORET((result = instantiate_metadict_template(tmpl, headerMetadata, metaDictSet)) > 0);
+        if (result == 1)
+        {
+            return 1;
+        }
+    }
+    
+    /* build the meta-dictionary in this header metadata if the template can't be used */
+    return mxf_avid_build_default_metadictionary(headerMetadata, metaDictSet);
+}
+
+int mxf_avid_get_default_metadict_encoding(MXFFile* mxfFile, MXFHeaderMetadata* headerMetadata,
+    const MXFAvidMetaDictEncoding** encoding)
+{
+    MetaDictTemplate* tmpl;
+    MXFMetadataSet** sets = NULL;
+    uint32_t numSets;
+    uint8_t llen;
+    uint32_t i;
+    
+    *encoding = NULL;
+    
+    CHK_ORET(mxf_call_once(&g_metaDictTemplateOnce, init_metadict_template_mutex));
+    CHK_ORET(g_haveMetaDictTemplateMutex);
+    
+    mxf_lock_mutex(&g_metaDictTemplateMutex);
+    tmpl = g_metaDictTemplate;
+    mxf_unlock_mutex(&g_metaDictTemplateMutex);
+    if (tmpl == NULL)
+    {
+        return 1;
+    }
+    
+    CHK_ORET(get_metadict_sets(headerMetadata, &sets, &numSets));
+    if (numSets != tmpl->numSets)
+    {
+        SAFE_FREE(&sets);
+        return 1;
+    }
+    for (i = 0; i < numSets; i++)
+    {
+        if (!is_unmodified_template_set(tmpl, i, sets[i]))
+        {
+            SAFE_FREE(&sets);
+            return 1;
+        }
+    }
+    
+    llen = get_encoding_llen(mxfFile);
+    if (llen >= sizeof(tmpl->encodings) / sizeof(tmpl->encodings[0]))
+    {
+        SAFE_FREE(&sets);
+        return 1;
+    }
+    
+    mxf_lock_mutex(&g_metaDictTemplateMutex);
+    if (tmpl->encodings[llen] == NULL &&
+        !create_metadict_encoding(sets, numSets, tmpl->instanceUIDs, llen, &tmpl->encodings[llen]))
+    {
+        mxf_unlock_mutex(&g_metaDictTemplateMutex);
+        SAFE_FREE(&sets);
+        return 0;
+    }
+    *encoding = tmpl->encodings[llen];
+    mxf_unlock_mutex(&g_metaDictTemplateMutex);
+    
+    SAFE_FREE(&sets);
+    return 1;
+}
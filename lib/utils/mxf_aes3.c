@@ -0,0 +1,520 @@
+/*
+ * $Id$
+ *
+ * Conversion between D-10 (SMPTE 331) AES3 sound elements and interleaved PCM
+ *
+ * Copyright (C) 2010  British Broadcasting Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include <string.h>
+
+#include <mxf/mxf.h>
+#include <mxf/mxf_aes3.h>
+
+
+#if defined(__GNUC__) && (__GNUC__ >= 5 || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_AES3_SIMD      1
+#define SSSE3_TARGET        __attribute__((target("ssse3")))
+#define AVX2_TARGET         __attribute__((target("avx2")))
+#include <tmmintrin.h>
+#include <immintrin.h>
+#elif defined(_MSC_VER) && _MSC_VER >= 1700 && (defined(_M_X64) || defined(_M_IX86))
+#define HAVE_AES3_SIMD      1
+#define SSSE3_TARGET
+#define AVX2_TARGET
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+
+typedef struct
+{
+    uint32_t blockAlign;
+    uint32_t shift;                 /* right shift of the channel word to get the PCM sample in the lsbs */
+    uint32_t numChannels;
+    uint32_t sampleSize;            /* numChannels * blockAlign */
+    uint32_t halfSize;              /* PCM bytes from channels 0 to 3 */
+    uint8_t channels[MXF_AES3_NUM_CHANNELS];
+} ConvertInfo;
+
+
+/* the SIMD paths read or write up to 32 PCM bytes per sample and the last samples are converted by the
+   scalar code to stay within the buffers */
+static uint32_t get_num_simd_samples(const ConvertInfo* info, uint32_t sampleCount)
+{
+    uint32_t tailSamples = (info->halfSize + 32 + info->sampleSize - 1) / info->sampleSize;
+
+    return sampleCount > tailSamples ? sampleCount - tailSamples : 0;
+}
+
+static void init_convert_info(ConvertInfo* info, uint8_t channelValidFlags, uint32_t blockAlign)
+{
+    uint32_t i;
+
+    info->blockAlign = blockAlign;
+    info->shift = 4 + (3 - blockAlign) * 8;
+    info->numChannels = 0;
+    info->halfSize = 0;
+    for (i = 0; i < MXF_AES3_NUM_CHANNELS; i++)
+    {
+        if (channelValidFlags & (1 << i))
+        {
+            info->channels[info->numChannels++] = (uint8_t)i;
+            if (i < 4)
+            {
+                info->halfSize += blockAlign;
+            }
+        }
+    }
+    info->sampleSize = info->numChannels * blockAlign;
+}
+
+
+static void scalar_aes3_to_pcm(const ConvertInfo* info, const uint8_t* aesSamples, uint32_t sampleCount,
+                               uint8_t* pcmData)
+{
+    const uint8_t* aesSample;
+    uint32_t word;
+    uint32_t i;
+    uint32_t c;
+
+    for (i = 0; i < sampleCount; i++)
+    {
+        for (c = 0; c < info->numChannels; c++)
+        {
+            aesSample = &aesSamples[info->channels[c] * 4];
+            word = (aesSample[0] | ((uint32_t)aesSample[1] << 8) | ((uint32_t)aesSample[2] << 16) |
+                       ((uint32_t)aesSample[3] << 24)) >> info->shift;
+
+            pcmData[0] = (uint8_t)word;
+            if (info->blockAlign > 1)
+            {
+                pcmData[1] = (uint8_t)(word >> 8);
+                if (info->blockAlign > 2)
+                {
+                    pcmData[2] = (uint8_t)(word >> 16);
+                }
+            }
+            pcmData += info->blockAlign;
+        }
+        aesSamples += MXF_AES3_SAMPLE_SIZE;
+    }
+}
+
+static void scalar_pcm_to_aes3(const ConvertInfo* info, const uint8_t* pcmData, uint32_t sampleCount,
+                               uint8_t* aesSamples)
+{
+    uint32_t word;
+    uint32_t i;
+    uint32_t c;
+
+    for (i = 0; i < sampleCount; i++)
+    {
+        for (c = 0; c < MXF_AES3_NUM_CHANNELS; c++)
+        {
+            word = c;
+            if (c < info->numChannels)
+            {
+                switch (info->blockAlign)
+                {
+                    case 1:
+                        word |= (uint32_t)pcmData[0] << 20;
+                        break;
+                    case 2:
+                        word |= ((uint32_t)pcmData[0] << 12) | ((uint32_t)pcmData[1] << 20);
+                        break;
+                    default:
+                        word |= ((uint32_t)pcmData[0] << 4) | ((uint32_t)pcmData[1] << 12) |
+                            ((uint32_t)pcmData[2] << 20);
+                        break;
+                }
+                pcmData += info->blockAlign;
+            }
+
+            aesSamples[0] = (uint8_t)word;
+            aesSamples[1] = (uint8_t)(word >> 8);
+            aesSamples[2] = (uint8_t)(word >> 16);
+            aesSamples[3] = (uint8_t)(word >> 24);
+            aesSamples += 4;
+        }
+    }
+}
+
+
+#if defined(HAVE_AES3_SIMD)
+
+/* -1: not checked yet. The check always produces the same value and so concurrent first calls are harmless */
+static volatile int g_cpuImpl = -1;
+static volatile int g_maxImpl = MXF_AES3_AVX2_IMPL;
+
+static int get_cpu_impl(void)
+{
+    if (g_cpuImpl < 0)
+    {
+#if defined(_MSC_VER)
+        int info[4];
+        int impl = MXF_AES3_SCALAR_IMPL;
+
+        __cpuid(info, 1);
+        if (info[2] & (1 << 9))
+        {
+            impl = MXF_AES3_SSSE3_IMPL;
+
+            /* AVX2 also requires the OS to save the YMM registers */
+            if ((info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 0x6) == 0x6)
+            {
+                __cpuidex(info, 7, 0);
+                if (info[1] & (1 << 5))
+                {
+                    impl = MXF_AES3_AVX2_IMPL;
+                }
+            }
+        }
+        g_cpuImpl = impl;
+#else
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2"))
+        {
+            g_cpuImpl = MXF_AES3_AVX2_IMPL;
+        }
+        else if (__builtin_cpu_supports("ssse3"))
+        {
+            g_cpuImpl = MXF_AES3_SSSE3_IMPL;
+        }
+        else
+        {
+            g_cpuImpl = MXF_AES3_SCALAR_IMPL;
+        }
+#endif
+    }
+
+    return g_cpuImpl;
+}
+
+/* Shuffle that packs the blockAlign lsbs of the valid channel words (after the shift) of one half
+   sample (channels 0-3 or 4-7) together */
+static void build_unpack_shuffle(const ConvertInfo* info, uint32_t half, uint8_t shuffle[16])
+{
+    uint32_t out = 0;
+    uint32_t c;
+    uint32_t b;
+
+    memset(shuffle, 0x80, 16);
+    for (c = 0; c < info->numChannels; c++)
+    {
+        if (info->channels[c] / 4 != half)
+        {
+            continue;
+        }
+        for (b = 0; b < info->blockAlign; b++)
+        {
+            shuffle[out++] = (uint8_t)((info->channels[c] % 4) * 4 + b);
+        }
+    }
+}
+
+/* Shuffle that places the PCM bytes of channels 0-3 or 4-7 in the msbs of the channel words; a shift
+   right by 4 then gives the channel word audio bits */
+static void build_pack_shuffle(const ConvertInfo* info, uint32_t half, uint8_t shuffle[16])
+{
+    uint32_t c;
+    uint32_t b;
+
+    memset(shuffle, 0x80, 16);
+    for (c = half * 4; c < half * 4 + 4 && c < info->numChannels; c++)
+    {
+        for (b = 0; b < info->blockAlign; b++)
+        {
+            shuffle[(c % 4) * 4 + 4 - info->blockAlign + b] = (uint8_t)((c % 4) * info->blockAlign + b);
+        }
+    }
+}
+
+SSSE3_TARGET static void ssse3_aes3_to_pcm(const ConvertInfo* info, const uint8_t* aesSamples,
+                                           uint32_t sampleCount, uint8_t* pcmData)
+{
+    uint8_t shuffleBytes[2][16];
+    __m128i shuffle0, shuffle1;
+    __m128i shift;
+    __m128i x0, x1;
+    uint32_t i;
+
+    build_unpack_shuffle(info, 0, shuffleBytes[0]);
+    build_unpack_shuffle(info, 1, shuffleBytes[1]);
+    shuffle0 = _mm_loadu_si128((const __m128i*)shuffleBytes[0]);
+    shuffle1 = _mm_loadu_si128((const __m128i*)shuffleBytes[1]);
+    shift = _mm_cvtsi32_si128((int)info->shift);
+
+    for (i = 0; i < sampleCount; i++)
+    {
+        x0 = _mm_loadu_si128((const __m128i*)aesSamples);
+        x1 = _mm_loadu_si128((const __m128i*)(aesSamples + 16));
+        x0 = _mm_shuffle_epi8(_mm_srl_epi32(x0, shift), shuffle0);
+        x1 = _mm_shuffle_epi8(_mm_srl_epi32(x1, shift), shuffle1);
+
+        /* the second store overwrites the unused part of the first */
+        _mm_storeu_si128((__m128i*)pcmData, x0);
+        _mm_storeu_si128((__m128i*)(pcmData + info->halfSize), x1);
+
+        aesSamples += MXF_AES3_SAMPLE_SIZE;
+        pcmData += info->sampleSize;
+    }
+}
+
+SSSE3_TARGET static void ssse3_pcm_to_aes3(const ConvertInfo* info, const uint8_t* pcmData,
+                                           uint32_t sampleCount, uint8_t* aesSamples)
+{
+    uint8_t shuffleBytes[2][16];
+    __m128i shuffle0, shuffle1;
+    __m128i channels0, channels1;
+    __m128i x0, x1;
+    uint32_t i;
+
+    build_pack_shuffle(info, 0, shuffleBytes[0]);
+    build_pack_shuffle(info, 1, shuffleBytes[1]);
+    shuffle0 = _mm_loadu_si128((const __m128i*)shuffleBytes[0]);
+    shuffle1 = _mm_loadu_si128((const __m128i*)shuffleBytes[1]);
+    channels0 = _mm_set_epi32(3, 2, 1, 0);
+    channels1 = _mm_set_epi32(7, 6, 5, 4);
+
+    for (i = 0; i < sampleCount; i++)
+    {
+        x0 = _mm_loadu_si128((const __m128i*)pcmData);
+        x1 = _mm_loadu_si128((const __m128i*)(pcmData + info->halfSize));
+        x0 = _mm_or_si128(_mm_srli_epi32(_mm_shuffle_epi8(x0, shuffle0), 4), channels0);
+        x1 = _mm_or_si128(_mm_srli_epi32(_mm_shuffle_epi8(x1, shuffle1), 4), channels1);
+        _mm_storeu_si128((__m128i*)aesSamples, x0);
+        _mm_storeu_si128((__m128i*)(aesSamples + 16), x1);
+
+        pcmData += info->sampleSize;
+        aesSamples += MXF_AES3_SAMPLE_SIZE;
+    }
+}
+
+/* the AVX2 versions process a whole sample (8 channel words) per register; the byte shuffles work
+   within each 128-bit lane and so use the same half sample shuffles as the SSSE3 versions. If the
+   PCM bytes from channels 0-3 are a whole number of 32-bit words then a cross-lane permute joins (or
+   splits) the two halves and a single 32 byte store (or load) is used */
+static void build_lane_permute(const ConvertInfo* info, int join, int32_t permute[8])
+{
+    int32_t halfWords = (int32_t)(info->halfSize / 4);
+    int32_t i;
+
+    for (i = 0; i < 8; i++)
+    {
+        if (join)
+        {
+            /* words 0 to halfWords-1 from the low lane followed by the words from the high lane */
+            permute[i] = (i < halfWords) ? i : 4 + i - halfWords;
+        }
+        else
+        {
+            /* the inverse: split the words at halfWords over the 2 lanes */
+            permute[i] = (i < 4) ? i : halfWords + i - 4;
+        }
+        permute[i] &= 7;
+    }
+}
+
+AVX2_TARGET static void avx2_aes3_to_pcm(const ConvertInfo* info, const uint8_t* aesSamples,
+                                         uint32_t sampleCount, uint8_t* pcmData)
+{
+    uint8_t shuffleBytes[32];
+    int32_t permuteWords[8];
+    __m256i shuffle;
+    __m256i permute;
+    __m128i shift;
+    __m256i x;
+    uint32_t i;
+
+    build_unpack_shuffle(info, 0, &shuffleBytes[0]);
+    build_unpack_shuffle(info, 1, &shuffleBytes[16]);
+    build_lane_permute(info, 1, permuteWords);
+    shuffle = _mm256_loadu_si256((const __m256i*)shuffleBytes);
+    permute = _mm256_loadu_si256((const __m256i*)permuteWords);
+    shift = _mm_cvtsi32_si128((int)info->shift);
+
+    if (info->halfSize % 4 == 0)
+    {
+        for (i = 0; i < sampleCount; i++)
+        {
+            x = _mm256_loadu_si256((const __m256i*)aesSamples);
+            x = _mm256_shuffle_epi8(_mm256_srl_epi32(x, shift), shuffle);
+            _mm256_storeu_si256((__m256i*)pcmData, _mm256_permutevar8x32_epi32(x, permute));
+
+            aesSamples += MXF_AES3_SAMPLE_SIZE;
+            pcmData += info->sampleSize;
+        }
+    }
+    else
+    {
+        for (i = 0; i < sampleCount; i++)
+        {
+            x = _mm256_loadu_si256((const __m256i*)aesSamples);
+            x = _mm256_shuffle_epi8(_mm256_srl_epi32(x, shift), shuffle);
+
+            /* the second store overwrites the unused part of the first */
+            _mm_storeu_si128((__m128i*)pcmData, _mm256_castsi256_si128(x));
+            _mm_storeu_si128((__m128i*)(pcmData + info->halfSize), _mm256_extracti128_si256(x, 1));
+
+            aesSamples += MXF_AES3_SAMPLE_SIZE;
+            pcmData += info->sampleSize;
+        }
+    }
+}
+
+AVX2_TARGET static void avx2_pcm_to_aes3(const ConvertInfo* info, const uint8_t* pcmData,
+                                         uint32_t sampleCount, uint8_t* aesSamples)
+{
+    uint8_t shuffleBytes[32];
+    int32_t permuteWords[8];
+    __m256i shuffle;
+    __m256i permute;
+    __m256i channels;
+    __m256i x;
+    uint32_t i;
+
+    build_pack_shuffle(info, 0, &shuffleBytes[0]);
+    build_pack_shuffle(info, 1, &shuffleBytes[16]);
+    build_lane_permute(info, 0, permuteWords);
+    shuffle = _mm256_loadu_si256((const __m256i*)shuffleBytes);
+    permute = _mm256_loadu_si256((const __m256i*)permuteWords);
+    channels = _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+
+    for (i = 0; i < sampleCount; i++)
+    {
+        if (info->halfSize % 4 == 0)
+        {
+            x = _mm256_permutevar8x32_epi32(_mm256_loadu_si256((const __m256i*)pcmData), permute);
+        }
+        else
+        {
+            x = _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)pcmData));
+            x = _mm256_inserti128_si256(x, _mm_loadu_si128((const __m128i*)(pcmData + info->halfSize)), 1);
+        }
+        x = _mm256_or_si256(_mm256_srli_epi32(_mm256_shuffle_epi8(x, shuffle), 4), channels);
+        _mm256_storeu_si256((__m256i*)aesSamples, x);
+
+        pcmData += info->sampleSize;
+        aesSamples += MXF_AES3_SAMPLE_SIZE;
+    }
+}
+
+#endif
+
+
+
+int mxf_convert_aes3_to_pcm(const uint8_t* aesData, uint64_t aesDataLen, uint32_t blockAlign,
+                            uint8_t* pcmData, uint64_t* pcmDataLen, uint32_t* numChannels)
+{
+    ConvertInfo info;
+    uint32_t sampleCount;
+    uint32_t simdSampleCount = 0;
+
+    CHK_ORET(aesDataLen >= MXF_AES3_HEADER_SIZE);
+    CHK_ORET(blockAlign >= 1 && blockAlign <= 3); /* only 8-bit to 24-bit sample size possible */
+
+    sampleCount = ((uint32_t)aesData[2] << 8) | aesData[1];
+    CHK_ORET(sampleCount == (aesDataLen - MXF_AES3_HEADER_SIZE) / MXF_AES3_SAMPLE_SIZE);
+
+    init_convert_info(&info, aesData[3], blockAlign);
+
+    if (info.numChannels > 0)
+    {
+#if defined(HAVE_AES3_SIMD)
+        switch (mxf_get_aes3_impl())
+        {
+            case MXF_AES3_AVX2_IMPL:
+                simdSampleCount = get_num_simd_samples(&info, sampleCount);
+                avx2_aes3_to_pcm(&info, &aesData[MXF_AES3_HEADER_SIZE], simdSampleCount, pcmData);
+                break;
+            case MXF_AES3_SSSE3_IMPL:
+                simdSampleCount = get_num_simd_samples(&info, sampleCount);
+                ssse3_aes3_to_pcm(&info, &aesData[MXF_AES3_HEADER_SIZE], simdSampleCount, pcmData);
+                break;
+            case MXF_AES3_SCALAR_IMPL:
+                break;
+        }
+#endif
+        scalar_aes3_to_pcm(&info, &aesData[MXF_AES3_HEADER_SIZE + simdSampleCount * MXF_AES3_SAMPLE_SIZE],
+                           sampleCount - simdSampleCount, &pcmData[simdSampleCount * info.sampleSize]);
+    }
+
+    *pcmDataLen = (uint64_t)sampleCount * info.sampleSize;
+    *numChannels = info.numChannels;
+    return 1;
+}
+
+int mxf_convert_pcm_to_aes3(const uint8_t* pcmData, uint32_t channelCount, uint32_t blockAlign,
+                            uint32_t sampleCount, uint8_t elementHeader, uint8_t* aesData)
+{
+    ConvertInfo info;
+    uint32_t simdSampleCount = 0;
+
+    CHK_ORET(channelCount >= 1 && channelCount <= MXF_AES3_NUM_CHANNELS);
+    CHK_ORET(blockAlign >= 1 && blockAlign <= 3);
+    CHK_ORET(sampleCount <= 0xffff);
+
+    init_convert_info(&info, (uint8_t)((1 << channelCount) - 1), blockAlign);
+
+    aesData[0] = elementHeader;
+    aesData[1] = (uint8_t)(sampleCount & 0xff);
+    aesData[2] = (uint8_t)((sampleCount >> 8) & 0xff);
+    aesData[3] = (uint8_t)((1 << channelCount) - 1);
+
+#if defined(HAVE_AES3_SIMD)
+    switch (mxf_get_aes3_impl())
+    {
+        case MXF_AES3_AVX2_IMPL:
+            simdSampleCount = get_num_simd_samples(&info, sampleCount);
+            avx2_pcm_to_aes3(&info, pcmData, simdSampleCount, &aesData[MXF_AES3_HEADER_SIZE]);
+            break;
+        case MXF_AES3_SSSE3_IMPL:
+            simdSampleCount = get_num_simd_samples(&info, sampleCount);
+            ssse3_pcm_to_aes3(&info, pcmData, simdSampleCount, &aesData[MXF_AES3_HEADER_SIZE]);
+            break;
+        case MXF_AES3_SCALAR_IMPL:
+            break;
+    }
+#endif
+    scalar_pcm_to_aes3(&info, &pcmData[simdSampleCount * info.sampleSize], sampleCount - simdSampleCount,
+                       &aesData[MXF_AES3_HEADER_SIZE + simdSampleCount * MXF_AES3_SAMPLE_SIZE]);
+
+    return 1;
+}
+
+MXFAES3Impl mxf_get_aes3_impl(void)
+{
+#if defined(HAVE_AES3_SIMD)
+    int impl = get_cpu_impl();
+
+    return (MXFAES3Impl)(impl < g_maxImpl ? impl : g_maxImpl);
+#else
+    return MXF_AES3_SCALAR_IMPL;
+#endif
+}
+
+void mxf_set_max_aes3_impl(MXFAES3Impl impl)
+{
+#if defined(HAVE_AES3_SIMD)
+    g_maxImpl = impl;
+#else
+    (void)impl;
+#endif
+}
+
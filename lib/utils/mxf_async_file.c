@@ -0,0 +1,451 @@
+/*
+ * $Id$
+ *
+ * Asynchronous write-behind MXFFile wrapper
+ *
+ * Copyright (C) 2010  British Broadcasting Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mxf/mxf.h>
+#include <mxf/mxf_thread.h>
+#include <mxf/mxf_async_file.h>
+
+
+typedef struct
+{
+    uint8_t* data;
+    uint32_t size;
+} AsyncBuffer;
+
+struct MXFAsyncFile
+{
+    MXFFile* mxfFile;
+};
+
+struct MXFFileSysData
+{
+    MXFAsyncFile asyncFile;
+
+    MXFFile* target;
+    int isSeekable;
+    int64_t position;
+
+    AsyncBuffer* buffers;
+    uint32_t bufferSize;
+    uint32_t numBuffers;
+
+    /* buffer being filled by the writer; only valid if haveFillBuffer is true */
+    uint32_t fillIndex;
+    int haveFillBuffer;
+
+    /* protected by the mutex: the queue starts at writeIndex and the buffer at writeIndex
+       stays queued until the background thread has written it */
+    MXFMutex mutex;
+    MXFCondition dataCondition;
+    MXFCondition spaceCondition;
+    uint32_t writeIndex;
+    uint32_t numQueued;
+    int stopThread;
+    int writeFailed;
+    MXFAsyncFileStats stats;
+
+    MXFThread thread;
+    int haveThread;
+    int haveSync;
+};
+
+
+static void write_thread(void* arg)
+{
+    MXFFileSysData* sysData = (MXFFileSysData*)arg;
+    AsyncBuffer* buffer;
+    int writeFailed;
+
+    mxf_lock_mutex(&sysData->mutex);
+    for (;;)
+    {
+        while (sysData->numQueued == 0 && !sysData->stopThread)
+        {
+            mxf_wait_condition(&sysData->dataCondition, &sysData->mutex);
+        }
+        if (sysData->numQueued == 0)
+        {
+            break;
+        }
+
+        buffer = &sysData->buffers[sysData->writeIndex];
+        writeFailed = sysData->writeFailed;
+        mxf_unlock_mutex(&sysData->mutex);
+
+        /* data is discarded once a write has failed */
+        if (!writeFailed && mxf_file_write(sysData->target, buffer->data, buffer->size) != buffer->size)
+        {
+            mxf_log_error("Failed to write %u bytes to the target file" LOG_LOC_FORMAT,
+                buffer->size, LOG_LOC_PARAMS);
+            writeFailed = 1;
+        }
+
+        mxf_lock_mutex(&sysData->mutex);
+        if (writeFailed)
+        {
+            sysData->writeFailed = 1;
+        }
+        else
+        {
+            sysData->stats.bytesWritten += buffer->size;
+        }
+        buffer->size = 0;
+        sysData->writeIndex = (sysData->writeIndex + 1) % sysData->numBuffers;
+        sysData->numQueued--;
+        mxf_broadcast_condition(&sysData->spaceCondition);
+    }
+    mxf_unlock_mutex(&sysData->mutex);
+}
+
+static void enqueue_fill_buffer(MXFFileSysData* sysData)
+{
+    mxf_lock_mutex(&sysData->mutex);
+    sysData->numQueued++;
+    if (sysData->numQueued > sysData->stats.maxQueueDepth)
+    {
+        sysData->stats.maxQueueDepth = sysData->numQueued;
+    }
+    mxf_signal_condition(&sysData->dataCondition);
+    mxf_unlock_mutex(&sysData->mutex);
+
+    sysData->haveFillBuffer = 0;
+}
+
+static int get_fill_buffer(MXFFileSysData* sysData)
+{
+    int64_t startTime;
+    int writeFailed;
+
+    mxf_lock_mutex(&sysData->mutex);
+    if (sysData->numQueued == sysData->numBuffers)
+    {
+        startTime = mxf_get_monotonic_time_usec();
+        while (sysData->numQueued == sysData->numBuffers)
+        {
+            mxf_wait_condition(&sysData->spaceCondition, &sysData->mutex);
+        }
+        sysData->stats.numStalls++;
+        sysData->stats.stallTime += mxf_get_monotonic_time_usec() - startTime;
+    }
+    sysData->fillIndex = (sysData->writeIndex + sysData->numQueued) % sysData->numBuffers;
+    writeFailed = sysData->writeFailed;
+    mxf_unlock_mutex(&sysData->mutex);
+
+    sysData->haveFillBuffer = !writeFailed;
+    return !writeFailed;
+}
+
+/* queue the partially filled buffer and wait until the background thread has written everything */
+static int drain_queue(MXFFileSysData* sysData)
+{
+    int writeFailed;
+
+    if (sysData->haveFillBuffer && sysData->buffers[sysData->fillIndex].size > 0)
+    {
+        enqueue_fill_buffer(sysData);
+    }
+
+    mxf_lock_mutex(&sysData->mutex);
+    while (sysData->numQueued > 0)
+    {
+        mxf_wait_condition(&sysData->spaceCondition, &sysData->mutex);
+    }
+    writeFailed = sysData->writeFailed;
+    mxf_unlock_mutex(&sysData->mutex);
+
+    return !writeFailed;
+}
+
+
+static void free_async_file(MXFFileSysData* sysData)
+{
+    if (sysData == NULL)
+    {
+        return;
+    }
+
+    free(sysData);
+}
+
+static void async_file_close(MXFFileSysData* sysData)
+{
+    uint32_t i;
+
+    if (sysData == NULL)
+    {
+        return;
+    }
+
+    if (sysData->haveThread)
+    {
+        drain_queue(sysData);
+
+        mxf_lock_mutex(&sysData->mutex);
+        sysData->stopThread = 1;
+        mxf_signal_condition(&sysData->dataCondition);
+        mxf_unlock_mutex(&sysData->mutex);
+
+        mxf_join_thread(&sysData->thread);
+        sysData->haveThread = 0;
+    }
+    if (sysData->haveSync)
+    {
+        mxf_destroy_condition(&sysData->spaceCondition);
+        mxf_destroy_condition(&sysData->dataCondition);
+        mxf_destroy_mutex(&sysData->mutex);
+        sysData->haveSync = 0;
+    }
+
+    mxf_file_close(&sysData->target);
+
+    if (sysData->buffers != NULL)
+    {
+        for (i = 0; i < sysData->numBuffers; i++)
+        {
+            SAFE_FREE(&sysData->buffers[i].data);
+        }
+        SAFE_FREE(&sysData->buffers);
+    }
+}
+
+static uint32_t async_file_write(MXFFileSysData* sysData, const uint8_t* data, uint32_t count)
+{
+    AsyncBuffer* buffer;
+    uint32_t totalWrite = 0;
+    uint32_t numWrite;
+
+    while (totalWrite < count)
+    {
+        if (!sysData->haveFillBuffer)
+        {
+            if (!get_fill_buffer(sysData))
+            {
+                break;
+            }
+        }
+        buffer = &sysData->buffers[sysData->fillIndex];
+
+        numWrite = sysData->bufferSize - buffer->size;
+        if (numWrite > count - totalWrite)
+        {
+            numWrite = count - totalWrite;
+        }
+        memcpy(&buffer->data[buffer->size], &data[totalWrite], numWrite);
+        buffer->size += numWrite;
+        totalWrite += numWrite;
+
+        if (buffer->size == sysData->bufferSize)
+        {
+            enqueue_fill_buffer(sysData);
+        }
+    }
+
+    sysData->position += totalWrite;
+    return totalWrite;
+}
+
+static int async_file_putchar(MXFFileSysData* sysData, int c)
+{
+    uint8_t data[1];
+    data[0] = (uint8_t)c;
+
+    if (async_file_write(sysData, data, 1) != 1)
+    {
+        return EOF;
+    }
+
+    return c;
+}
+
+static uint32_t async_file_read(MXFFileSysData* sysData, uint8_t* data, uint32_t count)
+{
+    uint32_t numRead;
+
+    if (!drain_queue(sysData))
+    {
+        return 0;
+    }
+
+    numRead = mxf_file_read(sysData->target, data, count);
+    sysData->position += numRead;
+
+    return numRead;
+}
+
+static int async_file_getchar(MXFFileSysData* sysData)
+{
+    uint8_t data[1];
+
+    if (async_file_read(sysData, data, 1) != 1)
+    {
+        return EOF;
+    }
+
+    return (int)data[0];
+}
+
+static int async_file_eof(MXFFileSysData* sysData)
+{
+    if (!drain_queue(sysData))
+    {
+        return 1;
+    }
+
+    return mxf_file_eof(sysData->target);
+}
+
+static int async_file_seek(MXFFileSysData* sysData, int64_t offset, int whence)
+{
+    int result;
+
+    if (!drain_queue(sysData))
+    {
+        return 0;
+    }
+
+    result = mxf_file_seek(sysData->target, offset, whence);
+    sysData->position = mxf_file_tell(sysData->target);
+
+    return result;
+}
+
+static int64_t async_file_tell(MXFFileSysData* sysData)
+{
+    return sysData->position;
+}
+
+static int async_file_is_seekable(MXFFileSysData* sysData)
+{
+    return sysData->isSeekable;
+}
+
+static int64_t async_file_size(MXFFileSysData* sysData)
+{
+    if (!drain_queue(sysData))
+    {
+        return -1;
+    }
+
+    return mxf_file_size(sysData->target);
+}
+
+
+
+int mxf_async_file_wrap(MXFFile* target, uint32_t bufferSize, uint32_t numBuffers, MXFAsyncFile** asyncFile)
+{
+    MXFFile* newMXFFile = NULL;
+    MXFFileSysData* sysData;
+    uint32_t i;
+
+    CHK_MALLOC_OFAIL(newMXFFile, MXFFile);
+    memset(newMXFFile, 0, sizeof(*newMXFFile));
+
+    newMXFFile->close = async_file_close;
+    newMXFFile->read = async_file_read;
+    newMXFFile->write = async_file_write;
+    newMXFFile->get_char = async_file_getchar;
+    newMXFFile->put_char = async_file_putchar;
+    newMXFFile->eof = async_file_eof;
+    newMXFFile->seek = async_file_seek;
+    newMXFFile->tell = async_file_tell;
+    newMXFFile->is_seekable = async_file_is_seekable;
+    newMXFFile->size = async_file_size;
+    newMXFFile->free_sys_data = free_async_file;
+    newMXFFile->minLLen = target->minLLen;
+
+
+    CHK_MALLOC_OFAIL(newMXFFile->sysData, MXFFileSysData);
+    memset(newMXFFile->sysData, 0, sizeof(*newMXFFile->sysData));
+    sysData = newMXFFile->sysData;
+
+    sysData->asyncFile.mxfFile = newMXFFile;
+    sysData->target = target;
+    sysData->isSeekable = mxf_file_is_seekable(target);
+    sysData->position = mxf_file_tell(target);
+    sysData->bufferSize = (bufferSize == 0 ? MXF_ASYNC_FILE_DEFAULT_BUFFER_SIZE : bufferSize);
+    sysData->numBuffers = (numBuffers == 0 ? MXF_ASYNC_FILE_DEFAULT_NUM_BUFFERS : numBuffers);
+
+    CHK_MALLOC_ARRAY_OFAIL(sysData->buffers, AsyncBuffer, sysData->numBuffers);
+    memset(sysData->buffers, 0, sizeof(AsyncBuffer) * sysData->numBuffers);
+    for (i = 0; i < sysData->numBuffers; i++)
+    {
+        CHK_MALLOC_ARRAY_OFAIL(sysData->buffers[i].data, uint8_t, sysData->bufferSize);
+    }
+
+    CHK_OFAIL(mxf_init_mutex(&sysData->mutex));
+    if (!mxf_init_condition(&sysData->dataCondition))
+    {
+        mxf_destroy_mutex(&sysData->mutex);
+        goto fail;
+    }
+    if (!mxf_init_condition(&sysData->spaceCondition))
+    {
+        mxf_destroy_condition(&sysData->dataCondition);
+        mxf_destroy_mutex(&sysData->mutex);
+        goto fail;
+    }
+    sysData->haveSync = 1;
+
+    CHK_OFAIL(mxf_create_thread(&sysData->thread, write_thread, sysData));
+    sysData->haveThread = 1;
+
+
+    *asyncFile = &sysData->asyncFile;
+    return 1;
+
+fail:
+    if (newMXFFile == NULL || newMXFFile->sysData == NULL)
+    {
+        mxf_file_close(&target);
+        SAFE_FREE(&newMXFFile);
+    }
+    else
+    {
+        mxf_file_close(&newMXFFile);
+    }
+    return 0;
+}
+
+MXFFile* mxf_async_file_get_file(MXFAsyncFile* asyncFile)
+{
+    return asyncFile->mxfFile;
+}
+
+int mxf_async_file_flush(MXFAsyncFile* asyncFile)
+{
+    return drain_queue(asyncFile->mxfFile->sysData);
+}
+
+void mxf_async_file_get_stats(MXFAsyncFile* asyncFile, MXFAsyncFileStats* stats)
+{
+    MXFFileSysData* sysData = asyncFile->mxfFile->sysData;
+
+    mxf_lock_mutex(&sysData->mutex);
+    *stats = sysData->stats;
+    stats->queueDepth = sysData->numQueued;
+    mxf_unlock_mutex(&sysData->mutex);
+}
+
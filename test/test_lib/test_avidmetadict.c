@@ -0,0 +1,217 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <mxf/mxf.h>
+#include <mxf/mxf_avid.h>
+#include <mxf/mxf_thread.h>
+
+
+#define BENCH_ITERATIONS    50
+
+static const mxfKey g_conflictItemKey =
+    {0x06, 0x0e, 0x2b, 0x34, 0x01, 0x01, 0x01, 0x01, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f, 0x7f};
+
+
+static int create_header_metadata(MXFDataModel* dataModel, MXFHeaderMetadata** headerMetadata,
+    MXFMetadataSet** metaDictSet)
+{
+    CHK_ORET(mxf_create_header_metadata(headerMetadata, dataModel));
+    CHK_ORET(mxf_avid_create_default_metadictionary(*headerMetadata, metaDictSet));
+
+    return 1;
+}
+
+/* writes the meta-dictionary sets one by one and checks the result equals the shared encoding */
+static int check_encoding(MXFHeaderMetadata* headerMetadata, MXFMetadataSet* metaDictSet, uint8_t llen)
+{
+    const MXFAvidMetaDictEncoding* encoding;
+    MXFListIterator iter;
+    MXFFile* memFile = NULL;
+    uint32_t numSets = 1;
+
+    CHK_ORET(mxf_mem_file_open_new(0, &memFile));
+    mxf_file_set_min_llen(memFile, llen);
+
+    CHK_OFAIL(mxf_avid_get_default_metadict_encoding(memFile, headerMetadata, &encoding));
+    CHK_OFAIL(encoding != NULL);
+
+    CHK_OFAIL(mxf_write_set(memFile, metaDictSet));
+    mxf_initialise_list_iter(&iter, &headerMetadata->sets);
+    while (mxf_next_list_iter_element(&iter))
+    {
+        MXFMetadataSet* set = (MXFMetadataSet*)mxf_get_iter_element(&iter);
+
+        if (mxf_is_subclass_of(headerMetadata->dataModel, &set->key, &MXF_SET_K(MetaDefinition)))
+        {
+            CHK_OFAIL(mxf_equals_uuid(&set->instanceUID, &encoding->instanceUIDs[numSets]));
+            CHK_OFAIL(mxf_file_tell(memFile) == encoding->setOffsets[numSets]);
+            CHK_OFAIL(mxf_write_set(memFile, set));
+            numSets++;
+        }
+    }
+
+    CHK_OFAIL(numSets == encoding->numSets);
+    CHK_OFAIL(mxf_file_size(memFile) == encoding->size);
+    CHK_OFAIL(memcmp(mxf_file_get_data(memFile, 0, encoding->size), encoding->data, encoding->size) == 0);
+
+    mxf_file_close(&memFile);
+    return 1;
+
+fail:
+    mxf_file_close(&memFile);
+    return 0;
+}
+
+static int get_first_metadef(MXFHeaderMetadata* headerMetadata, MXFMetadataSet** metaDefSet)
+{
+    MXFListIterator iter;
+
+    mxf_initialise_list_iter(&iter, &headerMetadata->sets);
+    while (mxf_next_list_iter_element(&iter))
+    {
+        MXFMetadataSet* set = (MXFMetadataSet*)mxf_get_iter_element(&iter);
+
+        if (mxf_is_subclass_of(headerMetadata->dataModel, &set->key, &MXF_SET_K(MetaDefinition)))
+        {
+            *metaDefSet = set;
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static int have_encoding(MXFHeaderMetadata* headerMetadata)
+{
+    const MXFAvidMetaDictEncoding* encoding = NULL;
+    MXFFile* memFile = NULL;
+
+    CHK_ORET(mxf_mem_file_open_new(0, &memFile));
+    if (!mxf_avid_get_default_metadict_encoding(memFile, headerMetadata, &encoding))
+    {
+        encoding = NULL;
+    }
+    mxf_file_close(&memFile);
+
+    return encoding != NULL;
+}
+
+int test()
+{
+    MXFDataModel* dataModel = NULL;
+    MXFHeaderMetadata* headerMetadata1 = NULL;
+    MXFHeaderMetadata* headerMetadata2 = NULL;
+    MXFHeaderMetadata* headerMetadata3 = NULL;
+    MXFMetadataSet* metaDictSet1;
+    MXFMetadataSet* metaDictSet2;
+    MXFMetadataSet* metaDictSet3;
+    MXFMetadataSet* metaDefSet;
+    mxfLocalTag tag;
+    mxfLocalTag conflictTag;
+
+    CHK_OFAIL(mxf_avid_get_default_data_model(&dataModel));
+
+    /* the meta-dictionaries are created from the shared template and match the shared encodings */
+    CHK_OFAIL(create_header_metadata(dataModel, &headerMetadata1, &metaDictSet1));
+    CHK_OFAIL(create_header_metadata(dataModel, &headerMetadata2, &metaDictSet2));
+    CHK_OFAIL(mxf_equals_uuid(&metaDictSet1->instanceUID, &metaDictSet2->instanceUID));
+    CHK_OFAIL(check_encoding(headerMetadata1, metaDictSet1, 0));
+    CHK_OFAIL(check_encoding(headerMetadata2, metaDictSet2, 9));
+
+    /* changing a set means the sets are written individually */
+    CHK_OFAIL(get_first_metadef(headerMetadata2, &metaDefSet));
+    CHK_OFAIL(mxf_set_utf16string_item(metaDefSet, &MXF_ITEM_K(MetaDefinition, Name), L"Changed"));
+    CHK_OFAIL(!have_encoding(headerMetadata2));
+    CHK_OFAIL(have_encoding(headerMetadata1));
+
+    /* a conflict with a dynamic primer tag registered by the meta-dictionary means the meta-dictionary 
+       is built in the header metadata instead */
+    CHK_OFAIL(mxf_create_header_metadata(&headerMetadata3, dataModel));
+    CHK_OFAIL(mxf_create_item_tag(headerMetadata1->primerPack, &conflictTag));
+    CHK_OFAIL(mxf_register_primer_entry(headerMetadata3->primerPack, (const mxfUID*)&g_conflictItemKey,
+        conflictTag + 1, &tag));
+    CHK_OFAIL(mxf_avid_create_default_metadictionary(headerMetadata3, &metaDictSet3));
+    CHK_OFAIL(!mxf_equals_uuid(&metaDictSet1->instanceUID, &metaDictSet3->instanceUID));
+    CHK_OFAIL(!have_encoding(headerMetadata3));
+
+    mxf_free_header_metadata(&headerMetadata1);
+    mxf_free_header_metadata(&headerMetadata2);
+    mxf_free_header_metadata(&headerMetadata3);
+    mxf_free_data_model(&dataModel);
+    return 1;
+
+fail:
+    mxf_free_header_metadata(&headerMetadata1);
+    mxf_free_header_metadata(&headerMetadata2);
+    mxf_free_header_metadata(&headerMetadata3);
+    mxf_free_data_model(&dataModel);
+    return 0;
+}
+
+/* time building the meta-dictionary in a header metadata and creating it from the shared template */
+static int benchmark()
+{
+    MXFDataModel* dataModel = NULL;
+    MXFHeaderMetadata* headerMetadata = NULL;
+    MXFMetadataSet* metaDictSet;
+    int64_t startTime;
+    int64_t buildTime = 0;
+    int64_t templateTime = 0;
+    int i;
+
+    CHK_OFAIL(mxf_avid_get_default_data_model(&dataModel));
+
+    for (i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        CHK_OFAIL(mxf_create_header_metadata(&headerMetadata, dataModel));
+        startTime = mxf_get_monotonic_time_usec();
+        CHK_OFAIL(mxf_avid_build_default_metadictionary(headerMetadata, &metaDictSet));
+        buildTime += mxf_get_monotonic_time_usec() - startTime;
+        mxf_free_header_metadata(&headerMetadata);
+
+        CHK_OFAIL(mxf_create_header_metadata(&headerMetadata, dataModel));
+        startTime = mxf_get_monotonic_time_usec();
+        CHK_OFAIL(mxf_avid_create_default_metadictionary(headerMetadata, &metaDictSet));
+        templateTime += mxf_get_monotonic_time_usec() - startTime;
+        mxf_free_header_metadata(&headerMetadata);
+    }
+
+    printf("Build meta-dictionary:         %8.1f us\n", buildTime / (double)BENCH_ITERATIONS);
+    printf("Create from shared template:   %8.1f us\n", templateTime / (double)BENCH_ITERATIONS);
+
+    mxf_free_data_model(&dataModel);
+    return 1;
+
+fail:
+    mxf_free_header_metadata(&headerMetadata);
+    mxf_free_data_model(&dataModel);
+    return 0;
+}
+
+void usage(const char* cmd)
+{
+    fprintf(stderr, "Usage: %s [--bench]\n", cmd);
+}
+
+int main(int argc, const char* argv[])
+{
+    if (argc > 2 || (argc == 2 && strcmp(argv[1], "--bench") != 0))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (!test())
+    {
+        return 1;
+    }
+
+    if (argc == 2 && !benchmark())
+    {
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,139 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <mxf/mxf.h>
+
+
+#define BUFFER_SIZE     70000
+
+
+/* byte at a time reference implementation */
+static uint32_t ref_crc32(const uint8_t* data, uint32_t size)
+{
+    uint32_t crc = 0xffffffff;
+    uint32_t i;
+    int k;
+
+    for (i = 0; i < size; i++)
+    {
+        crc ^= data[i];
+        for (k = 0; k < 8; k++)
+        {
+            crc = (crc & 1) ? (0xedb88320 ^ (crc >> 1)) : (crc >> 1);
+        }
+    }
+
+    return crc ^ 0xffffffff;
+}
+
+static int check_buffer(const uint8_t* data, uint32_t size)
+{
+    uint32_t expected = ref_crc32(data, size);
+    uint32_t crc32;
+    uint32_t split;
+
+    if (mxf_calc_crc32(data, size) != expected)
+    {
+        fprintf(stderr, "CRC-32 mismatch for size %u (simd=%d)\n", size, mxf_have_crc32_simd());
+        return 0;
+    }
+
+    /* incremental update with varying block sizes */
+    crc32 = 0;
+    split = 0;
+    while (split < size)
+    {
+        uint32_t blockSize = (split % 97) + 1;
+        if (blockSize > size - split)
+        {
+            blockSize = size - split;
+        }
+        crc32 = mxf_update_crc32(crc32, &data[split], blockSize);
+        split += blockSize;
+    }
+    if (crc32 != expected)
+    {
+        fprintf(stderr, "Incremental CRC-32 mismatch for size %u (simd=%d)\n", size, mxf_have_crc32_simd());
+        return 0;
+    }
+
+    return 1;
+}
+
+static int test_sizes(const uint8_t* buffer)
+{
+    static const uint32_t sizes[] = {0, 1, 7, 8, 15, 16, 17, 63, 64, 65, 79, 80, 127, 128, 129, 255, 1000,
+                                     5760, BUFFER_SIZE - 8};
+    size_t i;
+    uint32_t offset;
+
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    {
+        /* unaligned starts */
+        for (offset = 0; offset < 8; offset++)
+        {
+            CHK_ORET(check_buffer(&buffer[offset], sizes[i]));
+        }
+    }
+
+    return 1;
+}
+
+int test()
+{
+    static const uint8_t check[] = "123456789";
+    uint8_t* buffer;
+    uint32_t i;
+
+    /* the standard check value */
+    CHK_ORET(mxf_calc_crc32(check, 9) == 0xcbf43926);
+    CHK_ORET(mxf_update_crc32(mxf_update_crc32(0, check, 4), &check[4], 5) == 0xcbf43926);
+    CHK_ORET(mxf_calc_crc32(check, 0) == 0);
+
+    CHK_ORET((buffer = (uint8_t*)malloc(BUFFER_SIZE)) != NULL);
+    srand(1);
+    for (i = 0; i < BUFFER_SIZE; i++)
+    {
+        buffer[i] = (uint8_t)(rand() >> 4);
+    }
+
+    printf("CRC-32 SIMD path %savailable\n", mxf_have_crc32_simd() ? "" : "not ");
+    CHK_OFAIL(test_sizes(buffer));
+
+    mxf_enable_crc32_simd(0);
+    CHK_OFAIL(!mxf_have_crc32_simd());
+    CHK_OFAIL(test_sizes(buffer));
+    mxf_enable_crc32_simd(1);
+
+    free(buffer);
+    return 1;
+
+fail:
+    mxf_enable_crc32_simd(1);
+    free(buffer);
+    return 0;
+}
+
+void usage(const char* cmd)
+{
+    fprintf(stderr, "Usage: %s\n", cmd);
+}
+
+int main(int argc, const char* argv[])
+{
+    if (argc != 1)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (!test())
+    {
+        return 1;
+    }
+
+    return 0;
+}
+
@@ -4,6 +4,24 @@
 #include <assert.h>
 
 #include <mxf/mxf.h>
+#include <mxf/mxf_avid.h>
+#include <mxf/mxf_thread.h>
+
+
+#define NUM_STRESS_THREADS      8
+#define NUM_STRESS_ITERATIONS   50
+
+
+typedef struct
+{
+    MXFSetDef** setDefs;
+    MXFItemDef** itemDefs;
+    uint8_t* isMetadataSubclass;
+    size_t numSetDefs;
+    size_t numItemDefs;
+    int threadIndex;
+    int failed;
+} StressThreadData;
 
 
 #define EXT_DATA_MODEL \
@@ -143,6 +161,11 @@ int test()
     
     CHK_OFAIL(mxf_find_set_def(dataModel, &MXF_SET_K(TestSet4), &setDef));
     CHK_OFAIL(mxf_find_item_def_in_set_def(&MXF_ITEM_K(TestSet1, TestItem1), setDef, &itemDef));
+    CHK_OFAIL(mxf_find_item_def_in_set_def(&MXF_ITEM_K(InterchangeObject, InstanceUID), setDef, &itemDef));
+    
+    /* item defs in sibling set defs are not found */
+    CHK_OFAIL(mxf_find_set_def(dataModel, &MXF_SET_K(TestSet3), &setDef));
+    CHK_OFAIL(!mxf_find_item_def_in_set_def(&MXF_ITEM_K(TestSet4, TestItem3), setDef, &itemDef));
     
     CHK_OFAIL(mxf_is_subclass_of(dataModel, &MXF_SET_K(TestSet4), &MXF_SET_K(TestSet1)));
     
@@ -184,11 +207,201 @@ int test()
 #undef MXF_COMPOUND_TYPE_MEMBER
 #undef MXF_INTERPRETED_TYPE_DEF
 
+
+    /* a duplicate set def is detected and the first one registered is still found */
+    CHK_OFAIL(mxf_find_set_def(dataModel, &MXF_SET_K(TestSet2), &setDef));
+    CHK_OFAIL(mxf_register_set_def(dataModel, "TestSet2Duplicate", &MXF_SET_K(TestSet1), &MXF_SET_K(TestSet2)));
+    CHK_OFAIL(mxf_finalise_data_model(dataModel));
+    CHK_OFAIL(!mxf_check_data_model(dataModel));
+    CHK_OFAIL(mxf_find_set_def(dataModel, &MXF_SET_K(TestSet2), &setDef));
+    CHK_OFAIL(strcmp(setDef->name, "TestSet2") == 0);
+    
+    
+    mxf_free_data_model(&dataModel);
+    return 1;
+    
+fail:
+    mxf_free_data_model(&dataModel);
+    return 0;
+}
+
+
+/* the lookups use the default data model and must give the same results as the single threaded
+   lookups in test_default_data_model() */
+static int stress_data_model(StressThreadData* data)
+{
+    MXFDataModel* dataModel = NULL;
+    MXFHeaderMetadata* headerMetadata = NULL;
+    MXFMetadataSet* set;
+    MXFSetDef* setDef;
+    MXFItemDef* itemDef;
+    uint16_t version;
+    size_t i;
+    
+    /* each thread takes and releases its own reference */
+    CHK_ORET(mxf_get_default_data_model(&dataModel));
+    
+    for (i = 0; i < data->numSetDefs; i++)
+    {
+        CHK_OFAIL(mxf_find_set_def(dataModel, &data->setDefs[i]->key, &setDef));
+        CHK_OFAIL(setDef == data->setDefs[i]);
+        CHK_OFAIL(mxf_is_subclass_of(dataModel, &setDef->key, &MXF_SET_K(GenericPackage)) ==
+            data->isMetadataSubclass[i]);
+    }
+    for (i = 0; i < data->numItemDefs; i++)
+    {
+        CHK_OFAIL(mxf_find_item_def(dataModel, &data->itemDefs[i]->key, &itemDef));
+        CHK_OFAIL(itemDef == data->itemDefs[i]);
+        CHK_OFAIL(mxf_find_set_def(dataModel, &itemDef->setDefKey, &setDef));
+        CHK_OFAIL(mxf_find_item_def_in_set_def(&itemDef->key, setDef, &itemDef));
+        CHK_OFAIL(itemDef == data->itemDefs[i]);
+        CHK_OFAIL(mxf_get_item_def_type(dataModel, itemDef->typeId) != NULL);
+    }
+    
+    /* header metadata only reads the data model */
+    CHK_OFAIL(mxf_create_header_metadata(&headerMetadata, dataModel));
+    CHK_OFAIL(mxf_create_set(headerMetadata, &MXF_SET_K(Preface), &set));
+    CHK_OFAIL(mxf_set_version_type_item(set, &MXF_ITEM_K(Preface, Version), (uint16_t)(0x0102 + data->threadIndex)));
+    CHK_OFAIL(mxf_get_version_type_item(set, &MXF_ITEM_K(Preface, Version), &version));
+    CHK_OFAIL(version == 0x0102 + data->threadIndex);
+    CHK_OFAIL(mxf_create_set(headerMetadata, &MXF_SET_K(ContentStorage), &set));
+    
+    mxf_free_header_metadata(&headerMetadata);
+    mxf_free_data_model(&dataModel);
+    return 1;
+    
+fail:
+    mxf_free_header_metadata(&headerMetadata);
+    mxf_free_data_model(&dataModel);
+    return 0;
+}
+
+static void stress_thread(void* arg)
+{
+    StressThreadData* data = (StressThreadData*)arg;
+    int i;
+    
+    for (i = 0; i < NUM_STRESS_ITERATIONS; i++)
+    {
+        if (!stress_data_model(data))
+        {
+            data->failed = 1;
+            break;
+        }
+    }
+}
+
+int test_default_data_model()
+{
+    MXFDataModel* dataModel = NULL;
+    MXFDataModel* dataModel2 = NULL;
+    MXFDataModel* avidDataModel = NULL;
+    MXFDataModel* avidDataModel2 = NULL;
+    MXFListIterator iter;
+    MXFSetDef* setDef;
+    StressThreadData threadData[NUM_STRESS_THREADS];
+    MXFThread threads[NUM_STRESS_THREADS];
+    int numThreads = 0;
+    MXFSetDef** setDefs = NULL;
+    MXFItemDef** itemDefs = NULL;
+    uint8_t* isMetadataSubclass = NULL;
+    size_t numSetDefs;
+    size_t numItemDefs;
+    size_t i;
+    int j;
+    int result = 1;
+    
+    /* the default data model is shared, read-only and only contains the baseline definitions */
+    CHK_ORET(mxf_get_default_data_model(&dataModel));
+    CHK_OFAIL(mxf_get_default_data_model(&dataModel2));
+    CHK_OFAIL(dataModel == dataModel2);
+    mxf_free_data_model(&dataModel2);
+    CHK_OFAIL(dataModel2 == NULL);
+    CHK_OFAIL(mxf_find_set_def(dataModel, &MXF_SET_K(Preface), &setDef));
+    CHK_OFAIL(!mxf_find_set_def(dataModel, &MXF_SET_K(MetaDictionary), &setDef));
+    CHK_OFAIL(!mxf_register_set_def(dataModel, "TestSet1", &MXF_SET_K(InterchangeObject), &MXF_SET_K(TestSet1)));
+    CHK_OFAIL(!mxf_finalise_data_model(dataModel));
+    CHK_OFAIL(mxf_check_data_model(dataModel));
+    
+    /* the Avid default data model is a separate shared data model that includes the extensions */
+    CHK_OFAIL(mxf_avid_get_default_data_model(&avidDataModel));
+    CHK_OFAIL(mxf_avid_get_default_data_model(&avidDataModel2));
+    CHK_OFAIL(avidDataModel == avidDataModel2 && avidDataModel != dataModel);
+    mxf_free_data_model(&avidDataModel2);
+    CHK_OFAIL(mxf_find_set_def(avidDataModel, &MXF_SET_K(MetaDictionary), &setDef));
+    CHK_OFAIL(!mxf_finalise_data_model(avidDataModel));
+    CHK_OFAIL(mxf_check_data_model(avidDataModel));
+    mxf_free_data_model(&avidDataModel);
+    CHK_OFAIL(mxf_avid_get_default_data_model(&avidDataModel));
+    CHK_OFAIL(mxf_find_set_def(avidDataModel, &MXF_SET_K(MetaDictionary), &setDef));
+    mxf_free_data_model(&avidDataModel);
     
+    /* get the single threaded lookup results */
+    numSetDefs = mxf_get_list_length(&dataModel->setDefs);
+    numItemDefs = mxf_get_list_length(&dataModel->itemDefs);
+    CHK_MALLOC_ARRAY_OFAIL(setDefs, MXFSetDef*, numSetDefs);
+    CHK_MALLOC_ARRAY_OFAIL(itemDefs, MXFItemDef*, numItemDefs);
+    CHK_MALLOC_ARRAY_OFAIL(isMetadataSubclass, uint8_t, numSetDefs);
+    i = 0;
+    mxf_initialise_list_iter(&iter, &dataModel->setDefs);
+    while (mxf_next_list_iter_element(&iter))
+    {
+        setDefs[i] = (MXFSetDef*)mxf_get_iter_element(&iter);
+        isMetadataSubclass[i] = (uint8_t)mxf_is_subclass_of(dataModel, &setDefs[i]->key, &MXF_SET_K(GenericPackage));
+        i++;
+    }
+    i = 0;
+    mxf_initialise_list_iter(&iter, &dataModel->itemDefs);
+    while (mxf_next_list_iter_element(&iter))
+    {
+        itemDefs[i++] = (MXFItemDef*)mxf_get_iter_element(&iter);
+    }
+    
+    
+    /* run the lookups concurrently */
+    for (j = 0; j < NUM_STRESS_THREADS; j++)
+    {
+        threadData[j].setDefs = setDefs;
+        threadData[j].itemDefs = itemDefs;
+        threadData[j].isMetadataSubclass = isMetadataSubclass;
+        threadData[j].numSetDefs = numSetDefs;
+        threadData[j].numItemDefs = numItemDefs;
+        threadData[j].threadIndex = j;
+        threadData[j].failed = 0;
+        if (!mxf_create_thread(&threads[j], stress_thread, &threadData[j]))
+        {
+            result = 0;
+            break;
+        }
+        numThreads++;
+    }
+    for (j = 0; j < numThreads; j++)
+    {
+        if (!mxf_join_thread(&threads[j]) || threadData[j].failed)
+        {
+            result = 0;
+        }
+    }
+    CHK_OFAIL(result);
+    
+    
+    /* the default data model is recreated after the last reference has been released */
+    mxf_free_data_model(&dataModel);
+    CHK_OFAIL(mxf_get_default_data_model(&dataModel));
+    CHK_OFAIL(mxf_find_set_def(dataModel, &MXF_SET_K(Preface), &setDef));
+    
+    SAFE_FREE(&setDefs);
+    SAFE_FREE(&itemDefs);
+    SAFE_FREE(&isMetadataSubclass);
     mxf_free_data_model(&dataModel);
     return 1;
     
 fail:
+    SAFE_FREE(&setDefs);
+    SAFE_FREE(&itemDefs);
+    SAFE_FREE(&isMetadataSubclass);
+    mxf_free_data_model(&avidDataModel2);
+    mxf_free_data_model(&avidDataModel);
     mxf_free_data_model(&dataModel);
     return 0;
 }
@@ -212,6 +425,11 @@ int main(int argc, const char* argv[])
         return 1;
     }
     
+    if (!test_default_data_model())
+    {
+        return 1;
+    }
+    
     return 0;
 }
 
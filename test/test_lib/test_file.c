@@ -21,6 +21,30 @@ static uint8_t data[256];
     
 
 
+/* the file is positioned at offset 1 */
+static int test_read_vector(MXFFile* mxfFile)
+{
+    uint8_t indata[100];
+    MXFIOVector vectors[4];
+    
+    memset(indata, 0, sizeof(indata));
+    vectors[0].data = &indata[1];
+    vectors[0].size = 10;
+    vectors[1].data = &indata[11];
+    vectors[1].size = 0;
+    vectors[2].data = &indata[11];
+    vectors[2].size = 1;
+    vectors[3].data = &indata[12];
+    vectors[3].size = 88;
+    
+    CHK_ORET(mxf_file_read_vector(mxfFile, vectors, 4) == 99);
+    CHK_ORET(memcmp(&data[1], &indata[1], 99) == 0);
+    CHK_ORET(mxf_file_tell(mxfFile) == 100);
+    CHK_ORET(mxf_file_getc(mxfFile) == 0xff);
+    
+    return 1;
+}
+
 int test_read(const char* filename)
 {
     MXFFile* mxfFile = NULL;
@@ -113,10 +137,38 @@ int test_read(const char* filename)
     CHK_OFAIL(mxf_read_array_header(mxfFile, &ablen, &abelen));
     CHK_OFAIL(ablen == 4 && abelen == 32);
 
+    /* read into multiple buffers, mixed with buffered reads */
+    CHK_OFAIL(mxf_file_seek(mxfFile, 0, SEEK_SET));
+    CHK_OFAIL(mxf_file_getc(mxfFile) == data[0]);
+    CHK_OFAIL(test_read_vector(mxfFile));
+
 
     mxf_file_close(&mxfFile);
 
-    
+
+    /* test reading from a memory mapped file */
+
+    if (!mxf_disk_file_open_mmap_read(filename, MXF_FILE_ACCESS_SEQUENTIAL, &mxfFile))
+    {
+        mxf_log_error("Failed to open '%s' memory mapped" LOG_LOC_FORMAT, filename, LOG_LOC_PARAMS);
+        return 0;
+    }
+
+    CHK_OFAIL(mxf_file_read(mxfFile, indata, 100) == 100);
+    CHK_OFAIL(memcmp(data, indata, 100) == 0);
+    CHK_OFAIL(mxf_file_getc(mxfFile) == 0xff);
+    CHK_OFAIL(mxf_file_get_data(mxfFile, 0, 100) != NULL);
+    CHK_OFAIL(memcmp(data, mxf_file_get_data(mxfFile, 0, 100), 100) == 0);
+    CHK_OFAIL(mxf_file_get_data(mxfFile, mxf_file_size(mxfFile) - 1, 2) == NULL);
+    CHK_OFAIL(mxf_file_seek(mxfFile, 0, SEEK_SET));
+    CHK_OFAIL(mxf_file_read(mxfFile, indata, 100) == 100);
+    CHK_OFAIL(mxf_file_tell(mxfFile) == 100);
+    CHK_OFAIL(mxf_file_seek(mxfFile, 1, SEEK_SET));
+    CHK_OFAIL(test_read_vector(mxfFile));
+
+    mxf_file_close(&mxfFile);
+
+
     /* test reading from a byte buffer */
     
     const uint8_t data[5] = {1, 2, 3, 4, 5};
@@ -219,6 +271,52 @@ fail:
     return 0;
 }
 
+int test_direct_write(const char* filename)
+{
+    MXFFile* mxfFile = NULL;
+    uint8_t block[8192];
+    uint8_t indata[100];
+    int64_t filePos;
+    int i;
+    
+    
+    if (!mxf_disk_file_open_direct_new(filename, &mxfFile))
+    {
+        mxf_log_error("Failed to create direct '%s'" LOG_LOC_FORMAT, filename, LOG_LOC_PARAMS);
+        return 0;
+    }
+
+    /* TEST */
+    
+    /* write the data, followed by enough to be written in whole blocks, and then re-write the start */
+    memset(block, 0x55, sizeof(block));
+    CHK_OFAIL(do_write(mxfFile));
+    CHK_OFAIL((filePos = mxf_file_tell(mxfFile)) > 0);
+    for (i = 0; i < 16; i++)
+    {
+        CHK_OFAIL(mxf_file_write(mxfFile, block, sizeof(block)) == sizeof(block));
+    }
+    CHK_OFAIL(mxf_file_size(mxfFile) == filePos + 16 * (int64_t)sizeof(block));
+    CHK_OFAIL(mxf_file_seek(mxfFile, 0, SEEK_SET));
+    CHK_OFAIL(do_write(mxfFile));
+    CHK_OFAIL(mxf_file_tell(mxfFile) == filePos);
+    
+    CHK_OFAIL(mxf_file_read(mxfFile, indata, sizeof(indata)) == sizeof(indata));
+    CHK_OFAIL(memcmp(block, indata, sizeof(indata)) == 0);
+    CHK_OFAIL(mxf_file_seek(mxfFile, 0, SEEK_END));
+    CHK_OFAIL(mxf_file_tell(mxfFile) == filePos + 16 * (int64_t)sizeof(block));
+    
+    mxf_file_close(&mxfFile);
+    
+    CHK_OFAIL(test_read(filename));
+    
+    return 1;
+    
+fail:
+    mxf_file_close(&mxfFile);
+    return 0;
+}
+
 int test_modify(const char* filename)
 {
     MXFFile* mxfFile = NULL;
@@ -245,6 +343,91 @@ fail:
     return 0;
 }
 
+/* checks that the file contains size bytes matching the source file */
+static int check_copied_data(MXFFile* mxfFile, MXFFile* sourceFile, int64_t size)
+{
+    uint8_t indata[256];
+    uint8_t sourceData[256];
+    uint32_t count;
+    
+    CHK_ORET(mxf_file_seek(sourceFile, 0, SEEK_SET));
+    while (size > 0)
+    {
+        count = size < (int64_t)sizeof(indata) ? (uint32_t)size : sizeof(indata);
+        CHK_ORET(mxf_file_read(mxfFile, indata, count) == count);
+        CHK_ORET(mxf_file_read(sourceFile, sourceData, count) == count);
+        CHK_ORET(memcmp(indata, sourceData, count) == 0);
+        size -= count;
+    }
+    
+    return 1;
+}
+
+int test_copy(const char* filename)
+{
+    MXFFile* sourceFile = NULL;
+    MXFFile* mxfFile = NULL;
+    char copyFilename[FILENAME_MAX];
+    uint8_t indata[256];
+    int64_t size;
+    
+    
+    snprintf(copyFilename, sizeof(copyFilename), "%s_copy", filename);
+    
+    if (!mxf_disk_file_open_read(filename, &sourceFile))
+    {
+        mxf_log_error("Failed to open '%s'" LOG_LOC_FORMAT, filename, LOG_LOC_PARAMS);
+        return 0;
+    }
+    CHK_OFAIL((size = mxf_file_size(sourceFile)) > 0);
+    
+    if (!mxf_disk_file_open_new(copyFilename, &mxfFile))
+    {
+        mxf_log_error("Failed to create '%s'" LOG_LOC_FORMAT, copyFilename, LOG_LOC_PARAMS);
+        goto fail;
+    }
+
+    /* TEST */
+    
+    /* copy between disk files following a pending write, and past the end of the source file */
+    CHK_OFAIL(mxf_file_putc(mxfFile, 0x01));
+    CHK_OFAIL(mxf_file_copy(mxfFile, sourceFile, size) == (uint64_t)size);
+    CHK_OFAIL(mxf_file_tell(sourceFile) == size);
+    CHK_OFAIL(mxf_file_putc(mxfFile, 0x02));
+    CHK_OFAIL(mxf_file_seek(sourceFile, 0, SEEK_SET));
+    CHK_OFAIL(mxf_file_copy(mxfFile, sourceFile, size + 10) == (uint64_t)size);
+    CHK_OFAIL(mxf_file_tell(mxfFile) == 2 + 2 * size);
+    mxf_file_close(&sourceFile);
+    
+    /* copy through a buffer */
+    memset(data, 0xaa, 256);
+    CHK_OFAIL(mxf_byte_array_wrap_read(data, 256, &sourceFile));
+    CHK_OFAIL(mxf_file_copy(mxfFile, sourceFile, 256) == 256);
+    mxf_file_close(&sourceFile);
+    mxf_file_close(&mxfFile);
+    
+    CHK_OFAIL(mxf_disk_file_open_read(copyFilename, &mxfFile));
+    CHK_OFAIL(mxf_disk_file_open_read(filename, &sourceFile));
+    CHK_OFAIL(mxf_file_size(mxfFile) == 2 + 2 * size + 256);
+    CHK_OFAIL(mxf_file_getc(mxfFile) == 0x01);
+    CHK_OFAIL(check_copied_data(mxfFile, sourceFile, size));
+    CHK_OFAIL(mxf_file_getc(mxfFile) == 0x02);
+    CHK_OFAIL(check_copied_data(mxfFile, sourceFile, size));
+    CHK_OFAIL(mxf_file_read(mxfFile, indata, 256) == 256);
+    CHK_OFAIL(memcmp(data, indata, 256) == 0);
+    
+    mxf_file_close(&sourceFile);
+    mxf_file_close(&mxfFile);
+    remove(copyFilename);
+    return 1;
+    
+fail:
+    mxf_file_close(&sourceFile);
+    mxf_file_close(&mxfFile);
+    remove(copyFilename);
+    return 0;
+}
+
 
 void usage(const char* cmd)
 {
@@ -274,6 +457,16 @@ int main(int argc, const char* argv[])
         return 1;
     }
 
+    if (!test_copy(argv[1]))
+    {
+        return 1;
+    }
+
+    if (!test_direct_write(argv[1]))
+    {
+        return 1;
+    }
+
     return 0;
 }
 
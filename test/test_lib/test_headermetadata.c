@@ -204,6 +204,8 @@ int test_read(const char* filename)
     mxfUL ul;
     int64_t headerMetadataFilePos;
     MXFListIterator setsIter;
+    MXFMetadataItem* item;
+    uint8_t* bufferValue;
     
 
     if (!mxf_disk_file_open_read(filename, &mxfFile))
@@ -346,7 +348,57 @@ int test_read(const char* filename)
     CHK_OFAIL(mxf_dereference_s(headerMetadata, &setsIter, &prefaceSet->instanceUID, &prefaceSet));
     CHK_OFAIL(mxf_next_list_iter_element(&setsIter)); /* move it past the Preface */
     CHK_OFAIL(mxf_dereference_s(headerMetadata, &setsIter, &prefaceSet->instanceUID, &prefaceSet));
-                                    
+
+    /* test the instanceUID index is kept in sync when removing and adding sets */
+    CHK_OFAIL(mxf_remove_set(headerMetadata, set3));
+    CHK_OFAIL(!mxf_dereference(headerMetadata, &set3->instanceUID, &set));
+    CHK_OFAIL(mxf_add_set(headerMetadata, set3));
+    CHK_OFAIL(mxf_dereference(headerMetadata, &set3->instanceUID, &set) && set == set3);
+
+
+    /* read header metadata again, but now allocated from an arena */
+    mxf_free_header_metadata(&headerMetadata);
+    CHK_OFAIL(mxf_create_arena_header_metadata(&headerMetadata, dataModel));
+    CHK_OFAIL(mxf_file_seek(mxfFile, headerMetadataFilePos, SEEK_SET));
+    CHK_OFAIL(mxf_read_next_nonfiller_kl(mxfFile, &key, &llen, &len));
+    CHK_OFAIL(mxf_is_header_metadata(&key));
+    CHK_OFAIL(mxf_read_header_metadata(mxfFile, headerMetadata, headerPartition->headerByteCount,
+        &key, llen, len));
+
+    CHK_OFAIL(mxf_find_singular_set_by_key(headerMetadata, &MXF_SET_K(TestSet1), &set1));
+    CHK_OFAIL(mxf_get_utf16string_item(set1, &MXF_ITEM_K(TestSet1, TestItem14), value14));
+    CHK_OFAIL(wcscmp(L"A UTF16 String", value14) == 0);
+    CHK_OFAIL(mxf_set_utf16string_item(set1, &MXF_ITEM_K(TestSet1, TestItem14), L"A longer UTF16 String"));
+    CHK_OFAIL(mxf_get_utf16string_item(set1, &MXF_ITEM_K(TestSet1, TestItem14), value14));
+    CHK_OFAIL(wcscmp(L"A longer UTF16 String", value14) == 0);
+    CHK_OFAIL(mxf_find_singular_set_by_key(headerMetadata, &MXF_SET_K(TestSet3), &set3));
+    CHK_OFAIL(mxf_remove_set(headerMetadata, set3));
+    mxf_free_set(&set3);
+    CHK_OFAIL(mxf_get_list_length(&headerMetadata->sets) == 3);
+
+
+    /* read header metadata again, but now with item values referencing a single read buffer */
+    mxf_free_header_metadata(&headerMetadata);
+    CHK_OFAIL(mxf_create_header_metadata(&headerMetadata, dataModel));
+    CHK_OFAIL(mxf_file_seek(mxfFile, headerMetadataFilePos, SEEK_SET));
+    CHK_OFAIL(mxf_read_next_nonfiller_kl(mxfFile, &key, &llen, &len));
+    CHK_OFAIL(mxf_is_header_metadata(&key));
+    CHK_OFAIL(mxf_read_buffered_header_metadata(mxfFile, NULL, headerMetadata, headerPartition->headerByteCount,
+        &key, llen, len));
+
+    CHK_OFAIL(mxf_find_singular_set_by_key(headerMetadata, &MXF_SET_K(TestSet1), &set1));
+    CHK_OFAIL(mxf_get_strongref_item(set1, &MXF_ITEM_K(TestSet1, TestItem15), &set2));
+    CHK_OFAIL(memcmp(&set2->key, &MXF_SET_K(TestSet2), sizeof(mxfKey)) == 0);
+    CHK_OFAIL(mxf_get_item(set1, &MXF_ITEM_K(TestSet1, TestItem2), &item));
+    CHK_OFAIL(item->valueIsRef);
+    bufferValue = item->value;
+    CHK_OFAIL(mxf_set_uint16_item(set1, &MXF_ITEM_K(TestSet1, TestItem2), 0x00f0));
+    CHK_OFAIL(!item->valueIsRef && item->value != bufferValue);
+    mxf_get_uint16(bufferValue, &value2);
+    CHK_OFAIL(value2 == 0x0f00);
+    CHK_OFAIL(mxf_get_uint16_item(set1, &MXF_ITEM_K(TestSet1, TestItem2), &value2));
+    CHK_OFAIL(value2 == 0x00f0);
+
 
     /* test reading using filter */
     
@@ -409,6 +461,10 @@ int test_create_and_write(const char* filename)
     MXFMetadataSet* set2;
     MXFMetadataSet* set3;
     uint8_t* arrayElement;
+    MXFFile* memFile = NULL;
+    uint64_t headerSize;
+    uint8_t* headerBytes = NULL;
+    int64_t endPos;
 
     
     if (!mxf_disk_file_open_new(filename, &mxfFile))
@@ -482,6 +538,20 @@ int test_create_and_write(const char* filename)
     CHK_OFAIL(mxf_write_header_metadata(mxfFile, headerMetadata));
     CHK_OFAIL(mxf_mark_header_end(mxfFile, headerPartition));
 
+    /* the header metadata serialised in memory matches what was written */
+    CHK_OFAIL(mxf_write_header_metadata_to_mem_file(mxfFile, headerMetadata, &memFile));
+    mxf_get_header_metadata_size(mxfFile, headerMetadata, &headerSize);
+    CHK_OFAIL(mxf_file_size(memFile) == (int64_t)headerPartition->headerByteCount);
+    CHK_OFAIL((uint64_t)mxf_file_size(memFile) == headerSize);
+    CHK_MALLOC_ARRAY_OFAIL(headerBytes, uint8_t, (size_t)headerSize);
+    CHK_OFAIL((endPos = mxf_file_tell(mxfFile)) >= 0);
+    CHK_OFAIL(mxf_file_seek(mxfFile, endPos - (int64_t)headerSize, SEEK_SET));
+    CHK_OFAIL(mxf_file_read(mxfFile, headerBytes, (uint32_t)headerSize) == headerSize);
+    CHK_OFAIL(memcmp(headerBytes, mxf_file_get_data(memFile, 0, (uint32_t)headerSize), (size_t)headerSize) == 0);
+    CHK_OFAIL(mxf_file_seek(mxfFile, endPos, SEEK_SET));
+    SAFE_FREE(&headerBytes);
+    mxf_file_close(&memFile);
+
     
     /* write the footer pp */    
     CHK_OFAIL(mxf_append_new_from_partition(&partitions, headerPartition, 
@@ -500,6 +570,8 @@ int test_create_and_write(const char* filename)
     return 1;
     
 fail:
+    SAFE_FREE(&headerBytes);
+    mxf_file_close(&memFile);
     mxf_file_close(&mxfFile);
     mxf_clear_file_partitions(&partitions);
     mxf_free_data_model(&dataModel);
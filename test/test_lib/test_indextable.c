@@ -20,6 +20,10 @@ int test_read(const char* filename)
     MXFIndexTableSegment* indexSegment = NULL;
     MXFDeltaEntry* deltaEntry;
     MXFIndexEntry* indexEntry;
+    MXFCompactIndexTableSegment* compactSegments[2] = {NULL, NULL};
+    MXFCompactIndexTableSegment* compactSegment;
+    uint32_t segmentIndex;
+    uint32_t entryIndex;
 
     
     if (!mxf_disk_file_open_read(filename, &mxfFile))
@@ -106,13 +110,53 @@ int test_read(const char* filename)
     }
     
     
+    /* read compact index table segment */
     
+    CHK_OFAIL(mxf_read_next_nonfiller_kl(mxfFile, &key, &llen, &len));
+    CHK_OFAIL(mxf_is_index_table_segment(&key));
+    CHK_OFAIL(mxf_read_compact_index_table_segment(mxfFile, len, &compactSegments[1]));
+    compactSegment = compactSegments[1];
+    CHK_OFAIL(compactSegment->indexStartPosition == 0x0a);
+    CHK_OFAIL(compactSegment->indexDuration == 0x0a);
+    CHK_OFAIL(compactSegment->editUnitByteCount == 0);
+    CHK_OFAIL(compactSegment->sliceCount == 1);
+    CHK_OFAIL(compactSegment->posTableCount == 1);
+    CHK_OFAIL(compactSegment->numDeltaEntries == 2);
+    CHK_OFAIL(compactSegment->deltaElementData[1] == 1);
+    CHK_OFAIL(compactSegment->numIndexEntries == 0x0a);
+    for (i = 0; i < (int)compactSegment->numIndexEntries; i++)
+    {
+        CHK_OFAIL(compactSegment->temporalOffsets[i] == -i);
+        CHK_OFAIL(compactSegment->keyFrameOffsets[i] == -i);
+        CHK_OFAIL(compactSegment->flags[i] == 0x80 + i);
+        CHK_OFAIL(compactSegment->streamOffsets[i] == (uint64_t)i * 0x10000);
+        CHK_OFAIL((int)compactSegment->sliceOffsets[i] == i * 2);
+        CHK_OFAIL(compactSegment->posTables[i].numerator == i);
+        CHK_OFAIL(compactSegment->posTables[i].denominator == i + 1);
+    }
+    
+    /* lookup in a CBE followed by the VBE segment */
+    CHK_OFAIL(mxf_create_compact_index_table_segment(&compactSegments[0]));
+    compactSegments[0]->editUnitByteCount = 0x100;
+    compactSegments[0]->indexDuration = 0x0a;
+    CHK_OFAIL(mxf_find_compact_index_entry(compactSegments, 2, 3, &segmentIndex, &entryIndex));
+    CHK_OFAIL(segmentIndex == 0 && entryIndex == 3);
+    CHK_OFAIL(mxf_find_compact_index_entry(compactSegments, 2, 0x13, &segmentIndex, &entryIndex));
+    CHK_OFAIL(segmentIndex == 1 && entryIndex == 9);
+    CHK_OFAIL(!mxf_find_compact_index_entry(compactSegments, 2, 0x14, &segmentIndex, &entryIndex));
+    CHK_OFAIL(!mxf_find_compact_index_entry(compactSegments, 2, -1, &segmentIndex, &entryIndex));
+    
+    
+    mxf_free_compact_index_table_segment(&compactSegments[0]);
+    mxf_free_compact_index_table_segment(&compactSegments[1]);
     mxf_free_index_table_segment(&indexSegment);
     mxf_file_close(&mxfFile);
     mxf_clear_file_partitions(&partitions);
     return 1;
     
 fail:
+    mxf_free_compact_index_table_segment(&compactSegments[0]);
+    mxf_free_compact_index_table_segment(&compactSegments[1]);
     mxf_free_index_table_segment(&indexSegment);
     mxf_file_close(&mxfFile);
     mxf_clear_file_partitions(&partitions);
@@ -125,6 +169,7 @@ int test_create_and_write(const char* filename)
     MXFFilePartitions partitions;
     MXFPartition* headerPartition = NULL;
     MXFIndexTableSegment* indexSegment = NULL;
+    MXFCompactIndexTableSegment* compactSegment = NULL;
     uint32_t sliceOffset[2];
     mxfRational posTable[2];
     int i;
@@ -204,6 +249,37 @@ int test_create_and_write(const char* filename)
     CHK_OFAIL(mxf_mark_index_end(mxfFile, headerPartition));
 
     
+    /* write compact index table segment */  
+    CHK_OFAIL(mxf_mark_index_start(mxfFile, headerPartition));
+
+    CHK_OFAIL(mxf_create_compact_index_table_segment(&compactSegment)); 
+    mxf_generate_uuid(&compactSegment->instanceUID);
+    compactSegment->indexEditRate = editRate;
+    compactSegment->indexStartPosition = 0x0a;
+    compactSegment->indexDuration = 0x0a;
+    compactSegment->indexSID = 1;
+    compactSegment->bodySID = 2;
+    compactSegment->sliceCount = 1;
+    compactSegment->posTableCount = 1;
+    for (i = 0; i < 2; i++)
+    {
+        CHK_OFAIL(mxf_add_compact_delta_entry(compactSegment, 0, (uint8_t)i, i));
+    }
+    for (i = 0; i < compactSegment->indexDuration; i++)
+    {
+        sliceOffset[0] = i * 2;
+        posTable[0].numerator = i;
+        posTable[0].denominator = i + 1;
+        CHK_OFAIL(mxf_add_compact_index_entry(compactSegment, -i, -i, 0x80 + i, (uint64_t)i * 0x10000,
+            sliceOffset, posTable));
+    }
+    CHK_OFAIL(mxf_write_compact_index_table_segment(mxfFile, compactSegment));
+    
+    CHK_OFAIL(mxf_fill_to_kag(mxfFile, headerPartition));
+
+    CHK_OFAIL(mxf_mark_index_end(mxfFile, headerPartition));
+
+    
 
     /* update the partitions */
     CHK_OFAIL(mxf_update_partitions(mxfFile, &partitions));    
@@ -212,12 +288,105 @@ int test_create_and_write(const char* filename)
     mxf_file_close(&mxfFile);
     mxf_clear_file_partitions(&partitions);
     mxf_free_index_table_segment(&indexSegment);
+    mxf_free_compact_index_table_segment(&compactSegment);
     return 1;
     
 fail:
     mxf_file_close(&mxfFile);
     mxf_clear_file_partitions(&partitions);
     mxf_free_index_table_segment(&indexSegment);
+    mxf_free_compact_index_table_segment(&compactSegment);
+    return 0;
+}
+
+/* checks that a segment written using the compact representation is byte identical to the same 
+   segment written using the linked list representation */
+int test_compact_write_equals_list(int isVBE)
+{
+    MXFFile* listFile = NULL;
+    MXFFile* compactFile = NULL;
+    MXFIndexTableSegment* indexSegment = NULL;
+    MXFCompactIndexTableSegment* compactSegment = NULL;
+    const mxfRational editRate = {25, 1};
+    uint32_t sliceOffset[2];
+    mxfRational posTable[2];
+    int64_t size;
+    const uint8_t* listData;
+    const uint8_t* compactData;
+    int i;
+    int k;
+    
+    CHK_OFAIL(mxf_create_index_table_segment(&indexSegment)); 
+    CHK_OFAIL(mxf_create_compact_index_table_segment(&compactSegment)); 
+    
+    mxf_generate_uuid(&indexSegment->instanceUID);
+    indexSegment->indexEditRate = editRate;
+    indexSegment->indexStartPosition = 0x10;
+    indexSegment->indexDuration = isVBE ? 0x0c : 0x64;
+    indexSegment->editUnitByteCount = isVBE ? 0 : 0x100;
+    indexSegment->indexSID = 1;
+    indexSegment->bodySID = 2;
+    indexSegment->sliceCount = isVBE ? 2 : 0;
+    indexSegment->posTableCount = isVBE ? 2 : 0;
+    
+    compactSegment->instanceUID = indexSegment->instanceUID;
+    compactSegment->indexEditRate = indexSegment->indexEditRate;
+    compactSegment->indexStartPosition = indexSegment->indexStartPosition;
+    compactSegment->indexDuration = indexSegment->indexDuration;
+    compactSegment->editUnitByteCount = indexSegment->editUnitByteCount;
+    compactSegment->indexSID = indexSegment->indexSID;
+    compactSegment->bodySID = indexSegment->bodySID;
+    compactSegment->sliceCount = indexSegment->sliceCount;
+    compactSegment->posTableCount = indexSegment->posTableCount;
+    
+    for (i = 0; i < 3; i++)
+    {
+        CHK_OFAIL(mxf_default_add_delta_entry(NULL, 0, indexSegment, (int8_t)(i - 1), (uint8_t)i, i * 0x20));
+        CHK_OFAIL(mxf_add_compact_delta_entry(compactSegment, (int8_t)(i - 1), (uint8_t)i, i * 0x20));
+    }
+    if (isVBE)
+    {
+        for (i = 0; i < indexSegment->indexDuration; i++)
+        {
+            for (k = 0; k < indexSegment->sliceCount; k++)
+            {
+                sliceOffset[k] = i * 0x100 + k;
+            }
+            for (k = 0; k < indexSegment->posTableCount; k++)
+            {
+                posTable[k].numerator = -i;
+                posTable[k].denominator = k + 1;
+            }
+            CHK_OFAIL(mxf_default_add_index_entry(NULL, 0, indexSegment, (int8_t)(i % 3 - 1), (int8_t)-i, 
+                (uint8_t)(0x80 | i), (uint64_t)i * 0x12345, sliceOffset, posTable));
+            CHK_OFAIL(mxf_add_compact_index_entry(compactSegment, (int8_t)(i % 3 - 1), (int8_t)-i, 
+                (uint8_t)(0x80 | i), (uint64_t)i * 0x12345, sliceOffset, posTable));
+        }
+    }
+    
+    CHK_OFAIL(mxf_mem_file_open_new(0, &listFile));
+    CHK_OFAIL(mxf_mem_file_open_new(0, &compactFile));
+    CHK_OFAIL(mxf_write_index_table_segment(listFile, indexSegment));
+    CHK_OFAIL(mxf_write_compact_index_table_segment(compactFile, compactSegment));
+    
+    size = mxf_file_size(listFile);
+    CHK_OFAIL(size > 0 && size == mxf_file_size(compactFile));
+    CHK_OFAIL((listData = mxf_file_get_data(listFile, 0, (uint32_t)size)) != NULL);
+    CHK_OFAIL((compactData = mxf_file_get_data(compactFile, 0, (uint32_t)size)) != NULL);
+    CHK_OFAIL(memcmp(listData, compactData, (size_t)size) == 0);
+    
+    
+    mxf_file_close(&listFile);
+    mxf_file_close(&compactFile);
+    mxf_free_index_table_segment(&indexSegment);
+    mxf_free_compact_index_table_segment(&compactSegment);
+    return 1;
+    
+fail:
+    mxf_file_close(&listFile);
+    mxf_file_close(&compactFile);
+    mxf_free_index_table_segment(&indexSegment);
+    mxf_free_compact_index_table_segment(&compactSegment);
     return 0;
 }
 
@@ -244,6 +413,11 @@ int main(int argc, const char* argv[])
     {
         return 1;
     }
+    
+    if (!test_compact_write_equals_list(0) || !test_compact_write_equals_list(1))
+    {
+        return 1;
+    }
 
     return 0;
 }
@@ -0,0 +1,151 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include <mxf/mxf.h>
+#include <mxf/mxf_thread.h>
+
+
+#define NUM_LOG_THREADS         4
+#define NUM_THREAD_MESSAGES     5000
+
+
+typedef struct
+{
+    int threadIndex;
+} LogThreadData;
+
+
+/* only called by the async log thread */
+static uint32_t g_numReceived = 0;
+static uint32_t g_numFiltered = 0;
+static uint32_t g_numOutOfOrder = 0;
+static int g_lastMessage[NUM_LOG_THREADS];
+
+
+static void vlog_to_counter(MXFLogLevel level, const char* format, va_list p_arg)
+{
+    char buffer[256];
+    int threadIndex;
+    int messageIndex;
+
+    vsprintf(buffer, format, p_arg);
+
+    if (level < MXF_WLOG)
+    {
+        g_numFiltered++;
+        return;
+    }
+    if (sscanf(buffer, "thread %d message %d", &threadIndex, &messageIndex) != 2 ||
+        threadIndex < 0 || threadIndex >= NUM_LOG_THREADS)
+    {
+        g_numOutOfOrder++;
+        return;
+    }
+
+    /* messages from the same thread are output in the order they were logged */
+    if (messageIndex <= g_lastMessage[threadIndex])
+    {
+        g_numOutOfOrder++;
+    }
+    g_lastMessage[threadIndex] = messageIndex;
+    g_numReceived++;
+}
+
+static void log_thread(void* arg)
+{
+    LogThreadData* data = (LogThreadData*)arg;
+    int i;
+
+    for (i = 0; i < NUM_THREAD_MESSAGES; i++)
+    {
+        mxf_log_warn("thread %d message %d", data->threadIndex, i);
+        mxf_log_debug("thread %d filtered message %d", data->threadIndex, i);
+    }
+}
+
+static int test_threads(uint32_t numMessages)
+{
+    LogThreadData threadData[NUM_LOG_THREADS];
+    MXFThread threads[NUM_LOG_THREADS];
+    uint32_t numDropped;
+    int i;
+
+    g_numReceived = 0;
+    g_numFiltered = 0;
+    g_numOutOfOrder = 0;
+    for (i = 0; i < NUM_LOG_THREADS; i++)
+    {
+        g_lastMessage[i] = -1;
+    }
+
+    CHK_ORET(mxf_log_async_start(numMessages));
+
+    for (i = 0; i < NUM_LOG_THREADS; i++)
+    {
+        threadData[i].threadIndex = i;
+        CHK_OFAIL(mxf_create_thread(&threads[i], log_thread, &threadData[i]));
+    }
+    for (i = 0; i < NUM_LOG_THREADS; i++)
+    {
+        CHK_OFAIL(mxf_join_thread(&threads[i]));
+    }
+
+    mxf_log_async_stop();
+    CHK_ORET(mxf_vlog == vlog_to_counter);
+
+    numDropped = mxf_log_async_get_num_dropped();
+    printf("Async log (%u messages): received %u, dropped %u\n", numMessages, g_numReceived, numDropped);
+
+    CHK_ORET(g_numFiltered == 0);
+    CHK_ORET(g_numOutOfOrder == 0);
+    CHK_ORET(g_numReceived + numDropped == NUM_LOG_THREADS * NUM_THREAD_MESSAGES);
+    CHK_ORET(g_numReceived > 0);
+    return 1;
+
+fail:
+    mxf_log_async_stop();
+    return 0;
+}
+
+int test()
+{
+    mxf_vlog = vlog_to_counter;
+    g_mxfLogLevel = MXF_WLOG;
+
+    /* a buffer large enough to not drop any messages */
+    CHK_ORET(test_threads(NUM_LOG_THREADS * NUM_THREAD_MESSAGES));
+    CHK_ORET(mxf_log_async_get_num_dropped() == 0);
+
+    /* a small buffer which is likely to drop messages */
+    CHK_ORET(test_threads(16));
+
+    /* default size */
+    CHK_ORET(test_threads(0));
+
+    mxf_vlog = mxf_vlog_default;
+    g_mxfLogLevel = MXF_DLOG;
+    return 1;
+}
+
+void usage(const char* cmd)
+{
+    fprintf(stderr, "Usage: %s\n", cmd);
+}
+
+int main(int argc, const char* argv[])
+{
+    if (argc != 1)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (!test())
+    {
+        return 1;
+    }
+
+    return 0;
+}
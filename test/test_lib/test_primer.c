@@ -47,6 +47,15 @@ int test_read(const char* filename)
     CHK_OFAIL(mxf_get_item_tag(primer, &someKey1, &tag));
     CHK_OFAIL(tag == 0x0101);
     
+    /* dynamic tag maps back to the key */
+    CHK_OFAIL(mxf_get_item_tag(primer, &someKey2, &tag));
+    CHK_OFAIL(tag >= 0x8000);
+    CHK_OFAIL(mxf_get_item_key(primer, tag, &key));
+    CHK_OFAIL(mxf_equals_key(&someKey2, &key));
+    
+    /* unregistered tag */
+    CHK_OFAIL(!mxf_get_item_key(primer, 0x0102, &key));
+    
 
     
     mxf_file_close(&mxfFile);
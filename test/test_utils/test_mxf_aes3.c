@@ -0,0 +1,332 @@
+/*
+ * $Id$
+ *
+ * Test and benchmark the AES3 <-> PCM conversion
+ *
+ * Copyright (C) 2010  British Broadcasting Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mxf/mxf.h>
+#include <mxf/mxf_aes3.h>
+#include <mxf/mxf_thread.h>
+
+
+#define MAX_SAMPLES     1920
+#define GUARD_SIZE      64
+#define GUARD_BYTE      0xa5
+#define BENCH_FRAMES    2000
+
+
+#define CHECK(cmd) \
+    if (!(cmd)) \
+    { \
+        fprintf(stderr, "'%s' failed in %s:%d\n", #cmd, __FILE__, __LINE__); \
+        exit(1); \
+    }
+
+
+static const char* g_implNames[] = {"scalar", "ssse3", "avx2"};
+
+static const uint32_t g_sampleCounts[] = {0, 1, 2, 3, 7, 16, 1601, 1920};
+
+
+/* the per byte conversion previously used by the reader */
+static uint64_t ref_aes3_to_pcm(const uint8_t* buffer, uint32_t blockAlign, uint8_t* pcmDataPtr)
+{
+    uint16_t audioSampleCount = (buffer[2] << 8) | buffer[1];
+    uint8_t channelValidFlags = buffer[3];
+    const uint8_t* aesDataPtr = &buffer[4];
+    uint8_t* pcmStart = pcmDataPtr;
+    uint16_t sampleNum;
+    uint8_t channel;
+
+    for (sampleNum = 0; sampleNum < audioSampleCount; sampleNum++)
+    {
+        for (channel = 0; channel < 8; channel++)
+        {
+            if (channelValidFlags & (0x01 << channel))
+            {
+                switch (blockAlign)
+                {
+                    case 1:
+                        pcmDataPtr[0] = ((aesDataPtr[2] & 0xf0 ) >> 4) | ((aesDataPtr[3] << 4) & 0xff);
+                        break;
+                    case 2:
+                        pcmDataPtr[0] = ((aesDataPtr[1] & 0xf0 ) >> 4) | ((aesDataPtr[2] << 4) & 0xff);
+                        pcmDataPtr[1] = ((aesDataPtr[2] & 0xf0 ) >> 4) | ((aesDataPtr[3] << 4) & 0xff);
+                        break;
+                    default:
+                        pcmDataPtr[0] = ((aesDataPtr[0] & 0xf0) >> 4) | ((aesDataPtr[1] << 4) & 0xff);
+                        pcmDataPtr[1] = ((aesDataPtr[1] & 0xf0 ) >> 4) | ((aesDataPtr[2] << 4) & 0xff);
+                        pcmDataPtr[2] = ((aesDataPtr[2] & 0xf0 ) >> 4) | ((aesDataPtr[3] << 4) & 0xff);
+                        break;
+                }
+                pcmDataPtr += blockAlign;
+            }
+            aesDataPtr += 4;
+        }
+    }
+
+    return pcmDataPtr - pcmStart;
+}
+
+static void fill_random(uint8_t* data, uint32_t size)
+{
+    uint32_t i;
+
+    for (i = 0; i < size; i++)
+    {
+        data[i] = (uint8_t)(rand() >> 4);
+    }
+}
+
+static int check_guard(const uint8_t* data)
+{
+    int i;
+
+    for (i = 0; i < GUARD_SIZE; i++)
+    {
+        if (data[i] != GUARD_BYTE)
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void test_aes3_to_pcm(uint8_t* aesData, uint8_t* inPlaceData, uint8_t* pcmData, uint8_t* refData)
+{
+    uint64_t pcmDataLen;
+    uint64_t refDataLen;
+    uint32_t numChannels;
+    uint32_t sampleCount;
+    uint32_t blockAlign;
+    uint32_t flags;
+    size_t i;
+
+    for (i = 0; i < sizeof(g_sampleCounts) / sizeof(g_sampleCounts[0]); i++)
+    {
+        sampleCount = g_sampleCounts[i];
+        for (flags = 0; flags < 256; flags++)
+        {
+            fill_random(aesData, MXF_AES3_ELEMENT_SIZE(sampleCount));
+            aesData[1] = (uint8_t)(sampleCount & 0xff);
+            aesData[2] = (uint8_t)(sampleCount >> 8);
+            aesData[3] = (uint8_t)flags;
+
+            for (blockAlign = 1; blockAlign <= 3; blockAlign++)
+            {
+                refDataLen = ref_aes3_to_pcm(aesData, blockAlign, refData);
+
+                /* separate output buffer followed by a guard area */
+                memset(pcmData, GUARD_BYTE, refDataLen + GUARD_SIZE);
+                CHECK(mxf_convert_aes3_to_pcm(aesData, MXF_AES3_ELEMENT_SIZE(sampleCount), blockAlign,
+                                              pcmData, &pcmDataLen, &numChannels));
+                CHECK(pcmDataLen == refDataLen);
+                CHECK(memcmp(pcmData, refData, (size_t)refDataLen) == 0);
+                CHECK(check_guard(&pcmData[refDataLen]));
+
+                /* in-place */
+                memcpy(inPlaceData, aesData, MXF_AES3_ELEMENT_SIZE(sampleCount));
+                CHECK(mxf_convert_aes3_to_pcm(inPlaceData, MXF_AES3_ELEMENT_SIZE(sampleCount), blockAlign,
+                                              inPlaceData, &pcmDataLen, &numChannels));
+                CHECK(pcmDataLen == refDataLen);
+                CHECK(memcmp(inPlaceData, refData, (size_t)refDataLen) == 0);
+            }
+        }
+    }
+
+    /* sample count doesn't match the data length */
+    aesData[1] = 2;
+    aesData[2] = 0;
+    CHECK(!mxf_convert_aes3_to_pcm(aesData, MXF_AES3_ELEMENT_SIZE(1), 3, pcmData, &pcmDataLen, &numChannels));
+}
+
+static void test_pcm_to_aes3(uint8_t* pcmData, uint8_t* aesData, uint8_t* roundTripData)
+{
+    uint64_t roundTripLen;
+    uint32_t numChannels;
+    uint32_t channelCount;
+    uint32_t sampleCount;
+    uint32_t blockAlign;
+    uint32_t word;
+    uint32_t c;
+    size_t i;
+
+    for (i = 0; i < sizeof(g_sampleCounts) / sizeof(g_sampleCounts[0]); i++)
+    {
+        sampleCount = g_sampleCounts[i];
+        for (channelCount = 1; channelCount <= MXF_AES3_NUM_CHANNELS; channelCount++)
+        {
+            for (blockAlign = 1; blockAlign <= 3; blockAlign++)
+            {
+                fill_random(pcmData, sampleCount * channelCount * blockAlign);
+
+                memset(aesData, GUARD_BYTE, MXF_AES3_ELEMENT_SIZE(sampleCount) + GUARD_SIZE);
+                CHECK(mxf_convert_pcm_to_aes3(pcmData, channelCount, blockAlign, sampleCount, 0x85, aesData));
+                CHECK(check_guard(&aesData[MXF_AES3_ELEMENT_SIZE(sampleCount)]));
+                CHECK(aesData[0] == 0x85);
+                CHECK(aesData[1] == (sampleCount & 0xff) && aesData[2] == (sampleCount >> 8));
+                CHECK(aesData[3] == (uint8_t)((1 << channelCount) - 1));
+
+                /* channel numbers in bits 0-2, unused channels and bits are zero */
+                if (sampleCount > 0)
+                {
+                    for (c = 0; c < MXF_AES3_NUM_CHANNELS; c++)
+                    {
+                        word = aesData[MXF_AES3_SAMPLE_SIZE * (sampleCount - 1) + 4 + c * 4] |
+                            (aesData[MXF_AES3_SAMPLE_SIZE * (sampleCount - 1) + 4 + c * 4 + 3] << 24);
+                        CHECK((word & 0x0f) == c);
+                        CHECK((word & 0xf0000000) == 0);
+                        if (c >= channelCount)
+                        {
+                            CHECK(memcmp(&aesData[MXF_AES3_SAMPLE_SIZE * (sampleCount - 1) + 4 + c * 4 + 1],
+                                         "\0\0\0", 3) == 0);
+                        }
+                    }
+                }
+
+                CHECK(mxf_convert_aes3_to_pcm(aesData, MXF_AES3_ELEMENT_SIZE(sampleCount), blockAlign,
+                                              roundTripData, &roundTripLen, &numChannels));
+                CHECK(numChannels == channelCount);
+                CHECK(roundTripLen == sampleCount * channelCount * blockAlign);
+                CHECK(memcmp(roundTripData, pcmData, (size_t)roundTripLen) == 0);
+            }
+        }
+    }
+
+    CHECK(!mxf_convert_pcm_to_aes3(pcmData, 0, 3, 1, 0, aesData));
+    CHECK(!mxf_convert_pcm_to_aes3(pcmData, 9, 3, 1, 0, aesData));
+    CHECK(!mxf_convert_pcm_to_aes3(pcmData, 8, 4, 1, 0, aesData));
+}
+
+/* convert an 8 channel, 1920 sample frame (625-line D-10) */
+static void benchmark(uint8_t* aesData, uint8_t* pcmData)
+{
+    uint64_t pcmDataLen;
+    uint32_t numChannels;
+    uint32_t blockAlign;
+    int64_t startTime;
+    double refTime;
+    double aesTime;
+    double pcmTime;
+    int impl;
+    int i;
+
+    for (blockAlign = 2; blockAlign <= 3; blockAlign++)
+    {
+        fill_random(pcmData, MAX_SAMPLES * MXF_AES3_NUM_CHANNELS * blockAlign);
+        CHECK(mxf_convert_pcm_to_aes3(pcmData, MXF_AES3_NUM_CHANNELS, blockAlign, MAX_SAMPLES, 0, aesData));
+
+        startTime = mxf_get_monotonic_time_usec();
+        for (i = 0; i < BENCH_FRAMES; i++)
+        {
+            ref_aes3_to_pcm(aesData, blockAlign, pcmData);
+        }
+        refTime = (mxf_get_monotonic_time_usec() - startTime) / (double)BENCH_FRAMES;
+        printf("%d-bit per-byte reference:  AES3->PCM %7.2f us/frame\n", blockAlign * 8, refTime);
+
+        for (impl = MXF_AES3_SCALAR_IMPL; impl <= MXF_AES3_AVX2_IMPL; impl++)
+        {
+            mxf_set_max_aes3_impl((MXFAES3Impl)impl);
+            if ((int)mxf_get_aes3_impl() != impl)
+            {
+                continue;
+            }
+
+            startTime = mxf_get_monotonic_time_usec();
+            for (i = 0; i < BENCH_FRAMES; i++)
+            {
+                CHECK(mxf_convert_aes3_to_pcm(aesData, MXF_AES3_ELEMENT_SIZE(MAX_SAMPLES), blockAlign,
+                                              pcmData, &pcmDataLen, &numChannels));
+            }
+            aesTime = (mxf_get_monotonic_time_usec() - startTime) / (double)BENCH_FRAMES;
+
+            startTime = mxf_get_monotonic_time_usec();
+            for (i = 0; i < BENCH_FRAMES; i++)
+            {
+                CHECK(mxf_convert_pcm_to_aes3(pcmData, MXF_AES3_NUM_CHANNELS, blockAlign, MAX_SAMPLES, 0,
+                                              aesData));
+            }
+            pcmTime = (mxf_get_monotonic_time_usec() - startTime) / (double)BENCH_FRAMES;
+
+            printf("%d-bit %-18s  AES3->PCM %7.2f us/frame (x%.1f), PCM->AES3 %7.2f us/frame\n",
+                   blockAlign * 8, g_implNames[impl], aesTime, aesTime > 0 ? refTime / aesTime : 0.0, pcmTime);
+        }
+    }
+    mxf_set_max_aes3_impl(MXF_AES3_AVX2_IMPL);
+}
+
+static void usage(const char* cmd)
+{
+    fprintf(stderr, "Usage: %s [--bench]\n", cmd);
+}
+
+int main(int argc, const char* argv[])
+{
+    uint8_t* aesData;
+    uint8_t* inPlaceData;
+    uint8_t* pcmData;
+    uint8_t* refData;
+    int impl;
+
+    if (argc > 2 || (argc == 2 && strcmp(argv[1], "--bench") != 0))
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    CHECK((aesData = malloc(MXF_AES3_ELEMENT_SIZE(MAX_SAMPLES) + GUARD_SIZE)) != NULL);
+    CHECK((inPlaceData = malloc(MXF_AES3_ELEMENT_SIZE(MAX_SAMPLES))) != NULL);
+    CHECK((pcmData = malloc(MAX_SAMPLES * MXF_AES3_NUM_CHANNELS * 3 + GUARD_SIZE)) != NULL);
+    CHECK((refData = malloc(MAX_SAMPLES * MXF_AES3_NUM_CHANNELS * 3)) != NULL);
+
+    if (argc == 2)
+    {
+        benchmark(aesData, pcmData);
+    }
+    else
+    {
+        /* test each implementation supported by the CPU */
+        for (impl = MXF_AES3_SCALAR_IMPL; impl <= MXF_AES3_AVX2_IMPL; impl++)
+        {
+            mxf_set_max_aes3_impl((MXFAES3Impl)impl);
+            if ((int)mxf_get_aes3_impl() != impl)
+            {
+                continue;
+            }
+
+            test_aes3_to_pcm(aesData, inPlaceData, pcmData, refData);
+            test_pcm_to_aes3(refData, aesData, pcmData);
+            printf("Tested %s implementation\n", g_implNames[impl]);
+        }
+        mxf_set_max_aes3_impl(MXF_AES3_AVX2_IMPL);
+    }
+
+    free(aesData);
+    free(inPlaceData);
+    free(pcmData);
+    free(refData);
+
+    return 0;
+}
+
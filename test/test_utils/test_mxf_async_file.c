@@ -0,0 +1,127 @@
+/*
+ * $Id$
+ *
+ * Test the asynchronous write-behind MXFFile wrapper
+ *
+ * Copyright (C) 2010  British Broadcasting Corporation.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <mxf/mxf.h>
+#include <mxf/mxf_async_file.h>
+
+
+#define BUFFER_SIZE     (64 * 1024)
+#define NUM_BUFFERS     4
+#define CHUNK_SIZE      (BUFFER_SIZE / 3 + 7)
+#define NUM_CHUNKS      200
+
+static const char* g_testFile = "asynctest.mxf";
+
+
+
+#define CHECK(cmd) \
+    if (!(cmd)) \
+    { \
+        fprintf(stderr, "'%s' failed in %s:%d\n", #cmd, __FILE__, __LINE__); \
+        exit(1); \
+    }
+
+
+int main()
+{
+    MXFAsyncFile* asyncFile;
+    MXFAsyncFileStats stats;
+    MXFFile* target;
+    MXFFile* mxfFile;
+    uint8_t* data;
+    uint8_t* readData;
+    int i;
+    int j;
+
+    data = malloc(CHUNK_SIZE);
+    readData = malloc(CHUNK_SIZE);
+
+
+    CHECK(mxf_disk_file_open_new(g_testFile, &target));
+    CHECK(mxf_async_file_wrap(target, BUFFER_SIZE, NUM_BUFFERS, &asyncFile));
+    mxfFile = mxf_async_file_get_file(asyncFile);
+
+    CHECK(mxf_file_is_seekable(mxfFile));
+    for (i = 0; i < NUM_CHUNKS; i++)
+    {
+        memset(data, i & 0xff, CHUNK_SIZE);
+        CHECK(mxf_file_write(mxfFile, data, CHUNK_SIZE) == CHUNK_SIZE);
+        CHECK(mxf_file_tell(mxfFile) == (int64_t)(i + 1) * CHUNK_SIZE);
+    }
+    CHECK(mxf_write_uint32(mxfFile, 0x01020304));
+    CHECK(mxf_file_putc(mxfFile, 0xff) == 0xff);
+
+    CHECK(mxf_async_file_flush(asyncFile));
+
+    mxf_async_file_get_stats(asyncFile, &stats);
+    CHECK(stats.bytesWritten == (int64_t)NUM_CHUNKS * CHUNK_SIZE + 5);
+    CHECK(stats.queueDepth == 0);
+    CHECK(stats.maxQueueDepth >= 1 && stats.maxQueueDepth <= NUM_BUFFERS);
+    CHECK(stats.numStalls >= 0 && stats.stallTime >= 0);
+
+    /* rewrite the first chunk and read back across the rewritten data */
+    memset(data, 0xaa, CHUNK_SIZE);
+    CHECK(mxf_file_seek(mxfFile, 0, SEEK_SET));
+    CHECK(mxf_file_write(mxfFile, data, CHUNK_SIZE) == CHUNK_SIZE);
+    CHECK(mxf_file_seek(mxfFile, CHUNK_SIZE, SEEK_SET));
+    CHECK(mxf_file_read(mxfFile, readData, CHUNK_SIZE) == CHUNK_SIZE);
+    CHECK(readData[0] == 1 && readData[CHUNK_SIZE - 1] == 1);
+    CHECK(mxf_file_tell(mxfFile) == 2 * CHUNK_SIZE);
+
+    CHECK(mxf_file_seek(mxfFile, 0, SEEK_END));
+    CHECK(mxf_file_write(mxfFile, data, 3) == 3);
+    CHECK(mxf_async_file_flush(asyncFile));
+    CHECK(mxf_file_tell(mxfFile) == (int64_t)NUM_CHUNKS * CHUNK_SIZE + 8);
+
+    mxf_file_close(&mxfFile);
+
+
+    CHECK(mxf_disk_file_open_read(g_testFile, &mxfFile));
+
+    CHECK(mxf_file_size(mxfFile) == (int64_t)NUM_CHUNKS * CHUNK_SIZE + 8);
+    for (i = 0; i < NUM_CHUNKS; i++)
+    {
+        CHECK(mxf_file_read(mxfFile, readData, CHUNK_SIZE) == CHUNK_SIZE);
+        for (j = 0; j < CHUNK_SIZE; j++)
+        {
+            CHECK(readData[j] == (i == 0 ? 0xaa : (i & 0xff)));
+        }
+    }
+    CHECK(mxf_file_read(mxfFile, readData, 8) == 8);
+    CHECK(readData[0] == 0x01 && readData[3] == 0x04 && readData[4] == 0xff && readData[7] == 0xaa);
+    CHECK(mxf_file_read(mxfFile, readData, 1) == 0);
+
+    mxf_file_close(&mxfFile);
+
+
+    remove(g_testFile);
+
+    free(data);
+    free(readData);
+
+    return 0;
+}
+
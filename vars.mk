@@ -51,11 +51,13 @@ endif
 # Linux specific
 ifeq ($(OSNAME),Linux)
 UUIDLIB = -luuid
+PTHREADLIB = -lpthread
 endif
 
 # Solaris specific
 ifeq ($(OSNAME),SunOS)
 UUIDLIB = -luuid
+PTHREADLIB = -lpthread
 endif
 
 # MS Windows specific when building with msys